@@ -1,15 +1,35 @@
 #ifndef AFINA_STORAGE_H
 #define AFINA_STORAGE_H
 
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <stdexcept>
 #include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
 
 namespace Afina {
 
+/**
+ * Value kept in the file: size bytes at offset of fd. Range stays valid while pin is held
+ */
+struct FileValue {
+    int fd;
+    uint64_t offset;
+    std::size_t size;
+    std::shared_ptr<void> pin;
+};
+
 /**
  *
  */
 class Storage {
 public:
+    // Bytes place given by Reserve could exceed MaxValueSize by
+    static constexpr std::size_t kReserveSlack = 2;
+
     Storage() {}
     virtual ~Storage() {}
 
@@ -25,10 +45,48 @@ public:
      * method returns true any subsequent access to storage must indicates that
      * key->value association exists
      *
+     * Association gets the given expiration time together with the value, so no one sees one without the
+     * other. Expired one is as good as deleted, see Touch for the format
+     *
      * @param key to be associated with value
      * @param value to be assigned for the key
+     * @param expire expiration time of the association, never expires by default
+     */
+    virtual bool Put(const std::string &key, const std::string &value, int32_t expire = 0) = 0;
+
+    /**
+     * Same as above, but storage could take value memory over instead of copying it, value is left
+     * unspecified then. Storage which can't do that just copies
+     */
+    virtual bool Put(const std::string &key, std::string &&value, int32_t expire = 0) {
+        return Put(key, static_cast<const std::string &>(value), expire);
+    }
+
+    /**
+     * Largest value storage could ever keep. Caller rejects larger one before receiving it, so value size
+     * declared by client allocates nothing. Storage which doesn't know better keeps values up to 1MB, as
+     * memcached does
      */
-    virtual bool Put(const std::string &key, const std::string &value) = 0;
+    virtual std::size_t MaxValueSize() const { return 1024 * 1024; }
+
+    /**
+     * Places value of size bytes which is about to be stored by one of Put calls taking the value over.
+     * Caller fills it in, e.g. receives value from the network right there, and shrinks it to the actual
+     * value size. Reserved value which never gets stored is just dropped, storage isn't changed then
+     *
+     * Place could be a few bytes larger than the value, e.g. to receive \r\n following it. Returns false
+     * and allocates nothing if size is beyond MaxValueSize anyway
+     *
+     * @param size number of bytes caller is going to write
+     * @param value gets the place
+     */
+    virtual bool Reserve(std::size_t size, std::string &value) {
+        if (size > MaxValueSize() + kReserveSlack) {
+            return false;
+        }
+        value.assign(size, '\0');
+        return true;
+    }
 
     /**
      * Stores association between given key/value pair if key isn't present in
@@ -40,8 +98,16 @@ public:
      *
      * @param key to be associated with value
      * @param value to be assigned for the key
+     * @param expire expiration time of the association, see Put
      */
-    virtual bool PutIfAbsent(const std::string &key, const std::string &value) = 0;
+    virtual bool PutIfAbsent(const std::string &key, const std::string &value, int32_t expire = 0) = 0;
+
+    /**
+     * Same as above, value memory could be taken over, see Put
+     */
+    virtual bool PutIfAbsent(const std::string &key, std::string &&value, int32_t expire = 0) {
+        return PutIfAbsent(key, static_cast<const std::string &>(value), expire);
+    }
 
     /**
      * Updates existing association between given key/value pair
@@ -53,8 +119,37 @@ public:
      *
      * @param key to be associated with value
      * @param value to be assigned for the key
+     * @param expire expiration time of the association, see Put
+     */
+    virtual bool Set(const std::string &key, const std::string &value, int32_t expire = 0) = 0;
+
+    /**
+     * Same as above, value memory could be taken over, see Put
      */
-    virtual bool Set(const std::string &key, const std::string &value) = 0;
+    virtual bool Set(const std::string &key, std::string &&value, int32_t expire = 0) {
+        return Set(key, static_cast<const std::string &>(value), expire);
+    }
+
+    /**
+     * Changes value of the existing association in place: update gets the current value and changes it,
+     * or returns false to leave association as is. Expiration time of the association is kept
+     *
+     * Storage calls update under the same lock the key is changed with, so concurrent updates and stores
+     * of the key apply one after another and none of them is lost. Update must be quick and must not call
+     * the storage. Storage which can't do that gets value and sets it back, which isn't atomic
+     *
+     * Returns false if there is no association for the key or update returned false
+     *
+     * @param key to change value for
+     * @param update changes value passed to it, returns false to cancel
+     */
+    virtual bool Update(std::string_view key, const std::function<bool(std::string &)> &update) {
+        std::string value;
+        if (!Get(key, value) || !update(value)) {
+            return false;
+        }
+        return Set(std::string(key), std::move(value));
+    }
 
     /**
      * Removes association for the given key
@@ -68,9 +163,11 @@ public:
      * see deleted association until it created again by Put or PutIfAdsent
      * calls
      *
+     * Key is only looked up, see Get
+     *
      * @param key to be removed
      */
-    virtual bool Delete(const std::string &key) = 0;
+    virtual bool Delete(std::string_view key) = 0;
 
     /**
      * Retrive key for the given value
@@ -80,10 +177,52 @@ public:
      * In case if given key not found method returns false and doesn't perform
      * any changes on the output parameter
      *
+     * Key is only looked up, so it could refer any memory, e.g. request in the network buffer
+     *
      * @param key to retrive1 value for
      * @param value output parameter to copy value to
      */
-    virtual bool Get(const std::string &key, std::string &value) = 0;
+    virtual bool Get(std::string_view key, std::string &value) = 0;
+
+    /**
+     * Same as Get, but large value kept in the file could be returned as a file range instead of being
+     * copied to memory, so it could be sent straight from the page cache. file.fd is -1 if value is
+     * copied into value parameter
+     */
+    virtual bool GetFile(std::string_view key, std::string &value, FileValue &file) {
+        file.fd = -1;
+        return Get(key, value);
+    }
+
+    /**
+     * Sets expiration time of the existing association, value isn't touched. Expiration time follows
+     * memcached convention: 0 means association never expires, up to 30 days it is number of seconds
+     * from now and Unix time otherwise, negative one expires association right away. Put calls set
+     * expiration time given to them
+     *
+     * Returns false if there is no association for the key. Storage which doesn't support expiration
+     * only checks whether key is there
+     *
+     * @param key to change expiration time for
+     * @param expire new expiration time
+     */
+    virtual bool Touch(std::string_view key, int32_t expire) {
+        std::string value;
+        return Get(key, value);
+    }
+
+    /**
+     * Requests point-in-time copy of the storage content to be written to the disk. Copy is
+     * written in background, method returns right away.
+     *
+     * Throws std::runtime_error if storage doesn't support snapshots or they aren't configured
+     */
+    virtual void Snapshot() { throw std::runtime_error("Storage doesn't support snapshots"); }
+
+    /**
+     * Appends storage specific counters as name/value pairs, reported by stats command
+     */
+    virtual void Stats(std::vector<std::pair<std::string, std::string>> &stats) {}
 };
 
 } // namespace Afina
@@ -3,6 +3,7 @@
 
 #include <cstdint>
 #include <string>
+#include <utility>
 
 #include "InsertCommand.h"
 
@@ -20,10 +21,13 @@ namespace Execute {
  */
 class Add : public InsertCommand {
 public:
-    Add(const std::string &key, uint32_t flags, int32_t expire) : InsertCommand(key, flags, expire) {}
+    Add(std::string key, uint32_t flags, int32_t expire) : InsertCommand(std::move(key), flags, expire) {}
     ~Add() {}
 
     void Execute(Storage &storage, const std::string &args, std::string &out) override;
+
+    // Value is moved to the storage, see Command
+    void Execute(Storage &storage, std::string &&args, std::string &out) override;
 };
 
 } // namespace Execute
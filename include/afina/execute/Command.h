@@ -2,13 +2,36 @@
 #define AFINA_EXECUTE_COMMAND_H
 
 #include <string>
+#include <utility>
+#include <vector>
 
-namespace Afina {
+#include <afina/Storage.h>
 
-class Storage;
+namespace Afina {
 
 namespace Execute {
 
+/**
+ * Response that could refer values kept in files, see Storage::GetFile. Each file part goes right
+ * before the byte of text at the given position
+ *
+ * Server keeps response from command to command, so memory of its strings is reused. Text is written
+ * by ResponseBuilder
+ */
+struct Response {
+    std::string text;
+    std::vector<std::pair<std::size_t, FileValue>> files;
+
+    // Scratch space of the command, e.g. value on the way from storage to the text
+    std::string value;
+
+    // Prepares response for the next command, memory is kept
+    void Clear() {
+        text.clear();
+        files.clear();
+    }
+};
+
 /**
  *
  *
@@ -18,7 +41,27 @@ public:
     Command() {}
     virtual ~Command() {}
 
+    /**
+     * Executes command over the storage and writes response to out. Command could leave response
+     * empty if there is nothing to say, e.g. quiet meta command, then server sends nothing back
+     */
     virtual void Execute(Storage &storage, const std::string &args, std::string &out) = 0;
+
+    /**
+     * Same as above, but argument is dropped right after, so command could take it over, e.g. move value
+     * to the storage instead of copying it. Argument is left unspecified
+     */
+    virtual void Execute(Storage &storage, std::string &&args, std::string &out) {
+        Execute(storage, static_cast<const std::string &>(args), out);
+    }
+
+    /**
+     * Same as above, but command could respond with file parts instead of copying them to the text.
+     * Server calls that one
+     */
+    virtual void ExecuteResponse(Storage &storage, const std::string &args, Response &out) {
+        Execute(storage, args, out.text);
+    }
 };
 
 } // namespace Execute
@@ -1,6 +1,9 @@
 #ifndef AFINA_EXECUTE_DELETE_H
 #define AFINA_EXECUTE_DELETE_H
 
+#include <string>
+#include <string_view>
+
 #include "Command.h"
 
 namespace Afina {
@@ -14,13 +17,20 @@ namespace Execute {
  * Command must write result to the output, which could be:
  * - "DELETED" to indicate success
  * - "NOT_FOUND" to indicate that the item with this key was not found
+ *
+ * Key refers memory of the parsed request, so command must be executed before it is released
  */
 class Delete : public Command {
 public:
-    Delete();
-    ~Delete();
+    Delete(std::string_view key) : _key(key) {}
+    ~Delete() {}
+
+    inline std::string_view key() const { return _key; }
 
     void Execute(Storage &storage, const std::string &args, std::string &out) override;
+
+private:
+    std::string_view _key;
 };
 
 } // namespace Execute
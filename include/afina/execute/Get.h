@@ -2,6 +2,7 @@
 #define AFINA_EXECUTE_GET_H
 
 #include <string>
+#include <string_view>
 #include <vector>
 
 #include "Command.h"
@@ -18,7 +19,7 @@ namespace Execute {
  * the items have been transmitted, the server sends the string
  *
  * Each item sent by the server looks like this:
- * VALUE <key> <bytes>\r\n
+ * VALUE <key> <flags> <bytes> [<cas unique>]\r\n
  * <data>\r\n
  * VALUE ....
  * END
@@ -31,18 +32,32 @@ namespace Execute {
  * hold items with such keys (because they were never stored, or stored
  * but deleted to make space for more items, or expired, or explicitly
  * deleted by a client).
+ *
+ * CAS unique is sent for "gets" only, it is always 0 as storage doesn't keep it
+ *
+ * Keys refer memory of the parsed request, so command must be executed before it is released
  */
 class Get : public Command {
 public:
-    Get(const std::vector<std::string> &keys) : _keys(keys) {}
+    Get(const std::vector<std::string_view> &keys, bool cas = false) : _keys(keys), _cas(cas) {}
     ~Get() {}
 
-    inline const std::vector<std::string> &keys() const { return _keys; }
+    inline const std::vector<std::string_view> &keys() const { return _keys; }
+
+    // Switches command to another request, memory of the keys list is reused
+    void keys(const std::vector<std::string_view> &keys) { _keys.assign(keys.begin(), keys.end()); }
+
+    inline bool cas() const { return _cas; }
+    void cas(bool cas) { _cas = cas; }
 
     void Execute(Storage &storage, const std::string &args, std::string &out) override;
 
+    // Large values kept in files are sent from there
+    void ExecuteResponse(Storage &storage, const std::string &args, Response &out) override;
+
 private:
-    std::vector<std::string> _keys;
+    std::vector<std::string_view> _keys;
+    bool _cas;
 };
 
 } // namespace Execute
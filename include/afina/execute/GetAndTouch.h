@@ -0,0 +1,41 @@
+#ifndef AFINA_EXECUTE_GET_AND_TOUCH_H
+#define AFINA_EXECUTE_GET_AND_TOUCH_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "Get.h"
+
+namespace Afina {
+namespace Execute {
+
+/**
+ * # Retrive values and update their expiration time
+ * gat <exptime> <key>*
+ * gats <exptime> <key>*
+ *
+ * Expiration time of every key is updated first, then command responds exactly as get does, or as gets
+ * for gats. So client keeping hot items alive doesn't have to store them again
+ */
+class GetAndTouch : public Get {
+public:
+    GetAndTouch(int32_t expire, const std::vector<std::string_view> &keys, bool cas = false)
+        : Get(keys, cas), _expire(expire) {}
+    ~GetAndTouch() {}
+
+    inline int32_t expire() const { return _expire; }
+
+    void Execute(Storage &storage, const std::string &args, std::string &out) override;
+
+    void ExecuteResponse(Storage &storage, const std::string &args, Response &out) override;
+
+private:
+    int32_t _expire;
+};
+
+} // namespace Execute
+} // namespace Afina
+
+#endif // AFINA_EXECUTE_GET_AND_TOUCH_H
@@ -0,0 +1,64 @@
+#ifndef AFINA_EXECUTE_INCR_H
+#define AFINA_EXECUTE_INCR_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include "Command.h"
+
+namespace Afina {
+namespace Execute {
+
+/**
+ * # Change numeric value of the key
+ * Value must be a decimal representation of a 64-bit unsigned integer. It is increased by delta,
+ * wrapping around on overflow, or decreased down to 0 at most if command is "decr"
+ *
+ * If key isn't there command does nothing unless initial value is given, then it is stored
+ * as is
+ *
+ * Command must write result to the output, which could be:
+ * - new value of the item
+ * - "NOT_FOUND" to indicate that the item with this key was not found
+ * - "CLIENT_ERROR ..." if value isn't a number
+ *
+ * Key refers memory of the parsed request, so command must be executed before it is released
+ */
+class Incr : public Command {
+public:
+    Incr(std::string_view key, uint64_t delta, bool decrement)
+        : _key(key), _delta(delta), _decrement(decrement), _create(false), _initial(0) {}
+    Incr(std::string_view key, uint64_t delta, bool decrement, uint64_t initial)
+        : _key(key), _delta(delta), _decrement(decrement), _create(true), _initial(initial) {}
+    ~Incr() {}
+
+    inline std::string_view key() const { return _key; }
+    inline uint64_t delta() const { return _delta; }
+    inline bool decrement() const { return _decrement; }
+
+    void Execute(Storage &storage, const std::string &args, std::string &out) override;
+
+    // Outcome of Apply
+    enum class Result { Changed, Created, NotFound, NotNumber };
+
+    /**
+     * Changes item the way described above, value gets the new one. Item is changed by Storage::Update,
+     * so concurrent changes of the same key aren't lost and item keeps its expiration time. Shared with
+     * meta arithmetic
+     */
+    static Result Apply(Storage &storage, const std::string &key, uint64_t delta, bool decrement, bool create,
+                        uint64_t initial, uint64_t &value);
+
+private:
+    std::string_view _key;
+    uint64_t _delta;
+    bool _decrement;
+    bool _create;
+    uint64_t _initial;
+};
+
+} // namespace Execute
+} // namespace Afina
+
+#endif // AFINA_EXECUTE_INCR_H
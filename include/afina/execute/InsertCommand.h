@@ -3,6 +3,7 @@
 
 #include <cstdint>
 #include <string>
+#include <utility>
 
 #include "Command.h"
 
@@ -15,7 +16,8 @@ namespace Execute {
  */
 class InsertCommand : public Command {
 public:
-    InsertCommand(const std::string &key, uint32_t flags, int32_t expire) : _key(key), _flags(flags), _expire(expire) {}
+    InsertCommand(std::string key, uint32_t flags, int32_t expire)
+        : _key(std::move(key)), _flags(flags), _expire(expire) {}
     ~InsertCommand() {}
 
     inline const std::string &key() const { return _key; }
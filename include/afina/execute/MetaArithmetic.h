@@ -0,0 +1,53 @@
+#ifndef AFINA_EXECUTE_META_ARITHMETIC_H
+#define AFINA_EXECUTE_META_ARITHMETIC_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include "MetaCommand.h"
+
+namespace Afina {
+namespace Execute {
+
+/**
+ * # Change numeric item, meta version
+ * ma <key> <flags>*
+ *
+ * Item is changed the same way incr and decr do, see Incr. Request flags:
+ * - D<delta>: amount to change item by, 1 by default
+ * - MI, M+ to increment (the default) or MD, M- to decrement
+ * - N<ttl>: create item if it isn't there, with J<initial> value, 0 by default
+ * - v: return new value
+ *
+ * Command responds
+ * VA <bytes> <flags>*\r\n
+ * <number>
+ * if value is requested or HD <flags>* otherwise, nothing in quiet mode. NF <flags>* is responded if
+ * item isn't there and CLIENT_ERROR if it isn't a number
+ *
+ * Key refers memory of the parsed request, so command must be executed before it is released
+ */
+class MetaArithmetic : public MetaCommand {
+public:
+    MetaArithmetic(std::string_view key, uint64_t delta, bool decrement, bool create, uint64_t initial,
+                   const Flags &flags)
+        : MetaCommand(flags), _key(key), _delta(delta), _decrement(decrement), _create(create), _initial(initial) {}
+    ~MetaArithmetic() {}
+
+    inline std::string_view key() const { return _key; }
+
+    void Execute(Storage &storage, const std::string &args, std::string &out) override;
+
+private:
+    std::string_view _key;
+    uint64_t _delta;
+    bool _decrement;
+    bool _create;
+    uint64_t _initial;
+};
+
+} // namespace Execute
+} // namespace Afina
+
+#endif // AFINA_EXECUTE_META_ARITHMETIC_H
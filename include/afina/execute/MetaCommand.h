@@ -0,0 +1,59 @@
+#ifndef AFINA_EXECUTE_META_COMMAND_H
+#define AFINA_EXECUTE_META_COMMAND_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include "Command.h"
+
+namespace Afina {
+namespace Execute {
+
+/**
+ * # Basic class for meta commands
+ * Meta commands (mg, ms, md, ma) respond with a two letter code followed by the flags client asked
+ * for, so the response carries only what client needs:
+ * <code> <flags>*
+ *
+ * Flags every meta command understands:
+ * - k: return key as k<key>
+ * - O<token>: return opaque token as O<token>, so client could match responses of the pipeline
+ * - q: quiet mode, the usual outcome isn't responded at all, see each command. Pipeline of quiet
+ *   commands is usually terminated by mn, so client knows all responses are there
+ *
+ * Command which has nothing to respond leaves the response empty
+ */
+class MetaCommand : public Command {
+public:
+    /**
+     * Flags of the request which shape the response
+     */
+    struct Flags {
+        Flags() : returns(0), quiet(false) {}
+
+        // Lower case flag asking to return something
+        bool Has(char flag) const { return (returns & (1u << (flag - 'a'))) != 0; }
+        void Add(char flag) { returns |= (1u << (flag - 'a')); }
+
+        uint32_t returns;
+        bool quiet;
+        std::string opaque;
+    };
+
+    MetaCommand(const Flags &flags) : _flags(flags) {}
+    ~MetaCommand() {}
+
+    inline const Flags &flags() const { return _flags; }
+
+protected:
+    // Appends flags which don't depend on the item: key and opaque token
+    void AppendFlags(std::string &out, std::string_view key) const;
+
+    const Flags _flags;
+};
+
+} // namespace Execute
+} // namespace Afina
+
+#endif // AFINA_EXECUTE_META_COMMAND_H
@@ -0,0 +1,37 @@
+#ifndef AFINA_EXECUTE_META_DELETE_H
+#define AFINA_EXECUTE_META_DELETE_H
+
+#include <string>
+#include <string_view>
+
+#include "MetaCommand.h"
+
+namespace Afina {
+namespace Execute {
+
+/**
+ * # Remove item, meta version
+ * md <key> <flags>*
+ *
+ * Command responds HD <flags>* if item is deleted or NF <flags>* if it wasn't there, neither is
+ * responded in quiet mode
+ *
+ * Key refers memory of the parsed request, so command must be executed before it is released
+ */
+class MetaDelete : public MetaCommand {
+public:
+    MetaDelete(std::string_view key, const Flags &flags) : MetaCommand(flags), _key(key) {}
+    ~MetaDelete() {}
+
+    inline std::string_view key() const { return _key; }
+
+    void Execute(Storage &storage, const std::string &args, std::string &out) override;
+
+private:
+    std::string_view _key;
+};
+
+} // namespace Execute
+} // namespace Afina
+
+#endif // AFINA_EXECUTE_META_DELETE_H
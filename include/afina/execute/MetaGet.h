@@ -0,0 +1,52 @@
+#ifndef AFINA_EXECUTE_META_GET_H
+#define AFINA_EXECUTE_META_GET_H
+
+#include <string>
+#include <string_view>
+
+#include "MetaCommand.h"
+
+namespace Afina {
+namespace Execute {
+
+/**
+ * # Retrive item for the key, meta version
+ * mg <key> <flags>*
+ *
+ * Item is responded as
+ * VA <bytes> <flags>*\r\n
+ * <data>
+ * if client asked for value by v flag, or just as HD <flags>* otherwise. Besides common ones item flags
+ * could be requested:
+ * - s: item size
+ * - f: client flags, always 0 as storage doesn't keep them
+ * - t: seconds till item expires, -1 as items don't expire
+ * - c: CAS value, always 0
+ *
+ * EN is responded if item isn't there, or nothing at all in quiet mode
+ *
+ * Key refers memory of the parsed request, so command must be executed before it is released
+ */
+class MetaGet : public MetaCommand {
+public:
+    MetaGet(std::string_view key, const Flags &flags) : MetaCommand(flags), _key(key) {}
+    ~MetaGet() {}
+
+    inline std::string_view key() const { return _key; }
+
+    void Execute(Storage &storage, const std::string &args, std::string &out) override;
+
+    // Large values kept in files are sent from there
+    void ExecuteResponse(Storage &storage, const std::string &args, Response &out) override;
+
+private:
+    // Appends response line of the found item, data goes next if requested
+    void AppendItem(std::string &out, std::size_t size) const;
+
+    std::string_view _key;
+};
+
+} // namespace Execute
+} // namespace Afina
+
+#endif // AFINA_EXECUTE_META_GET_H
@@ -0,0 +1,29 @@
+#ifndef AFINA_EXECUTE_META_NOOP_H
+#define AFINA_EXECUTE_META_NOOP_H
+
+#include <string>
+
+#include "Command.h"
+
+namespace Afina {
+namespace Execute {
+
+/**
+ * # Meta no-op
+ * mn
+ *
+ * Responds MN. Commands are executed in order, so once client gets it all responses to the commands
+ * sent before are there, which is how pipeline of quiet commands is terminated
+ */
+class MetaNoop : public Command {
+public:
+    MetaNoop() {}
+    ~MetaNoop() {}
+
+    void Execute(Storage &storage, const std::string &args, std::string &out) override { out.assign("MN"); }
+};
+
+} // namespace Execute
+} // namespace Afina
+
+#endif // AFINA_EXECUTE_META_NOOP_H
@@ -0,0 +1,62 @@
+#ifndef AFINA_EXECUTE_META_SET_H
+#define AFINA_EXECUTE_META_SET_H
+
+#include <cstdint>
+#include <string>
+#include <utility>
+
+#include "MetaCommand.h"
+
+namespace Afina {
+namespace Execute {
+
+/**
+ * # Store item, meta version
+ * ms <key> <datalen> <flags>*\r\n
+ * <data>\r\n
+ *
+ * The way item is stored is given by M<mode> flag:
+ * - S: set, the default
+ * - E: add, only if item isn't there
+ * - R: replace, only if item is there
+ * - A: append data to the item
+ * - P: prepend data to the item
+ *
+ * Command responds HD <flags>* if item is stored, nothing in quiet mode, or NS <flags>* if mode condition
+ * isn't met. T<ttl> sets item expiration time, F<flags> is accepted, but not kept by storage
+ */
+class MetaSet : public MetaCommand {
+public:
+    enum class Mode : uint8_t { Set, Add, Replace, Append, Prepend };
+
+    MetaSet(std::string key, Mode mode, uint32_t flags, int32_t expire, const Flags &meta)
+        : MetaCommand(meta), _key(std::move(key)), _mode(mode), _client_flags(flags), _expire(expire) {}
+    ~MetaSet() {}
+
+    inline const std::string &key() const { return _key; }
+    inline Mode mode() const { return _mode; }
+    inline uint32_t client_flags() const { return _client_flags; }
+    inline int32_t expire() const { return _expire; }
+
+    void Execute(Storage &storage, const std::string &args, std::string &out) override;
+
+    // Value is moved to the storage unless it is appended, see Command
+    void Execute(Storage &storage, std::string &&args, std::string &out) override;
+
+private:
+    // Stores value the way mode says together with its expiration time, returns whether it is stored
+    template <typename Value> bool Store(Storage &storage, Value &&value);
+
+    // Writes response
+    void Respond(bool stored, std::string &out);
+
+    const std::string _key;
+    const Mode _mode;
+    const uint32_t _client_flags;
+    const int32_t _expire;
+};
+
+} // namespace Execute
+} // namespace Afina
+
+#endif // AFINA_EXECUTE_META_SET_H
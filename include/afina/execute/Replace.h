@@ -3,6 +3,7 @@
 
 #include <cstdint>
 #include <string>
+#include <utility>
 
 #include "InsertCommand.h"
 
@@ -21,10 +22,13 @@ namespace Execute {
  */
 class Replace : public InsertCommand {
 public:
-    Replace(const std::string &key, uint32_t flags, int32_t expire) : InsertCommand(key, flags, expire) {}
+    Replace(std::string key, uint32_t flags, int32_t expire) : InsertCommand(std::move(key), flags, expire) {}
     ~Replace() {}
 
     void Execute(Storage &storage, const std::string &args, std::string &out) override;
+
+    // Value is moved to the storage, see Command
+    void Execute(Storage &storage, std::string &&args, std::string &out) override;
 };
 
 } // namespace Execute
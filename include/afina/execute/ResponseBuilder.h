@@ -0,0 +1,69 @@
+#ifndef AFINA_EXECUTE_RESPONSE_BUILDER_H
+#define AFINA_EXECUTE_RESPONSE_BUILDER_H
+
+#include <algorithm>
+#include <charconv>
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+namespace Afina {
+namespace Execute {
+
+/**
+ * # Appends pieces of the response text
+ * Writes right into the response string: text is appended as is and numbers are formatted by
+ * std::to_chars, so there is no locale, no stream state and no temporary strings. Server keeps the
+ * response string from command to command, so once it has grown formatting allocates nothing.
+ *
+ * Command which knows about how long the rest of its response is reserves that at once, rather than
+ * growing the string piece by piece
+ */
+class ResponseBuilder {
+public:
+    explicit ResponseBuilder(std::string &out) : _out(out) {}
+
+    ResponseBuilder &Append(std::string_view text) {
+        _out.append(text.data(), text.size());
+        return *this;
+    }
+
+    ResponseBuilder &Append(char c) {
+        _out.push_back(c);
+        return *this;
+    }
+
+    /**
+     * Appends decimal integer
+     */
+    template <typename T> ResponseBuilder &Number(T number) {
+        static_assert(std::is_integral<T>::value, "Only integers are formatted");
+        char digits[24];
+        std::to_chars_result result = std::to_chars(digits, digits + sizeof(digits), number);
+        _out.append(digits, result.ptr - digits);
+        return *this;
+    }
+
+    /**
+     * Makes room for size more bytes. Capacity at least doubles once it is exceeded, so a number of
+     * reserves costs amortized constant time
+     */
+    ResponseBuilder &Reserve(std::size_t size) {
+        std::size_t need = _out.size() + size;
+        if (need > _out.capacity()) {
+            _out.reserve(std::max(need, 2 * _out.capacity()));
+        }
+        return *this;
+    }
+
+    std::size_t Size() const { return _out.size(); }
+
+private:
+    std::string &_out;
+};
+
+} // namespace Execute
+} // namespace Afina
+
+#endif // AFINA_EXECUTE_RESPONSE_BUILDER_H
@@ -0,0 +1,112 @@
+#ifndef AFINA_EXECUTE_SLOT_H
+#define AFINA_EXECUTE_SLOT_H
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <variant>
+
+#include "Add.h"
+#include "Append.h"
+#include "Command.h"
+#include "Delete.h"
+#include "Get.h"
+#include "GetAndTouch.h"
+#include "Incr.h"
+#include "MetaArithmetic.h"
+#include "MetaDelete.h"
+#include "MetaGet.h"
+#include "MetaNoop.h"
+#include "MetaSet.h"
+#include "Prepend.h"
+#include "Replace.h"
+#include "Set.h"
+#include "Snapshot.h"
+#include "Stats.h"
+#include "Touch.h"
+
+namespace Afina {
+namespace Execute {
+
+/**
+ * # Reusable place for the parsed command
+ * Built-in commands are kept by value in a variant, so parsing command allocates nothing and
+ * execution is a jump over alternatives with direct calls rather than a virtual one. Slot lives as
+ * long as connection does: once command is done it is only marked empty, so the next command of the
+ * same type could reuse its memory, see Reuse.
+ *
+ * Any other Command could be placed to the slot by pointer, that is the way to plug commands which
+ * aren't listed here
+ */
+class Slot {
+public:
+    Slot() : _ready(false) {}
+
+    /**
+     * Places new command of type T to the slot
+     */
+    template <typename T, typename... Args> T &Emplace(Args &&... args) {
+        _ready = true;
+        return _command.template emplace<T>(std::forward<Args>(args)...);
+    }
+
+    /**
+     * Places command of any other type
+     */
+    void Emplace(std::unique_ptr<Command> &&command) {
+        _ready = true;
+        _command = std::move(command);
+    }
+
+    /**
+     * If slot keeps command of type T left from some previous request, makes it current one and
+     * returns it, so caller could update it in place. Returns nullptr otherwise
+     */
+    template <typename T> T *Reuse() {
+        T *command = std::get_if<T>(&_command);
+        if (command != nullptr) {
+            _ready = true;
+        }
+        return command;
+    }
+
+    /**
+     * True if there is command to execute
+     */
+    bool Empty() const { return !_ready; }
+
+    /**
+     * Marks command as done, object is kept for reuse
+     */
+    void Clear() { _ready = false; }
+
+    /**
+     * Executes current command, see Command::ExecuteResponse
+     */
+    void ExecuteResponse(Storage &storage, const std::string &args, Response &out);
+
+    /**
+     * Same as above, but built-in command could take argument over, see Command::Execute. Commands with
+     * their own ExecuteResponse and plugged ones get it by reference
+     */
+    void ExecuteResponse(Storage &storage, std::string &&args, Response &out);
+
+    /**
+     * Moves current command out to the heap, slot becomes empty. Returns nullptr if slot is empty
+     */
+    std::unique_ptr<Command> Release();
+
+private:
+    Slot(const Slot &) = delete;
+    Slot &operator=(const Slot &) = delete;
+
+    std::variant<std::monostate, Get, Set, Add, Replace, Append, Prepend, Delete, Incr, Touch, GetAndTouch, MetaGet,
+                 MetaSet, MetaDelete, MetaArithmetic, MetaNoop, Stats, Snapshot, std::unique_ptr<Command>>
+        _command;
+    bool _ready;
+};
+
+} // namespace Execute
+} // namespace Afina
+
+#endif // AFINA_EXECUTE_SLOT_H
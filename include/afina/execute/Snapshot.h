@@ -0,0 +1,24 @@
+#ifndef AFINA_EXECUTE_SNAPSHOT_H
+#define AFINA_EXECUTE_SNAPSHOT_H
+
+#include <string>
+
+#include "Command.h"
+
+namespace Afina {
+namespace Execute {
+
+/**
+ * Asks storage to write its snapshot to the disk, see Storage::Snapshot
+ */
+class Snapshot : public Command {
+public:
+    Snapshot() {}
+    ~Snapshot() {}
+    void Execute(Storage &storage, const std::string &args, std::string &out) override;
+};
+
+} // namespace Execute
+} // namespace Afina
+
+#endif // AFINA_EXECUTE_SNAPSHOT_H
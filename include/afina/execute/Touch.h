@@ -0,0 +1,43 @@
+#ifndef AFINA_EXECUTE_TOUCH_H
+#define AFINA_EXECUTE_TOUCH_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include "Command.h"
+
+namespace Afina {
+namespace Execute {
+
+/**
+ * # Update expiration time of the key
+ * touch <key> <exptime>
+ *
+ * Item value isn't sent or copied, storage only changes its expiration time, see Storage::Touch
+ *
+ * Command must write result to the output, which could be:
+ * - "TOUCHED" to indicate success
+ * - "NOT_FOUND" to indicate that the item with this key was not found
+ *
+ * Key refers memory of the parsed request, so command must be executed before it is released
+ */
+class Touch : public Command {
+public:
+    Touch(std::string_view key, int32_t expire) : _key(key), _expire(expire) {}
+    ~Touch() {}
+
+    inline std::string_view key() const { return _key; }
+    inline int32_t expire() const { return _expire; }
+
+    void Execute(Storage &storage, const std::string &args, std::string &out) override;
+
+private:
+    std::string_view _key;
+    int32_t _expire;
+};
+
+} // namespace Execute
+} // namespace Afina
+
+#endif // AFINA_EXECUTE_TOUCH_H
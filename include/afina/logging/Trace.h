@@ -0,0 +1,92 @@
+#ifndef AFINA_LOGGING_TRACE_H
+#define AFINA_LOGGING_TRACE_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+#include <spdlog/logger.h>
+
+#include "Service.h"
+
+// Trace points below that level are compiled out. Levels are the ones of spdlog: 0 is trace, 1 is debug,
+// 2 is info and so on. Build sets it, see AFINA_TRACE_LEVEL in CMakeLists.txt
+#ifndef AFINA_TRACE_LEVEL
+#define AFINA_TRACE_LEVEL 0
+#endif
+
+namespace Afina {
+namespace Logging {
+
+/**
+ * # Sampled trace points of the request path
+ * Trace point below AFINA_TRACE_LEVEL costs nothing, its code is eliminated at compile time. The rest
+ * cost one atomic load till Setup routes them to the "trace" logger of the service. After that every
+ * n-th hit of a thread is passed to the logger, so tracing stays bounded whatever the request rate is.
+ * Arguments of the trace point are evaluated only for the hits which are logged
+ *
+ * AFINA_TRACE(level, format, args...) is the trace point, level and format are the ones of spdlog
+ */
+class Trace {
+public:
+    /**
+     * True if trace points of the given level are kept by the build
+     */
+    static constexpr bool CompiledIn(spdlog::level::level_enum level) {
+        return static_cast<int>(level) >= AFINA_TRACE_LEVEL;
+    }
+
+    /**
+     * Starts passing every sample-th trace point hit to the "trace" logger of the service
+     */
+    static void Setup(Service &service, uint32_t sample) {
+        _owner = service.select("trace");
+        _sample.store(sample > 0 ? sample : 1, std::memory_order_relaxed);
+        _logger.store(_owner.get(), std::memory_order_release);
+    }
+
+    /**
+     * Stops tracing, must be called once there is no one to hit trace points, e.g. server is stopped
+     */
+    static void Reset() {
+        _logger.store(nullptr, std::memory_order_release);
+        _owner.reset();
+    }
+
+    /**
+     * Returns logger if this hit is to be logged, nullptr otherwise
+     */
+    static spdlog::logger *Sample() {
+        spdlog::logger *logger = _logger.load(std::memory_order_acquire);
+        if (logger == nullptr) {
+            return nullptr;
+        }
+
+        // Counter is per thread, so sampling costs no shared writes
+        thread_local uint32_t hits = 0;
+        if (++hits < _sample.load(std::memory_order_relaxed)) {
+            return nullptr;
+        }
+        hits = 0;
+        return logger;
+    }
+
+private:
+    static inline std::shared_ptr<spdlog::logger> _owner;
+    static inline std::atomic<spdlog::logger *> _logger{nullptr};
+    static inline std::atomic<uint32_t> _sample{1};
+};
+
+} // namespace Logging
+} // namespace Afina
+
+#define AFINA_TRACE(level, ...)                                                                                        \
+    do {                                                                                                               \
+        if constexpr (::Afina::Logging::Trace::CompiledIn(level)) {                                                    \
+            if (spdlog::logger *afina_trace_logger = ::Afina::Logging::Trace::Sample()) {                              \
+                afina_trace_logger->log(level, __VA_ARGS__);                                                           \
+            }                                                                                                          \
+        }                                                                                                              \
+    } while (0)
+
+#endif // AFINA_LOGGING_TRACE_H
@@ -0,0 +1,79 @@
+#ifndef AFINA_NETWORK_CONFIG_H
+#define AFINA_NETWORK_CONFIG_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Afina {
+namespace Network {
+
+/**
+ * # Network layer tunables
+ * Shared by all server implementations, each one reads only options it is
+ * able to support and ignores the rest
+ */
+class Config {
+public:
+    Config()
+        : reuse_port(false), idle_timeout(300000), read_timeout(30000), write_timeout(0),
+          output_high_watermark(1 << 20), output_limit(0), zerocopy_threshold(0), fair_budget(64) {}
+
+    /*
+     * Every worker owns a private SO_REUSEPORT listening socket together with a private
+     * epoll instance, so kernel balances incoming connections between workers and a
+     * connection never leaves the thread it was accepted on
+     * Servers: mt_nonblock
+     */
+    bool reuse_port;
+
+    /*
+     * Connection deadlines in milliseconds, 0 disables corresponding check. Connection gets
+     * closed if during that time:
+     * - idle_timeout: client sent nothing while there was no command in progress
+     * - read_timeout: client started a command but didn't send the rest of it
+     * - write_timeout: responses are pending, but client didn't accept a single byte of them
+     * Idle connections are closed in 5 minutes and unfinished commands in 30 seconds by default
+     * Servers: st_nonblock, st_coroutine, mt_nonblock
+     */
+    uint32_t idle_timeout;
+    uint32_t read_timeout;
+    uint32_t write_timeout;
+
+    /*
+     * Output backpressure, bytes. Connection stops reading new commands once responses
+     * waiting for the client reach output_high_watermark and resumes when half of them are
+     * sent. Besides that, connections which have some output pending stop reading while all
+     * connections of the server together hold output_limit bytes. 0 disables the check
+     * Servers: st_nonblock, st_coroutine, mt_nonblock
+     */
+    std::size_t output_high_watermark;
+    std::size_t output_limit;
+
+    /*
+     * Responses of at least that many bytes are sent with MSG_ZEROCOPY: kernel sends pages of
+     * the buffer instead of copying them, buffer is kept until kernel reports completion. Pays
+     * off for large values only, 0 disables zerocopy
+     * Servers: st_nonblock, st_coroutine, mt_nonblock
+     */
+    std::size_t zerocopy_threshold;
+
+    /*
+     * Max number of commands connection executes per event loop iteration, the rest waits
+     * till other ready connections are served. 0 disables the limit
+     * Servers: mt_nonblock
+     */
+    std::size_t fair_budget;
+
+    /*
+     * Listening sockets inherited from the previous process on graceful restart, see
+     * Handoff.h. Server takes sockets bound to its port instead of binding new ones
+     * Servers: st_nonblock, st_coroutine, mt_nonblock, uring
+     */
+    std::vector<int> inherited_sockets;
+};
+
+} // namespace Network
+} // namespace Afina
+
+#endif // AFINA_NETWORK_CONFIG_H
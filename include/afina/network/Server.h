@@ -4,6 +4,8 @@
 #include <memory>
 #include <vector>
 
+#include <afina/network/Config.h>
+
 namespace Afina {
 class Storage;
 namespace Logging {
@@ -17,8 +19,9 @@ namespace Network {
  */
 class Server {
 public:
-    Server(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Afina::Logging::Service> pl)
-        : pStorage(ps), pLogging(pl) {}
+    Server(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Afina::Logging::Service> pl,
+           std::shared_ptr<Config> pc)
+        : pStorage(ps), pLogging(pl), pConfig(pc) {}
     virtual ~Server() {}
 
     /**
@@ -44,6 +47,13 @@ public:
      */
     virtual void Join() = 0;
 
+    /**
+     * Listening sockets of the running server, so they could be passed to the new process on
+     * graceful restart. Server must stop accepting on Stop without shutting these sockets down,
+     * as they keep serving in the other process. Empty if server doesn't support that
+     */
+    virtual std::vector<int> ListenSockets() const { return std::vector<int>(); }
+
 protected:
     /**
      * Instance of backing storeage on which current server should execute
@@ -55,6 +65,11 @@ protected:
      * Logging service to be used in order to report application progress
      */
     std::shared_ptr<Afina::Logging::Service> pLogging;
+
+    /**
+     * Network tunables, see Config.h
+     */
+    std::shared_ptr<Config> pConfig;
 };
 
 } // namespace Network
@@ -0,0 +1,71 @@
+// Load generator for 127.0.0.1:8080: each of <conns> connections sends <requests> get commands in batches
+// of <depth> and waits for all responses before the next batch. Prints requests per second
+//
+// gcc -O2 -pthread -o load itest/load.c && ./load <conns> <requests> <depth>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+static int per, depth;
+static int conn() {
+    int s = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in a = {.sin_family = AF_INET, .sin_port = htons(8080)};
+    a.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (connect(s, (struct sockaddr *)&a, sizeof a)) { perror("connect"); exit(1); }
+    int one = 1;
+    setsockopt(s, IPPROTO_TCP, TCP_NODELAY, &one, sizeof one);
+    return s;
+}
+static void *run(void *arg) {
+    int s = conn();
+    char req[64 * 16], buf[65536];
+    int n = 0;
+    for (int i = 0; i < depth; i++) n += sprintf(req + n, "get key\r\n");
+    // Response is "VALUE key 0 5\r\nvalue\r\nEND\r\n"
+    const int resp = 27;
+    for (int done = 0; done < per; done += depth) {
+        if (write(s, req, n) != n) { perror("write"); exit(1); }
+        int want = resp * depth, got = 0;
+        while (got < want) {
+            int r = read(s, buf, sizeof buf);
+            if (r <= 0) { perror("read"); exit(1); }
+            got += r;
+        }
+    }
+    close(s);
+    return NULL;
+}
+int main(int argc, char **argv) {
+    if (argc != 4) {
+        fprintf(stderr, "Usage: %s <conns> <requests per connection> <depth>\n", argv[0]);
+        return 1;
+    }
+    int conns = atoi(argv[1]);
+    per = atoi(argv[2]);
+    depth = atoi(argv[3]);
+    int s = conn();
+    const char *set = "set key 0 0 5\r\nvalue\r\n";
+    char buf[64];
+    write(s, set, strlen(set));
+    read(s, buf, sizeof buf);
+    close(s);
+    if (conns < 1 || conns > 256 || depth < 1 || depth > 64 || per < depth) {
+        fprintf(stderr, "Bad arguments\n");
+        return 1;
+    }
+    pthread_t th[256];
+    struct timespec a, b;
+    clock_gettime(CLOCK_MONOTONIC, &a);
+    for (int i = 0; i < conns; i++) pthread_create(&th[i], NULL, run, NULL);
+    for (int i = 0; i < conns; i++) pthread_join(th[i], NULL);
+    clock_gettime(CLOCK_MONOTONIC, &b);
+    double t = (b.tv_sec - a.tv_sec) + (b.tv_nsec - a.tv_nsec) / 1e9;
+    printf("%d requests in %.2fs: %.0f req/s\n", conns * per, t, conns * per / t);
+    return 0;
+}
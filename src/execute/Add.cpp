@@ -1,16 +1,32 @@
 #include <afina/Storage.h>
 #include <afina/execute/Add.h>
+#include <afina/logging/Trace.h>
 
-#include <iostream>
+#include <utility>
 
 namespace Afina {
 namespace Execute {
 
+namespace {
+
+// Puts value together with its expiration time if key is absent, value is moved to the storage if it is an rvalue.
+// Returns response
+template <typename Value> const char *add(Storage &storage, const std::string &key, int32_t expire, Value &&value) {
+    AFINA_TRACE(spdlog::level::trace, "Add({}): {} bytes", key, value.size());
+    return storage.PutIfAbsent(key, std::forward<Value>(value), expire) ? "STORED" : "NOT_STORED";
+}
+
+} // namespace
+
 // memcached protocol:  "add" means "store this data, but only if the server *doesn't* already
 // hold data for this key".
 void Add::Execute(Storage &storage, const std::string &args, std::string &out) {
-    std::cout << "Add(" << _key << ")" << args << std::endl;
-    out = storage.PutIfAbsent(_key, args) ? "STORED" : "NOT_STORED";
+    out = add(storage, _key, _expire, args);
+}
+
+// See Add.h
+void Add::Execute(Storage &storage, std::string &&args, std::string &out) {
+    out = add(storage, _key, _expire, std::move(args));
 }
 
 } // namespace Execute
@@ -1,21 +1,21 @@
 #include <afina/Storage.h>
 #include <afina/execute/Append.h>
+#include <afina/logging/Trace.h>
 
-#include <iostream>
+#include <utility>
 
 namespace Afina {
 namespace Execute {
 
 // memcached protocol: "append" means "add this data to an existing key after existing data".
 void Append::Execute(Storage &storage, const std::string &args, std::string &out) {
-    std::cout << "Append(" << _key << ")" << args << std::endl;
-    std::string value;
-    if (!storage.Get(_key, value)) {
-        out.assign("NOT_STORED");
-        return;
-    }
-    storage.Put(_key, value + args);
-    out.assign("STORED");
+    AFINA_TRACE(spdlog::level::trace, "Append({}): {} bytes", _key, args.size());
+    // Item is changed in place, so it keeps expiration time and concurrent changes aren't lost
+    bool stored = storage.Update(_key, [&args](std::string &value) {
+        value.append(args);
+        return true;
+    });
+    out.assign(stored ? "STORED" : "NOT_STORED");
 }
 
 } // namespace Execute
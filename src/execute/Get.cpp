@@ -1,18 +1,23 @@
 #include <afina/Storage.h>
 #include <afina/execute/Get.h>
-
-#include <iostream>
-#include <iterator>
-#include <sstream>
+#include <afina/execute/ResponseBuilder.h>
+#include <afina/logging/Trace.h>
 
 namespace Afina {
 namespace Execute {
 
+namespace {
+
+// Upper bound of the item line beside key: "VALUE ", flags, size, cas and separators
+constexpr std::size_t kItemLine = 48;
+
+} // namespace
+
 /* memcached protocol:
 
 Each item sent by the server looks like this:
 
-VALUE <key> <flags> <bytes>\r\n
+VALUE <key> <flags> <bytes> [<cas unique>]\r\n
 <data block>\r\n
 
 After all the items have been transmitted, the server sends the string
@@ -22,22 +27,38 @@ to indicate the end of response.
 */
 
 void Get::Execute(Storage &storage, const std::string &args, std::string &out) {
-    std::stringstream keyStream;
-    copy(_keys.begin(), _keys.end(), std::ostream_iterator<std::string>(keyStream, " "));
-    std::cout << "Get(" << keyStream.str() << ")" << std::endl;
-
-    std::stringstream outStream;
-
+    AFINA_TRACE(spdlog::level::trace, "Get: {} keys", _keys.size());
+    ResponseBuilder response(out);
     std::string value;
     for (auto &key : _keys) {
         if (!storage.Get(key, value))
             continue;
-        outStream << "VALUE " << key << " 0 " << value.size() << "\r\n";
-        outStream << value << "\r\n";
+        response.Reserve(kItemLine + key.size() + value.size());
+        response.Append("VALUE ").Append(key).Append(" 0 ").Number(value.size()).Append(_cas ? " 0\r\n" : "\r\n");
+        response.Append(value).Append("\r\n");
     }
-    outStream << "END"; // networking layer should add the last \r\n
+    response.Append("END"); // networking layer should add the last \r\n
+}
 
-    out = outStream.str();
+void Get::ExecuteResponse(Storage &storage, const std::string &args, Response &out) {
+    AFINA_TRACE(spdlog::level::trace, "Get: {} keys", _keys.size());
+    ResponseBuilder response(out.text);
+    FileValue file;
+    for (auto &key : _keys) {
+        if (!storage.GetFile(key, out.value, file)) {
+            continue;
+        }
+        std::size_t size = file.fd == -1 ? out.value.size() : file.size;
+        response.Reserve(kItemLine + key.size() + (file.fd == -1 ? size : 0));
+        response.Append("VALUE ").Append(key).Append(" 0 ").Number(size).Append(_cas ? " 0\r\n" : "\r\n");
+        if (file.fd == -1) {
+            response.Append(out.value);
+        } else {
+            out.files.emplace_back(out.text.size(), std::move(file));
+        }
+        response.Append("\r\n");
+    }
+    response.Append("END"); // networking layer should add the last \r\n
 }
 
 } // namespace Execute
@@ -0,0 +1,24 @@
+#include <afina/Storage.h>
+#include <afina/execute/GetAndTouch.h>
+
+namespace Afina {
+namespace Execute {
+
+// See GetAndTouch.h
+void GetAndTouch::Execute(Storage &storage, const std::string &args, std::string &out) {
+    for (auto &key : keys()) {
+        storage.Touch(key, _expire);
+    }
+    Get::Execute(storage, args, out);
+}
+
+// See GetAndTouch.h
+void GetAndTouch::ExecuteResponse(Storage &storage, const std::string &args, Response &out) {
+    for (auto &key : keys()) {
+        storage.Touch(key, _expire);
+    }
+    Get::ExecuteResponse(storage, args, out);
+}
+
+} // namespace Execute
+} // namespace Afina
@@ -0,0 +1,92 @@
+#include <afina/Storage.h>
+#include <afina/execute/Incr.h>
+#include <afina/execute/ResponseBuilder.h>
+
+#include <charconv>
+
+namespace Afina {
+namespace Execute {
+
+namespace {
+
+// Parses decimal 64-bit unsigned number, returns false if value is anything else
+bool parse_value(const std::string &value, uint64_t &number) {
+    if (value.empty() || value.size() > 20) {
+        return false;
+    }
+    number = 0;
+    for (char c : value) {
+        unsigned digit = static_cast<unsigned char>(c) - '0';
+        if (digit > 9 || number > (UINT64_MAX - digit) / 10) {
+            return false;
+        }
+        number = number * 10 + digit;
+    }
+    return true;
+}
+
+} // namespace
+
+// See Incr.h
+Incr::Result Incr::Apply(Storage &storage, const std::string &key, uint64_t delta, bool decrement, bool create,
+                         uint64_t initial, uint64_t &value) {
+    // Value is changed under the storage lock, so concurrent changes of the key aren't lost. State is
+    // captured by a single reference to keep the callback small
+    struct {
+        uint64_t delta;
+        bool decrement;
+        bool number;
+        uint64_t &value;
+    } change{delta, decrement, true, value};
+    auto update = [&change](std::string &current) {
+        if (!parse_value(current, change.value)) {
+            change.number = false;
+            return false;
+        }
+        if (change.decrement) {
+            change.value = change.value > change.delta ? change.value - change.delta : 0;
+        } else {
+            change.value += change.delta;
+        }
+        char digits[24];
+        std::to_chars_result end = std::to_chars(digits, digits + sizeof(digits), change.value);
+        current.assign(digits, end.ptr - digits);
+        return true;
+    };
+
+    if (storage.Update(key, update)) {
+        return Result::Changed;
+    }
+    if (change.number && create) {
+        value = initial;
+        if (storage.PutIfAbsent(key, std::to_string(value))) {
+            return Result::Created;
+        }
+
+        // Someone else has created the key in between
+        if (storage.Update(key, update)) {
+            return Result::Changed;
+        }
+    }
+    return change.number ? Result::NotFound : Result::NotNumber;
+}
+
+// memcached protocol: "incr" and "decr" change item in place, the new value is the response
+void Incr::Execute(Storage &storage, const std::string &args, std::string &out) {
+    uint64_t value;
+    switch (Apply(storage, std::string(_key), _delta, _decrement, _create, _initial, value)) {
+    case Result::NotFound:
+        out.assign("NOT_FOUND");
+        break;
+    case Result::NotNumber:
+        out.assign("CLIENT_ERROR cannot increment or decrement non-numeric value");
+        break;
+    default:
+        out.clear();
+        ResponseBuilder(out).Number(value);
+        break;
+    }
+}
+
+} // namespace Execute
+} // namespace Afina
@@ -0,0 +1,48 @@
+#include <afina/Storage.h>
+#include <afina/execute/Incr.h>
+#include <afina/execute/MetaArithmetic.h>
+#include <afina/execute/ResponseBuilder.h>
+
+#include <charconv>
+#include <string_view>
+
+namespace Afina {
+namespace Execute {
+
+// See MetaArithmetic.h
+void MetaArithmetic::Execute(Storage &storage, const std::string &args, std::string &out) {
+    uint64_t value;
+    switch (Incr::Apply(storage, std::string(_key), _delta, _decrement, _create, _initial, value)) {
+    case Incr::Result::NotFound:
+        out.append("NF");
+        AppendFlags(out, _key);
+        return;
+    case Incr::Result::NotNumber:
+        out.append("CLIENT_ERROR cannot increment or decrement non-numeric value");
+        return;
+    default:
+        break;
+    }
+
+    if (_flags.quiet) {
+        return;
+    }
+    // Length of the number goes before it
+    char number[24];
+    std::to_chars_result end = std::to_chars(number, number + sizeof(number), value);
+    std::string_view digits(number, end.ptr - number);
+
+    ResponseBuilder response(out);
+    if (_flags.Has('v')) {
+        response.Append("VA ").Number(digits.size());
+    } else {
+        response.Append("HD");
+    }
+    AppendFlags(out, _key);
+    if (_flags.Has('v')) {
+        response.Append("\r\n").Append(digits); // networking layer should add the last \r\n
+    }
+}
+
+} // namespace Execute
+} // namespace Afina
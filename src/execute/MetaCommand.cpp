@@ -0,0 +1,19 @@
+#include <afina/execute/MetaCommand.h>
+#include <afina/execute/ResponseBuilder.h>
+
+namespace Afina {
+namespace Execute {
+
+// See MetaCommand.h
+void MetaCommand::AppendFlags(std::string &out, std::string_view key) const {
+    ResponseBuilder response(out);
+    if (_flags.Has('k')) {
+        response.Append(" k").Append(key);
+    }
+    if (!_flags.opaque.empty()) {
+        response.Append(" O").Append(_flags.opaque);
+    }
+}
+
+} // namespace Execute
+} // namespace Afina
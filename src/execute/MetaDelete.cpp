@@ -0,0 +1,18 @@
+#include <afina/Storage.h>
+#include <afina/execute/MetaDelete.h>
+
+namespace Afina {
+namespace Execute {
+
+// See MetaDelete.h
+void MetaDelete::Execute(Storage &storage, const std::string &args, std::string &out) {
+    bool deleted = storage.Delete(_key);
+    if (_flags.quiet) {
+        return;
+    }
+    out.append(deleted ? "HD" : "NF");
+    AppendFlags(out, _key);
+}
+
+} // namespace Execute
+} // namespace Afina
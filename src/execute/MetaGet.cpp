@@ -0,0 +1,74 @@
+#include <afina/Storage.h>
+#include <afina/execute/MetaGet.h>
+#include <afina/execute/ResponseBuilder.h>
+
+namespace Afina {
+namespace Execute {
+
+// See MetaGet.h
+void MetaGet::Execute(Storage &storage, const std::string &args, std::string &out) {
+    std::string value;
+    if (!storage.Get(_key, value)) {
+        if (!_flags.quiet) {
+            out.append("EN");
+        }
+        return;
+    }
+    AppendItem(out, value.size());
+    if (_flags.Has('v')) {
+        out.append(value);
+    }
+}
+
+// See MetaGet.h
+void MetaGet::ExecuteResponse(Storage &storage, const std::string &args, Response &out) {
+    FileValue file;
+    if (!storage.GetFile(_key, out.value, file)) {
+        if (!_flags.quiet) {
+            out.text.append("EN");
+        }
+        return;
+    }
+    AppendItem(out.text, file.fd == -1 ? out.value.size() : file.size);
+    if (!_flags.Has('v')) {
+        return;
+    }
+    if (file.fd == -1) {
+        out.text.append(out.value);
+    } else {
+        out.files.emplace_back(out.text.size(), std::move(file));
+    }
+}
+
+// See MetaGet.h
+void MetaGet::AppendItem(std::string &out, std::size_t size) const {
+    ResponseBuilder response(out);
+    bool value = _flags.Has('v');
+
+    // Flags are short, only value is worth reserving for
+    response.Reserve(64 + _key.size() + _flags.opaque.size() + (value ? size : 0));
+    if (value) {
+        response.Append("VA ").Number(size);
+    } else {
+        response.Append("HD");
+    }
+    if (_flags.Has('s')) {
+        response.Append(" s").Number(size);
+    }
+    if (_flags.Has('f')) {
+        response.Append(" f0");
+    }
+    if (_flags.Has('t')) {
+        response.Append(" t-1");
+    }
+    if (_flags.Has('c')) {
+        response.Append(" c0");
+    }
+    AppendFlags(out, _key);
+    if (value) {
+        response.Append("\r\n"); // networking layer should add the last \r\n after data
+    }
+}
+
+} // namespace Execute
+} // namespace Afina
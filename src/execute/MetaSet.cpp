@@ -0,0 +1,53 @@
+#include <afina/Storage.h>
+#include <afina/execute/MetaSet.h>
+
+#include <utility>
+
+namespace Afina {
+namespace Execute {
+
+// See MetaSet.h
+template <typename Value> bool MetaSet::Store(Storage &storage, Value &&value) {
+    switch (_mode) {
+    case Mode::Set:
+        return storage.Put(_key, std::forward<Value>(value), _expire);
+    case Mode::Add:
+        return storage.PutIfAbsent(_key, std::forward<Value>(value), _expire);
+    case Mode::Replace:
+        return storage.Set(_key, std::forward<Value>(value), _expire);
+    case Mode::Append:
+        // Appended data keeps item expiration time
+        return storage.Update(_key, [&value](std::string &stored) {
+            stored.append(value);
+            return true;
+        });
+    case Mode::Prepend:
+        return storage.Update(_key, [&value](std::string &stored) {
+            stored.insert(0, value);
+            return true;
+        });
+    }
+    return false;
+}
+
+// See MetaSet.h
+void MetaSet::Execute(Storage &storage, const std::string &args, std::string &out) {
+    Respond(Store(storage, args), out);
+}
+
+// See MetaSet.h
+void MetaSet::Execute(Storage &storage, std::string &&args, std::string &out) {
+    Respond(Store(storage, std::move(args)), out);
+}
+
+// See MetaSet.h
+void MetaSet::Respond(bool stored, std::string &out) {
+    if (stored && _flags.quiet) {
+        return;
+    }
+    out.append(stored ? "HD" : "NS");
+    AppendFlags(out, _key);
+}
+
+} // namespace Execute
+} // namespace Afina
@@ -0,0 +1,20 @@
+#include <afina/Storage.h>
+#include <afina/execute/Prepend.h>
+
+#include <utility>
+
+namespace Afina {
+namespace Execute {
+
+// memcached protocol: "prepend" means "add this data to an existing key before existing data".
+void Prepend::Execute(Storage &storage, const std::string &args, std::string &out) {
+    // See Append
+    bool stored = storage.Update(_key, [&args](std::string &value) {
+        value.insert(0, args);
+        return true;
+    });
+    out.assign(stored ? "STORED" : "NOT_STORED");
+}
+
+} // namespace Execute
+} // namespace Afina
@@ -1,23 +1,34 @@
 #include <afina/Storage.h>
 #include <afina/execute/Replace.h>
+#include <afina/logging/Trace.h>
 
-#include <iostream>
+#include <utility>
 
 namespace Afina {
 namespace Execute {
 
+namespace {
+
+// Updates value together with its expiration time if key is there, value is moved to the storage if it is an
+// rvalue. Returns response
+template <typename Value>
+const char *replace(Storage &storage, const std::string &key, int32_t expire, Value &&value) {
+    AFINA_TRACE(spdlog::level::trace, "Replace({}): {} bytes", key, value.size());
+    return storage.Set(key, std::forward<Value>(value), expire) ? "STORED" : "NOT_STORED";
+}
+
+} // namespace
+
 // memcached protocol:  "replace" means "store this data, but only if the server *does*
 // already hold data for this key".
 
 void Replace::Execute(Storage &storage, const std::string &args, std::string &out) {
-    std::cout << "Replace(" << _key << "): " << args << std::endl;
-    std::string value;
-    if (storage.Get(_key, value)) {
-        storage.Set(_key, args);
-        out = "STORED";
-    } else {
-        out = "NOT_STORED";
-    }
+    out = replace(storage, _key, _expire, args);
+}
+
+// See Replace.h
+void Replace::Execute(Storage &storage, std::string &&args, std::string &out) {
+    out = replace(storage, _key, _expire, std::move(args));
 }
 
 } // namespace Execute
@@ -1,16 +1,30 @@
 #include <afina/Storage.h>
 #include <afina/execute/Set.h>
+#include <afina/logging/Trace.h>
 
-#include <iostream>
+#include <utility>
 
 namespace Afina {
 namespace Execute {
 
+namespace {
+
+// Puts value together with its expiration time, value is moved to the storage if it is an rvalue. Returns response
+template <typename Value> const char *put(Storage &storage, const std::string &key, int32_t expire, Value &&value) {
+    AFINA_TRACE(spdlog::level::trace, "Set({}): {} bytes", key, value.size());
+    return storage.Put(key, std::forward<Value>(value), expire) ? "STORED" : "NOT_STORED";
+}
+
+} // namespace
+
 // memcached protocol: "set" means "store this data".
 void Set::Execute(Storage &storage, const std::string &args, std::string &out) {
-    std::cout << "Set(" << _key << "): " << args << std::endl;
-    storage.Put(_key, args);
-    out = "STORED";
+    out = put(storage, _key, _expire, args);
+}
+
+// See Set.h
+void Set::Execute(Storage &storage, std::string &&args, std::string &out) {
+    out = put(storage, _key, _expire, std::move(args));
 }
 
 } // namespace Execute
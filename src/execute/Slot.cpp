@@ -0,0 +1,73 @@
+#include <afina/execute/Slot.h>
+
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+namespace Afina {
+namespace Execute {
+
+namespace {
+
+// True if command has its own ExecuteResponse, otherwise default one would just call Execute
+template <typename T>
+constexpr bool kOwnResponse = !std::is_same<decltype(&T::ExecuteResponse), decltype(&Command::ExecuteResponse)>::value;
+
+// Calls command of the known type directly, only plugged commands go through vtable. Argument is passed
+// on as rvalue if it is one
+template <typename Args> struct Dispatch {
+    Storage &storage;
+    Args &&args;
+    Response &out;
+
+    template <typename T> void operator()(T &command) const {
+        if constexpr (kOwnResponse<T>) {
+            command.T::ExecuteResponse(storage, args, out);
+        } else {
+            command.T::Execute(storage, std::forward<Args>(args), out.text);
+        }
+    }
+    void operator()(std::unique_ptr<Command> &command) const { command->ExecuteResponse(storage, args, out); }
+    void operator()(std::monostate &) const { throw std::runtime_error("No command to execute"); }
+};
+
+// Moves command to the heap
+struct Detach {
+    template <typename T> std::unique_ptr<Command> operator()(T &command) const {
+        return std::unique_ptr<Command>(new T(std::move(command)));
+    }
+    std::unique_ptr<Command> operator()(std::unique_ptr<Command> &command) const { return std::move(command); }
+    std::unique_ptr<Command> operator()(std::monostate &) const { return nullptr; }
+};
+
+} // namespace
+
+// See Slot.h
+void Slot::ExecuteResponse(Storage &storage, const std::string &args, Response &out) {
+    if (!_ready) {
+        throw std::runtime_error("No command to execute");
+    }
+    std::visit(Dispatch<const std::string &>{storage, args, out}, _command);
+}
+
+// See Slot.h
+void Slot::ExecuteResponse(Storage &storage, std::string &&args, Response &out) {
+    if (!_ready) {
+        throw std::runtime_error("No command to execute");
+    }
+    std::visit(Dispatch<std::string>{storage, std::move(args), out}, _command);
+}
+
+// See Slot.h
+std::unique_ptr<Command> Slot::Release() {
+    if (!_ready) {
+        return nullptr;
+    }
+    _ready = false;
+    std::unique_ptr<Command> command = std::visit(Detach(), _command);
+    _command = std::monostate();
+    return command;
+}
+
+} // namespace Execute
+} // namespace Afina
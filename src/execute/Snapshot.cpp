@@ -0,0 +1,21 @@
+#include <afina/Storage.h>
+#include <afina/execute/Snapshot.h>
+
+#include <stdexcept>
+
+namespace Afina {
+namespace Execute {
+
+// Snapshot is written in background, so OK means it has been scheduled
+void Snapshot::Execute(Storage &storage, const std::string &args, std::string &out) {
+    try {
+        storage.Snapshot();
+        out.assign("OK");
+    } catch (std::runtime_error &ex) {
+        out.assign("SERVER_ERROR ");
+        out.append(ex.what());
+    }
+}
+
+} // namespace Execute
+} // namespace Afina
@@ -1,14 +1,24 @@
 #include <afina/Storage.h>
+#include <afina/execute/ResponseBuilder.h>
 #include <afina/execute/Stats.h>
 
-#include <iostream>
-#include <iterator>
-#include <sstream>
+#include <utility>
+#include <vector>
 
 namespace Afina {
 namespace Execute {
 
-void Stats::Execute(Storage &storage, const std::string &args, std::string &out) { out.assign("END"); }
+void Stats::Execute(Storage &storage, const std::string &args, std::string &out) {
+    std::vector<std::pair<std::string, std::string>> stats;
+    storage.Stats(stats);
+
+    out.clear();
+    ResponseBuilder response(out);
+    for (auto &stat : stats) {
+        response.Append("STAT ").Append(stat.first).Append(' ').Append(stat.second).Append("\r\n");
+    }
+    response.Append("END");
+}
 
 } // namespace Execute
 } // namespace Afina
@@ -1,4 +1,6 @@
 #include <chrono>
+#include <functional>
+#include <initializer_list>
 #include <iostream>
 #include <memory>
 
@@ -12,15 +14,22 @@
 #include <afina/Storage.h>
 #include <afina/Version.h>
 #include <afina/logging/Service.h>
+#include <afina/logging/Trace.h>
+#include <afina/network/Config.h>
 #include <afina/network/Server.h>
 
 #include "logging/ServiceImpl.h"
+#include "network/common/Handoff.h"
 #include "network/mt_blocking/ServerImpl.h"
 #include "network/mt_nonblocking/ServerImpl.h"
 #include "network/st_blocking/ServerImpl.h"
 #include "network/st_coroutine/ServerImpl.h"
 #include "network/st_nonblocking/ServerImpl.h"
+#ifdef AFINA_HAVE_IO_URING
+#include "network/uring/ServerImpl.h"
+#endif
 
+#include "storage/SharedLRU.h"
 #include "storage/SimpleLRU.h"
 #include "storage/ThreadSafeSimpleLRU.h"
 #include "storage/StripedLRU.h"
@@ -44,6 +53,15 @@ public:
         logger.level = Logging::Logger::Level::WARNING;
         logger.appenders.push_back("console");
         logger.format = "[%H:%M:%S %z] [thread %t] [%n] [%l] %v";
+
+        // Trace points are off unless asked for, see Trace.h
+        if (options.count("trace-sample") > 0) {
+            traceSample = options["trace-sample"].as<uint32_t>();
+            Logging::Logger &trace = logConfig->loggers["trace"];
+            trace.level = Logging::Logger::Level::TRACE;
+            trace.appenders.push_back("console");
+            trace.format = logger.format;
+        }
         logService.reset(new Logging::ServiceImpl(logConfig));
 
         // Step 1: configure storage
@@ -57,7 +75,49 @@ public:
         } else if (storage_type == "mt_lru") {
             storage = std::make_shared<Afina::Backend::ThreadSafeSimplLRU>();
         } else if (storage_type == "mt_slru") {
-            storage = Afina::Backend::StripedLRU::BuildLRU();
+            std::size_t size = 64 * 1024 * 1024;
+            if (options.count("storage-size") > 0) {
+                size = options["storage-size"].as<std::size_t>();
+            }
+            auto striped = Afina::Backend::StripedLRU::BuildLRU(size);
+            if (options.count("snapshot") > 0) {
+                uint32_t period = 0;
+                if (options.count("snapshot-period") > 0) {
+                    period = options["snapshot-period"].as<uint32_t>();
+                }
+                striped->ConfigureSnapshot(options["snapshot"].as<std::string>(), std::chrono::seconds(period),
+                                           logService);
+            }
+            if (options.count("log") > 0) {
+                uint32_t sync = 0;
+                if (options.count("log-sync") > 0) {
+                    sync = options["log-sync"].as<uint32_t>();
+                }
+                striped->ConfigureLog(options["log"].as<std::string>(), std::chrono::milliseconds(sync), logService);
+            }
+            if (options.count("tier") > 0) {
+                std::size_t tier_size = 1024 * 1024 * 1024;
+                if (options.count("tier-size") > 0) {
+                    tier_size = options["tier-size"].as<std::size_t>();
+                }
+                std::size_t threshold = 8192;
+                if (options.count("tier-threshold") > 0) {
+                    threshold = options["tier-threshold"].as<std::size_t>();
+                }
+                striped->ConfigureTier(options["tier"].as<std::string>(), tier_size, threshold, logService);
+            }
+            storage = striped;
+        } else if (storage_type == "shm_lru") {
+            std::string name = "/afina";
+            if (options.count("shm-name") > 0) {
+                name = options["shm-name"].as<std::string>();
+            }
+            std::size_t size = 64 * 1024 * 1024;
+            if (options.count("shm-size") > 0) {
+                size = options["shm-size"].as<std::size_t>();
+            }
+            sharedStorage = std::make_shared<Afina::Backend::SharedLRU>(name, size);
+            storage = sharedStorage;
         } else {
             throw std::runtime_error("Unknown storage type");
         }
@@ -68,42 +128,116 @@ public:
             network_type = options["network"].as<std::string>();
         }
 
+        // uring backend has neither connection deadlines nor output backpressure, do not ignore them silently
+        if (network_type == "uring") {
+            for (const char *option : {"idle-timeout", "read-timeout", "write-timeout", "output-watermark",
+                                       "output-limit", "zerocopy", "fair-budget"}) {
+                if (options.count(option) > 0) {
+                    throw std::runtime_error(std::string("--") + option + " is not supported by uring network");
+                }
+            }
+        }
+
+        networkConfig.reset(new Network::Config);
+        networkConfig->reuse_port = options.count("reuseport") > 0;
+        if (options.count("idle-timeout") > 0) {
+            networkConfig->idle_timeout = options["idle-timeout"].as<uint32_t>();
+        }
+        if (options.count("read-timeout") > 0) {
+            networkConfig->read_timeout = options["read-timeout"].as<uint32_t>();
+        }
+        if (options.count("write-timeout") > 0) {
+            networkConfig->write_timeout = options["write-timeout"].as<uint32_t>();
+        }
+        if (options.count("output-watermark") > 0) {
+            networkConfig->output_high_watermark = options["output-watermark"].as<std::size_t>();
+        }
+        if (options.count("output-limit") > 0) {
+            networkConfig->output_limit = options["output-limit"].as<std::size_t>();
+        }
+        if (options.count("zerocopy") > 0) {
+            networkConfig->zerocopy_threshold = options["zerocopy"].as<std::size_t>();
+        }
+        if (options.count("fair-budget") > 0) {
+            networkConfig->fair_budget = options["fair-budget"].as<std::size_t>();
+        }
+        if (options.count("handoff") > 0) {
+            handoffPath = options["handoff"].as<std::string>();
+        }
+
         if (network_type == "st_block") {
-            server = std::make_shared<Afina::Network::STblocking::ServerImpl>(storage, logService);
+            server = std::make_shared<Afina::Network::STblocking::ServerImpl>(storage, logService, networkConfig);
         } else if (network_type == "mt_block") {
-            server = std::make_shared<Afina::Network::MTblocking::ServerImpl>(storage, logService);
+            server = std::make_shared<Afina::Network::MTblocking::ServerImpl>(storage, logService, networkConfig);
         } else if (network_type == "st_nonblock") {
-            server = std::make_shared<Afina::Network::STnonblock::ServerImpl>(storage, logService);
+            server = std::make_shared<Afina::Network::STnonblock::ServerImpl>(storage, logService, networkConfig);
         } else if (network_type == "mt_nonblock") {
-            server = std::make_shared<Afina::Network::MTnonblock::ServerImpl>(storage, logService);
+            server = std::make_shared<Afina::Network::MTnonblock::ServerImpl>(storage, logService, networkConfig);
+#ifdef AFINA_HAVE_IO_URING
+        } else if (network_type == "uring") {
+            server = std::make_shared<Afina::Network::Uring::ServerImpl>(storage, logService, networkConfig);
+#endif
         } else if (network_type == "st_coroutine") {
-            server = std::make_shared<Afina::Network::STcoroutine::ServerImpl>(storage, logService);
+            server = std::make_shared<Afina::Network::STcoroutine::ServerImpl>(storage, logService, networkConfig);
         } else {
             throw std::runtime_error("Unknown network type");
         }
     }
 
-    // Start services in correct order
-    void Start() {
+    // Start services in correct order, on_handoff is called once the next process took over
+    // listening sockets
+    void Start(std::function<void()> on_handoff) {
+        auto start = std::chrono::steady_clock::now();
         logService->Start();
         auto log = logService->select("root");
         log->warn("Start afina server {}", Afina::get_version());
+        if (traceSample > 0) {
+            // Request trace points are all at trace level
+            if (!Logging::Trace::CompiledIn(spdlog::level::trace)) {
+                log->warn("Request trace points are compiled out, --trace-sample does nothing: rebuild with "
+                          "AFINA_TRACE_LEVEL={}", static_cast<int>(spdlog::level::trace));
+            }
+            Logging::Trace::Setup(*logService, traceSample);
+        }
 
         log->warn("Start storage");
         storage->Start();
+        if (sharedStorage) {
+            if (!sharedStorage->Dropped().empty()) {
+                log->error("Shared storage dropped: {}", sharedStorage->Dropped());
+            }
+            log->warn("Shared storage attached with {} entries", sharedStorage->Recovered());
+        }
 
         // TODO: configure network service
         const uint16_t port = 8080;
+        if (!handoffPath.empty()) {
+            handoff.reset(new Network::Handoff(logService->select("network"), handoffPath));
+            networkConfig->inherited_sockets = handoff->Receive();
+        }
+
         log->warn("Start network on {}", port);
         server->Start(port, 2, 2);
+
+        if (handoff) {
+            handoff->Confirm(networkConfig->inherited_sockets);
+            handoff->Start(server, on_handoff);
+        }
+
+        auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+        log->warn("Ready to serve in {} ms", elapsed.count());
     }
 
     // Stop services in correct order
     void Stop() {
         auto log = logService->select("root");
         log->warn("Stop application");
+        if (handoff) {
+            handoff->Stop();
+        }
         server->Stop();
         server->Join();
+        Logging::Trace::Reset();
 
         storage->Stop();
         logService->Stop();
@@ -113,8 +247,17 @@ private:
     std::shared_ptr<Logging::Config> logConfig;
     std::shared_ptr<Logging::Service> logService;
 
+    // Every that many trace point hit is logged, tracing is off if 0
+    uint32_t traceSample = 0;
+
     std::shared_ptr<Afina::Storage> storage;
+    std::shared_ptr<Afina::Backend::SharedLRU> sharedStorage;
+    std::shared_ptr<Network::Config> networkConfig;
     std::shared_ptr<Network::Server> server;
+
+    // Graceful restart, see Handoff.h
+    std::string handoffPath;
+    std::unique_ptr<Network::Handoff> handoff;
 };
 
 // Signal set that to notify application about time to stop
@@ -135,6 +278,52 @@ int main(int argc, char **argv) {
         // and simplify validation below
         options.add_options()("s,storage", "Type of storage service to use", cxxopts::value<std::string>());
         options.add_options()("n,network", "Type of network service to use", cxxopts::value<std::string>());
+        options.add_options()("reuseport", "mt_nonblock: each worker owns a SO_REUSEPORT listener and epoll");
+        options.add_options()("idle-timeout", "Close connection silent for that many ms, 5 minutes by default, 0 "
+                                              "disables",
+                              cxxopts::value<uint32_t>());
+        options.add_options()("read-timeout", "Close connection not finished command in that many ms, 30 seconds by "
+                                              "default, 0 disables",
+                              cxxopts::value<uint32_t>());
+        options.add_options()("write-timeout", "Close connection not reading responses for that many ms, disabled by "
+                                               "default",
+                              cxxopts::value<uint32_t>());
+        options.add_options()("output-watermark", "Stop reading connection having that many bytes of responses",
+                              cxxopts::value<std::size_t>());
+        options.add_options()("output-limit", "Stop reading connections while server has that many bytes of responses",
+                              cxxopts::value<std::size_t>());
+        options.add_options()("zerocopy", "Send responses of that many bytes with MSG_ZEROCOPY, off by default",
+                              cxxopts::value<std::size_t>());
+        options.add_options()("fair-budget", "mt_nonblock: max commands per connection per loop turn, 0 is unlimited",
+                              cxxopts::value<std::size_t>());
+        options.add_options()("storage-size", "mt_slru: max size of keys and values, 64MB by default",
+                              cxxopts::value<std::size_t>());
+        options.add_options()("snapshot", "mt_slru: load snapshot from that file on start, save it there on stop "
+                                          "and by snapshot command",
+                              cxxopts::value<std::string>());
+        options.add_options()("snapshot-period", "mt_slru: also save snapshot every that many seconds",
+                              cxxopts::value<uint32_t>());
+        options.add_options()("log", "mt_slru: append every change to the log at that path prefix, replay on start",
+                              cxxopts::value<std::string>());
+        options.add_options()("log-sync", "mt_slru: sync log every that many ms, never by default",
+                              cxxopts::value<uint32_t>());
+        options.add_options()("tier", "mt_slru: keep large and cold values in files at that path prefix",
+                              cxxopts::value<std::string>());
+        options.add_options()("tier-size", "mt_slru: size of the file tier, 1GB by default",
+                              cxxopts::value<std::size_t>());
+        options.add_options()("tier-threshold", "mt_slru: values that long go to the file tier right away, "
+                                                "8KB by default",
+                              cxxopts::value<std::size_t>());
+        options.add_options()("shm-name", "shm_lru: name of the shared memory segment, /afina by default",
+                              cxxopts::value<std::string>());
+        options.add_options()("shm-size", "shm_lru: size of the new shared memory segment, 64MB by default",
+                              cxxopts::value<std::size_t>());
+        options.add_options()("handoff", "UNIX socket path to take listening sockets over from the running process and "
+                                         "pass them to the next one on restart",
+                              cxxopts::value<std::string>());
+        options.add_options()("trace-sample", "Log every that many hit of request trace points compiled in, "
+                                              "see AFINA_TRACE_LEVEL",
+                              cxxopts::value<uint32_t>());
         options.add_options()("h,help", "Print usage info");
         options.parse(argc, argv);
 
@@ -172,7 +361,7 @@ int main(int argc, char **argv) {
     // Run app
     try {
         // Start services
-        app.Start();
+        app.Start([]() { sem_post(&stop_semaphore); });
 
         // Freeze main thread until one of signals arrive
         while (stop_reason == 0 && ((sem_wait(&stop_semaphore) == -1) && (errno == EINTR))) {
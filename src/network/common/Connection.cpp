@@ -0,0 +1,188 @@
+#include "Connection.h"
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#include <sys/socket.h>
+
+#include <spdlog/logger.h>
+
+#include "Utils.h"
+
+namespace Afina {
+namespace Network {
+
+// See Connection.h
+void Connection::Start() {
+    _logger->debug("Start connection on descriptor {}", _socket);
+    _event.events = EPOLLIN | EPOLLRDHUP | EPOLLERR;
+}
+
+// See Connection.h
+void Connection::OnEvent(uint32_t events) {
+    if (events & EPOLLERR) {
+        // Zerocopy completions are reported as errors too
+        _logger->debug("Got EPOLLERR, value of returned events: {}", events);
+        DoErrorQueue();
+    }
+    if (!isAlive()) {
+        // Either failed or done with the last zerocopy send
+    } else if (events & EPOLLHUP) {
+        _logger->debug("Got EPOLLHUP, value of returned events: {}", events);
+        OnError();
+    } else if (events & EPOLLRDHUP) {
+        _logger->debug("Got EPOLLRDHUP, value of returned events: {}", events);
+        OnClose();
+    } else {
+        // Depends on what connection wants...
+        if (events & EPOLLIN) {
+            _logger->trace("Got EPOLLIN");
+            DoRead();
+        }
+        if (events & EPOLLOUT) {
+            _logger->trace("Got EPOLLOUT");
+            DoWrite();
+        }
+    }
+}
+
+// See Connection.h
+void Connection::OnError() {
+    _logger->debug("Connection on descriptor {} failed", _socket);
+    _output.Clear();
+    _alive = false;
+}
+
+// See Connection.h
+void Connection::DoErrorQueue() {
+    if (!_output.ErrorQueue(_socket)) {
+        OnError();
+        return;
+    }
+
+    // Connection which is done waits for its last zerocopy send to complete before close
+    if (_eof && _input.Empty() && _output.Empty() && !_output.Pending()) {
+        _alive = false;
+    }
+}
+
+// See Connection.h
+void Connection::OnClose() {
+    // Peer shutdown its side, but there still could be commands to execute and responses
+    // to send back
+    DoRead();
+}
+
+// See Connection.h
+void Connection::DoRead() {
+    _unfinished = false;
+    try {
+        std::size_t executed = 0;
+        bool full = false;
+        ssize_t readed_bytes = -1;
+        for (;;) {
+            // Commands left from the previous turn go first
+            if (!_input.Empty()) {
+                std::size_t remains = _budget > 0 ? _budget - executed : 0;
+                executed += _session.Process(_input, _output, _quota->HighWatermark(), remains);
+            }
+
+            if ((full = _quota->Full(_output.Size()))) {
+                break;
+            }
+            if (_budget > 0 && executed >= _budget) {
+                _unfinished = true;
+                break;
+            }
+            if ((readed_bytes = read_input(_socket, _session, _input, _output)) <= 0) {
+                break;
+            }
+            _logger->debug("Got {} bytes from socket", readed_bytes);
+        }
+
+        if (full || _unfinished) {
+            // Let the client catch up with responses or other connections to be served first
+        } else if (readed_bytes == 0) {
+            _logger->debug("Connection closed");
+            _eof = true;
+        } else if (errno != EAGAIN && errno != EWOULDBLOCK) {
+            throw std::runtime_error(std::string(strerror(errno)));
+        }
+    } catch (std::runtime_error &ex) {
+        _logger->error("Failed to process connection on descriptor {}: {}", _socket, ex.what());
+        OnError();
+        return;
+    }
+
+    // Nothing more to read, but responses still have to be delivered
+    if (_eof) {
+        _event.events &= ~(EPOLLIN | EPOLLRDHUP);
+    }
+
+    // Input ran dry, send whole batch of responses at once
+    DoWrite();
+}
+
+// See Connection.h
+void Connection::DoWrite() {
+    for (;;) {
+        if (!_output.Flush(_socket)) {
+            _logger->error("Failed to send response on descriptor {}: {}", _socket, strerror(errno));
+            OnError();
+            return;
+        }
+        UpdateBackpressure();
+
+        // Commands left in the input buffer when output got full, epoll knows nothing about them
+        if (_paused || _input.Empty()) {
+            break;
+        }
+        if (_budget > 0) {
+            // Server has to give connection a turn
+            _unfinished = true;
+            break;
+        }
+        try {
+            _session.Process(_input, _output, _quota->HighWatermark());
+        } catch (std::runtime_error &ex) {
+            _logger->error("Failed to process connection on descriptor {}: {}", _socket, ex.what());
+            OnError();
+            return;
+        }
+    }
+
+    if (_output.Empty()) {
+        _event.events &= ~EPOLLOUT;
+        if (_eof && _input.Empty() && !_output.Pending()) {
+            _alive = false;
+        }
+    } else {
+        _event.events |= EPOLLOUT;
+    }
+}
+
+// See Connection.h
+void Connection::UpdateBackpressure() {
+    if (!_paused && _quota->Full(_output.Size())) {
+        _logger->debug("Pause reading on descriptor {}: {} bytes of output pending", _socket, _output.Size());
+        _paused = true;
+        _quota->Pause(_quota->Exhausted());
+    } else if (_paused && _quota->Drained(_output.Size())) {
+        _logger->debug("Resume reading on descriptor {}", _socket);
+        _paused = false;
+    }
+
+    // Once peer closed its side there is nothing to read anyway
+    if (_eof) {
+        return;
+    }
+    if (_paused) {
+        _event.events &= ~(EPOLLIN | EPOLLRDHUP);
+    } else {
+        _event.events |= EPOLLIN | EPOLLRDHUP;
+    }
+}
+
+} // namespace Network
+} // namespace Afina
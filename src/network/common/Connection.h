@@ -0,0 +1,110 @@
+#ifndef AFINA_NETWORK_COMMON_CONNECTION_H
+#define AFINA_NETWORK_COMMON_CONNECTION_H
+
+#include <cstddef>
+#include <cstring>
+#include <memory>
+
+#include <sys/epoll.h>
+
+#include "ConnectionTimer.h"
+#include "InputBuffer.h"
+#include "OutputBuffer.h"
+#include "OutputQuota.h"
+#include "Session.h"
+
+namespace spdlog {
+class logger;
+}
+
+namespace Afina {
+namespace Network {
+
+/**
+ * # Non-blocking connection served by epoll loop
+ * Reads commands, executes them and writes responses back, keeping events it waits for in
+ * _event. Servers differ only in how they run the loop, so each one derives its own connection
+ * to befriend its loop and to keep the state loop needs. Owner is that derived connection: epoll
+ * event and timer refer it, so server gets it back from both
+ */
+class Connection {
+public:
+    Connection(void *owner, int s, std::shared_ptr<Afina::Storage> ps, std::shared_ptr<spdlog::logger> pl,
+               std::shared_ptr<OutputQuota> pq, std::size_t budget = 0)
+        : _socket(s), _alive(true), _eof(false), _paused(false), _budget(budget), _unfinished(false), _logger(pl),
+          _quota(pq), _session(ps, pl), _output(pq.get()), _timer(owner) {
+        std::memset(&_event, 0, sizeof(struct epoll_event));
+        _event.data.ptr = owner;
+    }
+
+    inline bool isAlive() const { return _alive; }
+
+    void Start();
+
+protected:
+    /**
+     * Serves events epoll reported for the connection socket
+     */
+    void OnEvent(uint32_t events);
+
+    void OnError();
+    void OnClose();
+
+    /**
+     * Handles EPOLLERR: collects zerocopy completions or fails connection if that is a real error
+     */
+    void DoErrorQueue();
+
+    /**
+     * Executes commands left from the previous turn, then reads and executes new ones till
+     * socket is drained or budget is spent. In the latter case connection is unfinished and
+     * needs another turn even if socket has nothing more
+     */
+    void DoRead();
+
+    /**
+     * Sends pending responses. Commands left in the input buffer once output drained are
+     * executed right away if budget is unlimited, otherwise connection is left unfinished
+     */
+    void DoWrite();
+
+    /**
+     * Stops or resumes reading input depending on amount of output waiting for the client,
+     * see OutputQuota
+     */
+    void UpdateBackpressure();
+
+    int _socket;
+    struct epoll_event _event;
+
+    // Connection should be closed by the server
+    bool _alive;
+
+    // Peer has nothing to send anymore, connection closes once output drained
+    bool _eof;
+
+    // Too much output is pending, input is not read until it drains
+    bool _paused;
+
+    // Max number of commands executed per turn, 0 if unlimited
+    std::size_t _budget;
+
+    // Budget is spent, but there could be more commands to execute
+    bool _unfinished;
+
+    std::shared_ptr<spdlog::logger> _logger;
+    std::shared_ptr<OutputQuota> _quota;
+
+    // Protocol state, unparsed input and responses waiting to be sent
+    Session _session;
+    InputBuffer _input;
+    OutputBuffer _output;
+
+    // Deadline in the server's timer wheel
+    ConnectionTimer _timer;
+};
+
+} // namespace Network
+} // namespace Afina
+
+#endif // AFINA_NETWORK_COMMON_CONNECTION_H
@@ -0,0 +1,41 @@
+#include "ConnectionTimer.h"
+
+#include <afina/network/Config.h>
+
+#include "OutputBuffer.h"
+#include "Session.h"
+
+namespace Afina {
+namespace Network {
+
+// See ConnectionTimer.h
+void ConnectionTimer::Update(TimerWheel &wheel, const Config &config, const Session &session,
+                             const OutputBuffer &output, uint64_t now_ms) {
+    Kind kind = kIdle;
+    uint32_t timeout = config.idle_timeout;
+    if (!output.Empty()) {
+        kind = kWrite;
+        timeout = config.write_timeout;
+        if (_kind == kWrite && _sent == output.Sent() && Armed()) {
+            return;
+        }
+        _sent = output.Sent();
+    } else if (session.Pending()) {
+        // Whole command must arrive in time, trickling bytes doesn't help
+        kind = kRead;
+        timeout = config.read_timeout;
+        if (_kind == kRead && Armed()) {
+            return;
+        }
+    }
+
+    _kind = kind;
+    if (timeout == 0) {
+        wheel.Cancel(this);
+    } else {
+        wheel.Arm(this, now_ms + timeout);
+    }
+}
+
+} // namespace Network
+} // namespace Afina
@@ -0,0 +1,51 @@
+#ifndef AFINA_NETWORK_COMMON_CONNECTION_TIMER_H
+#define AFINA_NETWORK_COMMON_CONNECTION_TIMER_H
+
+#include <cstdint>
+
+#include "TimerWheel.h"
+
+namespace Afina {
+namespace Network {
+
+class Config;
+class OutputBuffer;
+class Session;
+
+/**
+ * # Deadline of a single connection
+ * Picks one of idle/read/write timeouts from Config depending on what connection waits for
+ * and keeps it armed in the worker's wheel. Timer knows connection it belongs to, so
+ * server could find connection by expired timer
+ */
+class ConnectionTimer : public TimerWheel::Timer {
+public:
+    explicit ConnectionTimer(void *owner) : _owner(owner), _kind(kNone), _sent(0) {}
+
+    void *Owner() const { return _owner; }
+
+    /**
+     * Re-arms timer after connection has been served. Idle deadline moves on every call.
+     * Read deadline is armed once command starts and stays till it is complete. Write
+     * deadline moves only if some output has been sent since it was armed, so client which
+     * keeps sending requests but never reads responses still gets closed
+     */
+    void Update(TimerWheel &wheel, const Config &config, const Session &session, const OutputBuffer &output,
+                uint64_t now_ms);
+
+private:
+    enum Kind { kNone, kIdle, kRead, kWrite };
+
+    void *_owner;
+
+    // Deadline currently armed
+    Kind _kind;
+
+    // Output sent when write deadline has been armed
+    uint64_t _sent;
+};
+
+} // namespace Network
+} // namespace Afina
+
+#endif // AFINA_NETWORK_COMMON_CONNECTION_TIMER_H
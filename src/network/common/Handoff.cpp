@@ -0,0 +1,300 @@
+#include "Handoff.h"
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <spdlog/logger.h>
+
+#include <afina/network/Server.h>
+
+namespace Afina {
+namespace Network {
+
+namespace {
+
+// Marks handoff message, so random process listening on the path is not trusted
+constexpr uint32_t kMagic = 0x4146484f;
+
+// Max number of sockets passed by the single message
+constexpr std::size_t kMaxSockets = 64;
+
+// How long new process may take to start serving on the received sockets
+constexpr int kConfirmTimeoutMs = 30000;
+
+// How long previous process may take to answer
+constexpr int kReceiveTimeoutSec = 5;
+
+struct Header {
+    uint32_t magic;
+    uint32_t count;
+};
+
+struct sockaddr_un make_address(const std::string &path) {
+    struct sockaddr_un addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(addr.sun_path)) {
+        throw std::runtime_error("Handoff socket path is too long: " + path);
+    }
+    std::memcpy(addr.sun_path, path.c_str(), path.size());
+    return addr;
+}
+
+} // namespace
+
+// See Handoff.h
+Handoff::Handoff(std::shared_ptr<spdlog::logger> pl, const std::string &path)
+    : _logger(pl), _path(path), _peer(-1), _listen_socket(-1), _event_fd(-1), _handed_over(false) {}
+
+// See Handoff.h
+Handoff::~Handoff() {
+    Stop();
+    if (_peer != -1) {
+        close(_peer);
+    }
+}
+
+// See Handoff.h
+std::vector<int> Handoff::Receive() {
+    struct sockaddr_un addr = make_address(_path);
+    int peer = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (peer == -1) {
+        throw std::runtime_error("Failed to open handoff socket: " + std::string(strerror(errno)));
+    }
+
+    // Nobody is there, that is the first process
+    if (connect(peer, (struct sockaddr *)&addr, sizeof(addr)) == -1) {
+        int err = errno;
+        close(peer);
+        if (err == ENOENT || err == ECONNREFUSED) {
+            return std::vector<int>();
+        }
+        throw std::runtime_error("Failed to connect handoff socket: " + std::string(strerror(err)));
+    }
+
+    struct timeval tv;
+    tv.tv_sec = kReceiveTimeoutSec;
+    tv.tv_usec = 0;
+    setsockopt(peer, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+
+    Header header;
+    struct iovec iov;
+    iov.iov_base = &header;
+    iov.iov_len = sizeof(header);
+
+    char control[CMSG_SPACE(kMaxSockets * sizeof(int))];
+    struct msghdr msg;
+    std::memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+
+    ssize_t n = recvmsg(peer, &msg, MSG_WAITALL | MSG_CMSG_CLOEXEC);
+    if (n == -1) {
+        int err = errno;
+        close(peer);
+        throw std::runtime_error("Failed to receive listening sockets: " + std::string(strerror(err)));
+    }
+
+    // Sockets are ours once message is received, even if it turns out to be broken
+    std::vector<int> sockets;
+    for (struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg); cmsg != nullptr; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+        if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS) {
+            std::size_t count = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+            const int *fds = reinterpret_cast<const int *>(CMSG_DATA(cmsg));
+            sockets.insert(sockets.end(), fds, fds + count);
+        }
+    }
+
+    if (n != sizeof(header) || header.magic != kMagic || header.count != sockets.size() ||
+        (msg.msg_flags & MSG_CTRUNC)) {
+        for (int fd : sockets) {
+            close(fd);
+        }
+        close(peer);
+        throw std::runtime_error("Running process refused to hand listening sockets over");
+    }
+
+    _logger->warn("Received {} listening sockets from the running process", sockets.size());
+    _peer = peer;
+    return sockets;
+}
+
+// See Handoff.h
+void Handoff::Confirm(std::vector<int> &unused) {
+    if (!unused.empty()) {
+        _logger->warn("Close {} inherited listening sockets not used by the server", unused.size());
+        for (int fd : unused) {
+            close(fd);
+        }
+        unused.clear();
+    }
+
+    if (_peer == -1) {
+        return;
+    }
+    char ack = 1;
+    if (send(_peer, &ack, 1, MSG_NOSIGNAL) != 1) {
+        _logger->error("Failed to confirm handoff: {}", strerror(errno));
+    }
+    close(_peer);
+    _peer = -1;
+}
+
+// See Handoff.h
+void Handoff::Start(std::shared_ptr<Server> server, std::function<void()> on_done) {
+    struct sockaddr_un addr = make_address(_path);
+    _listen_socket = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (_listen_socket == -1) {
+        throw std::runtime_error("Failed to open handoff socket: " + std::string(strerror(errno)));
+    }
+
+    // Path may be left by the previous process, it doesn't listen there anymore
+    unlink(_path.c_str());
+    if (bind(_listen_socket, (struct sockaddr *)&addr, sizeof(addr)) == -1 || listen(_listen_socket, 1) == -1) {
+        int err = errno;
+        close(_listen_socket);
+        _listen_socket = -1;
+        throw std::runtime_error("Failed to listen handoff socket " + _path + ": " + std::string(strerror(err)));
+    }
+
+    _event_fd = eventfd(0, EFD_CLOEXEC);
+    if (_event_fd == -1) {
+        throw std::runtime_error("Failed to create event file descriptor: " + std::string(strerror(errno)));
+    }
+
+    _thread = std::thread(&Handoff::OnRun, this, server, on_done);
+}
+
+// See Handoff.h
+void Handoff::Stop() {
+    if (_thread.joinable()) {
+        if (eventfd_write(_event_fd, 1)) {
+            throw std::runtime_error("Failed to wakeup handoff thread");
+        }
+        _thread.join();
+    }
+
+    if (_listen_socket != -1) {
+        close(_listen_socket);
+        _listen_socket = -1;
+
+        // Next process owns the path now
+        if (!_handed_over) {
+            unlink(_path.c_str());
+        }
+    }
+    if (_event_fd != -1) {
+        close(_event_fd);
+        _event_fd = -1;
+    }
+}
+
+// See Handoff.h
+void Handoff::OnRun(std::shared_ptr<Server> server, std::function<void()> on_done) {
+    struct pollfd fds[2];
+    fds[0].fd = _event_fd;
+    fds[0].events = POLLIN;
+    fds[1].fd = _listen_socket;
+    fds[1].events = POLLIN;
+
+    for (;;) {
+        if (poll(fds, 2, -1) == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            _logger->error("Handoff poll failed: {}", strerror(errno));
+            return;
+        }
+        if (fds[0].revents) {
+            return;
+        }
+        if (!fds[1].revents) {
+            continue;
+        }
+
+        int peer = accept4(_listen_socket, nullptr, nullptr, SOCK_CLOEXEC);
+        if (peer == -1) {
+            continue;
+        }
+
+        _logger->warn("Next process asks for listening sockets");
+        bool done = HandOver(peer, server->ListenSockets());
+        close(peer);
+        if (done) {
+            _logger->warn("Listening sockets are handed over, stop serving");
+            _handed_over = true;
+            on_done();
+            return;
+        }
+    }
+}
+
+// See Handoff.h
+bool Handoff::HandOver(int peer, const std::vector<int> &sockets) {
+    if (sockets.empty() || sockets.size() > kMaxSockets) {
+        _logger->error("Server can't hand {} listening sockets over", sockets.size());
+        return false;
+    }
+
+    Header header;
+    header.magic = kMagic;
+    header.count = sockets.size();
+    struct iovec iov;
+    iov.iov_base = &header;
+    iov.iov_len = sizeof(header);
+
+    char control[CMSG_SPACE(kMaxSockets * sizeof(int))];
+    std::memset(control, 0, sizeof(control));
+    struct msghdr msg;
+    std::memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = CMSG_SPACE(sockets.size() * sizeof(int));
+
+    struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sockets.size() * sizeof(int));
+    std::memcpy(CMSG_DATA(cmsg), sockets.data(), sockets.size() * sizeof(int));
+
+    if (sendmsg(peer, &msg, MSG_NOSIGNAL) != sizeof(header)) {
+        _logger->error("Failed to send listening sockets: {}", strerror(errno));
+        return false;
+    }
+
+    // Both processes accept connections till the next one confirms it is ready. If it dies
+    // instead then it is up to this process to serve
+    struct pollfd fds[2];
+    fds[0].fd = _event_fd;
+    fds[0].events = POLLIN;
+    fds[1].fd = peer;
+    fds[1].events = POLLIN;
+    int ready;
+    while ((ready = poll(fds, 2, kConfirmTimeoutMs)) == -1 && errno == EINTR) {
+    }
+    if (ready <= 0 || fds[0].revents) {
+        _logger->error("Next process didn't confirm handoff, keep serving");
+        return false;
+    }
+
+    char ack = 0;
+    if (recv(peer, &ack, 1, 0) != 1 || ack != 1) {
+        _logger->error("Next process failed to start, keep serving");
+        return false;
+    }
+    return true;
+}
+
+} // namespace Network
+} // namespace Afina
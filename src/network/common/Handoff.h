@@ -0,0 +1,93 @@
+#ifndef AFINA_NETWORK_COMMON_HANDOFF_H
+#define AFINA_NETWORK_COMMON_HANDOFF_H
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace spdlog {
+class logger;
+}
+
+namespace Afina {
+namespace Network {
+
+class Server;
+
+/**
+ * # Listening sockets handoff
+ * Lets new process take over listening sockets of the running one on restart, so the port is
+ * never closed and no connection gets refused:
+ * - running process waits on the UNIX socket at the given path
+ * - new process connects and receives listening sockets by SCM_RIGHTS message
+ * - new process starts the server on them and confirms by a single byte
+ * - running process stops: it accepts no more connections, drains existing ones and exits
+ * If new process dies before confirmation then running one keeps serving as if nothing happened
+ */
+class Handoff {
+public:
+    Handoff(std::shared_ptr<spdlog::logger> pl, const std::string &path);
+    ~Handoff();
+
+    /**
+     * Asks process waiting on the path for its listening sockets. Returns empty vector if there is
+     * no such process. Throws std::runtime_error if process is there but handoff failed
+     */
+    std::vector<int> Receive();
+
+    /**
+     * Tells previous process that its sockets are served now. Sockets server didn't take are
+     * closed, connections waiting in their queues are lost
+     */
+    void Confirm(std::vector<int> &unused);
+
+    /**
+     * Starts thread waiting for the next process on the path. Once it confirms that sockets of
+     * the given server are taken over on_done is called and thread exits
+     */
+    void Start(std::shared_ptr<Server> server, std::function<void()> on_done);
+
+    /**
+     * Stops waiting for the next process
+     */
+    void Stop();
+
+private:
+    Handoff(const Handoff &) = delete;
+    Handoff &operator=(const Handoff &) = delete;
+
+    /**
+     * Method executing by background thread
+     */
+    void OnRun(std::shared_ptr<Server> server, std::function<void()> on_done);
+
+    /**
+     * Sends sockets to the next process and waits for confirmation, returns true on success
+     */
+    bool HandOver(int peer, const std::vector<int> &sockets);
+
+    std::shared_ptr<spdlog::logger> _logger;
+    std::string _path;
+
+    // Connection to the previous process, open between Receive and Confirm
+    int _peer;
+
+    // UNIX socket next process connects to
+    int _listen_socket;
+
+    // Wakes up background thread on Stop
+    int _event_fd;
+
+    // Path belongs to the next process already
+    std::atomic<bool> _handed_over;
+
+    std::thread _thread;
+};
+
+} // namespace Network
+} // namespace Afina
+
+#endif // AFINA_NETWORK_COMMON_HANDOFF_H
@@ -0,0 +1,46 @@
+#include "InputBuffer.h"
+
+#include <cstring>
+
+namespace Afina {
+namespace Network {
+
+// See InputBuffer.h
+InputBuffer::InputBuffer(std::size_t capacity)
+    : _buffer(new char[capacity]), _capacity(capacity), _head(0), _tail(0) {}
+
+// See InputBuffer.h
+void InputBuffer::Consume(std::size_t n) {
+    _head += n;
+    if (_head == _tail) {
+        _head = _tail = 0;
+    }
+}
+
+// See InputBuffer.h
+char *InputBuffer::Prepare(std::size_t &len, std::size_t min) {
+    if (_capacity - _tail < min) {
+        std::size_t size = Size();
+        if (_capacity - size < min) {
+            std::size_t capacity = _capacity;
+            while (capacity - size < min) {
+                capacity *= 2;
+            }
+
+            std::unique_ptr<char[]> buffer(new char[capacity]);
+            std::memcpy(buffer.get(), Data(), size);
+            _buffer.swap(buffer);
+            _capacity = capacity;
+        } else {
+            std::memmove(_buffer.get(), Data(), size);
+        }
+        _head = 0;
+        _tail = size;
+    }
+
+    len = _capacity - _tail;
+    return _buffer.get() + _tail;
+}
+
+} // namespace Network
+} // namespace Afina
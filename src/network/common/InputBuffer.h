@@ -0,0 +1,59 @@
+#ifndef AFINA_NETWORK_COMMON_INPUT_BUFFER_H
+#define AFINA_NETWORK_COMMON_INPUT_BUFFER_H
+
+#include <cstddef>
+#include <memory>
+
+namespace Afina {
+namespace Network {
+
+/**
+ * # Bytes read from the socket but not yet consumed
+ * Data is read into the free tail and consumed from the head in place: parser gets a
+ * pointer into the buffer and only moves the head forward. Nothing is moved once consumed,
+ * when everything got consumed buffer simply starts over from the beginning. The only
+ * copy happens when a partial message sits at the very end of the buffer and there is no
+ * space to read more, it is moved to the beginning once per read, not per command.
+ *
+ * Not thread safe, buffer belongs to a single connection
+ */
+class InputBuffer {
+public:
+    explicit InputBuffer(std::size_t capacity = 4096);
+
+    /**
+     * Unconsumed data
+     */
+    const char *Data() const { return _buffer.get() + _head; }
+    std::size_t Size() const { return _tail - _head; }
+    bool Empty() const { return _head == _tail; }
+
+    /**
+     * Drops first n bytes of data
+     */
+    void Consume(std::size_t n);
+
+    /**
+     * Returns free space at the end of the buffer where next bytes should be placed, at
+     * least min bytes long. Buffer grows if there is not enough space even after compaction
+     */
+    char *Prepare(std::size_t &len, std::size_t min = 1);
+
+    /**
+     * Marks n bytes written into the space returned by Prepare as data
+     */
+    void Commit(std::size_t n) { _tail += n; }
+
+private:
+    std::unique_ptr<char[]> _buffer;
+    std::size_t _capacity;
+
+    // Data lays in [_head, _tail)
+    std::size_t _head;
+    std::size_t _tail;
+};
+
+} // namespace Network
+} // namespace Afina
+
+#endif // AFINA_NETWORK_COMMON_INPUT_BUFFER_H
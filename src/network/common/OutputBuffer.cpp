@@ -0,0 +1,318 @@
+#include "OutputBuffer.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+
+#include <linux/errqueue.h>
+#include <netinet/in.h>
+#include <sys/sendfile.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include "OutputQuota.h"
+
+namespace Afina {
+namespace Network {
+
+namespace {
+
+// Number of chunks to be written by a single sendmsg call
+constexpr int kMaxIov = 64;
+
+// Zerocopy costs page pinning and a completion per send, it never pays off for chunks smaller than that.
+// Such chunks could also be stored inside std::string itself, so their memory moves along with it
+constexpr std::size_t kMinZerocopy = 16 * 1024;
+
+// Number of sent chunks kept for reuse
+constexpr std::size_t kMaxSpare = 8;
+
+// True if zerocopy send id is within [lo, hi], ids wrap around
+bool zerocopy_in(uint32_t id, uint32_t lo, uint32_t hi) { return id - lo <= hi - lo; }
+
+} // namespace
+
+// See OutputBuffer.h
+void OutputBuffer::Append(std::string &&data) {
+    if (data.empty()) {
+        return;
+    }
+    _size += data.size();
+    if (_quota != nullptr) {
+        _quota->Add(data.size());
+    }
+    _chunks.push_back(Chunk{std::move(data), FileValue{-1, 0, 0, nullptr}, false});
+}
+
+// See OutputBuffer.h
+void OutputBuffer::Append(std::string_view data) {
+    if (data.empty()) {
+        return;
+    }
+    _size += data.size();
+    if (_quota != nullptr) {
+        _quota->Add(data.size());
+    }
+
+    // Tail is appended to only if it doesn't reallocate, so its data sent meanwhile stays in place
+    if (!_chunks.empty()) {
+        Chunk &tail = _chunks.back();
+        if (tail.file.fd == -1 && !tail.zerocopy && tail.data.capacity() - tail.data.size() >= data.size()) {
+            tail.data.append(data.data(), data.size());
+            return;
+        }
+    }
+
+    std::string chunk;
+    if (!_spare.empty()) {
+        chunk.swap(_spare.back());
+        _spare.pop_back();
+    }
+    chunk.reserve(std::max(data.size(), kChunkSize));
+    chunk.assign(data.data(), data.size());
+    _chunks.push_back(Chunk{std::move(chunk), FileValue{-1, 0, 0, nullptr}, false});
+}
+
+// See OutputBuffer.h
+void OutputBuffer::Recycle(std::string &data) {
+    // Memory of large responses isn't kept
+    if (_spare.size() < kMaxSpare && data.capacity() >= kChunkSize && data.capacity() <= 2 * kChunkSize) {
+        data.clear();
+        _spare.push_back(std::move(data));
+    }
+}
+
+// See OutputBuffer.h
+void OutputBuffer::AppendFile(FileValue &&file) {
+    if (file.size == 0) {
+        return;
+    }
+    if (!_files) {
+        std::string data(file.size, '\0');
+        for (std::size_t done = 0; done < file.size;) {
+            ssize_t n = pread(file.fd, &data[done], file.size - done, file.offset + done);
+            if (n == -1 && errno == EINTR) {
+                continue;
+            }
+            if (n <= 0) {
+                throw std::runtime_error("Failed to read value: " + std::string(n == 0 ? "EOF" : strerror(errno)));
+            }
+            done += n;
+        }
+        Append(std::move(data));
+        return;
+    }
+
+    _size += file.size;
+    if (_quota != nullptr) {
+        _quota->Add(file.size);
+    }
+    _chunks.push_back(Chunk{std::string(), std::move(file), false});
+}
+
+// See OutputBuffer.h
+int OutputBuffer::Prepare(struct iovec *iov, int max) const {
+    // Large chunk is left for a zerocopy send of its own
+    std::size_t zerocopy = SIZE_MAX;
+    if (_quota != nullptr && _quota->ZerocopyThreshold() > 0 && _zc_state != ZerocopyState::Unsupported) {
+        zerocopy = std::max(_quota->ZerocopyThreshold(), kMinZerocopy);
+    }
+
+    int n = 0;
+    for (auto it = _chunks.begin(); it != _chunks.end() && it->file.fd == -1 && n < max; ++it, ++n) {
+        if (n > 0 && it->data.size() >= zerocopy) {
+            break;
+        }
+        std::size_t offset = (n == 0) ? _head_offset : 0;
+        iov[n].iov_base = const_cast<char *>(it->data.data()) + offset;
+        iov[n].iov_len = it->data.size() - offset;
+    }
+    return n;
+}
+
+// See OutputBuffer.h
+void OutputBuffer::Consume(std::size_t n) {
+    _size -= n;
+    _sent += n;
+    if (_quota != nullptr) {
+        _quota->Release(n);
+    }
+    while (n > 0) {
+        std::size_t left = _chunks.front().Size() - _head_offset;
+        if (n < left) {
+            _head_offset += n;
+            return;
+        }
+        n -= left;
+        _head_offset = 0;
+        if (_chunks.front().zerocopy) {
+            // Kernel is done with the chunk once its last send completes
+            _zc_buffers.emplace_back(_zc_next - 1, std::move(_chunks.front().data));
+        } else {
+            Recycle(_chunks.front().data);
+        }
+        _chunks.pop_front();
+    }
+}
+
+// See OutputBuffer.h
+bool OutputBuffer::Flush(int socket, bool more) {
+    struct iovec iov[kMaxIov];
+    while (!Empty()) {
+        ssize_t sent;
+        const FileValue &file = _chunks.front().file;
+        if (file.fd != -1) {
+            off_t offset = file.offset + _head_offset;
+            sent = sendfile(socket, file.fd, &offset, file.size - _head_offset);
+            if (sent == 0) {
+                // File is shorter than the value, response can't be completed
+                errno = EIO;
+                return false;
+            }
+        } else {
+            struct msghdr msg;
+            std::memset(&msg, 0, sizeof(msg));
+            msg.msg_iov = iov;
+            bool zerocopy = Zerocopy(socket);
+            msg.msg_iovlen = zerocopy ? Prepare(iov, 1) : Prepare(iov, kMaxIov);
+
+            // Tell kernel there is more to come unless it is the last portion of the batch
+            int flags = MSG_NOSIGNAL;
+            if (more || msg.msg_iovlen < _chunks.size()) {
+                flags |= MSG_MORE;
+            }
+            if (zerocopy) {
+                sent = sendmsg(socket, &msg, flags | MSG_ZEROCOPY);
+                if (sent > 0) {
+                    _zc_sends.push_back(ZerocopySend{_zc_next++, static_cast<std::size_t>(sent), false});
+                    _chunks.front().zerocopy = true;
+                } else if (sent < 0 && errno == ENOBUFS) {
+                    // Socket is out of memory for completions, data has to be copied
+                    sent = sendmsg(socket, &msg, flags);
+                    if (sent > 0) {
+                        _quota->Zerocopy(sent, true);
+                    }
+                }
+            } else {
+                sent = sendmsg(socket, &msg, flags);
+            }
+        }
+
+        if (sent < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return errno == EAGAIN || errno == EWOULDBLOCK;
+        }
+        Consume(sent);
+    }
+    return true;
+}
+
+// See OutputBuffer.h
+void OutputBuffer::Clear() {
+    if (_quota != nullptr) {
+        _quota->Release(_size);
+    }
+    for (auto &chunk : _chunks) {
+        if (!chunk.zerocopy) {
+            Recycle(chunk.data);
+        }
+    }
+    _chunks.clear();
+    _head_offset = 0;
+    _size = 0;
+    _zc_sends.clear();
+    _zc_buffers.clear();
+}
+
+// See OutputBuffer.h
+bool OutputBuffer::ErrorQueue(int socket) {
+    int error = 0;
+    socklen_t len = sizeof(error);
+    if (getsockopt(socket, SOL_SOCKET, SO_ERROR, &error, &len) == -1) {
+        return false;
+    }
+    if (error != 0 || _zc_state != ZerocopyState::Enabled) {
+        errno = error != 0 ? error : EIO;
+        return false;
+    }
+
+    char control[128];
+    for (;;) {
+        struct msghdr msg;
+        std::memset(&msg, 0, sizeof(msg));
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+        if (recvmsg(socket, &msg, MSG_ERRQUEUE) == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return errno == EAGAIN || errno == EWOULDBLOCK;
+        }
+
+        for (struct cmsghdr *cm = CMSG_FIRSTHDR(&msg); cm != nullptr; cm = CMSG_NXTHDR(&msg, cm)) {
+            if (!(cm->cmsg_level == SOL_IP && cm->cmsg_type == IP_RECVERR) &&
+                !(cm->cmsg_level == SOL_IPV6 && cm->cmsg_type == IPV6_RECVERR)) {
+                continue;
+            }
+            struct sock_extended_err err;
+            std::memcpy(&err, CMSG_DATA(cm), sizeof(err));
+            if (err.ee_errno == 0 && err.ee_origin == SO_EE_ORIGIN_ZEROCOPY) {
+                Complete(err.ee_info, err.ee_data, err.ee_code & SO_EE_CODE_ZEROCOPY_COPIED);
+            }
+        }
+    }
+}
+
+// See OutputBuffer.h
+void OutputBuffer::Abandon(int socket) {
+    if (!Pending()) {
+        return;
+    }
+    struct linger reset = {1, 0};
+    setsockopt(socket, SOL_SOCKET, SO_LINGER, &reset, sizeof(reset));
+}
+
+// See OutputBuffer.h
+bool OutputBuffer::Zerocopy(int socket) {
+    if (_quota == nullptr || _quota->ZerocopyThreshold() == 0 || _zc_state == ZerocopyState::Unsupported) {
+        return false;
+    }
+    const Chunk &head = _chunks.front();
+    if (head.data.size() - _head_offset < std::max(_quota->ZerocopyThreshold(), kMinZerocopy)) {
+        return false;
+    }
+
+    if (_zc_state == ZerocopyState::Unknown) {
+        int one = 1;
+        bool enabled = setsockopt(socket, SOL_SOCKET, SO_ZEROCOPY, &one, sizeof(one)) == 0;
+        _zc_state = enabled ? ZerocopyState::Enabled : ZerocopyState::Unsupported;
+    }
+    return _zc_state == ZerocopyState::Enabled;
+}
+
+// See OutputBuffer.h
+void OutputBuffer::Complete(uint32_t lo, uint32_t hi, bool copied) {
+    for (auto &send : _zc_sends) {
+        if (!send.done && zerocopy_in(send.id, lo, hi)) {
+            send.done = true;
+            _quota->Zerocopy(send.size, copied);
+        }
+    }
+    while (!_zc_sends.empty() && _zc_sends.front().done) {
+        _zc_sends.pop_front();
+    }
+
+    // Buffer is free once all sends up to its last one are completed
+    while (!_zc_buffers.empty() &&
+           (_zc_sends.empty() || static_cast<int32_t>(_zc_buffers.front().first - _zc_sends.front().id) < 0)) {
+        _zc_buffers.pop_front();
+    }
+}
+
+} // namespace Network
+} // namespace Afina
@@ -0,0 +1,194 @@
+#ifndef AFINA_NETWORK_COMMON_OUTPUT_BUFFER_H
+#define AFINA_NETWORK_COMMON_OUTPUT_BUFFER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include <afina/Storage.h>
+
+struct iovec;
+
+namespace Afina {
+namespace Network {
+
+class OutputQuota;
+
+/**
+ * # Responses waiting to be sent
+ * Large response is appended as a separate chunk, so it isn't copied. Small ones are copied to the end of
+ * the last chunk while there is room, chunk memory is reused once it is sent, so small responses cost no
+ * allocations. Whole batch goes to the socket with a single sendmsg call over iovec list, instead of a
+ * send call per command.
+ *
+ * Chunks never move in memory until consumed, so it is safe to pass pointers obtained
+ * from Prepare to kernel and keep appending new responses meanwhile: chunk is appended to only if
+ * that doesn't reallocate it
+ *
+ * Values kept in files are queued as file chunks and written by sendfile, so they go from page cache
+ * to the socket with no copy in user space. Memory chunks before them are sent with MSG_MORE, so headers
+ * share segments with the value
+ *
+ * Memory chunks over the quota's zerocopy threshold are sent alone with MSG_ZEROCOPY: kernel sends their
+ * pages instead of copying them and reports completion through the socket error queue, see ErrorQueue.
+ * Chunk memory is kept until then. If socket doesn't support zerocopy, buffer falls back to copy
+ */
+class OutputBuffer {
+public:
+    // Size of chunks small responses are copied to, responses shorter than that are better copied than
+    // queued as a chunk of their own
+    static constexpr std::size_t kChunkSize = 4 * 1024;
+
+    /**
+     * If quota is given, buffer reports there amount of data it holds. Buffer which is written by
+     * Prepare/Consume rather than Flush must be created with no files: it reads file chunks to memory
+     */
+    explicit OutputBuffer(OutputQuota *quota = nullptr, bool files = true)
+        : _quota(quota), _files(files), _head_offset(0), _size(0), _sent(0), _zc_state(ZerocopyState::Unknown),
+          _zc_next(0) {}
+    ~OutputBuffer() { Clear(); }
+
+    /**
+     * Queues response
+     */
+    void Append(std::string &&data);
+
+    /**
+     * Queues copy of the small response
+     */
+    void Append(std::string_view data);
+    void Append(const char *data) { Append(std::string_view(data)); }
+
+    /**
+     * Queues value kept in the file, pin is held until value is sent. Throws std::runtime_error if
+     * buffer has no files and value can't be read
+     */
+    void AppendFile(FileValue &&file);
+
+    /**
+     * True if there is nothing to send
+     */
+    bool Empty() const { return _size == 0; }
+
+    /**
+     * Number of bytes waiting to be sent
+     */
+    std::size_t Size() const { return _size; }
+
+    /**
+     * Number of bytes sent since buffer creation
+     */
+    uint64_t Sent() const { return _sent; }
+
+    /**
+     * Fills iov with at most max pending chunks up to the first file one, returns number of
+     * filled entries
+     */
+    int Prepare(struct iovec *iov, int max) const;
+
+    /**
+     * Drops first n bytes which have been written by the caller
+     */
+    void Consume(std::size_t n);
+
+    /**
+     * Writes as much as socket accepts. On non-blocking socket could leave part of the data
+     * in buffer. If more is set, kernel is told that more data is about to follow
+     * (MSG_MORE), so it could delay sending of partial segment.
+     *
+     * Returns false in case of socket error, errno describes the problem
+     */
+    bool Flush(int socket, bool more = false);
+
+    /**
+     * Drops all pending data
+     */
+    void Clear();
+
+    /**
+     * True if kernel still refers memory of zerocopy sends. Connection must not be closed gracefully
+     * before that, see Abandon
+     */
+    bool Pending() const { return !_zc_sends.empty(); }
+
+    /**
+     * Handles EPOLLERR: reads zerocopy completions from socket error queue and frees memory kernel is done
+     * with. Returns false if that is a real socket error or buffer had no zerocopy sends at all, errno
+     * describes the problem
+     */
+    bool ErrorQueue(int socket);
+
+    /**
+     * Resets connection which is closed while zerocopy sends are in flight, so kernel drops their pages
+     * rather than sends them after buffer is gone
+     */
+    void Abandon(int socket);
+
+private:
+    OutputBuffer(const OutputBuffer &) = delete;
+    OutputBuffer &operator=(const OutputBuffer &) = delete;
+
+    // Either data or file range
+    struct Chunk {
+        std::string data;
+        FileValue file;
+
+        // Some part of data has been sent with MSG_ZEROCOPY
+        bool zerocopy;
+
+        std::size_t Size() const { return file.fd == -1 ? data.size() : file.size; }
+    };
+
+    // Zerocopy send kernel hasn't completed yet
+    struct ZerocopySend {
+        uint32_t id;
+        std::size_t size;
+        bool done;
+    };
+
+    // True if head chunk should be sent with MSG_ZEROCOPY, enables zerocopy on the socket if needed
+    bool Zerocopy(int socket);
+
+    // Keeps memory of the sent chunk for the next ones, if it is worth that
+    void Recycle(std::string &data);
+
+    // Accounts completions of sends with ids from lo to hi
+    void Complete(uint32_t lo, uint32_t hi, bool copied);
+
+    OutputQuota *_quota;
+    bool _files;
+
+    std::deque<Chunk> _chunks;
+
+    // Memory of sent chunks, reused by the next ones
+    std::vector<std::string> _spare;
+
+    // Number of bytes of the first chunk already sent
+    std::size_t _head_offset;
+
+    // Total number of pending bytes
+    std::size_t _size;
+
+    uint64_t _sent;
+
+    // Whether socket supports zerocopy, checked on the first large send
+    enum class ZerocopyState { Unknown, Enabled, Unsupported };
+    ZerocopyState _zc_state;
+
+    // Id of the next zerocopy send, kernel numbers them from zero for every socket
+    uint32_t _zc_next;
+
+    // Sends not completed yet in the order of ids and consumed chunks kernel could still refer, each
+    // tagged by id of its last send
+    std::deque<ZerocopySend> _zc_sends;
+    std::deque<std::pair<uint32_t, std::string>> _zc_buffers;
+};
+
+} // namespace Network
+} // namespace Afina
+
+#endif // AFINA_NETWORK_COMMON_OUTPUT_BUFFER_H
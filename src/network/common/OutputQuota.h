@@ -0,0 +1,113 @@
+#ifndef AFINA_NETWORK_COMMON_OUTPUT_QUOTA_H
+#define AFINA_NETWORK_COMMON_OUTPUT_QUOTA_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace Afina {
+namespace Network {
+
+/**
+ * # Limits on responses buffered by a server
+ * Every output buffer of the server reports here how many bytes it holds, so server knows
+ * total amount of memory taken by responses waiting for slow clients. Connection stops
+ * reading new commands when its own output grows over high watermark or when total over
+ * the server passes the limit, see Config. Zerocopy threshold and counters live here as well,
+ * since that is the only server wide state output buffers see.
+ *
+ * Thread safe
+ */
+class OutputQuota {
+public:
+    OutputQuota(std::size_t high_watermark, std::size_t limit, std::size_t zerocopy_threshold = 0)
+        : _high_watermark(high_watermark), _limit(limit), _zerocopy_threshold(zerocopy_threshold), _buffered(0),
+          _peak(0), _paused(0), _throttled(0), _zerocopied(0), _copied(0) {}
+
+    /**
+     * True if connection holding that many bytes of output should stop reading input
+     */
+    bool Full(std::size_t size) const {
+        if (size == 0) {
+            // Connection with nothing to send gets no EPOLLOUT to resume on, so keep it reading
+            return false;
+        }
+        return (_high_watermark > 0 && size >= _high_watermark) || Exhausted();
+    }
+
+    /**
+     * True if connection paused with that many bytes of output could read input again. Half
+     * of the watermark must drain first, so connection doesn't flip on every send
+     */
+    bool Drained(std::size_t size) const {
+        if (size == 0) {
+            return true;
+        }
+        return (_high_watermark == 0 || size <= _high_watermark / 2) && !Exhausted();
+    }
+
+    /**
+     * Amount of output single connection could collect before it has to stop, 0 if unlimited
+     */
+    std::size_t HighWatermark() const { return _high_watermark; }
+
+    /**
+     * True if total amount of buffered output exceeds the limit
+     */
+    bool Exhausted() const { return _limit > 0 && _buffered.load(std::memory_order_relaxed) >= _limit; }
+
+    /**
+     * Accounts bytes added to or removed from some output buffer
+     */
+    void Add(std::size_t n) {
+        std::size_t total = _buffered.fetch_add(n, std::memory_order_relaxed) + n;
+        std::size_t peak = _peak.load(std::memory_order_relaxed);
+        while (total > peak && !_peak.compare_exchange_weak(peak, total, std::memory_order_relaxed)) {
+        }
+    }
+    void Release(std::size_t n) { _buffered.fetch_sub(n, std::memory_order_relaxed); }
+
+    /**
+     * Accounts connection which stopped reading, global tells if that happened because of
+     * the server wide limit
+     */
+    void Pause(bool global) { (global ? _throttled : _paused).fetch_add(1, std::memory_order_relaxed); }
+
+    /**
+     * Chunks of output that large are sent with MSG_ZEROCOPY, 0 if zerocopy is disabled
+     */
+    std::size_t ZerocopyThreshold() const { return _zerocopy_threshold; }
+
+    /**
+     * Accounts bytes of completed zerocopy send, copied tells if kernel or buffer had to fall back
+     * to copy them anyway
+     */
+    void Zerocopy(std::size_t n, bool copied) {
+        (copied ? _copied : _zerocopied).fetch_add(n, std::memory_order_relaxed);
+    }
+
+    // Statistics
+    std::size_t Buffered() const { return _buffered.load(std::memory_order_relaxed); }
+    std::size_t Peak() const { return _peak.load(std::memory_order_relaxed); }
+    uint64_t Paused() const { return _paused.load(std::memory_order_relaxed); }
+    uint64_t Throttled() const { return _throttled.load(std::memory_order_relaxed); }
+    uint64_t Zerocopied() const { return _zerocopied.load(std::memory_order_relaxed); }
+    uint64_t ZerocopyCopied() const { return _copied.load(std::memory_order_relaxed); }
+
+private:
+    const std::size_t _high_watermark;
+    const std::size_t _limit;
+    const std::size_t _zerocopy_threshold;
+
+    std::atomic<std::size_t> _buffered;
+    std::atomic<std::size_t> _peak;
+    std::atomic<uint64_t> _paused;
+    std::atomic<uint64_t> _throttled;
+    std::atomic<uint64_t> _zerocopied;
+    std::atomic<uint64_t> _copied;
+};
+
+} // namespace Network
+} // namespace Afina
+
+#endif // AFINA_NETWORK_COMMON_OUTPUT_QUOTA_H
@@ -0,0 +1,265 @@
+#include "Session.h"
+
+#include <algorithm>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+
+#include <spdlog/logger.h>
+
+#include <afina/Storage.h>
+#include <afina/execute/Command.h>
+
+#include "InputBuffer.h"
+#include "OutputBuffer.h"
+
+namespace Afina {
+namespace Network {
+
+namespace {
+
+// Argument and response buffers are reused by the next commands unless they grew beyond that
+constexpr std::size_t kMaxKeptArgument = 64 * 1024;
+
+// Response to the value storage could never keep, its data block is skipped
+const char kTooLarge[] = "SERVER_ERROR object too large for cache";
+
+} // namespace
+
+// See Session.h
+Session::Session(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<spdlog::logger> pl)
+    : _pStorage(ps), _logger(pl), mode(Mode::Unknown), arg_remains(0), arg_filled(0), partial(false),
+      reserved(false), rejected(false) {}
+
+// See Session.h
+Session::~Session() {}
+
+// See Session.h
+std::size_t Session::Process(const char *data, std::size_t size, OutputBuffer &out) {
+    std::size_t executed = 0;
+    Feed(data, size, out, 0, 0, executed);
+    return executed;
+}
+
+// See Session.h
+std::size_t Session::Process(InputBuffer &in, OutputBuffer &out, std::size_t max_output,
+                             std::size_t max_commands) {
+    std::size_t executed = 0;
+    in.Consume(Feed(in.Data(), in.Size(), out, max_output, max_commands, executed));
+    return executed;
+}
+
+// See Session.h
+std::size_t Session::Feed(const char *data, std::size_t size, OutputBuffer &out, std::size_t max_output,
+                          std::size_t max_commands, std::size_t &executed) {
+    std::size_t consumed = 0;
+    std::size_t limit = executed + max_commands;
+    while (size > 0) {
+        // Enough work for now, next command waits for the next call
+        if (!partial && max_output > 0 && out.Size() >= max_output) {
+            break;
+        }
+        if (!partial && max_commands > 0 && executed >= limit) {
+            break;
+        }
+
+        _logger->debug("Process {} bytes", size);
+        // There is no command yet
+        if (command_to_execute.Empty()) {
+            if (mode == Mode::Unknown) {
+                mode = static_cast<uint8_t>(data[0]) == Protocol::BinaryParser::kRequestMagic ? Mode::Binary
+                                                                                                : Mode::Text;
+            }
+
+            std::size_t parsed = 0;
+            if (mode == Mode::Binary) {
+                if (binary_parser.Parse(data, size, parsed)) {
+                    _logger->debug("Found new command: {} in {} bytes", binary_parser.Name(), parsed);
+                    binary_parser.Build(command_to_execute, arg_remains);
+                }
+            } else if (parser.Parse(data, size, parsed)) {
+                // There is no command to be launched, continue to parse input stream
+                // Here we are, current chunk finished some command, process it
+                _logger->debug("Found new command: {} in {} bytes", parser.Name(), parsed);
+                parser.Build(command_to_execute, arg_remains);
+                if (parser.HasBody()) {
+                    // Argument is followed by \r\n, empty one as well
+                    arg_remains += 2;
+                }
+            }
+            if (!command_to_execute.Empty() && arg_remains > 0) {
+                // Reserve space for the whole argument at once. Large argument is received straight into the
+                // place storage could keep it in and then handed over to the command, the rest goes through
+                // the buffer session reuses. Size is declared by client, so value storage could never keep
+                // allocates nothing: its bytes are skipped as they arrive
+                std::size_t terminator = mode == Mode::Text ? 2 : 0;
+                try {
+                    if (arg_remains - terminator > _pStorage->MaxValueSize()) {
+                        rejected = true;
+                    } else if (arg_remains > kMaxKeptArgument) {
+                        reserved = _pStorage->Reserve(arg_remains, argument_for_command);
+                        rejected = !reserved;
+                    } else {
+                        argument_for_command.resize(arg_remains);
+                    }
+                } catch (std::bad_alloc &) {
+                    rejected = true;
+                }
+                if (rejected) {
+                    _logger->debug("Skip value of {} bytes, storage can't keep it", arg_remains - terminator);
+                }
+                arg_filled = 0;
+            }
+
+            // Parsed might fails to consume any bytes from input stream. In real life that could happens,
+            // for example, because we are working with UTF-16 chars and only 1 byte left in stream
+            if (parsed == 0) {
+                break;
+            }
+            partial = true;
+            data += parsed;
+            size -= parsed;
+            consumed += parsed;
+        }
+
+        // There is command, but we still wait for argument to arrive...
+        if (!command_to_execute.Empty() && arg_remains > 0) {
+            _logger->debug("Fill argument: {} bytes of {}", size, arg_remains);
+            // There is some parsed command, and now we are reading argument
+            std::size_t to_read = std::min(arg_remains, size);
+            if (!rejected) {
+                std::memcpy(&argument_for_command[arg_filled], data, to_read);
+            }
+
+            arg_filled += to_read;
+            arg_remains -= to_read;
+            data += to_read;
+            size -= to_read;
+            consumed += to_read;
+        }
+
+        // Thre is command & argument - RUN!
+        if (!command_to_execute.Empty() && arg_remains == 0) {
+            Execute(out);
+            executed++;
+        }
+    }
+    return consumed;
+}
+
+// See Session.h
+char *Session::ArgumentSpace(std::size_t &len) {
+    if (command_to_execute.Empty() || arg_remains == 0 || rejected) {
+        return nullptr;
+    }
+    len = arg_remains;
+    return &argument_for_command[arg_filled];
+}
+
+// See Session.h
+std::size_t Session::ArgumentReceived(std::size_t n, OutputBuffer &out) {
+    _logger->debug("Got {} bytes of argument, {} left", n, arg_remains - n);
+    arg_filled += n;
+    arg_remains -= n;
+    if (arg_remains > 0) {
+        return 0;
+    }
+
+    Execute(out);
+    return 1;
+}
+
+// See Session.h
+void Session::Execute(OutputBuffer &out) {
+    _logger->debug("Start command execution");
+
+    response.Clear();
+    if (rejected) {
+        // Value is skipped, but stream stays in sync: client gets an error instead of the response
+        response.text = kTooLarge;
+    } else if (mode == Mode::Text && parser.HasBody()) {
+        // Value is complete only once \r\n follows it, otherwise stream is broken and nothing is stored
+        std::size_t size = argument_for_command.size() - 2;
+        if (argument_for_command.compare(size, 2, "\r\n") != 0) {
+            throw std::runtime_error("Command argument isn't terminated by \\r\\n");
+        }
+        argument_for_command.resize(size);
+    }
+    if (rejected) {
+        rejected = false;
+    } else if (reserved) {
+        command_to_execute.ExecuteResponse(*_pStorage, std::move(argument_for_command), response);
+        argument_for_command.clear();
+        reserved = false;
+    } else {
+        command_to_execute.ExecuteResponse(*_pStorage, argument_for_command, response);
+    }
+
+    // Response is sent later, together with the rest of the batch. Client asked for no reply gets nothing: no
+    // output is queued, so there is nothing to send either
+    if (mode == Mode::Binary) {
+        if (binary_parser.Respond(response)) {
+            Reply(response, out);
+        }
+    } else if (!parser.NoReply() && (!response.text.empty() || !response.files.empty())) {
+        response.text += "\r\n";
+        Reply(response, out);
+    }
+
+    // Prepare for the next command
+    command_to_execute.Clear();
+    if (argument_for_command.capacity() > kMaxKeptArgument) {
+        std::string().swap(argument_for_command);
+    } else {
+        argument_for_command.resize(0);
+    }
+    if (response.value.capacity() > kMaxKeptArgument) {
+        std::string().swap(response.value);
+    }
+    arg_filled = 0;
+    partial = false;
+    parser.Reset();
+    binary_parser.Reset();
+}
+
+// See Session.h
+void Session::Reply(Afina::Execute::Response &result, OutputBuffer &out) {
+    // Small response is copied, so response memory is reused by the next command
+    if (result.files.empty()) {
+        if (result.text.size() < OutputBuffer::kChunkSize) {
+            out.Append(std::string_view(result.text));
+        } else {
+            out.Append(std::move(result.text));
+        }
+        return;
+    }
+
+    std::string_view text = result.text;
+    std::size_t pos = 0;
+    for (auto &part : result.files) {
+        out.Append(text.substr(pos, part.first - pos));
+        out.AppendFile(std::move(part.second));
+        pos = part.first;
+    }
+    out.Append(text.substr(pos));
+}
+
+// See Session.h
+void Session::Reset() {
+    command_to_execute.Clear();
+    if (reserved) {
+        // Reserved value is dropped, so set is aborted
+        std::string().swap(argument_for_command);
+        reserved = false;
+    }
+    argument_for_command.resize(0);
+    arg_remains = 0;
+    arg_filled = 0;
+    partial = false;
+    rejected = false;
+    parser.Reset();
+    binary_parser.Reset();
+}
+
+} // namespace Network
+} // namespace Afina
@@ -0,0 +1,131 @@
+#ifndef AFINA_NETWORK_COMMON_SESSION_H
+#define AFINA_NETWORK_COMMON_SESSION_H
+
+#include <cstddef>
+#include <memory>
+#include <string>
+
+#include <afina/execute/Slot.h>
+
+#include "protocol/BinaryParser.h"
+#include "protocol/Parser.h"
+
+namespace spdlog {
+class logger;
+}
+
+namespace Afina {
+
+class Storage;
+
+namespace Network {
+
+class InputBuffer;
+class OutputBuffer;
+
+/**
+ * # Protocol state of a single connection
+ * Turns stream of bytes into commands, executes them and collects responses. The same
+ * code is used by every server implementation, they differ only in how bytes are read
+ * and how output gets written back.
+ *
+ * Single block of data readed from the socket could trigger inside actions a multiple times,
+ * for example:
+ * - read#0: [<command1 start>]
+ * - read#1: [<command1 end> <argument> <command2> <argument for command 2> <command3> ... ]
+ * all commands completed by the block are executed at once, so client pipelining many
+ * requests gets all responses in a single batch
+ *
+ * Connection speaks either text or binary memcached protocol, which one is decided by the first byte
+ * client sends: binary requests always start with the magic byte no text command starts with
+ */
+class Session {
+public:
+    Session(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<spdlog::logger> pl);
+    ~Session();
+
+    /**
+     * Consumes the whole given block: executes every command it completes and appends
+     * responses to the output. Incomplete tail is kept inside till the next call.
+     *
+     * Returns number of executed commands. Throws std::runtime_error if input is malformed,
+     * connection should be closed in a such case
+     */
+    std::size_t Process(const char *data, std::size_t size, OutputBuffer &out);
+
+    /**
+     * Same as above, but data is parsed in place from the input buffer and consumed. Execution
+     * stops once output grows up to max_output or max_commands are executed, if given: the rest
+     * of the commands stay in the input buffer until the next call
+     */
+    std::size_t Process(InputBuffer &in, OutputBuffer &out, std::size_t max_output = 0,
+                        std::size_t max_commands = 0);
+
+    /**
+     * If session waits for the argument of parsed command, returns place where the rest of
+     * argument should be written and its length. Caller could read large argument straight
+     * there instead of passing it through input buffer. Returns nullptr otherwise
+     */
+    char *ArgumentSpace(std::size_t &len);
+
+    /**
+     * Marks n bytes written into the space returned by ArgumentSpace as received, executes
+     * command once argument is complete. Returns number of executed commands
+     */
+    std::size_t ArgumentReceived(std::size_t n, OutputBuffer &out);
+
+    /**
+     * True if some command is received only partially, i.e session waits for the rest of it
+     */
+    bool Pending() const { return partial; }
+
+    /**
+     * Forgets partially parsed command
+     */
+    void Reset();
+
+private:
+    // Protocol of the connection, unknown till the first byte arrives
+    enum class Mode : uint8_t { Unknown, Text, Binary };
+
+    // Consumes data till the end or till one of limits is reached, returns number of consumed bytes
+    std::size_t Feed(const char *data, std::size_t size, OutputBuffer &out, std::size_t max_output,
+                     std::size_t max_commands, std::size_t &executed);
+
+    // Executes parsed command and prepares for the next one
+    void Execute(OutputBuffer &out);
+
+    // Queues response of the command to the output
+    void Reply(Afina::Execute::Response &result, OutputBuffer &out);
+
+    std::shared_ptr<Afina::Storage> _pStorage;
+    std::shared_ptr<spdlog::logger> _logger;
+
+    // Here is connection state
+    // - mode: protocol client speaks
+    // - parser, binary_parser: parse state of the stream, only one of them is used
+    // - command_to_execute: last command parsed out of stream, its memory is reused by the next one
+    // - arg_remains: how many bytes to read from stream to get command argument
+    // - argument_for_command: buffer stores argument, sized once command is parsed
+    // - response: response of the last command, its memory is reused by the next one
+    // - arg_filled: how many bytes of argument are already there
+    // - partial: command is received only partially
+    // - reserved: argument is the value place given by Storage::Reserve, command takes it over
+    // - rejected: argument is too large for storage, it is skipped and command isn't executed
+    Mode mode;
+    Protocol::Parser parser;
+    Protocol::BinaryParser binary_parser;
+    std::size_t arg_remains;
+    std::size_t arg_filled;
+    bool partial;
+    bool reserved;
+    bool rejected;
+    std::string argument_for_command;
+    Execute::Slot command_to_execute;
+    Execute::Response response;
+};
+
+} // namespace Network
+} // namespace Afina
+
+#endif // AFINA_NETWORK_COMMON_SESSION_H
@@ -0,0 +1,183 @@
+#include "TimerWheel.h"
+
+#include <algorithm>
+#include <chrono>
+
+namespace Afina {
+namespace Network {
+
+// See TimerWheel.h
+void TimerWheel::Timer::Unlink() {
+    if (_prev != nullptr) {
+        _prev->_next = _next;
+        _next->_prev = _prev;
+        _prev = _next = nullptr;
+    }
+}
+
+// See TimerWheel.h
+TimerWheel::TimerWheel(uint64_t now_ms, unsigned tick_ms) : _tick_ms(std::max(tick_ms, 1u)) {
+    _current = now_ms / _tick_ms;
+    for (unsigned level = 0; level < kLevels; level++) {
+        for (unsigned slot = 0; slot < kSlots; slot++) {
+            Timer &head = _slots[level][slot];
+            head._prev = head._next = &head;
+        }
+        _occupied[level] = 0;
+    }
+}
+
+// See TimerWheel.h
+uint64_t TimerWheel::Now() {
+    auto now = std::chrono::steady_clock::now().time_since_epoch();
+    return std::chrono::duration_cast<std::chrono::milliseconds>(now).count();
+}
+
+// See TimerWheel.h
+void TimerWheel::Arm(Timer *timer, uint64_t expires_ms) {
+    timer->Unlink();
+
+    // Never fire early, current tick is already processed so next one is the earliest possible
+    uint64_t expires = (expires_ms + _tick_ms - 1) / _tick_ms;
+    timer->_expires = std::max(expires, _current + 1);
+    Place(timer);
+}
+
+// See TimerWheel.h
+void TimerWheel::Place(Timer *timer) {
+    uint64_t delta = timer->_expires - _current;
+
+    unsigned level = 0;
+    while (level + 1 < kLevels && delta >= (uint64_t(1) << (kSlotBits * (level + 1)))) {
+        level++;
+    }
+
+    // Timers beyond the last level stay in its farthest slot and get placed again on cascade
+    uint64_t limit = (uint64_t(1) << (kSlotBits * kLevels)) - 1;
+    uint64_t expires = _current + std::min(delta, limit);
+    unsigned slot = (expires >> (kSlotBits * level)) & kSlotMask;
+
+    Timer &head = _slots[level][slot];
+    timer->_prev = head._prev;
+    timer->_next = &head;
+    head._prev->_next = timer;
+    head._prev = timer;
+    _occupied[level] |= uint64_t(1) << slot;
+}
+
+// See TimerWheel.h
+void TimerWheel::Cascade(unsigned level, unsigned slot) {
+    Timer &head = _slots[level][slot];
+    if (!Occupied(level, slot)) {
+        return;
+    }
+
+    // Detach the whole list first, timers could be placed back into the same slot
+    Timer *timer = head._next;
+    head._prev->_next = nullptr;
+    head._prev = head._next = &head;
+    _occupied[level] &= ~(uint64_t(1) << slot);
+
+    while (timer != nullptr) {
+        Timer *next = timer->_next;
+        Place(timer);
+        timer = next;
+    }
+}
+
+// See TimerWheel.h
+bool TimerWheel::Occupied(unsigned level, unsigned slot) const {
+    uint64_t bit = uint64_t(1) << slot;
+    if ((_occupied[level] & bit) == 0) {
+        return false;
+    }
+
+    const Timer &head = _slots[level][slot];
+    if (head._next == &head) {
+        _occupied[level] &= ~bit;
+        return false;
+    }
+    return true;
+}
+
+// See TimerWheel.h
+bool TimerWheel::LevelEmpty(unsigned level) const {
+    for (uint64_t bits = _occupied[level]; bits != 0; bits &= bits - 1) {
+        if (Occupied(level, __builtin_ctzll(bits))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// See TimerWheel.h
+bool TimerWheel::Empty() const {
+    for (unsigned level = 0; level < kLevels; level++) {
+        if (!LevelEmpty(level)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// See TimerWheel.h
+void TimerWheel::Expire(uint64_t now_ms, std::vector<Timer *> &expired) {
+    uint64_t target = now_ms / _tick_ms;
+    while (_current < target) {
+        if (Empty()) {
+            _current = target;
+            break;
+        }
+
+        // Nothing on the lowest level: jump right before the next cascade point
+        uint64_t last = _current | kSlotMask;
+        if (last > _current && LevelEmpty(0)) {
+            _current = std::min(last, target);
+            continue;
+        }
+
+        _current++;
+
+        // Level 0 made a full turn, time to bring timers of the upper levels closer
+        for (unsigned level = 1; level < kLevels; level++) {
+            if (((_current >> (kSlotBits * (level - 1))) & kSlotMask) != 0) {
+                break;
+            }
+            Cascade(level, (_current >> (kSlotBits * level)) & kSlotMask);
+        }
+
+        unsigned slot = _current & kSlotMask;
+        Timer &head = _slots[0][slot];
+        while (head._next != &head) {
+            Timer *timer = head._next;
+            timer->Unlink();
+            expired.push_back(timer);
+        }
+        _occupied[0] &= ~(uint64_t(1) << slot);
+    }
+}
+
+// See TimerWheel.h
+int TimerWheel::NextTimeout(uint64_t now_ms) const {
+    if (Empty()) {
+        return -1;
+    }
+
+    // Level 0 has exact deadlines, upper levels need wheel to get to the next cascade point
+    uint64_t next = (_current | kSlotMask) + 1;
+    for (unsigned d = 1; d < kSlots; d++) {
+        if (Occupied(0, (_current + d) & kSlotMask)) {
+            next = _current + d;
+            break;
+        }
+    }
+
+    uint64_t next_ms = next * _tick_ms;
+    if (next_ms <= now_ms) {
+        return 0;
+    }
+    return static_cast<int>(std::min<uint64_t>(next_ms - now_ms, 1u << 30));
+}
+
+} // namespace Network
+} // namespace Afina
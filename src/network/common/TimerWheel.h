@@ -0,0 +1,128 @@
+#ifndef AFINA_NETWORK_COMMON_TIMER_WHEEL_H
+#define AFINA_NETWORK_COMMON_TIMER_WHEEL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Afina {
+namespace Network {
+
+/**
+ * # Hierarchical timer wheel
+ * Tracks deadlines of many timers which are re-armed far more often than they fire, like
+ * connection idle timeouts re-armed on every read. Both Arm and Cancel are O(1): timer is
+ * just linked into the slot list, there is no ordered structure to maintain.
+ *
+ * Time is measured in ticks of the given length. Level 0 has a slot per tick, each slot of
+ * level N covers the whole level N-1. Timers are moved to the lower level once the wheel gets
+ * close enough to their deadline, so every timer is touched at most once per level.
+ *
+ * Not thread safe, wheel belongs to a single thread
+ */
+class TimerWheel {
+public:
+    /**
+     * Intrusive timer, embedded into the object it tracks
+     */
+    class Timer {
+    public:
+        Timer() : _prev(nullptr), _next(nullptr), _expires(0) {}
+        ~Timer() { Unlink(); }
+
+        bool Armed() const { return _prev != nullptr; }
+
+    private:
+        friend class TimerWheel;
+
+        Timer(const Timer &) = delete;
+        Timer &operator=(const Timer &) = delete;
+
+        void Unlink();
+
+        Timer *_prev;
+        Timer *_next;
+
+        // Deadline in ticks
+        uint64_t _expires;
+    };
+
+    /**
+     * Creates wheel starting at now_ms with the given tick length in milliseconds
+     */
+    TimerWheel(uint64_t now_ms, unsigned tick_ms = 10);
+
+    /**
+     * Current time of the monotonic clock in milliseconds
+     */
+    static uint64_t Now();
+
+    /**
+     * Arms timer to fire at the given time, previous deadline if any is forgotten
+     */
+    void Arm(Timer *timer, uint64_t expires_ms);
+
+    /**
+     * Disarms timer, nothing happens if timer isn't armed
+     */
+    void Cancel(Timer *timer) { timer->Unlink(); }
+
+    /**
+     * Deadline of the armed timer in milliseconds, rounded up to the tick. Lets timer move to the
+     * other wheel with the same tick keeping its deadline
+     */
+    uint64_t Deadline(const Timer *timer) const { return timer->_expires * _tick_ms; }
+
+    /**
+     * Moves wheel forward till now_ms, expired timers get disarmed and appended to the list
+     */
+    void Expire(uint64_t now_ms, std::vector<Timer *> &expired);
+
+    /**
+     * Returns number of milliseconds till the wheel needs to be moved forward, suitable for
+     * epoll_wait timeout: -1 if no timers are armed. Result may be earlier than the nearest
+     * deadline, but never later
+     */
+    int NextTimeout(uint64_t now_ms) const;
+
+private:
+    static constexpr unsigned kLevels = 4;
+    static constexpr unsigned kSlotBits = 6;
+    static constexpr unsigned kSlots = 1 << kSlotBits;
+    static constexpr unsigned kSlotMask = kSlots - 1;
+
+    TimerWheel(const TimerWheel &) = delete;
+    TimerWheel &operator=(const TimerWheel &) = delete;
+
+    // Links timer into slot matching its deadline
+    void Place(Timer *timer);
+
+    // Moves all timers of the given slot to the lower levels
+    void Cascade(unsigned level, unsigned slot);
+
+    // True if slot has timers, refreshes occupancy bit
+    bool Occupied(unsigned level, unsigned slot) const;
+
+    // True if there are no timers on the given level
+    bool LevelEmpty(unsigned level) const;
+
+    // True if there are no timers at all
+    bool Empty() const;
+
+    unsigned _tick_ms;
+
+    // Last tick processed
+    uint64_t _current;
+
+    // Slot lists heads, timers are linked into circular lists through the head
+    Timer _slots[kLevels][kSlots];
+
+    // Bit per slot which could be non-empty. Timer unlinks itself without wheel knowing,
+    // so bit is cleared lazily once slot is found empty
+    mutable uint64_t _occupied[kLevels];
+};
+
+} // namespace Network
+} // namespace Afina
+
+#endif // AFINA_NETWORK_COMMON_TIMER_WHEEL_H
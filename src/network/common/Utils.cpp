@@ -0,0 +1,121 @@
+#include "Utils.h"
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+#include <spdlog/logger.h>
+
+#include <afina/network/Config.h>
+
+#include "InputBuffer.h"
+#include "OutputBuffer.h"
+#include "Session.h"
+
+namespace Afina {
+namespace Network {
+
+namespace {
+
+// Send responses even if there is more input to process once that many bytes are collected
+constexpr std::size_t kMaxPendingOutput = 64 * 1024;
+
+// Arguments that long are read directly into the session
+constexpr std::size_t kDirectReadArgument = 4096;
+
+} // namespace
+
+// See Utils.h
+ssize_t read_input(int client_socket, Session &session, InputBuffer &in, OutputBuffer &out, int flags) {
+    std::size_t len = 0;
+    char *argument = session.ArgumentSpace(len);
+    if (argument != nullptr && len >= kDirectReadArgument && in.Empty()) {
+        ssize_t readed_bytes = recv(client_socket, argument, len, flags);
+        if (readed_bytes > 0) {
+            session.ArgumentReceived(readed_bytes, out);
+        }
+        return readed_bytes;
+    }
+
+    char *space = in.Prepare(len);
+    ssize_t readed_bytes = recv(client_socket, space, len, flags);
+    if (readed_bytes > 0) {
+        in.Commit(readed_bytes);
+    }
+    return readed_bytes;
+}
+
+// See Utils.h
+void serve_blocking(int client_socket, std::shared_ptr<Afina::Storage> ps, std::shared_ptr<spdlog::logger> pl) {
+    Session session(ps, pl);
+    InputBuffer input;
+    OutputBuffer output;
+
+    ssize_t readed_bytes = -1;
+    for (;;) {
+        // While there are responses to send do not block in read: once input is drained client
+        // waits for them
+        bool pending = !output.Empty();
+        readed_bytes = read_input(client_socket, session, input, output, pending ? MSG_DONTWAIT : 0);
+        if (readed_bytes < 0 && pending && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            if (!output.Flush(client_socket)) {
+                throw std::runtime_error("Failed to send response: " + std::string(strerror(errno)));
+            }
+            continue;
+        } else if (readed_bytes <= 0) {
+            break;
+        }
+        pl->debug("Got {} bytes from socket", readed_bytes);
+        session.Process(input, output);
+
+        // Keep collecting responses, unless too much is pending already
+        if (output.Size() >= kMaxPendingOutput && !output.Flush(client_socket, true)) {
+            throw std::runtime_error("Failed to send response: " + std::string(strerror(errno)));
+        }
+    }
+
+    if (!output.Empty() && !output.Flush(client_socket)) {
+        throw std::runtime_error("Failed to send response: " + std::string(strerror(errno)));
+    }
+
+    if (readed_bytes == 0) {
+        pl->debug("Connection closed");
+    } else {
+        throw std::runtime_error(std::string(strerror(errno)));
+    }
+}
+
+// See Utils.h
+int take_server_socket(Config &config, uint16_t port, bool reuse_port) {
+    for (auto it = config.inherited_sockets.begin(); it != config.inherited_sockets.end(); it++) {
+        struct sockaddr_in addr;
+        socklen_t addr_len = sizeof(addr);
+        if (getsockname(*it, (struct sockaddr *)&addr, &addr_len) == -1 || addr.sin_family != AF_INET ||
+            ntohs(addr.sin_port) != port) {
+            continue;
+        }
+
+        int opts = 0;
+        socklen_t opts_len = sizeof(opts);
+        if (getsockopt(*it, SOL_SOCKET, SO_REUSEPORT, &opts, &opts_len) == -1 || (opts != 0) != reuse_port) {
+            continue;
+        }
+
+        int server_socket = *it;
+        int flags = fcntl(server_socket, F_GETFL, 0);
+        if (flags == -1 || fcntl(server_socket, F_SETFL, flags | O_NONBLOCK) == -1) {
+            throw std::runtime_error("Failed to make inherited socket non blocking: " + std::string(strerror(errno)));
+        }
+        config.inherited_sockets.erase(it);
+        return server_socket;
+    }
+    return -1;
+}
+
+} // namespace Network
+} // namespace Afina
@@ -0,0 +1,55 @@
+#ifndef AFINA_NETWORK_COMMON_UTILS_H
+#define AFINA_NETWORK_COMMON_UTILS_H
+
+#include <cstdint>
+#include <memory>
+
+#include <sys/types.h>
+
+namespace spdlog {
+class logger;
+}
+
+namespace Afina {
+
+class Storage;
+
+namespace Network {
+
+class Config;
+class InputBuffer;
+class OutputBuffer;
+class Session;
+
+/**
+ * Reads next portion of client input into the buffer, it is up to the caller to process it.
+ * Large command argument is read directly into the session instead, bypassing input buffer,
+ * so it is copied only once. Command gets executed once such argument is complete.
+ *
+ * Returns result of the recv call done with the given flags. Throws std::runtime_error if input
+ * is malformed
+ */
+ssize_t read_input(int client_socket, Session &session, InputBuffer &in, OutputBuffer &out, int flags = 0);
+
+/**
+ * Serves blocking client socket until peer closes it: reads commands, executes them and
+ * sends responses back. Responses of all commands found in the input are sent together
+ * once socket has no more input immediately available.
+ *
+ * Throws std::runtime_error in case of protocol or socket error
+ */
+void serve_blocking(int client_socket, std::shared_ptr<Afina::Storage> ps, std::shared_ptr<spdlog::logger> pl);
+
+/**
+ * Takes inherited listening socket bound to the given port out of config, see Config::inherited_sockets.
+ * Socket must have SO_REUSEPORT option if and only if reuse_port is set. Socket is switched to
+ * non-blocking mode.
+ *
+ * Returns -1 if there is no such socket
+ */
+int take_server_socket(Config &config, uint16_t port, bool reuse_port);
+
+} // namespace Network
+} // namespace Afina
+
+#endif // AFINA_NETWORK_COMMON_UTILS_H
@@ -18,17 +18,18 @@
 #include <spdlog/logger.h>
 
 #include <afina/Storage.h>
-#include <afina/execute/Command.h>
 #include <afina/logging/Service.h>
 
-#include "protocol/Parser.h"
+#include "network/common/Utils.h"
 
 namespace Afina {
 namespace Network {
 namespace MTblocking {
 
 // See Server.h
-ServerImpl::ServerImpl(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Logging::Service> pl) : Server(ps, pl), max_workers(0), _server_socket(0) {}
+ServerImpl::ServerImpl(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Logging::Service> pl,
+                       std::shared_ptr<Config> pc)
+    : Server(ps, pl, pc), max_workers(0), _server_socket(0) {}
 
 // See Server.h
 ServerImpl::~ServerImpl() {}
@@ -113,15 +114,6 @@ void ServerImpl::Join() {
 
 // See Server.h
 void ServerImpl::OnRun() {
-    // Here is connection state
-    // - parser: parse state of the stream
-    // - command_to_execute: last command parsed out of stream
-    // - arg_remains: how many bytes to read from stream to get command argument
-    // - argument_for_command: buffer stores argument
-    std::size_t arg_remains;
-    Protocol::Parser parser;
-    std::string argument_for_command;
-    std::unique_ptr<Execute::Command> command_to_execute;
     while (running.load()) {
         _logger->debug("waiting for connection...");
 
@@ -184,113 +176,22 @@ void ServerImpl::OnRun() {
     _logger->warn("Network stopped");
 }
 
-void ServerImpl::Worker(int client_socket){
-
-	std::size_t arg_remains = 0;
-	Protocol::Parser parser;
-	std::string argument_for_command = "";
-	std::unique_ptr<Execute::Command> command_to_execute;
-
-	try{        
-		int readed_bytes = -1;
-    		char client_buffer[4096] = "";
-    		while ((readed_bytes = read(client_socket, client_buffer, sizeof(client_buffer))) > 0) {
-			_logger->debug("Got {} bytes from socket", readed_bytes);
-
-			// Single block of data readed from the socket could trigger inside actions a multiple times,
-			// for example:
-			// - read#0: [<command1 start>]
-	                // - read#1: [<command1 end> <argument> <command2> <argument for command 2> <command3> ... ]
-			while (readed_bytes > 0) {
-	    
-				_logger->debug("Process {} bytes", readed_bytes);
-	     			// There is no command yet				
-				if (!command_to_execute) {
-					std::size_t parsed = 0;
-					if (parser.Parse(client_buffer, readed_bytes, parsed)) {
-                	        	// There is no command to be launched, continue to parse input stream
-                        		// Here we are, current chunk finished some command, process it
-					_logger->debug("Found new command: {} in {} bytes", parser.Name(), parsed);
-	    				command_to_execute = parser.Build(arg_remains);
-	    					if (arg_remains > 0) {
-							arg_remains += 2;
-     						}
-					}	
-
-		                        // Parsed might fails to consume any bytes from input stream. In real life that could happens,
-		                        // for example, because we are working with UTF-16 chars and only 1 byte left in stream
-                		        if (parsed == 0) {
-		                        	break;
- 	                                } else {
-
-		   	                	std::memmove(client_buffer, client_buffer + parsed, readed_bytes - parsed);
-                            			readed_bytes -= parsed;
-		                        }
-                		}
-
-                    		// There is command, but we still wait for argument to arrive...
-		                if (command_to_execute && arg_remains > 0) {
-                        
-					_logger->debug("Fill argument: {} bytes of {}", readed_bytes, arg_remains);
-	                        	// There is some parsed command, and now we are reading argument
-		                        std::size_t to_read = std::min(arg_remains, std::size_t(readed_bytes));
-	        	                argument_for_command.append(client_buffer, to_read);
-
-	                	        std::memmove(client_buffer, client_buffer + to_read, readed_bytes - to_read);
-	                        	arg_remains -= to_read;
-		                        readed_bytes -= to_read;
-	                        }
-	
-		                // Thre is command & argument - RUN!
-	        	        if (command_to_execute && arg_remains == 0) {
-	                	        
-					_logger->debug("Start command execution");
-	
-	                        	std::string result;
-	                        	if (argument_for_command.size()) {
-	                            		argument_for_command.resize(argument_for_command.size() - 2);
-	                        	}
-	                        	command_to_execute->Execute(*pStorage, argument_for_command, result);
-	
-	                        	// Send response
-	                        	result += "\r\n";
-	                        	if (send(client_socket, result.data(), result.size(), 0) <= 0) {
-	                            		throw std::runtime_error("Failed to send response");
-	                        	}
-
-	                        	// Prepare for the next command
-	                        	command_to_execute.reset();
-	                        	argument_for_command.resize(0);
-	                        	parser.Reset();
-	                    	}
-		 	} // while (readed_bytes)
-		}
-
-	    	if (readed_bytes == 0) {
-		
-			_logger->debug("Connection closed");
-    		} else {
-		
-			throw std::runtime_error(std::string(strerror(errno)));
-    		}
+void ServerImpl::Worker(int client_socket) {
+    try {
+        serve_blocking(client_socket, pStorage, _logger);
+    } catch (std::runtime_error &ex) {
+        _logger->error("Failed to process connection on descriptor {}: {}", client_socket, ex.what());
+    }
 
-        } catch (std::runtime_error &ex) {
-            _logger->error("Failed to process connection on descriptor {}: {}", client_socket, ex.what());
+    // We are done with this connection
+    {
+        std::unique_lock<std::mutex> lock(sock_manager);
+        close(client_socket);
+        socketset.erase(client_socket);
+        if (!running.load()) {
+            serv_stop.notify_all();
         }
-
-
-        // Prepare for the next command: just in case if connection was closed in the middle of executing something
-
-	{
-		std::unique_lock<std::mutex> lock(sock_manager);
-		close(client_socket); // We are done with this connection
-		socketset.erase(client_socket);
-		if( socketset.size() > 0 && !running.load() ){
-
-			serv_stop.notify_all();
-		}
-	}
-
+    }
 }
 
 } // namespace MTblocking
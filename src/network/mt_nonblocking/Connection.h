@@ -1,37 +1,40 @@
 #ifndef AFINA_NETWORK_MT_NONBLOCKING_CONNECTION_H
 #define AFINA_NETWORK_MT_NONBLOCKING_CONNECTION_H
 
-#include <cstring>
+#include <cstdint>
+#include <list>
+#include <memory>
 
-#include <sys/epoll.h>
+#include "network/common/Connection.h"
 
 namespace Afina {
 namespace Network {
 namespace MTnonblock {
 
-class Connection {
-public:
-    Connection(int s) : _socket(s) {
-        std::memset(&_event, 0, sizeof(struct epoll_event));
-        _event.data.ptr = this;
-    }
-
-    inline bool isAlive() const { return true; }
-
-    void Start();
+class Deadlines;
 
-protected:
-    void OnError();
-    void OnClose();
-    void DoRead();
-    void DoWrite();
+// Connection served by one of the workers in turns limited by budget, see Network::Connection
+class Connection : public Network::Connection {
+public:
+    Connection(int s, std::shared_ptr<Afina::Storage> ps, std::shared_ptr<spdlog::logger> pl,
+               std::shared_ptr<OutputQuota> pq, std::size_t budget)
+        : Network::Connection(this, s, ps, pl, pq, budget), _queued(false), _turn(0), _deadlines(nullptr) {}
 
 private:
     friend class Worker;
     friend class ServerImpl;
+    friend class ConnectionSet;
+    friend class Deadlines;
+
+    // Position in the worker's ready list if connection waits for its turn there
+    bool _queued;
+    std::list<Connection *>::iterator _ready_pos;
+
+    // Worker loop iteration connection got its last turn on
+    uint64_t _turn;
 
-    int _socket;
-    struct epoll_event _event;
+    // Wheel deadline is armed in, nullptr if it has never been armed
+    Deadlines *_deadlines;
 };
 
 } // namespace MTnonblock
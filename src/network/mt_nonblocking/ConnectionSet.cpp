@@ -0,0 +1,46 @@
+#include "ConnectionSet.h"
+
+#include <sys/socket.h>
+
+#include "Connection.h"
+
+namespace Afina {
+namespace Network {
+namespace MTnonblock {
+
+// See ConnectionSet.h
+void ConnectionSet::Add(Connection *pc) {
+    std::lock_guard<std::mutex> lock(_lock);
+    _connections.insert(pc);
+    if (_closing) {
+        shutdown(pc->_socket, SHUT_RD);
+    }
+}
+
+// See ConnectionSet.h
+void ConnectionSet::Remove(Connection *pc) {
+    std::lock_guard<std::mutex> lock(_lock);
+    _connections.erase(pc);
+}
+
+// See ConnectionSet.h
+bool ConnectionSet::Close() {
+    std::lock_guard<std::mutex> lock(_lock);
+    if (!_closing) {
+        _closing = true;
+        for (Connection *pc : _connections) {
+            shutdown(pc->_socket, SHUT_RD);
+        }
+    }
+    return _workers > 0 && --_workers == 0;
+}
+
+// See ConnectionSet.h
+bool ConnectionSet::Empty() {
+    std::lock_guard<std::mutex> lock(_lock);
+    return _connections.empty();
+}
+
+} // namespace MTnonblock
+} // namespace Network
+} // namespace Afina
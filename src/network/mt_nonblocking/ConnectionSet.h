@@ -0,0 +1,66 @@
+#ifndef AFINA_NETWORK_MT_NONBLOCKING_CONNECTION_SET_H
+#define AFINA_NETWORK_MT_NONBLOCKING_CONNECTION_SET_H
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <unordered_set>
+
+namespace Afina {
+namespace Network {
+namespace MTnonblock {
+
+class Connection;
+
+/**
+ * # Connections registered in the epoll instance
+ * Lets workers find every connection once server stops. In shared epoll mode connections are
+ * registered by acceptors and closed by any worker, so access is synchronized. Set is touched only
+ * when connection opens or closes, deadlines are kept by workers, see Deadlines
+ */
+class ConnectionSet {
+public:
+    explicit ConnectionSet(std::size_t workers) : _workers(workers), _closing(false) {}
+
+    /**
+     * Registers new connection, must be called before connection gets into epoll. If set is
+     * closing already then reading side of the connection is shut down right away
+     */
+    void Add(Connection *pc);
+
+    /**
+     * Unregisters connection, must be called before its socket gets closed
+     */
+    void Remove(Connection *pc);
+
+    /**
+     * Called by each worker sharing the set once it is asked to stop. Shuts down reading side of
+     * all connections, so each one closes by itself as soon as commands already sent by client
+     * are executed and responses are delivered.
+     *
+     * Returns true for the last worker, once it is safe to stop waking workers up
+     */
+    bool Close();
+
+    /**
+     * True if there is no more connections to serve
+     */
+    bool Empty();
+
+private:
+    ConnectionSet(const ConnectionSet &) = delete;
+    ConnectionSet &operator=(const ConnectionSet &) = delete;
+
+    std::mutex _lock;
+    std::unordered_set<Connection *> _connections;
+
+    // Number of workers which haven't called Close yet
+    std::size_t _workers;
+    bool _closing;
+};
+
+} // namespace MTnonblock
+} // namespace Network
+} // namespace Afina
+
+#endif // AFINA_NETWORK_MT_NONBLOCKING_CONNECTION_SET_H
@@ -0,0 +1,64 @@
+#include "Deadlines.h"
+
+#include <vector>
+
+#include <sys/socket.h>
+
+#include "Connection.h"
+
+namespace Afina {
+namespace Network {
+namespace MTnonblock {
+
+// See Deadlines.h
+void Deadlines::Arm(Connection *pc, const Config &config, uint64_t now_ms) {
+    Deadlines *previous = pc->_deadlines;
+    bool armed = false;
+    uint64_t deadline = 0;
+    if (previous != this && previous != nullptr) {
+        std::lock_guard<std::mutex> lock(previous->_lock);
+        armed = pc->_timer.Armed();
+        if (armed) {
+            deadline = previous->_wheel.Deadline(&pc->_timer);
+            previous->_wheel.Cancel(&pc->_timer);
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(_lock);
+    pc->_deadlines = this;
+    if (armed) {
+        _wheel.Arm(&pc->_timer, deadline);
+    }
+    pc->_timer.Update(_wheel, config, pc->_session, pc->_output, now_ms);
+}
+
+// See Deadlines.h
+void Deadlines::Cancel(Connection *pc) {
+    Deadlines *deadlines = pc->_deadlines;
+    if (deadlines != nullptr) {
+        std::lock_guard<std::mutex> lock(deadlines->_lock);
+        deadlines->_wheel.Cancel(&pc->_timer);
+    }
+}
+
+// See Deadlines.h
+int Deadlines::NextTimeout(uint64_t now_ms) {
+    std::lock_guard<std::mutex> lock(_lock);
+    return _wheel.NextTimeout(now_ms);
+}
+
+// See Deadlines.h
+std::size_t Deadlines::Expire(uint64_t now_ms) {
+    std::vector<TimerWheel::Timer *> expired;
+    std::lock_guard<std::mutex> lock(_lock);
+    _wheel.Expire(now_ms, expired);
+    for (TimerWheel::Timer *timer : expired) {
+        Connection *pc = static_cast<Connection *>(static_cast<ConnectionTimer *>(timer)->Owner());
+        shutdown(pc->_socket, SHUT_RDWR);
+    }
+    return expired.size();
+}
+
+} // namespace MTnonblock
+} // namespace Network
+} // namespace Afina
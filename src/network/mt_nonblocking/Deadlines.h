@@ -0,0 +1,70 @@
+#ifndef AFINA_NETWORK_MT_NONBLOCKING_DEADLINES_H
+#define AFINA_NETWORK_MT_NONBLOCKING_DEADLINES_H
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+#include "network/common/TimerWheel.h"
+
+namespace Afina {
+namespace Network {
+
+// Forward declaration, see afina/network/Config.h
+class Config;
+
+namespace MTnonblock {
+
+class Connection;
+
+/**
+ * # Deadlines of connections served by a single worker
+ * Each worker has its own wheel, connection deadline stays in the wheel of the worker which armed
+ * it last. In shared epoll mode connection could get to other worker, which then moves deadline
+ * into its own wheel. So the lock of the wheel is taken by the other thread only once connection
+ * moves between workers or is armed by acceptor, otherwise it is never contended
+ */
+class Deadlines {
+public:
+    Deadlines() : _wheel(TimerWheel::Now()) {}
+
+    /**
+     * Re-arms deadline of the connection in this wheel, see ConnectionTimer. Deadline armed in the
+     * other wheel moves here as is. Must be called by the thread serving connection before epoll
+     * could pass connection to the other one
+     */
+    void Arm(Connection *pc, const Config &config, uint64_t now_ms);
+
+    /**
+     * Cancels deadline of the connection wherever it is armed, must be called before connection
+     * socket gets closed
+     */
+    static void Cancel(Connection *pc);
+
+    /**
+     * Milliseconds till the nearest deadline, -1 if there is none
+     */
+    int NextTimeout(uint64_t now_ms);
+
+    /**
+     * Shuts down both sides of connections which missed their deadlines. Connection could be
+     * served by other worker right now, so it isn't closed here: epoll reports EPOLLHUP and
+     * connection gets closed by the worker serving it.
+     *
+     * Returns number of expired connections
+     */
+    std::size_t Expire(uint64_t now_ms);
+
+private:
+    Deadlines(const Deadlines &) = delete;
+    Deadlines &operator=(const Deadlines &) = delete;
+
+    std::mutex _lock;
+    TimerWheel _wheel;
+};
+
+} // namespace MTnonblock
+} // namespace Network
+} // namespace Afina
+
+#endif // AFINA_NETWORK_MT_NONBLOCKING_DEADLINES_H
@@ -22,15 +22,21 @@
 #include <afina/logging/Service.h>
 
 #include "Connection.h"
+#include "ConnectionSet.h"
+#include "Deadlines.h"
 #include "Utils.h"
 #include "Worker.h"
+#include "network/common/TimerWheel.h"
+#include "network/common/Utils.h"
 
 namespace Afina {
 namespace Network {
 namespace MTnonblock {
 
 // See Server.h
-ServerImpl::ServerImpl(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Logging::Service> pl) : Server(ps, pl) {}
+ServerImpl::ServerImpl(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Logging::Service> pl,
+                       std::shared_ptr<Config> pc)
+    : Server(ps, pl, pc), _server_socket(-1), _data_epoll_fd(-1), _event_fd(-1) {}
 
 // See Server.h
 ServerImpl::~ServerImpl() {}
@@ -39,6 +45,8 @@ ServerImpl::~ServerImpl() {}
 void ServerImpl::Start(uint16_t port, uint32_t n_acceptors, uint32_t n_workers) {
     _logger = pLogging->select("network");
     _logger->info("Start mt_nonblocking network service");
+    _quota = std::make_shared<OutputQuota>(pConfig->output_high_watermark, pConfig->output_limit,
+                                           pConfig->zerocopy_threshold);
 
     sigset_t sig_mask;
     sigemptyset(&sig_mask);
@@ -47,57 +55,30 @@ void ServerImpl::Start(uint16_t port, uint32_t n_acceptors, uint32_t n_workers)
         throw std::runtime_error("Unable to mask SIGPIPE");
     }
 
-    // Create server socket
-    struct sockaddr_in server_addr;
-    std::memset(&server_addr, 0, sizeof(server_addr));
-    server_addr.sin_family = AF_INET;         // IPv4
-    server_addr.sin_port = htons(port);       // TCP port number
-    server_addr.sin_addr.s_addr = INADDR_ANY; // Bind to any address
-
-    _server_socket = socket(PF_INET, SOCK_STREAM, IPPROTO_TCP);
-    if (_server_socket == -1) {
-        throw std::runtime_error("Failed to open socket: " + std::string(strerror(errno)));
-    }
-
-    int opts = 1;
-    if (setsockopt(_server_socket, SOL_SOCKET, (SO_KEEPALIVE), &opts, sizeof(opts)) == -1) {
-        close(_server_socket);
-        throw std::runtime_error("Socket setsockopt() failed: " + std::string(strerror(errno)));
+    _event_fd = eventfd(0, EFD_NONBLOCK);
+    if (_event_fd == -1) {
+        throw std::runtime_error("Failed to create epoll file descriptor: " + std::string(strerror(errno)));
     }
 
-    if (bind(_server_socket, (struct sockaddr *)&server_addr, sizeof(server_addr)) == -1) {
-        close(_server_socket);
-        throw std::runtime_error("Socket bind() failed: " + std::string(strerror(errno)));
+    if (pConfig->reuse_port) {
+        StartReusePort(port, n_workers);
+        return;
     }
 
-    make_socket_non_blocking(_server_socket);
-    if (listen(_server_socket, 5) == -1) {
-        close(_server_socket);
-        throw std::runtime_error("Socket listen() failed: " + std::string(strerror(errno)));
+    // Create server socket, unless previous process handed one over
+    _server_socket = take_server_socket(*pConfig, port, false);
+    if (_server_socket == -1) {
+        _server_socket = make_server_socket(port, false);
     }
 
     // Start IO workers
-    _data_epoll_fd = epoll_create1(0);
-    if (_data_epoll_fd == -1) {
-        throw std::runtime_error("Failed to create epoll file descriptor: " + std::string(strerror(errno)));
-    }
-
-    _event_fd = eventfd(0, EFD_NONBLOCK);
-    if (_event_fd == -1) {
-        throw std::runtime_error("Failed to create epoll file descriptor: " + std::string(strerror(errno)));
-    }
-
-    struct epoll_event event;
-    event.events = EPOLLIN;
-    event.data.ptr = nullptr;
-    if (epoll_ctl(_data_epoll_fd, EPOLL_CTL_ADD, _event_fd, &event)) {
-        throw std::runtime_error("Failed to add eventfd descriptor to epoll");
-    }
+    _data_epoll_fd = make_epoll(_event_fd);
+    _registry = std::make_shared<ConnectionSet>(n_workers);
 
     _workers.reserve(n_workers);
     for (int i = 0; i < n_workers; i++) {
-        _workers.emplace_back(pStorage, pLogging);
-        _workers.back().Start(_data_epoll_fd);
+        _workers.emplace_back(pStorage, pLogging, pConfig, _quota, _registry);
+        _workers.back().Start(_data_epoll_fd, _event_fd);
     }
 
     // Start acceptors
@@ -107,6 +88,28 @@ void ServerImpl::Start(uint16_t port, uint32_t n_acceptors, uint32_t n_workers)
     }
 }
 
+// See ServerImpl.h
+void ServerImpl::StartReusePort(uint16_t port, uint32_t n_workers) {
+    _logger->info("Start {} workers with private SO_REUSEPORT listeners", n_workers);
+
+    // Kernel balances new connections between all sockets bound to the same port, so
+    // each worker accepts, reads, executes and writes on its own without any cross
+    // thread handoff
+    _workers.reserve(n_workers);
+    for (int i = 0; i < n_workers; i++) {
+        int server_socket = take_server_socket(*pConfig, port, true);
+        if (server_socket == -1) {
+            server_socket = make_server_socket(port, true);
+        }
+        int epoll_fd = make_epoll(_event_fd);
+        _listen_sockets.push_back(server_socket);
+        _worker_epoll_fds.push_back(epoll_fd);
+
+        _workers.emplace_back(pStorage, pLogging, pConfig, _quota, std::make_shared<ConnectionSet>(1));
+        _workers.back().Start(epoll_fd, _event_fd, server_socket);
+    }
+}
+
 // See Server.h
 void ServerImpl::Stop() {
     _logger->warn("Stop network service");
@@ -121,6 +124,14 @@ void ServerImpl::Stop() {
     }
 }
 
+// See Server.h
+std::vector<int> ServerImpl::ListenSockets() const {
+    if (pConfig->reuse_port) {
+        return _listen_sockets;
+    }
+    return std::vector<int>(1, _server_socket);
+}
+
 // See Server.h
 void ServerImpl::Join() {
     for (auto &t : _acceptors) {
@@ -130,6 +141,26 @@ void ServerImpl::Join() {
     for (auto &w : _workers) {
         w.Join();
     }
+
+    // Report how connections were spread across workers
+    for (std::size_t i = 0; i < _workers.size(); i++) {
+        _logger->warn("Worker {}: accepted {} connections, {:.1f} accepts/s, {} still open, {} timed out", i,
+                      _workers[i].AcceptedConnections(), _workers[i].AcceptRate(), _workers[i].OpenConnections(),
+                      _workers[i].ReapedConnections());
+    }
+    _logger->warn("Output peak {} bytes, reading paused {} times by connection and {} by server limit, "
+                  "{} bytes sent with zerocopy and {} copied anyway",
+                  _quota->Peak(), _quota->Paused(), _quota->Throttled(), _quota->Zerocopied(),
+                  _quota->ZerocopyCopied());
+
+    for (int fd : _listen_sockets) {
+        close(fd);
+    }
+    for (int fd : _worker_epoll_fds) {
+        close(fd);
+    }
+    _listen_sockets.clear();
+    _worker_epoll_fds.clear();
 }
 
 // See ServerImpl.h
@@ -154,6 +185,9 @@ void ServerImpl::OnRun() {
         throw std::runtime_error("Failed to add file descriptor to epoll");
     }
 
+    // Deadlines of new connections are spread over workers' wheels
+    std::size_t next_worker = 0;
+
     bool run = true;
     std::array<struct epoll_event, 64> mod_list;
     while (run) {
@@ -193,7 +227,7 @@ void ServerImpl::OnRun() {
                 }
 
                 // Register the new FD to be monitored by epoll.
-                Connection *pc = new Connection(infd);
+                Connection *pc = new (std::nothrow) Connection(infd, pStorage, _logger, _quota, pConfig->fair_budget);
                 if (pc == nullptr) {
                     throw std::runtime_error("Failed to allocate connection");
                 }
@@ -201,11 +235,16 @@ void ServerImpl::OnRun() {
                 // Register connection in worker's epoll
                 pc->Start();
                 if (pc->isAlive()) {
+                    _registry->Add(pc);
+                    _workers[next_worker++ % _workers.size()].Arm(pc, TimerWheel::Now());
                     pc->_event.events |= EPOLLONESHOT;
                     int epoll_ctl_retval;
                     if ((epoll_ctl_retval = epoll_ctl(_data_epoll_fd, EPOLL_CTL_ADD, pc->_socket, &pc->_event))) {
                         _logger->debug("epoll_ctl failed during connection register in workers'epoll: error {}", epoll_ctl_retval);
                         pc->OnError();
+                        Deadlines::Cancel(pc);
+                        _registry->Remove(pc);
+                        close(pc->_socket);
                         delete pc;
                     }
                 }
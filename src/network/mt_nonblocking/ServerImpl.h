@@ -12,10 +12,15 @@ class logger;
 
 namespace Afina {
 namespace Network {
+
+// Forward declaration, see network/common/OutputQuota.h
+class OutputQuota;
+
 namespace MTnonblock {
 
 // Forward declaration, see Worker.h
 class Worker;
+class ConnectionSet;
 
 /**
  * # Network resource manager implementation
@@ -23,7 +28,8 @@ class Worker;
  */
 class ServerImpl : public Server {
 public:
-    ServerImpl(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Logging::Service> pl);
+    ServerImpl(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Logging::Service> pl,
+               std::shared_ptr<Config> pc);
     ~ServerImpl();
 
     // See Server.h
@@ -35,10 +41,19 @@ public:
     // See Server.h
     void Join() override;
 
+    // See Server.h
+    std::vector<int> ListenSockets() const override;
+
 protected:
     void OnRun();
     void OnNewConnection();
 
+    /**
+     * Starts workers so that each owns a private SO_REUSEPORT listening socket and a private
+     * epoll instance. No acceptor threads are used in this mode
+     */
+    void StartReusePort(uint16_t port, uint32_t n_workers);
+
 private:
     // logger to use
     std::shared_ptr<spdlog::logger> _logger;
@@ -63,6 +78,16 @@ private:
 
     // threads serving read/write requests
     std::vector<Worker> _workers;
+
+    // Per worker listening sockets and epoll instances, used in SO_REUSEPORT mode only
+    std::vector<int> _listen_sockets;
+    std::vector<int> _worker_epoll_fds;
+
+    // Memory taken by responses, shared by all workers
+    std::shared_ptr<OutputQuota> _quota;
+
+    // Connections of the shared epoll
+    std::shared_ptr<ConnectionSet> _registry;
 };
 
 } // namespace MTnonblock
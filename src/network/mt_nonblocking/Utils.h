@@ -1,12 +1,27 @@
 #ifndef AFINA_NETWORK_MT_NONBLOCKING_UTILS_H
 #define AFINA_NETWORK_MT_NONBLOCKING_UTILS_H
 
+#include <cstdint>
+
 namespace Afina {
 namespace Network {
 namespace MTnonblock {
 
 void make_socket_non_blocking(int sfd);
 
+/**
+ * Creates non-blocking server socket listening on the given port. If reuse_port is set then
+ * socket gets SO_REUSEPORT option so that many sockets could share the same port and kernel
+ * balances incoming connections between them
+ */
+int make_server_socket(uint16_t port, bool reuse_port);
+
+/**
+ * Creates new epoll instance with the given eventfd registered in it, event_fd is used
+ * to wakeup threads sleeping on the epoll. Event data pointer for event_fd is nullptr
+ */
+int make_epoll(int event_fd);
+
 } // namespace MTnonblock
 } // namespace Network
 } // namespace Afina
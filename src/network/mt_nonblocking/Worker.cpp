@@ -1,28 +1,59 @@
 #include "Worker.h"
 
+#include <array>
 #include <cassert>
+#include <cerrno>
 #include <functional>
+#include <initializer_list>
 #include <iostream>
+#include <stdexcept>
+#include <vector>
 
 #include <netdb.h>
 #include <sys/epoll.h>
 #include <sys/socket.h>
 #include <sys/types.h>
+#include <unistd.h>
 
 #include <spdlog/logger.h>
 
 #include <afina/logging/Service.h>
+#include <afina/network/Config.h>
+
+#include "network/common/TimerWheel.h"
 
 #include "Connection.h"
+#include "ConnectionSet.h"
+#include "Deadlines.h"
 #include "Utils.h"
 
 namespace Afina {
 namespace Network {
 namespace MTnonblock {
 
+namespace {
+
+// Once stopped, worker checks that often if connections served by other workers are closed
+constexpr int kDrainPollMs = 100;
+
+// The shortest of connection timeouts, -1 if there is none
+int shortest_timeout(const Config &config) {
+    int result = -1;
+    for (uint32_t timeout : {config.idle_timeout, config.read_timeout, config.write_timeout}) {
+        if (timeout > 0 && (result < 0 || timeout < static_cast<uint32_t>(result))) {
+            result = timeout;
+        }
+    }
+    return result;
+}
+
+} // namespace
+
 // See Worker.h
-Worker::Worker(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Afina::Logging::Service> pl)
-    : _pStorage(ps), _pLogging(pl), isRunning(false), _epoll_fd(-1) {
+Worker::Worker(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Afina::Logging::Service> pl,
+               std::shared_ptr<Config> pc, std::shared_ptr<OutputQuota> pq, std::shared_ptr<ConnectionSet> pr)
+    : _pStorage(ps), _pLogging(pl), _pConfig(pc), _quota(pq), _registry(pr), _deadlines(new Deadlines()), isRunning(false), _epoll_fd(-1),
+      _event_fd(-1), _server_socket(-1), _accepted(0), _connections(0), _reaped(0), _iteration(0) {
     // TODO: implementation here
 }
 
@@ -39,19 +70,46 @@ Worker &Worker::operator=(Worker &&other) {
     _pStorage = std::move(other._pStorage);
     _pLogging = std::move(other._pLogging);
     _logger = std::move(other._logger);
+    _pConfig = std::move(other._pConfig);
+    _quota = std::move(other._quota);
+    _registry = std::move(other._registry);
+    _deadlines = std::move(other._deadlines);
     _thread = std::move(other._thread);
     _epoll_fd = other._epoll_fd;
+    _event_fd = other._event_fd;
+    _server_socket = other._server_socket;
+    _accepted = other._accepted.load();
+    _connections = other._connections.load();
+    _reaped = other._reaped.load();
+    _ready = std::move(other._ready);
+    _iteration = other._iteration;
+    _started = other._started;
 
     other._epoll_fd = -1;
+    other._server_socket = -1;
     return *this;
 }
 
 // See Worker.h
-void Worker::Start(int epoll_fd) {
+void Worker::Start(int epoll_fd, int event_fd, int server_socket) {
     if (isRunning.exchange(true) == false) {
         assert(_epoll_fd == -1);
         _epoll_fd = epoll_fd;
+        _event_fd = event_fd;
+        _server_socket = server_socket;
+        _started = std::chrono::steady_clock::now();
         _logger = _pLogging->select("network.worker");
+
+        if (_server_socket != -1) {
+            // Worker pointer marks events of the listening socket
+            struct epoll_event event;
+            event.events = EPOLLIN;
+            event.data.ptr = this;
+            if (epoll_ctl(_epoll_fd, EPOLL_CTL_ADD, _server_socket, &event)) {
+                throw std::runtime_error("Failed to add server socket to worker's epoll");
+            }
+        }
+
         _thread = std::thread(&Worker::OnRun, this);
     }
 }
@@ -65,6 +123,59 @@ void Worker::Join() {
     _thread.join();
 }
 
+// See Worker.h
+double Worker::AcceptRate() const {
+    std::chrono::duration<double> uptime = std::chrono::steady_clock::now() - _started;
+    if (uptime.count() <= 0) {
+        return 0;
+    }
+    return AcceptedConnections() / uptime.count();
+}
+
+// See Worker.h
+void Worker::Arm(Connection *pc, uint64_t now_ms) { _deadlines->Arm(pc, *_pConfig, now_ms); }
+
+// See Worker.h
+void Worker::OnNewConnection() {
+    for (;;) {
+        struct sockaddr in_addr;
+        socklen_t in_len;
+
+        // No need to make these sockets non blocking since accept4() takes care of it.
+        in_len = sizeof in_addr;
+        int infd = accept4(_server_socket, &in_addr, &in_len, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (infd == -1) {
+            if ((errno != EAGAIN) && (errno != EWOULDBLOCK)) {
+                _logger->error("Failed to accept socket");
+            }
+            break; // We have processed all incoming connections.
+        }
+        _accepted.fetch_add(1, std::memory_order_relaxed);
+        _logger->debug("Accepted connection on descriptor {}", infd);
+
+        Connection *pc = new (std::nothrow) Connection(infd, _pStorage, _logger, _quota, _pConfig->fair_budget);
+        if (pc == nullptr) {
+            throw std::runtime_error("Failed to allocate connection");
+        }
+
+        // Epoll is private, so no need in EPOLLONESHOT here
+        pc->Start();
+        if (pc->isAlive()) {
+            _registry->Add(pc);
+            _deadlines->Arm(pc, *_pConfig, TimerWheel::Now());
+            if (epoll_ctl(_epoll_fd, EPOLL_CTL_ADD, pc->_socket, &pc->_event)) {
+                pc->OnError();
+                Deadlines::Cancel(pc);
+                _registry->Remove(pc);
+                close(pc->_socket);
+                delete pc;
+                continue;
+            }
+            _connections.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+}
+
 // See Worker.h
 void Worker::OnRun() {
     assert(_epoll_fd >= 0);
@@ -74,12 +185,32 @@ void Worker::OnRun() {
     //
     // Do not forget to use EPOLLEXCLUSIVE flag when register socket
     // for events to avoid thundering herd type behavior.
-    int timeout = -1;
     std::array<struct epoll_event, 64> mod_list;
-    while (isRunning) {
+    bool stopping = false;
+    while (!stopping || !_registry->Empty()) {
+        _iteration++;
+
+        // Sleep no longer than till the nearest connection deadline, do not sleep at all if
+        // there are connections waiting for their turn
+        int timeout = _deadlines->NextTimeout(TimerWheel::Now());
+        if (_server_socket == -1) {
+            // Acceptors arm deadlines of new connections while workers sleep, so the nearest one could
+            // be missed here. It is due no sooner than the shortest timeout, sleep no longer than that
+            int shortest = shortest_timeout(*_pConfig);
+            if (timeout < 0 || (shortest >= 0 && shortest < timeout)) {
+                timeout = shortest;
+            }
+        }
+        if (stopping && (timeout < 0 || timeout > kDrainPollMs)) {
+            timeout = kDrainPollMs;
+        }
+        if (!_ready.empty()) {
+            timeout = 0;
+        }
         int nmod = epoll_wait(_epoll_fd, &mod_list[0], mod_list.size(), timeout);
         _logger->debug("Worker wokeup: {} events", nmod);
 
+        uint64_t now = TimerWheel::Now();
         for (int i = 0; i < nmod; i++) {
             struct epoll_event &current_event = mod_list[i];
 
@@ -90,49 +221,141 @@ void Worker::OnRun() {
                 continue;
             }
 
+            // Private listening socket has new connections
+            if (current_event.data.ptr == this) {
+                OnNewConnection();
+                continue;
+            }
+
             // Some connection gets new data
             Connection *pconn = static_cast<Connection *>(current_event.data.ptr);
-            if ((current_event.events & EPOLLERR) || (current_event.events & EPOLLHUP)) {
-                _logger->debug("Got EPOLLERR or EPOLLHUP, value of returned events: {}", current_event.events);
-                pconn->OnError();
-            } else if (current_event.events & EPOLLRDHUP) {
-                _logger->debug("Got EPOLLRDHUP, value of returned events: {}", current_event.events);
-                pconn->OnClose();
-            } else {
-                // Depends on what connection wants...
-                if (current_event.events & EPOLLIN) {
-                    _logger->trace("Got EPOLLIN");
-                    pconn->DoRead();
-                }
-                if (current_event.events & EPOLLOUT) {
-                    _logger->trace("Got EPOLLOUT");
-                    pconn->DoWrite();
-                }
-            }
+            auto old_mask = pconn->_event.events;
+            pconn->_turn = _iteration;
+            pconn->OnEvent(current_event.events);
+            Reschedule(pconn, old_mask, now);
+        }
 
-            // Rearm connection
-            if (pconn->isAlive()) {
-                pconn->_event.events |= EPOLLONESHOT;
-                int epoll_ctl_retval;
-                if ((epoll_ctl_retval = epoll_ctl(_epoll_fd, EPOLL_CTL_MOD, pconn->_socket, &pconn->_event))) {
-                    _logger->debug("epoll_ctl failed during connection rearm: error {}", epoll_ctl_retval);
-                    pconn->OnError();
-                    delete pconn;
-                }
-            }
-            // Or delete closed one
-            else {
-                if (epoll_ctl(_epoll_fd, EPOLL_CTL_DEL, pconn->_socket, &pconn->_event)) {
-                    std::cerr << "Failed to delete connection!" << std::endl;
-                }
-                delete pconn;
-            }
+        if (!stopping && !isRunning) {
+            stopping = true;
+            OnStop();
         }
-        // TODO: Select timeout...
+
+        OnReady();
+        OnTimeout();
     }
     _logger->warn("Worker stopped");
 }
 
+// See Worker.h
+void Worker::OnStop() {
+    _logger->debug("Stop worker due to stop signal");
+
+    // No more new connections...
+    if (_server_socket != -1 && epoll_ctl(_epoll_fd, EPOLL_CTL_DEL, _server_socket, nullptr)) {
+        _logger->error("Failed to delete server socket from epoll");
+    }
+
+    // ...and no more new commands, connections close once responses are sent. Stop signal is
+    // level triggered, so it is removed from epoll once all workers sharing it got it
+    if (_registry->Close() && epoll_ctl(_epoll_fd, EPOLL_CTL_DEL, _event_fd, nullptr)) {
+        _logger->error("Failed to delete stop signal from epoll");
+    }
+}
+
+// See Worker.h
+void Worker::OnReady() {
+    uint64_t now = TimerWheel::Now();
+    for (std::size_t n = _ready.size(); n > 0 && !_ready.empty(); n--) {
+        Connection *pconn = _ready.front();
+        _ready.pop_front();
+        pconn->_queued = false;
+
+        // Connection already had a turn on this iteration due to epoll event
+        if (pconn->_turn == _iteration) {
+            pconn->_ready_pos = _ready.insert(_ready.end(), pconn);
+            pconn->_queued = true;
+            continue;
+        }
+
+        auto old_mask = pconn->_event.events;
+        pconn->_turn = _iteration;
+        pconn->DoRead();
+        Reschedule(pconn, old_mask, now);
+    }
+}
+
+// See Worker.h
+void Worker::Reschedule(Connection *pconn, uint32_t old_mask, uint64_t now) {
+    if (!pconn->isAlive()) {
+        Close(pconn);
+        return;
+    }
+
+    if (pconn->_unfinished && !pconn->_queued) {
+        pconn->_ready_pos = _ready.insert(_ready.end(), pconn);
+        pconn->_queued = true;
+    }
+
+    // Private epoll has no other threads to race with: just update mask if needed
+    if (_server_socket != -1) {
+        if (pconn->_event.events != old_mask) {
+            if (epoll_ctl(_epoll_fd, EPOLL_CTL_MOD, pconn->_socket, &pconn->_event)) {
+                _logger->error("Failed to change connection event mask");
+                pconn->OnError();
+                Close(pconn);
+                return;
+            }
+        }
+        _deadlines->Arm(pconn, *_pConfig, now);
+        return;
+    }
+
+    // Connection waiting in the ready list belongs to this worker, it gets rearmed once done
+    if (pconn->_queued) {
+        return;
+    }
+
+    // Once back in epoll connection could be taken by any worker, deadline stays in this one's wheel
+    _deadlines->Arm(pconn, *_pConfig, now);
+
+    // Rearm connection
+    pconn->_event.events |= EPOLLONESHOT;
+    int epoll_ctl_retval;
+    if ((epoll_ctl_retval = epoll_ctl(_epoll_fd, EPOLL_CTL_MOD, pconn->_socket, &pconn->_event))) {
+        _logger->debug("epoll_ctl failed during connection rearm: error {}", epoll_ctl_retval);
+        pconn->OnError();
+        Close(pconn);
+    }
+}
+
+// See Worker.h
+void Worker::Close(Connection *pconn) {
+    if (epoll_ctl(_epoll_fd, EPOLL_CTL_DEL, pconn->_socket, &pconn->_event)) {
+        _logger->error("Failed to delete connection from epoll");
+    }
+    Deadlines::Cancel(pconn);
+    _registry->Remove(pconn);
+    pconn->_output.Abandon(pconn->_socket);
+    close(pconn->_socket);
+
+    if (pconn->_queued) {
+        _ready.erase(pconn->_ready_pos);
+    }
+    if (_server_socket != -1) {
+        _connections.fetch_sub(1, std::memory_order_relaxed);
+    }
+    delete pconn;
+}
+
+// See Worker.h
+void Worker::OnTimeout() {
+    std::size_t expired = _deadlines->Expire(TimerWheel::Now());
+    if (expired > 0) {
+        _logger->debug("{} connections timed out", expired);
+        _reaped.fetch_add(expired, std::memory_order_relaxed);
+    }
+}
+
 } // namespace MTnonblock
 } // namespace Network
 } // namespace Afina
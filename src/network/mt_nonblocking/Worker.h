@@ -2,6 +2,9 @@
 #define AFINA_NETWORK_MT_NONBLOCKING_WORKER_H
 
 #include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <list>
 #include <memory>
 #include <thread>
 
@@ -18,16 +21,30 @@ class Service;
 }
 
 namespace Network {
+
+// Forward declaration, see afina/network/Config.h
+class Config;
+class OutputQuota;
+
 namespace MTnonblock {
 
+class Connection;
+class ConnectionSet;
+class Deadlines;
+
 /**
  * # Thread running epoll
  * On Start spaws background thread that is doing epoll on the given server
  * socket and process incoming connections and its data
+ *
+ * Each loop iteration every ready connection gets a single turn limited by Config::fair_budget
+ * commands. Connection which has more to do goes to the back of the worker's ready list and
+ * waits for the next iteration, so a client pipelining lots of commands can't delay others
  */
 class Worker {
 public:
-    Worker(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Afina::Logging::Service> pl);
+    Worker(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Afina::Logging::Service> pl,
+           std::shared_ptr<Config> pc, std::shared_ptr<OutputQuota> pq, std::shared_ptr<ConnectionSet> pr);
     ~Worker();
 
     Worker(Worker &&);
@@ -36,9 +53,12 @@ public:
     /**
      * Spaws new background thread that is doing epoll on the given server
      * socket. Once connection accepted it must be registered and being processed
-     * on this thread
+     * on this thread. Thread is woken up on stop by the event_fd registered in epoll
+     *
+     * If server_socket is given then epoll instance is private for the worker: it accepts
+     * connections from that socket by itself and keeps them till the end
      */
-    void Start(int epoll_fd);
+    void Start(int epoll_fd, int event_fd, int server_socket = -1);
 
     /**
      * Signal background thread to stop. After that signal thread must stop to
@@ -54,12 +74,70 @@ public:
      */
     void Join();
 
+    /**
+     * Number of connections accepted by this worker, private listener mode only
+     */
+    uint64_t AcceptedConnections() const { return _accepted.load(std::memory_order_relaxed); }
+
+    /**
+     * Average number of accepted connections per second since worker start
+     */
+    double AcceptRate() const;
+
+    /**
+     * Number of connections currently served by this worker, private listener mode only
+     */
+    uint64_t OpenConnections() const { return _connections.load(std::memory_order_relaxed); }
+
+    /**
+     * Number of connections found timed out by this worker
+     */
+    uint64_t ReapedConnections() const { return _reaped.load(std::memory_order_relaxed); }
+
+    /**
+     * Arms deadline of the new connection in this worker's wheel, called by acceptors in shared
+     * epoll mode before connection gets into epoll
+     */
+    void Arm(Connection *pc, uint64_t now_ms);
+
 protected:
     /**
      * Method executing by background thread
      */
     void OnRun();
 
+    /**
+     * Accepts all pending connections from the private server socket and registers
+     * them in the worker's epoll
+     */
+    void OnNewConnection();
+
+    /**
+     * Shuts down connections which missed their deadlines, see Config and Deadlines::Expire
+     */
+    void OnTimeout();
+
+    /**
+     * Stops accepting new connections and reading new commands, see Stop
+     */
+    void OnStop();
+
+    /**
+     * Gives a turn to every connection which didn't finish its work on the previous iterations
+     */
+    void OnReady();
+
+    /**
+     * Applies connection state after its turn: updates epoll registration, deadline and place
+     * in the ready list, or deletes connection if it is dead
+     */
+    void Reschedule(Connection *pconn, uint32_t old_mask, uint64_t now);
+
+    /**
+     * Unregisters, closes and deletes connection
+     */
+    void Close(Connection *pconn);
+
 private:
     Worker(Worker &) = delete;
     Worker &operator=(Worker &) = delete;
@@ -73,6 +151,18 @@ private:
     // Logger to be used
     std::shared_ptr<spdlog::logger> _logger;
 
+    // Network settings
+    std::shared_ptr<Config> _pConfig;
+
+    // Memory taken by responses, shared with other workers
+    std::shared_ptr<OutputQuota> _quota;
+
+    // Connections served by this worker, shared with other workers in shared epoll mode
+    std::shared_ptr<ConnectionSet> _registry;
+
+    // Deadlines of connections this worker served last
+    std::unique_ptr<Deadlines> _deadlines;
+
     // Flag signals that thread should continue to operate
     std::atomic<bool> isRunning;
 
@@ -81,6 +171,24 @@ private:
 
     // EPOLL descriptor using for events processing
     int _epoll_fd;
+
+    // Stop notification registered in the epoll
+    int _event_fd;
+
+    // Private listening socket, -1 if connections are accepted by the server
+    int _server_socket;
+
+    // Connections waiting for the turn, see OnReady
+    std::list<Connection *> _ready;
+
+    // Loop iterations counter
+    uint64_t _iteration;
+
+    // Accept statistics, written by worker thread only
+    std::atomic<uint64_t> _accepted;
+    std::atomic<uint64_t> _connections;
+    std::atomic<uint64_t> _reaped;
+    std::chrono::steady_clock::time_point _started;
 };
 
 } // namespace MTnonblock
@@ -20,7 +20,8 @@ namespace STblocking {
  */
 class ServerImpl : public Server {
 public:
-    ServerImpl(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Logging::Service> pl);
+    ServerImpl(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Logging::Service> pl,
+               std::shared_ptr<Config> pc);
     ~ServerImpl();
 
     // See Server.h
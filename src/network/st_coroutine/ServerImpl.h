@@ -2,10 +2,14 @@
 #define AFINA_NETWORK_ST_COROUTINE_SERVER_H
 
 #include <thread>
+#include <unordered_set>
 #include <vector>
 
 #include <afina/network/Server.h>
 
+#include "network/common/OutputQuota.h"
+#include "network/common/TimerWheel.h"
+
 namespace spdlog {
 class logger;
 }
@@ -16,6 +20,7 @@ namespace STcoroutine {
 
 // Forward declaration, see Worker.h
 class Worker;
+class Connection;
 
 /**
  * # Network resource manager implementation
@@ -23,7 +28,8 @@ class Worker;
  */
 class ServerImpl : public Server {
 public:
-    ServerImpl(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Logging::Service> pl);
+    ServerImpl(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Logging::Service> pl,
+               std::shared_ptr<Config> pc);
     ~ServerImpl();
 
     // See Server.h
@@ -35,10 +41,29 @@ public:
     // See Server.h
     void Join() override;
 
+    // See Server.h
+    std::vector<int> ListenSockets() const override;
+
 protected:
     void OnRun();
     void OnNewConnection(int);
 
+    /**
+     * Closes connections which missed their deadlines, see Config
+     */
+    void OnTimeout(int epoll_descr);
+
+    /**
+     * Stops accepting new connections and reading new commands. Server stops once all
+     * connections are closed
+     */
+    void OnStop(int epoll_descr);
+
+    /**
+     * Unregisters, closes and deletes connection
+     */
+    void Close(int epoll_descr, Connection *pc);
+
 private:
     // logger to use
     std::shared_ptr<spdlog::logger> _logger;
@@ -56,6 +81,18 @@ private:
 
     // IO thread
     std::thread _work_thread;
+
+    // Connection deadlines, accessed by IO thread only
+    TimerWheel _wheel;
+
+    // Number of connections closed due to timeout
+    uint64_t _reaped;
+
+    // Alive connections, accessed by IO thread only
+    std::unordered_set<Connection *> _connections;
+
+    // Memory taken by responses
+    std::shared_ptr<OutputQuota> _quota;
 };
 
 } // namespace STcoroutine
@@ -1,36 +1,23 @@
 #ifndef AFINA_NETWORK_ST_NONBLOCKING_CONNECTION_H
 #define AFINA_NETWORK_ST_NONBLOCKING_CONNECTION_H
 
-#include <cstring>
+#include <memory>
 
-#include <sys/epoll.h>
+#include "network/common/Connection.h"
 
 namespace Afina {
 namespace Network {
 namespace STnonblock {
 
-class Connection {
+// Connection served by the single server loop, see Network::Connection
+class Connection : public Network::Connection {
 public:
-    Connection(int s) : _socket(s) {
-        std::memset(&_event, 0, sizeof(struct epoll_event));
-        _event.data.ptr = this;
-    }
-
-    inline bool isAlive() const { return true; }
-
-    void Start();
-
-protected:
-    void OnError();
-    void OnClose();
-    void DoRead();
-    void DoWrite();
+    Connection(int s, std::shared_ptr<Afina::Storage> ps, std::shared_ptr<spdlog::logger> pl,
+               std::shared_ptr<OutputQuota> pq)
+        : Network::Connection(this, s, ps, pl, pq) {}
 
 private:
     friend class ServerImpl;
-
-    int _socket;
-    struct epoll_event _event;
 };
 
 } // namespace STnonblock
@@ -5,6 +5,7 @@
 #include <iostream>
 #include <memory>
 #include <stdexcept>
+#include <vector>
 
 #include <arpa/inet.h>
 #include <netdb.h>
@@ -23,13 +24,16 @@
 
 #include "Connection.h"
 #include "Utils.h"
+#include "network/common/Utils.h"
 
 namespace Afina {
 namespace Network {
 namespace STnonblock {
 
 // See Server.h
-ServerImpl::ServerImpl(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Logging::Service> pl) : Server(ps, pl) {}
+ServerImpl::ServerImpl(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Logging::Service> pl,
+                       std::shared_ptr<Config> pc)
+    : Server(ps, pl, pc), _wheel(TimerWheel::Now()), _reaped(0) {}
 
 // See Server.h
 ServerImpl::~ServerImpl() {}
@@ -38,6 +42,8 @@ ServerImpl::~ServerImpl() {}
 void ServerImpl::Start(uint16_t port, uint32_t n_acceptors, uint32_t n_workers) {
     _logger = pLogging->select("network");
     _logger->info("Start st_nonblocking network service");
+    _quota = std::make_shared<OutputQuota>(pConfig->output_high_watermark, pConfig->output_limit,
+                                           pConfig->zerocopy_threshold);
 
     sigset_t sig_mask;
     sigemptyset(&sig_mask);
@@ -46,33 +52,36 @@ void ServerImpl::Start(uint16_t port, uint32_t n_acceptors, uint32_t n_workers)
         throw std::runtime_error("Unable to mask SIGPIPE");
     }
 
-    // Create server socket
-    struct sockaddr_in server_addr;
-    std::memset(&server_addr, 0, sizeof(server_addr));
-    server_addr.sin_family = AF_INET;         // IPv4
-    server_addr.sin_port = htons(port);       // TCP port number
-    server_addr.sin_addr.s_addr = INADDR_ANY; // Bind to any address
-
-    _server_socket = socket(PF_INET, SOCK_STREAM, IPPROTO_TCP);
+    // Create server socket, unless previous process handed one over
+    _server_socket = take_server_socket(*pConfig, port, false);
     if (_server_socket == -1) {
-        throw std::runtime_error("Failed to open socket: " + std::string(strerror(errno)));
-    }
+        struct sockaddr_in server_addr;
+        std::memset(&server_addr, 0, sizeof(server_addr));
+        server_addr.sin_family = AF_INET;         // IPv4
+        server_addr.sin_port = htons(port);       // TCP port number
+        server_addr.sin_addr.s_addr = INADDR_ANY; // Bind to any address
+
+        _server_socket = socket(PF_INET, SOCK_STREAM, IPPROTO_TCP);
+        if (_server_socket == -1) {
+            throw std::runtime_error("Failed to open socket: " + std::string(strerror(errno)));
+        }
 
-    int opts = 1;
-    if (setsockopt(_server_socket, SOL_SOCKET, (SO_KEEPALIVE), &opts, sizeof(opts)) == -1) {
-        close(_server_socket);
-        throw std::runtime_error("Socket setsockopt() failed: " + std::string(strerror(errno)));
-    }
+        int opts = 1;
+        if (setsockopt(_server_socket, SOL_SOCKET, (SO_KEEPALIVE), &opts, sizeof(opts)) == -1) {
+            close(_server_socket);
+            throw std::runtime_error("Socket setsockopt() failed: " + std::string(strerror(errno)));
+        }
 
-    if (bind(_server_socket, (struct sockaddr *)&server_addr, sizeof(server_addr)) == -1) {
-        close(_server_socket);
-        throw std::runtime_error("Socket bind() failed: " + std::string(strerror(errno)));
-    }
+        if (bind(_server_socket, (struct sockaddr *)&server_addr, sizeof(server_addr)) == -1) {
+            close(_server_socket);
+            throw std::runtime_error("Socket bind() failed: " + std::string(strerror(errno)));
+        }
 
-    make_socket_non_blocking(_server_socket);
-    if (listen(_server_socket, 5) == -1) {
-        close(_server_socket);
-        throw std::runtime_error("Socket listen() failed: " + std::string(strerror(errno)));
+        make_socket_non_blocking(_server_socket);
+        if (listen(_server_socket, 5) == -1) {
+            close(_server_socket);
+            throw std::runtime_error("Socket listen() failed: " + std::string(strerror(errno)));
+        }
     }
 
     _event_fd = eventfd(0, EFD_NONBLOCK);
@@ -93,10 +102,18 @@ void ServerImpl::Stop() {
     }
 }
 
+// See Server.h
+std::vector<int> ServerImpl::ListenSockets() const { return std::vector<int>(1, _server_socket); }
+
 // See Server.h
 void ServerImpl::Join() {
     // Wait for work to be complete
     _work_thread.join();
+    _logger->warn("Closed {} connections due to timeout", _reaped);
+    _logger->warn("Output peak {} bytes, reading paused {} times by connection and {} by server limit, "
+                  "{} bytes sent with zerocopy and {} copied anyway",
+                  _quota->Peak(), _quota->Paused(), _quota->Throttled(), _quota->Zerocopied(),
+                  _quota->ZerocopyCopied());
 }
 
 // See ServerImpl.h
@@ -121,17 +138,21 @@ void ServerImpl::OnRun() {
         throw std::runtime_error("Failed to add file descriptor to epoll");
     }
 
-    bool run = true;
+    bool stopping = false;
     std::array<struct epoll_event, 64> mod_list;
-    while (run) {
-        int nmod = epoll_wait(epoll_descr, &mod_list[0], mod_list.size(), -1);
+    while (!stopping || !_connections.empty()) {
+        // Sleep no longer than till the nearest connection deadline
+        int timeout = _wheel.NextTimeout(TimerWheel::Now());
+        int nmod = epoll_wait(epoll_descr, &mod_list[0], mod_list.size(), timeout);
         _logger->debug("Acceptor wokeup: {} events", nmod);
 
+        uint64_t now = TimerWheel::Now();
         for (int i = 0; i < nmod; i++) {
             struct epoll_event &current_event = mod_list[i];
             if (current_event.data.fd == _event_fd) {
                 _logger->debug("Break acceptor due to stop signal");
-                run = false;
+                stopping = true;
+                OnStop(epoll_descr);
                 continue;
             } else if (current_event.data.fd == _server_socket) {
                 OnNewConnection(epoll_descr);
@@ -142,41 +163,23 @@ void ServerImpl::OnRun() {
             Connection *pc = static_cast<Connection *>(current_event.data.ptr);
 
             auto old_mask = pc->_event.events;
-            if ((current_event.events & EPOLLERR) || (current_event.events & EPOLLHUP)) {
-                pc->OnError();
-            } else if (current_event.events & EPOLLRDHUP) {
-                pc->OnClose();
-            } else {
-                // Depends on what connection wants...
-                if (current_event.events & EPOLLIN) {
-                    pc->DoRead();
-                }
-                if (current_event.events & EPOLLOUT) {
-                    pc->DoWrite();
-                }
-            }
+            pc->OnEvent(current_event.events);
 
             // Does it alive?
             if (!pc->isAlive()) {
-                if (epoll_ctl(epoll_descr, EPOLL_CTL_DEL, pc->_socket, &pc->_event)) {
-                    _logger->error("Failed to delete connection from epoll");
-                }
-
-                close(pc->_socket);
-                pc->OnClose();
-
-                delete pc;
+                Close(epoll_descr, pc);
+                continue;
             } else if (pc->_event.events != old_mask) {
                 if (epoll_ctl(epoll_descr, EPOLL_CTL_MOD, pc->_socket, &pc->_event)) {
                     _logger->error("Failed to change connection event mask");
-
-                    close(pc->_socket);
-                    pc->OnClose();
-
-                    delete pc;
+                    Close(epoll_descr, pc);
+                    continue;
                 }
             }
+            pc->_timer.Update(_wheel, *pConfig, pc->_session, pc->_output, now);
         }
+
+        OnTimeout(epoll_descr);
     }
     _logger->warn("Acceptor stopped");
 }
@@ -207,7 +210,7 @@ void ServerImpl::OnNewConnection(int epoll_descr) {
         }
 
         // Register the new FD to be monitored by epoll.
-        Connection *pc = new(std::nothrow) Connection(infd);
+        Connection *pc = new (std::nothrow) Connection(infd, pStorage, _logger, _quota);
         if (pc == nullptr) {
             throw std::runtime_error("Failed to allocate connection");
         }
@@ -217,12 +220,57 @@ void ServerImpl::OnNewConnection(int epoll_descr) {
         if (pc->isAlive()) {
             if (epoll_ctl(epoll_descr, EPOLL_CTL_ADD, pc->_socket, &pc->_event)) {
                 pc->OnError();
+                close(pc->_socket);
                 delete pc;
+                continue;
             }
+            _connections.insert(pc);
+            pc->_timer.Update(_wheel, *pConfig, pc->_session, pc->_output, TimerWheel::Now());
         }
     }
 }
 
+// See ServerImpl.h
+void ServerImpl::OnTimeout(int epoll_descr) {
+    std::vector<TimerWheel::Timer *> expired;
+    _wheel.Expire(TimerWheel::Now(), expired);
+
+    for (TimerWheel::Timer *timer : expired) {
+        Connection *pc = static_cast<Connection *>(static_cast<ConnectionTimer *>(timer)->Owner());
+        _logger->debug("Connection on descriptor {} timed out", pc->_socket);
+        Close(epoll_descr, pc);
+        _reaped++;
+    }
+}
+
+// See ServerImpl.h
+void ServerImpl::OnStop(int epoll_descr) {
+    // No more new connections...
+    if (epoll_ctl(epoll_descr, EPOLL_CTL_DEL, _server_socket, nullptr)) {
+        _logger->error("Failed to delete server socket from epoll");
+    }
+    if (epoll_ctl(epoll_descr, EPOLL_CTL_DEL, _event_fd, nullptr)) {
+        _logger->error("Failed to delete stop signal from epoll");
+    }
+
+    // ...and no more new commands: connection reads what client has sent so far, gets EOF and
+    // closes once responses are sent
+    for (Connection *pc : _connections) {
+        shutdown(pc->_socket, SHUT_RD);
+    }
+}
+
+// See ServerImpl.h
+void ServerImpl::Close(int epoll_descr, Connection *pc) {
+    if (epoll_ctl(epoll_descr, EPOLL_CTL_DEL, pc->_socket, &pc->_event)) {
+        _logger->error("Failed to delete connection from epoll");
+    }
+    pc->_output.Abandon(pc->_socket);
+    close(pc->_socket);
+    _connections.erase(pc);
+    delete pc;
+}
+
 } // namespace STnonblock
 } // namespace Network
 } // namespace Afina
@@ -0,0 +1,64 @@
+#ifndef AFINA_NETWORK_URING_CONNECTION_H
+#define AFINA_NETWORK_URING_CONNECTION_H
+
+#include <cstring>
+#include <memory>
+
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+#include "network/common/OutputBuffer.h"
+#include "network/common/Session.h"
+
+namespace Afina {
+namespace Network {
+namespace Uring {
+
+/**
+ * # Connection served by io_uring worker
+ * Keeps protocol state and responses which are not yet sent. Object must stay alive
+ * until the last request submitted on its behalf gets completed. Responses are sent by
+ * sendmsg requests only, so values kept in files are read to memory
+ */
+class Connection {
+public:
+    Connection(int s, std::shared_ptr<Afina::Storage> ps, std::shared_ptr<spdlog::logger> pl)
+        : _socket(s), _recv_armed(false), _send_armed(false), _closing(false), _broken(false), _session(ps, pl),
+          _output(nullptr, false) {
+        std::memset(&_msg, 0, sizeof(_msg));
+        _msg.msg_iov = _iov;
+    }
+
+private:
+    friend class Worker;
+
+    // Max number of responses written by a single send request
+    static constexpr int kMaxIov = 64;
+
+    int _socket;
+
+    // There is multishot recv request in the ring
+    bool _recv_armed;
+
+    // There is sendmsg request in the ring, kernel reads _msg and output chunks
+    bool _send_armed;
+
+    // No more input will be processed, connection closes as soon as output drained
+    bool _closing;
+
+    // Socket failed, output must be dropped
+    bool _broken;
+
+    Session _session;
+    OutputBuffer _output;
+
+    // Arguments of the send request in flight
+    struct msghdr _msg;
+    struct iovec _iov[kMaxIov];
+};
+
+} // namespace Uring
+} // namespace Network
+} // namespace Afina
+
+#endif // AFINA_NETWORK_URING_CONNECTION_H
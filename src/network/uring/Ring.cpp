@@ -0,0 +1,223 @@
+#include "Ring.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace Afina {
+namespace Network {
+namespace Uring {
+
+namespace {
+
+int io_uring_setup(unsigned entries, struct io_uring_params *p) {
+    return static_cast<int>(syscall(__NR_io_uring_setup, entries, p));
+}
+
+int io_uring_enter(int fd, unsigned to_submit, unsigned min_complete, unsigned flags) {
+    return static_cast<int>(syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, nullptr, 0));
+}
+
+int io_uring_register(int fd, unsigned opcode, void *arg, unsigned nr_args) {
+    return static_cast<int>(syscall(__NR_io_uring_register, fd, opcode, arg, nr_args));
+}
+
+template <typename T> T *ring_offset(void *base, uint32_t offset) {
+    return reinterpret_cast<T *>(static_cast<char *>(base) + offset);
+}
+
+} // namespace
+
+// See Ring.h
+Ring::Ring(unsigned entries)
+    : _ring_fd(-1), _sq_ptr(MAP_FAILED), _sq_size(0), _cq_ptr(MAP_FAILED), _cq_size(0), _sqes(nullptr),
+      _sqes_size(0), _sqe_tail(0), _sqe_head(0), _enter_calls(0) {
+    struct io_uring_params params;
+    std::memset(&params, 0, sizeof(params));
+
+    _ring_fd = io_uring_setup(entries, &params);
+    if (_ring_fd < 0) {
+        throw std::runtime_error("io_uring_setup() failed: " + std::string(strerror(errno)));
+    }
+
+    _sq_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    _cq_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    if (params.features & IORING_FEAT_SINGLE_MMAP) {
+        _sq_size = _cq_size = std::max(_sq_size, _cq_size);
+    }
+
+    _sq_ptr = mmap(nullptr, _sq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _ring_fd, IORING_OFF_SQ_RING);
+    if (_sq_ptr == MAP_FAILED) {
+        close(_ring_fd);
+        throw std::runtime_error("Failed to map io_uring submission queue: " + std::string(strerror(errno)));
+    }
+
+    if (params.features & IORING_FEAT_SINGLE_MMAP) {
+        _cq_ptr = _sq_ptr;
+    } else {
+        _cq_ptr =
+            mmap(nullptr, _cq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _ring_fd, IORING_OFF_CQ_RING);
+        if (_cq_ptr == MAP_FAILED) {
+            munmap(_sq_ptr, _sq_size);
+            close(_ring_fd);
+            throw std::runtime_error("Failed to map io_uring completion queue: " + std::string(strerror(errno)));
+        }
+    }
+
+    _sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+    void *sqes = mmap(nullptr, _sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _ring_fd, IORING_OFF_SQES);
+    if (sqes == MAP_FAILED) {
+        if (_cq_ptr != _sq_ptr) {
+            munmap(_cq_ptr, _cq_size);
+        }
+        munmap(_sq_ptr, _sq_size);
+        close(_ring_fd);
+        throw std::runtime_error("Failed to map io_uring entries: " + std::string(strerror(errno)));
+    }
+    _sqes = static_cast<struct io_uring_sqe *>(sqes);
+
+    _sq_head = ring_offset<unsigned>(_sq_ptr, params.sq_off.head);
+    _sq_tail = ring_offset<unsigned>(_sq_ptr, params.sq_off.tail);
+    _sq_mask = *ring_offset<unsigned>(_sq_ptr, params.sq_off.ring_mask);
+    _sq_entries = *ring_offset<unsigned>(_sq_ptr, params.sq_off.ring_entries);
+    _sq_array = ring_offset<unsigned>(_sq_ptr, params.sq_off.array);
+
+    _cq_head = ring_offset<unsigned>(_cq_ptr, params.cq_off.head);
+    _cq_tail = ring_offset<unsigned>(_cq_ptr, params.cq_off.tail);
+    _cq_mask = *ring_offset<unsigned>(_cq_ptr, params.cq_off.ring_mask);
+    _cqes = ring_offset<struct io_uring_cqe>(_cq_ptr, params.cq_off.cqes);
+
+    _sqe_head = _sqe_tail = *_sq_tail;
+}
+
+// See Ring.h
+Ring::~Ring() {
+    munmap(_sqes, _sqes_size);
+    if (_cq_ptr != _sq_ptr) {
+        munmap(_cq_ptr, _cq_size);
+    }
+    munmap(_sq_ptr, _sq_size);
+    close(_ring_fd);
+}
+
+// See Ring.h
+struct io_uring_sqe *Ring::GetSqe() {
+    unsigned head = __atomic_load_n(_sq_head, __ATOMIC_ACQUIRE);
+    if (_sqe_tail - head >= _sq_entries) {
+        Submit();
+        head = __atomic_load_n(_sq_head, __ATOMIC_ACQUIRE);
+        if (_sqe_tail - head >= _sq_entries) {
+            throw std::runtime_error("io_uring submission queue overflow");
+        }
+    }
+
+    struct io_uring_sqe *sqe = &_sqes[_sqe_tail & _sq_mask];
+    std::memset(sqe, 0, sizeof(*sqe));
+    _sqe_tail++;
+    return sqe;
+}
+
+// See Ring.h
+int Ring::Submit(unsigned wait_nr) {
+    // Publish new entries to kernel
+    unsigned to_submit = _sqe_tail - _sqe_head;
+    if (to_submit > 0) {
+        unsigned tail = *_sq_tail;
+        for (; _sqe_head != _sqe_tail; _sqe_head++, tail++) {
+            _sq_array[tail & _sq_mask] = _sqe_head & _sq_mask;
+        }
+        __atomic_store_n(_sq_tail, tail, __ATOMIC_RELEASE);
+    }
+
+    if (to_submit == 0 && wait_nr == 0) {
+        return 0;
+    }
+
+    unsigned flags = wait_nr > 0 ? IORING_ENTER_GETEVENTS : 0;
+    int ret;
+    do {
+        _enter_calls++;
+        ret = io_uring_enter(_ring_fd, to_submit, wait_nr, flags);
+    } while (ret < 0 && errno == EINTR);
+
+    if (ret < 0) {
+        throw std::runtime_error("io_uring_enter() failed: " + std::string(strerror(errno)));
+    }
+    return ret;
+}
+
+// See Ring.h
+struct io_uring_cqe *Ring::PeekCqe() {
+    unsigned head = *_cq_head;
+    if (head == __atomic_load_n(_cq_tail, __ATOMIC_ACQUIRE)) {
+        return nullptr;
+    }
+    return &_cqes[head & _cq_mask];
+}
+
+// See Ring.h
+void Ring::Seen() { __atomic_store_n(_cq_head, *_cq_head + 1, __ATOMIC_RELEASE); }
+
+// See Ring.h
+BufferRing::BufferRing(Ring &ring, uint16_t group, unsigned entries, std::size_t buffer_size)
+    : _ring(ring), _group(group), _entries(entries), _buffer_size(buffer_size), _br(nullptr), _br_size(0),
+      _buffers(nullptr) {
+    if (entries == 0 || (entries & (entries - 1)) != 0) {
+        throw std::runtime_error("Number of provided buffers must be power of 2");
+    }
+
+    // Ring memory must be page aligned, anonymous mapping gives that for free
+    _br_size = entries * sizeof(struct io_uring_buf) + entries * buffer_size;
+    void *mem = mmap(nullptr, _br_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mem == MAP_FAILED) {
+        throw std::runtime_error("Failed to allocate provided buffers: " + std::string(strerror(errno)));
+    }
+    _br = static_cast<struct io_uring_buf_ring *>(mem);
+    _buffers = static_cast<char *>(mem) + entries * sizeof(struct io_uring_buf);
+
+    struct io_uring_buf_reg reg;
+    std::memset(&reg, 0, sizeof(reg));
+    reg.ring_addr = reinterpret_cast<uint64_t>(_br);
+    reg.ring_entries = entries;
+    reg.bgid = group;
+    if (io_uring_register(_ring.fd(), IORING_REGISTER_PBUF_RING, &reg, 1) < 0) {
+        munmap(mem, _br_size);
+        throw std::runtime_error("Failed to register provided buffers: " + std::string(strerror(errno)));
+    }
+
+    _br->tail = 0;
+    for (unsigned bid = 0; bid < entries; bid++) {
+        Recycle(bid);
+    }
+}
+
+// See Ring.h
+BufferRing::~BufferRing() {
+    struct io_uring_buf_reg reg;
+    std::memset(&reg, 0, sizeof(reg));
+    reg.bgid = _group;
+    io_uring_register(_ring.fd(), IORING_UNREGISTER_PBUF_RING, &reg, 1);
+    munmap(_br, _br_size);
+}
+
+// See Ring.h
+void BufferRing::Recycle(uint16_t bid) {
+    // Do not use io_uring_buf_ring::bufs: in C++ its flex array wrapper is shifted by an empty
+    // struct member, while kernel expects entries to start at the very beginning of the ring
+    uint16_t tail = _br->tail;
+    struct io_uring_buf *buf = reinterpret_cast<struct io_uring_buf *>(_br) + (tail & (_entries - 1));
+    buf->addr = reinterpret_cast<uint64_t>(Buffer(bid));
+    buf->len = static_cast<uint32_t>(_buffer_size);
+    buf->bid = bid;
+    __atomic_store_n(&_br->tail, static_cast<uint16_t>(tail + 1), __ATOMIC_RELEASE);
+}
+
+} // namespace Uring
+} // namespace Network
+} // namespace Afina
@@ -0,0 +1,133 @@
+#ifndef AFINA_NETWORK_URING_RING_H
+#define AFINA_NETWORK_URING_RING_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include <linux/io_uring.h>
+
+namespace Afina {
+namespace Network {
+namespace Uring {
+
+/**
+ * # Minimal io_uring instance
+ * Owns submission/completion queues of a single ring. There is no liburing dependency,
+ * the class talks to kernel using raw io_uring_setup/io_uring_enter syscalls.
+ *
+ * Not thread safe, ring must be used from the only thread
+ */
+class Ring {
+public:
+    explicit Ring(unsigned entries);
+    ~Ring();
+
+    /**
+     * Returns next free submission entry, zeroed. If submission queue is full then
+     * pending entries get submitted first
+     */
+    struct io_uring_sqe *GetSqe();
+
+    /**
+     * Submits all pending entries and waits till at least wait_nr completions are
+     * available. Single io_uring_enter call is used for both
+     */
+    int Submit(unsigned wait_nr = 0);
+
+    /**
+     * Returns next completion or nullptr if completion queue is empty, entry must
+     * be released by Seen after use
+     */
+    struct io_uring_cqe *PeekCqe();
+
+    /**
+     * Releases completion entry returned by PeekCqe
+     */
+    void Seen();
+
+    /**
+     * Descriptor of the ring, for io_uring_register calls
+     */
+    int fd() const { return _ring_fd; }
+
+    /**
+     * Number of io_uring_enter syscalls issued so far
+     */
+    uint64_t EnterCalls() const { return _enter_calls; }
+
+private:
+    Ring(const Ring &) = delete;
+    Ring &operator=(const Ring &) = delete;
+
+    int _ring_fd;
+
+    // Mapped regions
+    void *_sq_ptr;
+    std::size_t _sq_size;
+    void *_cq_ptr;
+    std::size_t _cq_size;
+    struct io_uring_sqe *_sqes;
+    std::size_t _sqes_size;
+
+    // Submission queue, shared with kernel
+    unsigned *_sq_head;
+    unsigned *_sq_tail;
+    unsigned _sq_mask;
+    unsigned _sq_entries;
+    unsigned *_sq_array;
+
+    // Entries filled by us but not published to kernel yet
+    unsigned _sqe_tail;
+    unsigned _sqe_head;
+
+    // Completion queue, shared with kernel
+    unsigned *_cq_head;
+    unsigned *_cq_tail;
+    unsigned _cq_mask;
+    struct io_uring_cqe *_cqes;
+
+    uint64_t _enter_calls;
+};
+
+/**
+ * # Provided buffers ring
+ * Pool of equal sized buffers registered in the ring under the given group. Kernel picks
+ * buffers on its own for the requests with IOSQE_BUFFER_SELECT, so there is no need to
+ * preallocate receive buffer for each connection
+ */
+class BufferRing {
+public:
+    BufferRing(Ring &ring, uint16_t group, unsigned entries, std::size_t buffer_size);
+    ~BufferRing();
+
+    uint16_t group() const { return _group; }
+
+    /**
+     * Address of the buffer with the given id
+     */
+    char *Buffer(uint16_t bid) const { return _buffers + bid * _buffer_size; }
+
+    /**
+     * Returns buffer back to kernel
+     */
+    void Recycle(uint16_t bid);
+
+private:
+    BufferRing(const BufferRing &) = delete;
+    BufferRing &operator=(const BufferRing &) = delete;
+
+    Ring &_ring;
+    uint16_t _group;
+    unsigned _entries;
+    std::size_t _buffer_size;
+
+    struct io_uring_buf_ring *_br;
+    std::size_t _br_size;
+    char *_buffers;
+};
+
+} // namespace Uring
+} // namespace Network
+} // namespace Afina
+
+#endif // AFINA_NETWORK_URING_RING_H
@@ -0,0 +1,99 @@
+#include "ServerImpl.h"
+
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#include <pthread.h>
+#include <signal.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <spdlog/logger.h>
+
+#include <afina/Storage.h>
+#include <afina/logging/Service.h>
+
+#include "Utils.h"
+#include "Worker.h"
+#include "network/common/Utils.h"
+
+namespace Afina {
+namespace Network {
+namespace Uring {
+
+// See Server.h
+ServerImpl::ServerImpl(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Logging::Service> pl,
+                       std::shared_ptr<Config> pc)
+    : Server(ps, pl, pc), _event_fd(-1) {}
+
+// See Server.h
+ServerImpl::~ServerImpl() {}
+
+// See Server.h
+void ServerImpl::Start(uint16_t port, uint32_t n_acceptors, uint32_t n_workers) {
+    _logger = pLogging->select("network");
+    _logger->info("Start io_uring network service");
+
+    sigset_t sig_mask;
+    sigemptyset(&sig_mask);
+    sigaddset(&sig_mask, SIGPIPE);
+    if (pthread_sigmask(SIG_BLOCK, &sig_mask, NULL) != 0) {
+        throw std::runtime_error("Unable to mask SIGPIPE");
+    }
+
+    _event_fd = eventfd(0, EFD_NONBLOCK);
+    if (_event_fd == -1) {
+        throw std::runtime_error("Failed to create event file descriptor: " + std::string(strerror(errno)));
+    }
+
+    // Acceptors are not used: every worker accepts connections from its own socket
+    _workers.reserve(n_workers);
+    for (uint32_t i = 0; i < n_workers; i++) {
+        int server_socket = take_server_socket(*pConfig, port, true);
+        if (server_socket == -1) {
+            server_socket = make_server_socket(port, true);
+        }
+        _listen_sockets.push_back(server_socket);
+        _workers.emplace_back(new Worker(pStorage, pLogging));
+        _workers.back()->Start(_listen_sockets.back(), _event_fd);
+    }
+}
+
+// See Server.h
+void ServerImpl::Stop() {
+    _logger->warn("Stop network service");
+
+    // Wakeup all rings, eventfd stays readable so each worker gets its notification
+    if (eventfd_write(_event_fd, 1)) {
+        throw std::runtime_error("Failed to wakeup workers");
+    }
+}
+
+// See Server.h
+std::vector<int> ServerImpl::ListenSockets() const { return _listen_sockets; }
+
+// See Server.h
+void ServerImpl::Join() {
+    for (auto &w : _workers) {
+        w->Join();
+    }
+
+    for (std::size_t i = 0; i < _workers.size(); i++) {
+        uint64_t requests = _workers[i]->Requests();
+        uint64_t enters = _workers[i]->EnterCalls();
+        _logger->warn("Worker {}: {} requests, {} io_uring_enter calls, {:.3f} syscalls per request", i, requests,
+                      enters, requests > 0 ? double(enters) / requests : 0.0);
+    }
+
+    for (int fd : _listen_sockets) {
+        close(fd);
+    }
+    _listen_sockets.clear();
+    _workers.clear();
+    close(_event_fd);
+}
+
+} // namespace Uring
+} // namespace Network
+} // namespace Afina
@@ -0,0 +1,23 @@
+#ifndef AFINA_NETWORK_URING_UTILS_H
+#define AFINA_NETWORK_URING_UTILS_H
+
+#include <cstdint>
+
+namespace Afina {
+namespace Network {
+namespace Uring {
+
+void make_socket_non_blocking(int sfd);
+
+/**
+ * Creates non-blocking server socket listening on the given port. If reuse_port is set then
+ * socket gets SO_REUSEPORT option so that many sockets could share the same port and kernel
+ * balances incoming connections between them
+ */
+int make_server_socket(uint16_t port, bool reuse_port);
+
+} // namespace Uring
+} // namespace Network
+} // namespace Afina
+
+#endif // AFINA_NETWORK_URING_UTILS_H
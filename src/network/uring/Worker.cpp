@@ -0,0 +1,296 @@
+#include "Worker.h"
+
+#include <cassert>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <spdlog/logger.h>
+
+#include <afina/Storage.h>
+#include <afina/logging/Service.h>
+
+#include "Connection.h"
+#include "Ring.h"
+
+namespace Afina {
+namespace Network {
+namespace Uring {
+
+namespace {
+
+// Ring and provided buffers sizing
+constexpr unsigned kRingEntries = 256;
+constexpr unsigned kBufferCount = 512;
+constexpr std::size_t kBufferSize = 4096;
+constexpr uint16_t kBufferGroup = 0;
+
+inline uint64_t make_tag(void *ptr, uint64_t op) { return reinterpret_cast<uint64_t>(ptr) | op; }
+inline uint64_t tag_op(uint64_t tag) { return tag & 0x7; }
+inline Connection *tag_conn(uint64_t tag) { return reinterpret_cast<Connection *>(tag & ~uint64_t(0x7)); }
+
+} // namespace
+
+// See Worker.h
+Worker::Worker(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Afina::Logging::Service> pl)
+    : _pStorage(ps), _pLogging(pl), _server_socket(-1), _event_fd(-1), _stopping(false), _accept_armed(false),
+      _requests(0), _enter_calls(0) {}
+
+// See Worker.h
+Worker::~Worker() {}
+
+// See Worker.h
+void Worker::Start(int server_socket, int event_fd) {
+    _server_socket = server_socket;
+    _event_fd = event_fd;
+    _logger = _pLogging->select("network.worker");
+
+    // Create ring in the caller thread, so setup errors are reported by Server::Start
+    _ring.reset(new Ring(kRingEntries));
+    _buffers.reset(new BufferRing(*_ring, kBufferGroup, kBufferCount, kBufferSize));
+
+    _thread = std::thread(&Worker::OnRun, this);
+}
+
+// See Worker.h
+void Worker::Join() {
+    assert(_thread.joinable());
+    _thread.join();
+}
+
+// See Worker.h
+void Worker::OnRun() {
+    _logger->trace("OnRun");
+    try {
+        ArmAccept();
+        ArmWakeup();
+
+        while (!_stopping || _accept_armed || !_connections.empty()) {
+            // Everything queued by the previous iteration goes to kernel together with the wait
+            _ring->Submit(1);
+            _enter_calls.store(_ring->EnterCalls(), std::memory_order_relaxed);
+
+            struct io_uring_cqe *cqe;
+            while ((cqe = _ring->PeekCqe()) != nullptr) {
+                uint64_t tag = cqe->user_data;
+                switch (tag_op(tag)) {
+                case kAccept:
+                    OnAccept(cqe);
+                    break;
+                case kWakeup:
+                    OnWakeup();
+                    break;
+                case kRecv:
+                    OnRecv(tag_conn(tag), cqe);
+                    break;
+                case kSend:
+                    OnSend(tag_conn(tag), cqe);
+                    break;
+                default:
+                    break;
+                }
+                _ring->Seen();
+            }
+
+            // Flush responses produced by this batch of completions
+            for (Connection *pc : _dirty) {
+                if (_connections.count(pc) > 0) {
+                    SubmitSend(pc);
+                }
+            }
+            _dirty.clear();
+        }
+    } catch (std::exception &ex) {
+        _logger->error("Worker failed: {}", ex.what());
+    }
+
+    for (Connection *pc : _connections) {
+        close(pc->_socket);
+        delete pc;
+    }
+    _connections.clear();
+    _logger->warn("Worker stopped");
+}
+
+// See Worker.h
+void Worker::ArmAccept() {
+    struct io_uring_sqe *sqe = _ring->GetSqe();
+    sqe->opcode = IORING_OP_ACCEPT;
+    sqe->fd = _server_socket;
+    sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+    sqe->accept_flags = SOCK_CLOEXEC;
+    sqe->user_data = make_tag(nullptr, kAccept);
+    _accept_armed = true;
+}
+
+// See Worker.h
+void Worker::ArmWakeup() {
+    struct io_uring_sqe *sqe = _ring->GetSqe();
+    sqe->opcode = IORING_OP_POLL_ADD;
+    sqe->fd = _event_fd;
+    sqe->poll32_events = POLLIN;
+    sqe->user_data = make_tag(nullptr, kWakeup);
+}
+
+// See Worker.h
+void Worker::ArmRecv(Connection *pc) {
+    struct io_uring_sqe *sqe = _ring->GetSqe();
+    sqe->opcode = IORING_OP_RECV;
+    sqe->fd = pc->_socket;
+    sqe->ioprio = IORING_RECV_MULTISHOT;
+    sqe->flags = IOSQE_BUFFER_SELECT;
+    sqe->buf_group = _buffers->group();
+    sqe->user_data = make_tag(pc, kRecv);
+    pc->_recv_armed = true;
+}
+
+// See Worker.h
+void Worker::SubmitSend(Connection *pc) {
+    if (pc->_send_armed || pc->_output.Empty() || pc->_broken) {
+        return;
+    }
+
+    // Whole batch of responses goes by the single request, chunks stay in place until
+    // completion arrives
+    pc->_msg.msg_iovlen = pc->_output.Prepare(pc->_iov, Connection::kMaxIov);
+
+    struct io_uring_sqe *sqe = _ring->GetSqe();
+    sqe->opcode = IORING_OP_SENDMSG;
+    sqe->fd = pc->_socket;
+    sqe->addr = reinterpret_cast<uint64_t>(&pc->_msg);
+    sqe->msg_flags = MSG_NOSIGNAL;
+    sqe->user_data = make_tag(pc, kSend);
+    pc->_send_armed = true;
+}
+
+// See Worker.h
+void Worker::OnAccept(struct io_uring_cqe *cqe) {
+    if (!(cqe->flags & IORING_CQE_F_MORE)) {
+        _accept_armed = false;
+    }
+
+    if (cqe->res >= 0) {
+        Connection *pc = new (std::nothrow) Connection(cqe->res, _pStorage, _logger);
+        if (pc == nullptr) {
+            throw std::runtime_error("Failed to allocate connection");
+        }
+        _logger->debug("Accepted connection on descriptor {}", cqe->res);
+        _connections.insert(pc);
+        ArmRecv(pc);
+    } else if (cqe->res != -ECANCELED) {
+        _logger->error("Failed to accept socket: {}", strerror(-cqe->res));
+    }
+
+    if (!_accept_armed && !_stopping) {
+        ArmAccept();
+    }
+}
+
+// See Worker.h
+void Worker::OnWakeup() {
+    _logger->debug("Stop worker due to stop signal");
+    _stopping = true;
+
+    // No more new connections...
+    if (_accept_armed) {
+        struct io_uring_sqe *sqe = _ring->GetSqe();
+        sqe->opcode = IORING_OP_ASYNC_CANCEL;
+        sqe->fd = -1;
+        sqe->addr = make_tag(nullptr, kAccept);
+        sqe->user_data = make_tag(nullptr, kCancel);
+    }
+
+    // ...and no more new commands, connections close once responses are sent
+    for (Connection *pc : _connections) {
+        shutdown(pc->_socket, SHUT_RD);
+    }
+}
+
+// See Worker.h
+void Worker::OnRecv(Connection *pc, struct io_uring_cqe *cqe) {
+    bool more = (cqe->flags & IORING_CQE_F_MORE) != 0;
+    if (!more) {
+        pc->_recv_armed = false;
+    }
+
+    if (cqe->flags & IORING_CQE_F_BUFFER) {
+        uint16_t bid = cqe->flags >> IORING_CQE_BUFFER_SHIFT;
+        if (cqe->res > 0 && !pc->_closing) {
+            Process(pc, _buffers->Buffer(bid), cqe->res);
+        }
+        _buffers->Recycle(bid);
+    }
+
+    if (cqe->res == 0) {
+        _logger->debug("Connection closed");
+        pc->_closing = true;
+    } else if (cqe->res < 0 && cqe->res != -ENOBUFS) {
+        _logger->error("Failed to read connection on descriptor {}: {}", pc->_socket, strerror(-cqe->res));
+        pc->_closing = true;
+    }
+
+    // Buffers pool exhausted or kernel decided to stop multishot, just start it again
+    if (!pc->_recv_armed && !pc->_closing) {
+        ArmRecv(pc);
+    }
+    MaybeClose(pc);
+}
+
+// See Worker.h
+void Worker::OnSend(Connection *pc, struct io_uring_cqe *cqe) {
+    pc->_send_armed = false;
+    if (cqe->res < 0) {
+        _logger->error("Failed to send response on descriptor {}: {}", pc->_socket, strerror(-cqe->res));
+        pc->_broken = true;
+        pc->_closing = true;
+        pc->_output.Clear();
+        shutdown(pc->_socket, SHUT_RDWR);
+    } else {
+        pc->_output.Consume(cqe->res);
+    }
+
+    // Short write or new responses queued meanwhile
+    if (!pc->_output.Empty()) {
+        _dirty.push_back(pc);
+    }
+    MaybeClose(pc);
+}
+
+// See Worker.h
+void Worker::Process(Connection *pc, const char *data, std::size_t size) {
+    try {
+        bool was_empty = pc->_output.Empty();
+        std::size_t executed = pc->_session.Process(data, size, pc->_output);
+        _requests.fetch_add(executed, std::memory_order_relaxed);
+        if (was_empty && !pc->_output.Empty()) {
+            _dirty.push_back(pc);
+        }
+    } catch (std::runtime_error &ex) {
+        _logger->error("Failed to process connection on descriptor {}: {}", pc->_socket, ex.what());
+        pc->_closing = true;
+        shutdown(pc->_socket, SHUT_RD);
+    }
+}
+
+// See Worker.h
+bool Worker::MaybeClose(Connection *pc) {
+    if (!pc->_closing || pc->_recv_armed || pc->_send_armed) {
+        return false;
+    }
+    if (!pc->_output.Empty() && !pc->_broken) {
+        return false;
+    }
+
+    close(pc->_socket);
+    _connections.erase(pc);
+    delete pc;
+    return true;
+}
+
+} // namespace Uring
+} // namespace Network
+} // namespace Afina
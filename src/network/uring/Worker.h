@@ -0,0 +1,136 @@
+#ifndef AFINA_NETWORK_URING_WORKER_H
+#define AFINA_NETWORK_URING_WORKER_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+namespace spdlog {
+class logger;
+}
+
+struct io_uring_cqe;
+
+namespace Afina {
+
+// Forward declaration, see afina/Storage.h
+class Storage;
+namespace Logging {
+class Service;
+}
+
+namespace Network {
+namespace Uring {
+
+class Connection;
+class Ring;
+class BufferRing;
+
+/**
+ * # Thread running io_uring
+ * Each worker owns a ring, a pool of provided receive buffers and a private SO_REUSEPORT
+ * listening socket. Connection is accepted, read, executed and written on the same thread:
+ * - one multishot accept request serves all incoming connections
+ * - one multishot recv request per connection, kernel picks receive buffers from the pool
+ * - responses produced by a batch of completions are sent by a single sendmsg request
+ * All requests produced by a loop iteration are submitted by the single io_uring_enter
+ * call which also waits for the next completions
+ */
+class Worker {
+public:
+    Worker(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Afina::Logging::Service> pl);
+    ~Worker();
+
+    /**
+     * Spawns background thread serving connections from the given listening socket. Worker
+     * stops once event_fd become readable
+     */
+    void Start(int server_socket, int event_fd);
+
+    /**
+     * Blocks calling thread until background one for this worker is actually
+     * been destoryed
+     */
+    void Join();
+
+    /**
+     * Number of commands executed by this worker
+     */
+    uint64_t Requests() const { return _requests.load(std::memory_order_relaxed); }
+
+    /**
+     * Number of io_uring_enter syscalls done by this worker
+     */
+    uint64_t EnterCalls() const { return _enter_calls.load(std::memory_order_relaxed); }
+
+protected:
+    /**
+     * Method executing by background thread
+     */
+    void OnRun();
+
+private:
+    Worker(const Worker &) = delete;
+    Worker &operator=(const Worker &) = delete;
+
+    // Kind of request, stored in the low bits of user_data
+    enum Op : uint64_t { kAccept = 0, kWakeup = 1, kRecv = 2, kSend = 3, kCancel = 4 };
+
+    void ArmAccept();
+    void ArmWakeup();
+    void ArmRecv(Connection *pc);
+    void SubmitSend(Connection *pc);
+
+    void OnAccept(struct io_uring_cqe *cqe);
+    void OnWakeup();
+    void OnRecv(Connection *pc, struct io_uring_cqe *cqe);
+    void OnSend(Connection *pc, struct io_uring_cqe *cqe);
+
+    /**
+     * Parses given chunk of data, executes every completed command and queues responses
+     */
+    void Process(Connection *pc, const char *data, std::size_t size);
+
+    /**
+     * Closes connection if there is nothing left to do with it, returns true if
+     * connection has been deleted
+     */
+    bool MaybeClose(Connection *pc);
+
+    // afina services
+    std::shared_ptr<Afina::Storage> _pStorage;
+    std::shared_ptr<Afina::Logging::Service> _pLogging;
+    std::shared_ptr<spdlog::logger> _logger;
+
+    std::thread _thread;
+    int _server_socket;
+    int _event_fd;
+
+    std::unique_ptr<Ring> _ring;
+    std::unique_ptr<BufferRing> _buffers;
+
+    // Server asked to stop, accept is being canceled
+    bool _stopping;
+
+    // Multishot accept is in the ring
+    bool _accept_armed;
+
+    // All alive connections
+    std::unordered_set<Connection *> _connections;
+
+    // Connections got new output during current iteration
+    std::vector<Connection *> _dirty;
+
+    // Statistics
+    std::atomic<uint64_t> _requests;
+    std::atomic<uint64_t> _enter_calls;
+};
+
+} // namespace Uring
+} // namespace Network
+} // namespace Afina
+
+#endif // AFINA_NETWORK_URING_WORKER_H
@@ -0,0 +1,492 @@
+#include "BinaryParser.h"
+
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+
+#include <afina/execute/Add.h>
+#include <afina/execute/Append.h>
+#include <afina/execute/Command.h>
+#include <afina/execute/Delete.h>
+#include <afina/execute/Get.h>
+#include <afina/execute/Incr.h>
+#include <afina/execute/Prepend.h>
+#include <afina/execute/Replace.h>
+#include <afina/execute/Set.h>
+#include <afina/execute/Slot.h>
+
+namespace Afina {
+namespace Protocol {
+
+namespace {
+
+// Numbers are in network byte order
+uint16_t load16(const char *p) {
+    const unsigned char *b = reinterpret_cast<const unsigned char *>(p);
+    return uint16_t(b[0]) << 8 | b[1];
+}
+
+uint32_t load32(const char *p) { return uint32_t(load16(p)) << 16 | load16(p + 2); }
+
+uint64_t load64(const char *p) { return uint64_t(load32(p)) << 32 | load32(p + 4); }
+
+void store16(char *p, uint16_t value) {
+    p[0] = char(value >> 8);
+    p[1] = char(value);
+}
+
+void store32(char *p, uint32_t value) {
+    store16(p, uint16_t(value >> 16));
+    store16(p + 2, uint16_t(value));
+}
+
+void store64(char *p, uint64_t value) {
+    store32(p, uint32_t(value >> 32));
+    store32(p + 4, uint32_t(value));
+}
+
+// Writes response header of kHeaderSize bytes, cas is always 0
+void write_header(char *header, uint8_t opcode, uint16_t key_length, uint8_t extras_length, uint16_t status,
+                  uint32_t body_length, uint32_t opaque) {
+    std::memset(header, 0, BinaryParser::kHeaderSize);
+    header[0] = char(BinaryParser::kResponseMagic);
+    header[1] = char(opcode);
+    store16(header + 2, key_length);
+    header[4] = char(extras_length);
+    store16(header + 6, status);
+    store32(header + 8, body_length);
+    store32(header + 12, opaque);
+}
+
+// Appends response header
+void append_header(std::string &out, uint8_t opcode, uint16_t key_length, uint8_t extras_length, uint16_t status,
+                   uint32_t body_length, uint32_t opaque) {
+    char header[BinaryParser::kHeaderSize];
+    write_header(header, opcode, key_length, extras_length, status, body_length, opaque);
+    out.append(header, sizeof(header));
+}
+
+// Command with the fixed response, used for requests which have nothing to execute
+class Reply : public Execute::Command {
+public:
+    Reply(const char *text) : _text(text) {}
+    void Execute(Storage &storage, const std::string &args, std::string &out) override { out.assign(_text); }
+
+private:
+    const char *_text;
+};
+
+// Error description sent in the response body
+const char *describe(BinaryParser::Status status) {
+    switch (status) {
+    case BinaryParser::Status::KeyNotFound:
+        return "Not found";
+    case BinaryParser::Status::KeyExists:
+        return "Data exists for key";
+    case BinaryParser::Status::ValueTooLarge:
+        return "Too large";
+    case BinaryParser::Status::InvalidArguments:
+        return "Invalid arguments";
+    case BinaryParser::Status::ItemNotStored:
+        return "Not stored";
+    case BinaryParser::Status::NonNumeric:
+        return "Non-numeric server-side value for incr or decr";
+    case BinaryParser::Status::UnknownCommand:
+        return "Unknown command";
+    default:
+        return "Internal error";
+    }
+}
+
+bool starts_with(const std::string &text, const char *prefix) {
+    return text.compare(0, std::strlen(prefix), prefix) == 0;
+}
+
+} // namespace
+
+// See BinaryParser.h
+bool BinaryParser::Parse(const char *input, const size_t size, size_t &parsed) {
+    parsed = 0;
+    if (parse_complete) {
+        return true;
+    }
+
+    // Nothing else could be recovered from after that
+    if (packet.empty() && size > 0 && static_cast<uint8_t>(input[0]) != kRequestMagic) {
+        throw std::runtime_error("Invalid request magic " + std::to_string(static_cast<uint8_t>(input[0])));
+    }
+
+    // Usual case: request is parsed right in the input
+    if (packet.empty() && size >= kHeaderSize) {
+        ParseHeader(input);
+        size_t length = kHeaderSize + extras_length + key_length;
+        if (size >= length) {
+            ParseRequest(input);
+            parsed = length;
+            parse_complete = true;
+            return true;
+        }
+    }
+
+    // Request is split between reads, collect it here
+    if (packet.size() < kHeaderSize) {
+        size_t take = std::min(kHeaderSize - packet.size(), size);
+        packet.append(input, take);
+        parsed = take;
+        if (packet.size() < kHeaderSize) {
+            return false;
+        }
+        ParseHeader(packet.data());
+    }
+
+    size_t length = kHeaderSize + extras_length + key_length;
+    size_t take = std::min(length - packet.size(), size - parsed);
+    packet.append(input + parsed, take);
+    parsed += take;
+    if (packet.size() < length) {
+        return false;
+    }
+    ParseRequest(packet.data());
+    parse_complete = true;
+    return true;
+}
+
+// See BinaryParser.h
+void BinaryParser::ParseHeader(const char *header) {
+    if (static_cast<uint8_t>(header[0]) != kRequestMagic) {
+        throw std::runtime_error("Invalid request magic " + std::to_string(static_cast<uint8_t>(header[0])));
+    }
+    opcode = static_cast<uint8_t>(header[1]);
+    key_length = load16(header + 2);
+    extras_length = static_cast<uint8_t>(header[4]);
+    body_length = load32(header + 8);
+    opaque = load32(header + 12);
+    if (uint64_t(key_length) + extras_length > body_length) {
+        throw std::runtime_error("Key and extras don't fit into request body of " + std::to_string(body_length) +
+                                 " bytes");
+    }
+}
+
+// See BinaryParser.h
+void BinaryParser::ParseRequest(const char *request) {
+    const char *extras = request + kHeaderSize;
+    keys.emplace_back(extras + extras_length, key_length);
+    size_t value_length = body_length - extras_length - key_length;
+
+    quiet = false;
+    switch (static_cast<Opcode>(opcode)) {
+    case Opcode::GetQ:
+        quiet = true;
+        // fallthrough
+    case Opcode::Get:
+        command = Command::Get;
+        break;
+    case Opcode::GetKQ:
+        quiet = true;
+        // fallthrough
+    case Opcode::GetK:
+        command = Command::GetK;
+        break;
+    case Opcode::SetQ:
+        quiet = true;
+        // fallthrough
+    case Opcode::Set:
+        command = Command::Set;
+        break;
+    case Opcode::AddQ:
+        quiet = true;
+        // fallthrough
+    case Opcode::Add:
+        command = Command::Add;
+        break;
+    case Opcode::ReplaceQ:
+        quiet = true;
+        // fallthrough
+    case Opcode::Replace:
+        command = Command::Replace;
+        break;
+    case Opcode::AppendQ:
+        quiet = true;
+        // fallthrough
+    case Opcode::Append:
+        command = Command::Append;
+        break;
+    case Opcode::PrependQ:
+        quiet = true;
+        // fallthrough
+    case Opcode::Prepend:
+        command = Command::Prepend;
+        break;
+    case Opcode::DeleteQ:
+        quiet = true;
+        // fallthrough
+    case Opcode::Delete:
+        command = Command::Delete;
+        break;
+    case Opcode::IncrementQ:
+        quiet = true;
+        // fallthrough
+    case Opcode::Increment:
+        command = Command::Incr;
+        break;
+    case Opcode::DecrementQ:
+        quiet = true;
+        // fallthrough
+    case Opcode::Decrement:
+        command = Command::Decr;
+        break;
+    case Opcode::Noop:
+        command = Command::Noop;
+        break;
+    default:
+        command = Command::None;
+        return;
+    }
+
+    // Check what request must and must not have
+    switch (command) {
+    case Command::Set:
+    case Command::Add:
+    case Command::Replace:
+        valid = (extras_length == 8 && key_length > 0);
+        if (valid) {
+            flags = load32(extras);
+            exprtime = int32_t(load32(extras + 4));
+        }
+        break;
+    case Command::Append:
+    case Command::Prepend:
+        valid = (extras_length == 0 && key_length > 0);
+        break;
+    case Command::Incr:
+    case Command::Decr:
+        valid = (extras_length == 20 && key_length > 0 && value_length == 0);
+        if (valid) {
+            delta = load64(extras);
+            initial = load64(extras + 8);
+            expiration = load32(extras + 16);
+        }
+        break;
+    case Command::Noop:
+        valid = (extras_length == 0 && key_length == 0 && value_length == 0);
+        break;
+    default:
+        valid = (extras_length == 0 && key_length > 0 && value_length == 0);
+        break;
+    }
+}
+
+// See BinaryParser.h
+bool BinaryParser::Build(Execute::Slot &slot, size_t &body_size) const {
+    if (!parse_complete) {
+        return false;
+    }
+
+    body_size = body_length - extras_length - key_length;
+    if (command == Command::None) {
+        slot.Emplace(std::unique_ptr<Execute::Command>(new Reply("ERROR")));
+        return true;
+    }
+    if (!valid) {
+        slot.Emplace(std::unique_ptr<Execute::Command>(new Reply("CLIENT_ERROR invalid arguments")));
+        return true;
+    }
+
+    switch (command) {
+    case Command::Get:
+    case Command::GetK:
+        if (Execute::Get *get = slot.Reuse<Execute::Get>()) {
+            get->keys(keys);
+        } else {
+            slot.Emplace<Execute::Get>(keys);
+        }
+        break;
+    case Command::Set:
+        slot.Emplace<Execute::Set>(std::string(keys[0]), flags, exprtime);
+        break;
+    case Command::Add:
+        slot.Emplace<Execute::Add>(std::string(keys[0]), flags, exprtime);
+        break;
+    case Command::Replace:
+        slot.Emplace<Execute::Replace>(std::string(keys[0]), flags, exprtime);
+        break;
+    case Command::Append:
+        slot.Emplace<Execute::Append>(std::string(keys[0]), 0, 0);
+        break;
+    case Command::Prepend:
+        slot.Emplace<Execute::Prepend>(std::string(keys[0]), 0, 0);
+        break;
+    case Command::Delete:
+        slot.Emplace<Execute::Delete>(keys[0]);
+        break;
+    case Command::Incr:
+    case Command::Decr:
+        if (expiration == UINT32_MAX) {
+            slot.Emplace<Execute::Incr>(keys[0], delta, command == Command::Decr);
+        } else {
+            slot.Emplace<Execute::Incr>(keys[0], delta, command == Command::Decr, initial);
+        }
+        break;
+    default:
+        slot.Emplace(std::unique_ptr<Execute::Command>(new Reply("")));
+        break;
+    }
+    return true;
+}
+
+// See BinaryParser.h
+bool BinaryParser::Respond(Execute::Response &response) const {
+    const std::string &text = response.text;
+    Status status = Status::NoError;
+    if (text == "ERROR") {
+        status = Status::UnknownCommand;
+    } else if (text == "SERVER_ERROR object too large for cache") {
+        status = Status::ValueTooLarge;
+    } else if (starts_with(text, "SERVER_ERROR")) {
+        status = Status::InternalError;
+    } else if (command == Command::Get || command == Command::GetK) {
+        if (starts_with(text, "VALUE ")) {
+            return RespondValue(response);
+        }
+        status = starts_with(text, "CLIENT_ERROR") ? Status::InvalidArguments : Status::KeyNotFound;
+    } else if (starts_with(text, "CLIENT_ERROR")) {
+        bool numeric = (command == Command::Incr || command == Command::Decr) && valid;
+        status = numeric ? Status::NonNumeric : Status::InvalidArguments;
+    } else if (text == "NOT_FOUND") {
+        status = Status::KeyNotFound;
+    } else if (text == "NOT_STORED") {
+        if (command == Command::Add) {
+            status = Status::KeyExists;
+        } else if (command == Command::Replace) {
+            status = Status::KeyNotFound;
+        } else {
+            status = Status::ItemNotStored;
+        }
+    }
+
+    // Quiet get is silent on miss, the rest of quiet commands on success
+    bool get = (command == Command::Get || command == Command::GetK);
+    if (quiet && (get ? status == Status::KeyNotFound : status == Status::NoError)) {
+        response.text.clear();
+        return false;
+    }
+
+    // Packet replaces the text, so memory of the response is reused
+    if (status != Status::NoError) {
+        // Error message goes in the body
+        const char *message = describe(status);
+        size_t length = std::strlen(message);
+        response.text.clear();
+        append_header(response.text, opcode, 0, 0, uint16_t(status), length, opaque);
+        response.text.append(message, length);
+    } else if (command == Command::Incr || command == Command::Decr) {
+        // New value of the item, as 64-bit number
+        uint64_t value = 0;
+        for (char c : text) {
+            value = value * 10 + (c - '0');
+        }
+        char body[8];
+        store64(body, value);
+        response.text.clear();
+        append_header(response.text, opcode, 0, 0, uint16_t(status), sizeof(body), opaque);
+        response.text.append(body, sizeof(body));
+    } else {
+        response.text.clear();
+        append_header(response.text, opcode, 0, 0, uint16_t(status), 0, opaque);
+    }
+    return true;
+}
+
+// See BinaryParser.h
+bool BinaryParser::RespondValue(Execute::Response &response) const {
+    // Response is "VALUE <key> <flags> <bytes>\r\n<data>\r\nEND" with data either in the text or in
+    // the file. Header line is replaced with the binary one, so the data isn't copied
+    std::string &text = response.text;
+    size_t line_end = text.find("\r\n");
+    if (line_end == std::string::npos || text.size() < line_end + 2 + 5) {
+        throw std::runtime_error("Unexpected get response");
+    }
+
+    uint32_t item_flags = 0;
+    for (size_t pos = 6 + keys[0].size() + 1; pos < line_end && text[pos] != ' '; pos++) {
+        item_flags = item_flags * 10 + (text[pos] - '0');
+    }
+
+    size_t value_size;
+    if (response.files.empty()) {
+        value_size = text.size() - (line_end + 2) - 5;
+    } else {
+        value_size = response.files[0].second.size;
+    }
+
+    // Header, extras and key take place of the text line, then they are written there
+    bool with_key = (command == Command::GetK);
+    uint16_t key_size = with_key ? keys[0].size() : 0;
+    size_t header_size = kHeaderSize + 4 + key_size;
+    std::string_view key = keys[0];
+    text.replace(0, line_end + 2, header_size, '\0');
+    write_header(&text[0], opcode, key_size, 4, uint16_t(Status::NoError), 4 + key_size + value_size, opaque);
+    store32(&text[kHeaderSize], item_flags);
+    if (with_key) {
+        std::memcpy(&text[kHeaderSize + 4], key.data(), key_size);
+    }
+
+    text.resize(text.size() - 5);
+    if (!response.files.empty()) {
+        response.files[0].first = header_size;
+    }
+    return true;
+}
+
+// See BinaryParser.h
+void BinaryParser::Reset() {
+    packet.clear();
+    opcode = 0;
+    extras_length = 0;
+    key_length = 0;
+    body_length = 0;
+    opaque = 0;
+    command = Command::None;
+    quiet = false;
+    valid = false;
+    keys.clear();
+    flags = 0;
+    exprtime = 0;
+    delta = 0;
+    initial = 0;
+    expiration = 0;
+    parse_complete = false;
+}
+
+// See BinaryParser.h
+const char *BinaryParser::Name() const {
+    switch (command) {
+    case Command::Get:
+        return "get";
+    case Command::GetK:
+        return "getk";
+    case Command::Set:
+        return "set";
+    case Command::Add:
+        return "add";
+    case Command::Replace:
+        return "replace";
+    case Command::Append:
+        return "append";
+    case Command::Prepend:
+        return "prepend";
+    case Command::Delete:
+        return "delete";
+    case Command::Incr:
+        return "incr";
+    case Command::Decr:
+        return "decr";
+    case Command::Noop:
+        return "noop";
+    default:
+        return "unknown";
+    }
+}
+
+} // namespace Protocol
+} // namespace Afina
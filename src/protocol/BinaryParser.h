@@ -0,0 +1,162 @@
+#ifndef AFINA_PROTOCOL_BINARY_PARSER_H
+#define AFINA_PROTOCOL_BINARY_PARSER_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <cstddef>
+#include <cstdint>
+
+namespace Afina {
+namespace Execute {
+struct Response;
+class Slot;
+} // namespace Execute
+namespace Protocol {
+
+/**
+ * # Memcached binary protocol parser
+ * Supports get, getk, set, add, replace, append, prepend, delete, incr, decr and noop, together with
+ * quiet variants of them
+ *
+ * Each request starts with fixed 24 bytes header which gives lengths of extras, key and value, so
+ * there is nothing to search for: request is parsed once header, extras and key are in the input,
+ * value is an argument of the command just like in the text protocol. Request split between reads
+ * is collected in the parser till the rest arrives
+ *
+ * Parser builds the same Execute commands the text one does, their text response is then turned to
+ * the binary one by Respond. Keys of commands without value refer the parsed input the same way as
+ * in Parser, see it for details
+ */
+class BinaryParser {
+public:
+    // The first byte of every request
+    static constexpr uint8_t kRequestMagic = 0x80;
+
+    // The first byte of every response
+    static constexpr uint8_t kResponseMagic = 0x81;
+
+    // Size of request and response header
+    static constexpr std::size_t kHeaderSize = 24;
+
+    // Supported opcodes
+    enum class Opcode : uint8_t {
+        Get = 0x00,
+        Set = 0x01,
+        Add = 0x02,
+        Replace = 0x03,
+        Delete = 0x04,
+        Increment = 0x05,
+        Decrement = 0x06,
+        GetQ = 0x09,
+        Noop = 0x0a,
+        GetK = 0x0c,
+        GetKQ = 0x0d,
+        Append = 0x0e,
+        Prepend = 0x0f,
+        SetQ = 0x11,
+        AddQ = 0x12,
+        ReplaceQ = 0x13,
+        DeleteQ = 0x14,
+        IncrementQ = 0x15,
+        DecrementQ = 0x16,
+        AppendQ = 0x19,
+        PrependQ = 0x1a
+    };
+
+    // Response status
+    enum class Status : uint16_t {
+        NoError = 0x0000,
+        KeyNotFound = 0x0001,
+        KeyExists = 0x0002,
+        ValueTooLarge = 0x0003,
+        InvalidArguments = 0x0004,
+        ItemNotStored = 0x0005,
+        NonNumeric = 0x0006,
+        UnknownCommand = 0x0081,
+        InternalError = 0x0084
+    };
+
+    BinaryParser() { Reset(); }
+
+    /**
+     * Push given bytes into parser input. Method returns true once request header, extras and key
+     * are parsed out, then method Build places the command
+     *
+     * Throws std::runtime_error if input isn't a binary protocol request, stream could not be
+     * resynchronized after that
+     *
+     * @param input bytes to be added to the parsed input
+     * @param size number of bytes in the input buffer that could be read
+     * @param parsed output parameter tells how many bytes was consumed from the input
+     * @return true if request has been parsed out
+     */
+    bool Parse(const char *input, const size_t size, size_t &parsed);
+
+    /**
+     * Places command of the parsed request to the given slot, body_size is the size of request value.
+     * Unknown or malformed request gets a command which responds with an error, its value is just
+     * skipped. Returns false if there is no request yet
+     */
+    bool Build(Execute::Slot &slot, size_t &body_size) const;
+
+    /**
+     * Turns text response of the command built for the current request into binary response in place.
+     * Returns false if quiet request has nothing to respond
+     */
+    bool Respond(Execute::Response &response) const;
+
+    /**
+     * Reset parser so that it could be used to parse out new request
+     */
+    void Reset();
+
+    const char *Name() const;
+
+private:
+    // Kinds of requests, quiet ones are mapped to the same kind
+    enum class Command : uint8_t { None, Get, GetK, Set, Add, Replace, Append, Prepend, Delete, Incr, Decr, Noop };
+
+    // Reads fields of the request header
+    void ParseHeader(const char *header);
+
+    // Reads extras and key of the complete request
+    void ParseRequest(const char *request);
+
+    // Turns response to get into binary one in place
+    bool RespondValue(Execute::Response &response) const;
+
+    // Request received so far if it is split between reads, kept till Reset as key refers it
+    std::string packet;
+
+    // Fields of the request header
+    uint8_t opcode;
+    uint8_t extras_length;
+    uint16_t key_length;
+    uint32_t body_length;
+    uint32_t opaque;
+
+    // Request itself
+    Command command;
+    bool quiet;
+    bool valid;
+    std::vector<std::string_view> keys;
+
+    // set, add and replace extras
+    uint32_t flags;
+    int32_t exprtime;
+
+    // incr and decr extras: item is created with initial value if it isn't there, unless expiration
+    // is 0xffffffff
+    uint64_t delta;
+    uint64_t initial;
+    uint32_t expiration;
+
+    bool parse_complete;
+};
+
+} // namespace Protocol
+} // namespace Afina
+
+#endif // AFINA_PROTOCOL_BINARY_PARSER_H
@@ -1,198 +1,611 @@
 #include "Parser.h"
 
-#include <iostream>
+#include <cstring>
 #include <sstream>
 #include <stdexcept>
 
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 #include <afina/execute/Add.h>
 #include <afina/execute/Append.h>
 #include <afina/execute/Command.h>
 #include <afina/execute/Delete.h>
 #include <afina/execute/Get.h>
+#include <afina/execute/GetAndTouch.h>
+#include <afina/execute/Incr.h>
+#include <afina/execute/MetaArithmetic.h>
+#include <afina/execute/MetaDelete.h>
+#include <afina/execute/MetaGet.h>
+#include <afina/execute/MetaNoop.h>
+#include <afina/execute/Prepend.h>
+#include <afina/execute/Replace.h>
 #include <afina/execute/Set.h>
+#include <afina/execute/Slot.h>
+#include <afina/execute/Snapshot.h>
 #include <afina/execute/Stats.h>
+#include <afina/execute/Touch.h>
 
 namespace Afina {
 namespace Protocol {
 
+namespace {
+
+// Position of the first byte c in data or size if there is none. Whole vectors are compared at once,
+// only the tail shorter than vector is checked byte by byte
+size_t find_byte(const char *data, size_t size, char c) {
+    size_t pos = 0;
+#if defined(__AVX2__)
+    const __m256i wide = _mm256_set1_epi8(c);
+    for (; pos + 32 <= size; pos += 32) {
+        __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + pos));
+        uint32_t mask = _mm256_movemask_epi8(_mm256_cmpeq_epi8(block, wide));
+        if (mask != 0) {
+            return pos + __builtin_ctz(mask);
+        }
+    }
+#endif
+#if defined(__AVX2__) || defined(__SSE2__)
+    const __m128i narrow = _mm_set1_epi8(c);
+    for (; pos + 16 <= size; pos += 16) {
+        __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + pos));
+        uint32_t mask = _mm_movemask_epi8(_mm_cmpeq_epi8(block, narrow));
+        if (mask != 0) {
+            return pos + __builtin_ctz(mask);
+        }
+    }
+#endif
+    for (; pos < size; pos++) {
+        if (data[pos] == c) {
+            return pos;
+        }
+    }
+    return size;
+}
+
+// Finds the next space separated token of the line starting from pos, returns false if there is none
+bool next_token(const char *line, size_t size, size_t &pos, const char *&token, size_t &length) {
+    while (pos < size && line[pos] == ' ') {
+        pos++;
+    }
+    if (pos == size) {
+        return false;
+    }
+    token = line + pos;
+    length = find_byte(token, size - pos, ' ');
+    pos += length;
+    return true;
+}
+
+// Parses unsigned decimal number. Digits are checked all at once rather than one by one, there are
+// at most 10 of them anyway
+uint64_t parse_number(const char *token, size_t length, const char *field) {
+    uint64_t value = 0;
+    unsigned bad = (length == 0);
+    for (size_t i = 0; i < length && i < 11; i++) {
+        unsigned digit = static_cast<unsigned char>(token[i]) - '0';
+        bad |= (digit > 9);
+        value = value * 10 + digit;
+    }
+    if (bad) {
+        throw std::runtime_error(std::string("Invalid ") + field + " field: " + std::string(token, length));
+    }
+    if (length > 10 || value > UINT32_MAX) {
+        throw std::runtime_error(std::string(field) + " field overflow");
+    }
+    return value;
+}
+
+uint32_t parse_unsigned(const char *token, size_t length, const char *field) {
+    return parse_number(token, length, field);
+}
+
+// 64-bit numbers are rare and checked one digit at a time
+uint64_t parse_unsigned64(const char *token, size_t length, const char *field) {
+    if (length == 0) {
+        throw std::runtime_error(std::string("Invalid ") + field + " field");
+    }
+    uint64_t value = 0;
+    for (size_t i = 0; i < length; i++) {
+        unsigned digit = static_cast<unsigned char>(token[i]) - '0';
+        if (digit > 9) {
+            throw std::runtime_error(std::string("Invalid ") + field + " field: " + std::string(token, length));
+        }
+        if (value > (UINT64_MAX - digit) / 10) {
+            throw std::runtime_error(std::string(field) + " field overflow");
+        }
+        value = value * 10 + digit;
+    }
+    return value;
+}
+
+int32_t parse_signed(const char *token, size_t length, const char *field) {
+    bool negative = (length > 0 && token[0] == '-');
+    uint64_t value = parse_number(token + negative, length - negative, field);
+    if (value > uint64_t(INT32_MAX) + negative) {
+        throw std::runtime_error(std::string(field) + " field overflow");
+    }
+    return negative ? int32_t(-int64_t(value)) : int32_t(value);
+}
+
+// True if the rest of the line ends with noreply, other tokens are ignored
+bool parse_noreply(const char *line, size_t size, size_t pos) {
+    const char *token;
+    size_t length;
+    bool noreply = false;
+    while (next_token(line, size, pos, token, length)) {
+        noreply = (length == 7 && std::memcmp(token, "noreply", 7) == 0);
+    }
+    return noreply;
+}
+
+} // namespace
+
 // See Parse.h
 bool Parser::Parse(const char *input, const size_t size, size_t &parsed) {
-    size_t pos;
     parsed = 0;
+    if (parse_complete) {
+        return true;
+    }
 
-    for (pos = 0; pos < size && !parse_complete; pos++) {
-        char c = input[pos];
-        // std::cout << "[" << pos << "] '" << c << "': state=" << int(state) << std::endl;
-
-        switch (state) {
-        case State::sName: {
-            if (c == ' ' || c == '\r') {
-                // std::cout << "parser debug: name='" << name << "'" << std::endl;
-                if (name == "set" || name == "add" || name == "append" || name == "prepend") {
-                    state = State::spKey;
-                } else if (name == "get" || name == "gets") {
-                    state = State::sgKey;
-                } else if (name == "stats") {
-                    state = State::sLF;
-                    continue;
-                } else {
-                    throw std::runtime_error("Unknown command name: " + name);
-                }
-            } else {
-                name.push_back(c);
-            }
-            break;
+    // Previous portion has ended right between \r and \n
+    if (!line.empty() && line.back() == '\r') {
+        if (size == 0) {
+            return false;
         }
+        if (input[0] != '\n') {
+            std::stringstream err;
+            err << "Invalid char " << (int)input[0] << " at position 0, \\n expected";
+            throw std::runtime_error(err.str());
+        }
+        parsed = 1;
+        ParseLine(line.data(), line.size() - 1);
+        parse_complete = true;
+        return true;
+    }
 
-        case State::spKey: {
-            if (c == ' ') {
-                state = State::spFlags;
-                keys.push_back(curKey);
-                // std::cout << "parser debug: key[" << keys.size() - 1 << "]='" << curKey << "'" << std::endl;
-            } else {
-                curKey.push_back(c);
-            }
-            break;
+    size_t cr = find_byte(input, size, '\r');
+    if (cr + 1 >= size) {
+        // Line isn't complete yet, keep it till the rest arrives. Unknown command fails right away
+        // rather than after the whole line
+        line.append(input, size);
+        parsed = size;
+        size_t space = find_byte(line.data(), line.size(), ' ');
+        if (space < line.size() && Lookup(line.data(), space) == Command::None) {
+            throw std::runtime_error("Unknown command name: " + line.substr(0, space));
         }
+        return false;
+    }
+    if (input[cr + 1] != '\n') {
+        std::stringstream err;
+        err << "Invalid char " << (int)input[cr + 1] << " at position " << (cr + 1) << ", \\n expected";
+        throw std::runtime_error(err.str());
+    }
 
-        case State::sgKey: {
-            if (c == '\r') {
-                keys.push_back(curKey);
-                // std::cout << "parser debug: total '" << keys.size() << " keys" << std::endl;
-
-                if (keys.size() == 0) {
-                    throw std::runtime_error("Client provides no key to retrive");
-                }
-
-                curKey.clear();
-                state = State::sLF;
-            } else if (c == ' ') {
-                // std::cout << "parser debug: key[" << keys.size() << "]='" << curKey << "'" << std::endl;
-                state = State::sgKey;
-                keys.push_back(curKey);
-                curKey.clear();
-            } else {
-                curKey.push_back(c);
-            }
+    parsed = cr + 2;
+    if (line.empty()) {
+        // Usual case: line is parsed right in the input
+        ParseLine(input, cr);
+    } else {
+        line.append(input, cr);
+        ParseLine(line.data(), line.size());
+    }
+    parse_complete = true;
+    return true;
+}
+
+// See Parse.h
+Parser::Command Parser::Lookup(const char *name, size_t size) {
+    // Length and the first byte leave a single candidate to compare with
+    switch (size) {
+    case 2:
+        if (name[0] != 'm') {
             break;
         }
-
-        case State::spFlags: {
-            if (c == ' ') {
-                negative = false;
-                state = State::spExprTimeStart;
-                // std::cout << "parser debug: flags='" << flags << "'" << std::endl;
-            } else if (c >= '0' && c <= '9') {
-                uint32_t f = (flags * 10) + (c - '0');
-                if (f < flags) {
-                    // Overflow
-                    throw std::runtime_error("Flags field overflow");
-                }
-                flags = f;
+        switch (name[1]) {
+        case 'g':
+            return Command::MetaGet;
+        case 's':
+            return Command::MetaSet;
+        case 'd':
+            return Command::MetaDelete;
+        case 'a':
+            return Command::MetaArithmetic;
+        case 'n':
+            return Command::MetaNoop;
+        }
+        break;
+    case 3:
+        switch (name[0]) {
+        case 's':
+            return std::memcmp(name, "set", 3) == 0 ? Command::Set : Command::None;
+        case 'g':
+            if (std::memcmp(name, "get", 3) == 0) {
+                return Command::Get;
             }
-            break;
+            return std::memcmp(name, "gat", 3) == 0 ? Command::Gat : Command::None;
+        case 'a':
+            return std::memcmp(name, "add", 3) == 0 ? Command::Add : Command::None;
         }
-
-        case State::spExprTimeStart: {
-            if (c == '-') {
-                negative = true;
-                state = State::spExprTime;
-            } else if (c >= '0' && c <= '9') {
-                exprtime = (c - '0');
-                state = State::spExprTime;
+        break;
+    case 4:
+        switch (name[0]) {
+        case 'g':
+            if (std::memcmp(name, "gets", 4) == 0) {
+                return Command::Gets;
             }
-            break;
+            return std::memcmp(name, "gats", 4) == 0 ? Command::Gats : Command::None;
+        case 'i':
+            return std::memcmp(name, "incr", 4) == 0 ? Command::Incr : Command::None;
+        case 'd':
+            return std::memcmp(name, "decr", 4) == 0 ? Command::Decr : Command::None;
+        }
+        break;
+    case 5:
+        switch (name[0]) {
+        case 's':
+            return std::memcmp(name, "stats", 5) == 0 ? Command::Stats : Command::None;
+        case 't':
+            return std::memcmp(name, "touch", 5) == 0 ? Command::Touch : Command::None;
+        }
+        break;
+    case 6:
+        switch (name[0]) {
+        case 'a':
+            return std::memcmp(name, "append", 6) == 0 ? Command::Append : Command::None;
+        case 'd':
+            return std::memcmp(name, "delete", 6) == 0 ? Command::Delete : Command::None;
+        }
+        break;
+    case 7:
+        switch (name[0]) {
+        case 'p':
+            return std::memcmp(name, "prepend", 7) == 0 ? Command::Prepend : Command::None;
+        case 'r':
+            return std::memcmp(name, "replace", 7) == 0 ? Command::Replace : Command::None;
         }
+        break;
+    case 8:
+        return std::memcmp(name, "snapshot", 8) == 0 ? Command::Snapshot : Command::None;
+    }
+    return Command::None;
+}
 
-        case State::spExprTime: {
-            if (c == ' ') {
-                state = State::spBytes;
-                // std::cout << "parser debug: ExprTime='" << exprtime << "'" << std::endl;
-            } else if (c >= '0' && c <= '9') {
-                int32_t et = exprtime;
-                if (negative) {
-                    et -= (c - '0');
-                    if (et > exprtime) {
-                        throw std::runtime_error("Expire time field overflow");
-                    }
-                } else {
-                    et += (c - '0');
-                    if (et < exprtime) {
-                        throw std::runtime_error("Expire time field overflow");
-                    }
-                }
-                exprtime = et;
-            }
-            break;
+// See Parse.h
+void Parser::ParseLine(const char *input, size_t size) {
+    size_t pos = find_byte(input, size, ' ');
+    name.assign(input, pos);
+    command = Lookup(input, pos);
+
+    const char *token;
+    size_t length;
+    switch (command) {
+    case Command::Set:
+    case Command::Add:
+    case Command::Replace:
+    case Command::Append:
+    case Command::Prepend:
+        // <command name> <key> <flags> <exptime> <bytes> [noreply]
+        if (!next_token(input, size, pos, token, length)) {
+            throw std::runtime_error("Client provides no key to store");
+        }
+        keys.emplace_back(token, length);
+        if (!next_token(input, size, pos, token, length)) {
+            throw std::runtime_error("Flags field expected");
         }
+        flags = parse_unsigned(token, length, "Flags");
+        if (!next_token(input, size, pos, token, length)) {
+            throw std::runtime_error("Expire time field expected");
+        }
+        exprtime = parse_signed(token, length, "Expire time");
+        if (!next_token(input, size, pos, token, length)) {
+            throw std::runtime_error("Bytes field expected");
+        }
+        bytes = parse_unsigned(token, length, "Bytes");
+        noreply = parse_noreply(input, size, pos);
+        break;
 
-        case State::spBytes: {
-            if (c == '\r') {
-                state = State::sLF;
-                // std::cout << "parser debug: bytes='" << bytes << "'" << std::endl;
-            } else if (c >= '0' && c <= '9') {
-                uint32_t b = (bytes * 10) + (c - '0');
-                if (b < bytes) {
-                    // Overflow
-                    throw std::runtime_error("Bytes field overflow");
-                }
-                bytes = b;
-            }
-            break;
+    case Command::Get:
+    case Command::Gets:
+        while (next_token(input, size, pos, token, length)) {
+            keys.emplace_back(token, length);
+        }
+        if (keys.empty()) {
+            throw std::runtime_error("Client provides no key to retrive");
         }
+        break;
 
-        case State::sLF: {
-            if (c == '\n') {
-                parse_complete = true;
-            } else {
-                std::stringstream err;
-                err << "Invalid char " << (int)c << " at position " << (parsed + pos) << ", \\n expected";
-                throw std::runtime_error(err.str());
-            }
-            break;
+    case Command::Gat:
+    case Command::Gats:
+        // <command name> <exptime> <key>*
+        if (!next_token(input, size, pos, token, length)) {
+            throw std::runtime_error("Expire time field expected");
         }
+        exprtime = parse_signed(token, length, "Expire time");
+        while (next_token(input, size, pos, token, length)) {
+            keys.emplace_back(token, length);
+        }
+        if (keys.empty()) {
+            throw std::runtime_error("Client provides no key to retrive");
+        }
+        break;
 
-        default:
-            throw std::runtime_error("Unknown state");
+    case Command::Touch:
+        // touch <key> <exptime> [noreply]
+        if (!next_token(input, size, pos, token, length)) {
+            throw std::runtime_error("Client provides no key to touch");
+        }
+        keys.emplace_back(token, length);
+        if (!next_token(input, size, pos, token, length)) {
+            throw std::runtime_error("Expire time field expected");
         }
+        exprtime = parse_signed(token, length, "Expire time");
+        noreply = parse_noreply(input, size, pos);
+        break;
+
+    case Command::Delete:
+        // delete <key> [<time>] [noreply], obsolete time is ignored
+        if (!next_token(input, size, pos, token, length)) {
+            throw std::runtime_error("Client provides no key to delete");
+        }
+        keys.emplace_back(token, length);
+        noreply = parse_noreply(input, size, pos);
+        break;
+
+    case Command::Incr:
+    case Command::Decr:
+        // <command name> <key> <value> [noreply]
+        if (!next_token(input, size, pos, token, length)) {
+            throw std::runtime_error("Client provides no key to change");
+        }
+        keys.emplace_back(token, length);
+        if (!next_token(input, size, pos, token, length)) {
+            throw std::runtime_error("Value field expected");
+        }
+        delta = parse_unsigned64(token, length, "Value");
+        noreply = parse_noreply(input, size, pos);
+        break;
+
+    case Command::MetaGet:
+    case Command::MetaSet:
+    case Command::MetaDelete:
+    case Command::MetaArithmetic:
+        // <command name> <key> <flags>*, ms has <datalen> right after the key
+        if (!next_token(input, size, pos, token, length)) {
+            throw std::runtime_error("Client provides no key");
+        }
+        keys.emplace_back(token, length);
+        if (command == Command::MetaSet) {
+            if (!next_token(input, size, pos, token, length)) {
+                throw std::runtime_error("Data length field expected");
+            }
+            bytes = parse_unsigned(token, length, "Data length");
+        }
+        if (command == Command::MetaArithmetic) {
+            delta = 1;
+        }
+        while (next_token(input, size, pos, token, length)) {
+            ParseMetaFlag(token, length);
+        }
+        break;
+
+    case Command::MetaNoop:
+    case Command::Stats:
+    case Command::Snapshot:
+        break;
+
+    default:
+        throw std::runtime_error("Unknown command name: " + name);
+    }
+}
+
+// See Parse.h
+void Parser::ParseMetaFlag(const char *token, size_t length) {
+    char flag = token[0];
+    const char *value = token + 1;
+    size_t size = length - 1;
+    if (flag == 'q') {
+        meta.quiet = true;
+        return;
+    }
+    if (flag >= 'a' && flag <= 'z') {
+        meta.Add(flag);
+        return;
     }
 
-    parsed += pos;
-    return parse_complete;
+    switch (flag) {
+    case 'O':
+        if (size > 32) {
+            throw std::runtime_error("Opaque token is too long");
+        }
+        meta.opaque.assign(value, size);
+        break;
+    case 'F':
+        flags = parse_unsigned(value, size, "Flags");
+        break;
+    case 'T':
+        exprtime = parse_signed(value, size, "TTL");
+        break;
+    case 'N':
+        create = true;
+        exprtime = parse_signed(value, size, "TTL");
+        break;
+    case 'J':
+        initial = parse_unsigned64(value, size, "Initial value");
+        break;
+    case 'D':
+        delta = parse_unsigned64(value, size, "Delta");
+        break;
+    case 'M':
+        if (size != 1) {
+            throw std::runtime_error("Invalid mode flag: " + std::string(token, length));
+        }
+        if (command == Command::MetaSet) {
+            switch (value[0]) {
+            case 'S':
+            case 's':
+                set_mode = Execute::MetaSet::Mode::Set;
+                break;
+            case 'E':
+            case 'e':
+                set_mode = Execute::MetaSet::Mode::Add;
+                break;
+            case 'R':
+            case 'r':
+                set_mode = Execute::MetaSet::Mode::Replace;
+                break;
+            case 'A':
+            case 'a':
+                set_mode = Execute::MetaSet::Mode::Append;
+                break;
+            case 'P':
+            case 'p':
+                set_mode = Execute::MetaSet::Mode::Prepend;
+                break;
+            default:
+                throw std::runtime_error("Invalid mode flag: " + std::string(token, length));
+            }
+        } else if (command == Command::MetaArithmetic) {
+            switch (value[0]) {
+            case 'I':
+            case 'i':
+            case '+':
+                decrement = false;
+                break;
+            case 'D':
+            case 'd':
+            case '-':
+                decrement = true;
+                break;
+            default:
+                throw std::runtime_error("Invalid mode flag: " + std::string(token, length));
+            }
+        }
+        break;
+    default:
+        // The rest of flags isn't supported and just ignored
+        break;
+    }
 }
 
 // See Parse.h
 std::unique_ptr<Execute::Command> Parser::Build(size_t &body_size) const {
-    if (state != State::sLF) {
-        return std::unique_ptr<Execute::Command>(nullptr);
+    Execute::Slot slot;
+    Build(slot, body_size);
+    return slot.Release();
+}
+
+// See Parser.h
+bool Parser::HasBody() const {
+    switch (command) {
+    case Command::Set:
+    case Command::Add:
+    case Command::Replace:
+    case Command::Append:
+    case Command::Prepend:
+    case Command::MetaSet:
+        return parse_complete;
+    default:
+        return false;
+    }
+}
+
+// See Parse.h
+bool Parser::Build(Execute::Slot &slot, size_t &body_size) const {
+    if (!parse_complete) {
+        return false;
     }
 
     body_size = bytes;
-    if (name == "set") {
-        return std::unique_ptr<Execute::Command>(new Execute::Set(keys[0], flags, exprtime));
-    } else if (name == "add") {
-        return std::unique_ptr<Execute::Command>(new Execute::Add(keys[0], flags, exprtime));
-    } else if (name == "append") {
-        return std::unique_ptr<Execute::Command>(new Execute::Append(keys[0], flags, exprtime));
-    } else if (name == "get") {
-        return std::unique_ptr<Execute::Command>(new Execute::Get(keys));
-    } else if (name == "stats") {
-        return std::unique_ptr<Execute::Command>(new Execute::Stats());
-    } else {
+    switch (command) {
+    case Command::Set:
+        slot.Emplace<Execute::Set>(std::string(keys[0]), flags, exprtime);
+        break;
+    case Command::Add:
+        slot.Emplace<Execute::Add>(std::string(keys[0]), flags, exprtime);
+        break;
+    case Command::Replace:
+        slot.Emplace<Execute::Replace>(std::string(keys[0]), flags, exprtime);
+        break;
+    case Command::Append:
+        slot.Emplace<Execute::Append>(std::string(keys[0]), flags, exprtime);
+        break;
+    case Command::Prepend:
+        slot.Emplace<Execute::Prepend>(std::string(keys[0]), flags, exprtime);
+        break;
+    case Command::Delete:
+        slot.Emplace<Execute::Delete>(keys[0]);
+        break;
+    case Command::Incr:
+    case Command::Decr:
+        slot.Emplace<Execute::Incr>(keys[0], delta, command == Command::Decr);
+        break;
+    case Command::Get:
+    case Command::Gets:
+        // The most frequent command, keeps memory of its keys list between requests
+        if (Execute::Get *get = slot.Reuse<Execute::Get>()) {
+            get->keys(keys);
+            get->cas(command == Command::Gets);
+        } else {
+            slot.Emplace<Execute::Get>(keys, command == Command::Gets);
+        }
+        break;
+    case Command::Gat:
+    case Command::Gats:
+        slot.Emplace<Execute::GetAndTouch>(exprtime, keys, command == Command::Gats);
+        break;
+    case Command::Touch:
+        slot.Emplace<Execute::Touch>(keys[0], exprtime);
+        break;
+    case Command::MetaGet:
+        slot.Emplace<Execute::MetaGet>(keys[0], meta);
+        break;
+    case Command::MetaSet:
+        slot.Emplace<Execute::MetaSet>(std::string(keys[0]), set_mode, flags, exprtime, meta);
+        break;
+    case Command::MetaDelete:
+        slot.Emplace<Execute::MetaDelete>(keys[0], meta);
+        break;
+    case Command::MetaArithmetic:
+        slot.Emplace<Execute::MetaArithmetic>(keys[0], delta, decrement, create, initial, meta);
+        break;
+    case Command::MetaNoop:
+        slot.Emplace<Execute::MetaNoop>();
+        break;
+    case Command::Stats:
+        slot.Emplace<Execute::Stats>();
+        break;
+    case Command::Snapshot:
+        slot.Emplace<Execute::Snapshot>();
+        break;
+    default:
         throw std::runtime_error("Unsupported command");
     }
+    return true;
 }
 
 // See Parse.h
 void Parser::Reset() {
-    state = State::sName;
+    line.clear();
+    command = Command::None;
     name.clear();
     keys.clear();
-    curKey.clear();
     parse_complete = false;
     flags = 0;
     bytes = 0;
     exprtime = 0;
+    delta = 0;
+    noreply = false;
+    meta.returns = 0;
+    meta.quiet = false;
+    meta.opaque.clear();
+    set_mode = Execute::MetaSet::Mode::Set;
+    decrement = false;
+    create = false;
+    initial = 0;
 }
 
 } // namespace Protocol
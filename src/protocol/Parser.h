@@ -3,20 +3,34 @@
 
 #include <memory>
 #include <string>
+#include <string_view>
 #include <vector>
 
 #include <cstddef>
 #include <cstdint>
 
+#include <afina/execute/MetaCommand.h>
+#include <afina/execute/MetaSet.h>
+
 namespace Afina {
 namespace Execute {
 class Command;
+class Slot;
 } // namespace Execute
 namespace Protocol {
 
 /**
  * # Memcached protocol parser
  * Parser supports subset of memcached protocol
+ *
+ * Command line is parsed at once when its \r\n is in the input: delimiters are found by SIMD byte
+ * compare (AVX2 or SSE2 when built for them) and the line is split into tokens with no per char state
+ * machine. Line split between reads is kept in the parser till the rest arrives, so any split of the
+ * input gives the same result
+ *
+ * Keys are not copied: they refer the parsed input or the parser itself if line has been split. So
+ * command without body must be executed before that input is consumed and parser is reset, which is
+ * what Session does. Commands with body own their key, body could arrive much later
  */
 class Parser {
 public:
@@ -31,6 +45,9 @@ public:
      */
     bool Parse(const std::string &input, size_t &parsed) { return Parse(&input[0], input.size(), parsed); }
 
+    // Keys refer the input, so it must outlive the command
+    bool Parse(std::string &&input, size_t &parsed) = delete;
+
     /**
      * Push given string into parser input. Method returns true if it was a command parsed out
      * from comulative input. In a such case method Build will return new command
@@ -48,6 +65,12 @@ public:
      */
     std::unique_ptr<Execute::Command> Build(size_t &body_size) const;
 
+    /**
+     * Same as above, but command is placed to the given slot rather than allocated. Returns false if
+     * there is no command yet
+     */
+    bool Build(Execute::Slot &slot, size_t &body_size) const;
+
     /**
      * Reset parse so that it could be used to parse out new command
      */
@@ -55,21 +78,59 @@ public:
 
     inline const std::string &Name() const { return name; }
 
-private:
     /**
-     * State of the command parser. Prefixes are:
-     * - s: state for PUT and GET commands
-     * - sp: for PUT commands only
-     * - sg: for GET commands only
+     * True if parsed command is followed by data block, even empty one: block is terminated by \r\n
+     * which isn't counted in body_size
      */
-    enum State : uint16_t { sCR, sLF, sName, spKey, spFlags, spExprTimeStart, spExprTime, spBytes, sgKey };
+    bool HasBody() const;
 
-    // Current parser state
-    State state;
+    /**
+     * True if client asked for no reply to the parsed command: response isn't needed at all
+     */
+    inline bool NoReply() const { return noreply; }
+
+private:
+    // Known command names
+    enum class Command : uint8_t {
+        None,
+        Set,
+        Add,
+        Replace,
+        Append,
+        Prepend,
+        Get,
+        Gets,
+        Gat,
+        Gats,
+        Touch,
+        Delete,
+        Incr,
+        Decr,
+        MetaGet,
+        MetaSet,
+        MetaDelete,
+        MetaArithmetic,
+        MetaNoop,
+        Stats,
+        Snapshot
+    };
+
+    // Looks command up by name, returns Command::None if there is no such command
+    static Command Lookup(const char *name, size_t size);
+
+    // Parses complete command line, size doesn't include \r\n
+    void ParseLine(const char *line, size_t size);
+
+    // Parses single flag of the meta command
+    void ParseMetaFlag(const char *token, size_t length);
+
+    // Command line received so far if it is split between reads, kept till Reset as keys refer it
+    std::string line;
 
     // vrious fields of the command
+    Command command;
     std::string name;
-    std::vector<std::string> keys;
+    std::vector<std::string_view> keys;
 
     // <flags> is an arbitrary 16-bit unsigned integer (written out in decimal) that the server stores along with
     // the data and sends back when the item is retrieved. Clients may use this as a bit field to store data-specific
@@ -88,8 +149,19 @@ private:
     // it's followed by an empty data block).
     uint32_t bytes;
 
-    bool negative;
-    std::string curKey;
+    // <value> of incr/decr is the amount to change item by, 64-bit unsigned integer
+    uint64_t delta;
+
+    // Storage commands, delete, incr/decr and touch could end with "noreply": client doesn't wait for response
+    bool noreply;
+
+    // Meta commands flags: ones shaping the response, ms mode, ma mode and initial value to create item with
+    Execute::MetaCommand::Flags meta;
+    Execute::MetaSet::Mode set_mode;
+    bool decrement;
+    bool create;
+    uint64_t initial;
+
     bool parse_complete;
 };
 
@@ -0,0 +1,30 @@
+#ifndef AFINA_STORAGE_EXPIRATION_H
+#define AFINA_STORAGE_EXPIRATION_H
+
+#include <cstdint>
+#include <ctime>
+
+namespace Afina {
+namespace Backend {
+
+// Longer expiration time is Unix time rather than number of seconds from now
+constexpr int32_t kMaxRelativeExpire = 30 * 24 * 3600;
+
+// Deadline for memcached expiration time, see Storage::Touch. Deadline is Unix time, 0 if there is none
+inline int64_t deadline(int32_t expire) {
+    if (expire == 0) {
+        return 0;
+    }
+    int64_t now = time(nullptr);
+    if (expire < 0) {
+        return now;
+    }
+    return expire <= kMaxRelativeExpire ? now + expire : expire;
+}
+
+inline bool expired(int64_t deadline, int64_t now) { return deadline != 0 && deadline <= now; }
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_EXPIRATION_H
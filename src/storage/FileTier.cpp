@@ -0,0 +1,318 @@
+#include "FileTier.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <spdlog/logger.h>
+
+namespace Afina {
+namespace Backend {
+
+namespace {
+
+// Record header: key_size, value_size
+const std::size_t kHeader = 2 * sizeof(uint32_t);
+
+const uint32_t kNone = UINT32_MAX;
+
+// Segment is compacted once that share of it is dead
+const double kCompactDead = 0.5;
+
+// Compaction thread wakes up that often to look for work
+const std::chrono::milliseconds kCompactInterval(1000);
+
+bool read_all(int fd, char *data, std::size_t size, off_t offset) {
+    while (size > 0) {
+        ssize_t n = pread(fd, data, size, offset);
+        if (n == -1 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        data += n;
+        size -= n;
+        offset += n;
+    }
+    return true;
+}
+
+bool write_all(int fd, const char *data, std::size_t size, off_t offset) {
+    while (size > 0) {
+        ssize_t n = pwrite(fd, data, size, offset);
+        if (n == -1 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        data += n;
+        size -= n;
+        offset += n;
+    }
+    return true;
+}
+
+} // namespace
+
+// See FileTier.h
+FileTier::FileTier(const std::string &path, std::size_t size, std::shared_ptr<spdlog::logger> logger,
+                   std::size_t segment_size)
+    : _path(path), _segment_size(segment_size), _logger(logger), _current(0), _compacting(kNone),
+      _stopping(false), _compactions(0) {
+    std::size_t count = std::max<std::size_t>(2, size / segment_size);
+    for (std::size_t i = 0; i < count; i++) {
+        char suffix[32];
+        std::snprintf(suffix, sizeof(suffix), ".%04zu", i);
+        std::string name = path + suffix;
+
+        int fd = open(name.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+        if (fd == -1) {
+            throw std::runtime_error("Failed to create " + name + ": " + std::string(strerror(errno)));
+        }
+        // Blocks are allocated once, so appends never run out of disk
+        int err = posix_fallocate(fd, 0, segment_size);
+        if (err != 0) {
+            close(fd);
+            throw std::runtime_error("Failed to allocate " + name + ": " + std::string(strerror(err)));
+        }
+
+        _segments.push_back(Segment{fd, 0, 0, 0});
+        if (i > 0) {
+            _free.push_back(i);
+        }
+    }
+}
+
+// See FileTier.h
+FileTier::~FileTier() {
+    Stop();
+    for (auto &s : _segments) {
+        close(s.fd);
+    }
+}
+
+// See FileTier.h
+void FileTier::Start(Refers refers, Relocate relocate) {
+    _refers = refers;
+    _relocate = relocate;
+    _stopping = false;
+    _compactor = std::thread(&FileTier::OnRun, this);
+}
+
+// See FileTier.h
+void FileTier::Stop() {
+    if (!_compactor.joinable()) {
+        return;
+    }
+
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _stopping = true;
+    }
+    _cv.notify_one();
+    _compactor.join();
+}
+
+// See FileTier.h
+bool FileTier::Append(const std::string &key, const std::string &value, Location &location, bool compaction) {
+    std::size_t size = kHeader + key.size() + value.size();
+    if (size > _segment_size) {
+        return false;
+    }
+
+    // Space is reserved under the lock, data is written without it
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        if (_segments[_current].used + size > _segment_size) {
+            // The last free segment is left for compaction, otherwise tier could get stuck being full of
+            // half dead segments
+            if (_free.empty() || (_free.size() == 1 && !compaction)) {
+                _cv.notify_one();
+                return false;
+            }
+            uint32_t full = _current;
+            _current = _free.back();
+            _free.pop_back();
+            Recycle(full);
+            _cv.notify_one();
+        }
+
+        Segment &s = _segments[_current];
+        location.segment = _current;
+        location.offset = s.used;
+        location.key_size = key.size();
+        location.size = value.size();
+        s.used += size;
+        s.live += size;
+    }
+
+    uint32_t header[2] = {static_cast<uint32_t>(key.size()), static_cast<uint32_t>(value.size())};
+    std::string record;
+    record.reserve(size);
+    record.append(reinterpret_cast<const char *>(header), sizeof(header));
+    record.append(key);
+    record.append(value);
+    if (!write_all(_segments[location.segment].fd, record.data(), record.size(), location.offset)) {
+        _logger->error("Failed to write tier segment {}: {}", location.segment, strerror(errno));
+        Release(location);
+        return false;
+    }
+    return true;
+}
+
+// See FileTier.h
+bool FileTier::Read(const Location &location, std::string &value) const {
+    value.resize(location.size);
+    if (!read_all(_segments[location.segment].fd, &value[0], location.size, ValueOffset(location))) {
+        _logger->error("Failed to read tier segment {}: {}", location.segment, strerror(errno));
+        return false;
+    }
+    return true;
+}
+
+// See FileTier.h
+void FileTier::Release(const Location &location) {
+    std::unique_lock<std::mutex> lock(_mutex);
+    _segments[location.segment].live -= kHeader + location.key_size + location.size;
+    Recycle(location.segment);
+}
+
+// See FileTier.h
+std::shared_ptr<void> FileTier::Pin(const Location &location) {
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _segments[location.segment].pins++;
+    }
+    uint32_t segment = location.segment;
+    return std::shared_ptr<void>(nullptr, [this, segment](void *) { Unpin(segment); });
+}
+
+// See FileTier.h
+uint64_t FileTier::ValueOffset(const Location &location) {
+    return uint64_t(location.offset) + kHeader + location.key_size;
+}
+
+// See FileTier.h
+bool FileTier::ReadAt(int fd, char *data, std::size_t size, uint64_t offset) { return read_all(fd, data, size, offset); }
+
+// See FileTier.h
+void FileTier::Unpin(uint32_t segment) {
+    std::unique_lock<std::mutex> lock(_mutex);
+    _segments[segment].pins--;
+    Recycle(segment);
+}
+
+// See FileTier.h
+void FileTier::Recycle(uint32_t segment) {
+    Segment &s = _segments[segment];
+    // Segment with used == 0 is already free
+    if (s.live == 0 && s.pins == 0 && s.used > 0 && segment != _current && segment != _compacting) {
+        s.used = 0;
+        _free.push_back(segment);
+    }
+}
+
+// See FileTier.h
+std::size_t FileTier::LiveBytes() const {
+    std::unique_lock<std::mutex> lock(_mutex);
+    std::size_t live = 0;
+    for (auto &s : _segments) {
+        live += s.live;
+    }
+    return live;
+}
+
+// See FileTier.h
+void FileTier::OnRun() {
+    std::unique_lock<std::mutex> lock(_mutex);
+    while (!_stopping) {
+        _cv.wait_for(lock, kCompactInterval);
+        if (_stopping) {
+            break;
+        }
+
+        // Pick the most dead segment
+        uint32_t victim = 0;
+        double dead = 0;
+        for (uint32_t i = 0; i < _segments.size(); i++) {
+            const Segment &s = _segments[i];
+            // Segment with nothing alive is waiting for pins to be dropped, nothing to compact there
+            if (i == _current || s.used == 0 || s.live == 0) {
+                continue;
+            }
+            double share = 1.0 - double(s.live) / s.used;
+            if (share > dead) {
+                victim = i;
+                dead = share;
+            }
+        }
+        if (dead < kCompactDead) {
+            continue;
+        }
+
+        _compacting = victim;
+        lock.unlock();
+        bool done = Compact(victim);
+        lock.lock();
+        _compacting = kNone;
+
+        // Whatever left alive there has been moved, so segment is free once pins are dropped
+        if (done) {
+            _segments[victim].live = 0;
+            _compactions++;
+        }
+        Recycle(victim);
+    }
+}
+
+// See FileTier.h
+bool FileTier::Compact(uint32_t segment) {
+    std::size_t used;
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        used = _segments[segment].used;
+    }
+
+    std::string data(used, '\0');
+    if (!read_all(_segments[segment].fd, &data[0], used, 0)) {
+        _logger->error("Failed to read tier segment {}: {}", segment, strerror(errno));
+        return false;
+    }
+
+    std::string key, value;
+    for (std::size_t pos = 0; pos + kHeader <= used;) {
+        uint32_t header[2];
+        std::memcpy(header, &data[pos], sizeof(header));
+        std::size_t record = kHeader + header[0] + header[1];
+        Location from{segment, static_cast<uint32_t>(pos), header[0], header[1]};
+        key.assign(&data[pos + kHeader], header[0]);
+        pos += record;
+
+        // Dead records are skipped, otherwise their copies would make the next segment worth compaction
+        if (!_refers(key, from)) {
+            continue;
+        }
+
+        value.assign(&data[from.offset + kHeader + header[0]], header[1]);
+        Location to;
+        if (!Append(key, value, to, true)) {
+            return false;
+        }
+        if (_relocate(key, from, to)) {
+            Release(from);
+        } else {
+            // Value has been overwritten or deleted since the check, so the copy is dead
+            Release(to);
+        }
+    }
+    return true;
+}
+
+} // namespace Backend
+} // namespace Afina
@@ -0,0 +1,174 @@
+#ifndef AFINA_STORAGE_FILE_TIER_H
+#define AFINA_STORAGE_FILE_TIER_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace spdlog {
+class logger;
+}
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # File-backed storage tier for values
+ * Values that are too large or too cold to keep in memory are written to the tier, while storage keeps
+ * only key and Location in memory. Tier is a set of preallocated segment files of the same size. Values
+ * are appended to the current segment, once it is full the next free one becomes current.
+ *
+ * Overwritten and deleted values are just counted as dead space of their segments. Segment with no live
+ * values becomes free right away, background thread compacts segments which are mostly dead by copying
+ * live values to the current segment. Storage is asked whether record is still live via refers callback
+ * and to switch every copied value to the new location via relocate one, so tier doesn't need any index
+ * of its own.
+ *
+ * Value could be sent straight from the segment file, see Pin: pinned segment isn't reused until pin is
+ * dropped, even if all its values are dead.
+ *
+ * Tier content doesn't survive restart, files are reused from scratch by the next process.
+ *
+ * All methods are thread safe. Read doesn't take any locks, caller must guarantee location isn't released
+ * while it is being read, which holds if storage reads and relocates value under the same lock.
+ */
+class FileTier {
+public:
+    // Where record with the value lives in the tier
+    struct Location {
+        uint32_t segment;
+        uint32_t offset;
+        uint32_t key_size;
+        uint32_t size;
+
+        bool operator==(const Location &other) const { return segment == other.segment && offset == other.offset; }
+    };
+
+    /**
+     * Called by compaction for every record, storage must return true if key still refers the location
+     */
+    using Refers = std::function<bool(const std::string &key, const Location &location)>;
+
+    /**
+     * Called by compaction for value copied to the new location, storage must switch key to the new
+     * location and return true if key still refers old one, otherwise return false
+     */
+    using Relocate = std::function<bool(const std::string &key, const Location &from, const Location &to)>;
+
+    /**
+     * Creates size / segment_size (at least 2) segment files named <path>.NNNN. Throws std::runtime_error
+     * if files can't be created
+     */
+    FileTier(const std::string &path, std::size_t size, std::shared_ptr<spdlog::logger> logger,
+             std::size_t segment_size = 64 * 1024 * 1024);
+    ~FileTier();
+
+    /**
+     * Starts background compaction, refers is called for every record of compacted segment, relocate
+     * for every value moved
+     */
+    void Start(Refers refers, Relocate relocate);
+    void Stop();
+
+    /**
+     * Appends value to the tier, returns false if value doesn't fit into segment, tier is full or write
+     * failed
+     */
+    bool Write(const std::string &key, const std::string &value, Location &location) {
+        return Append(key, value, location, false);
+    }
+
+    /**
+     * Reads value from the location, returns false on I/O error
+     */
+    bool Read(const Location &location, std::string &value) const;
+
+    /**
+     * Marks value at the location as dead
+     */
+    void Release(const Location &location);
+
+    /**
+     * Keeps data at the location in place until returned pin is destroyed, even if value gets released
+     * meanwhile. Pin must not outlive the tier
+     */
+    std::shared_ptr<void> Pin(const Location &location);
+
+    // File descriptor and offset of the value at the location, valid while location is live or pinned
+    int Fd(const Location &location) const { return _segments[location.segment].fd; }
+    static uint64_t ValueOffset(const Location &location);
+
+    /**
+     * Reads size bytes of the segment file at offset, e.g. pinned value, returns false on I/O error
+     */
+    static bool ReadAt(int fd, char *data, std::size_t size, uint64_t offset);
+
+    // Counters for stats
+    std::size_t LiveBytes() const;
+    std::size_t Capacity() const { return _segments.size() * _segment_size; }
+
+    // Record of key and value larger than that is never written
+    std::size_t SegmentSize() const { return _segment_size; }
+    std::size_t Compactions() const { return _compactions.load(); }
+
+private:
+    FileTier(const FileTier &) = delete;
+    FileTier &operator=(const FileTier &) = delete;
+
+    struct Segment {
+        int fd;
+
+        // Bytes appended, bytes still referred and number of pins, guarded by _mutex
+        std::size_t used;
+        std::size_t live;
+        std::size_t pins;
+    };
+
+    bool Append(const std::string &key, const std::string &value, Location &location, bool compaction);
+
+    // Drops pin taken by Pin
+    void Unpin(uint32_t segment);
+
+    // Makes segment free if nothing refers it anymore, _mutex must be held
+    void Recycle(uint32_t segment);
+
+    // Compaction thread
+    void OnRun();
+
+    // Moves live values of the given segment, returns false if tier ran out of space
+    bool Compact(uint32_t segment);
+
+    std::string _path;
+    std::size_t _segment_size;
+    std::shared_ptr<spdlog::logger> _logger;
+
+    // Segments, their fds never change while tier exists
+    std::vector<Segment> _segments;
+
+    // Allocation state, guarded by _mutex. Segment being compacted isn't freed until compaction is done
+    mutable std::mutex _mutex;
+    uint32_t _current;
+    uint32_t _compacting;
+    std::vector<uint32_t> _free;
+
+    // Compaction thread
+    Refers _refers;
+    Relocate _relocate;
+    std::condition_variable _cv;
+    bool _stopping;
+    std::thread _compactor;
+    std::atomic<std::size_t> _compactions;
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_FILE_TIER_H
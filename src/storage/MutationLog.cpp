@@ -0,0 +1,341 @@
+#include "MutationLog.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <spdlog/logger.h>
+
+namespace Afina {
+namespace Backend {
+
+namespace {
+
+const char kPut = 'P';
+const char kDelete = 'D';
+const char kExpiring = 'E';
+const char kTouch = 'T';
+
+// checksum, op, key_size, value_size
+const std::size_t kRecordHeader = 4 + 1 + 4 + 4;
+
+// Async mode doesn't sync, but still writes in groups
+const std::chrono::milliseconds kAsyncInterval(10);
+
+// FNV-1a
+uint32_t checksum(const char *data, std::size_t size) {
+    uint32_t hash = 2166136261u;
+    for (std::size_t i = 0; i < size; i++) {
+        hash ^= static_cast<unsigned char>(data[i]);
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+} // namespace
+
+// Record in the list, serialized record data follows the struct
+struct MutationLog::Record {
+    Record *next;
+    std::size_t size;
+
+    char *Data() { return reinterpret_cast<char *>(this + 1); }
+};
+
+// See MutationLog.h
+MutationLog::MutationLog(const std::string &path, std::chrono::milliseconds sync_interval,
+                         std::shared_ptr<spdlog::logger> logger)
+    : _path(path), _sync_interval(sync_interval), _logger(logger), _head(nullptr), _fd(-1), _segment(0),
+      _stopping(false) {}
+
+// See MutationLog.h
+MutationLog::~MutationLog() {
+    Stop();
+
+    // Not written if Start has never been called
+    Record *record = _head.exchange(nullptr);
+    while (record != nullptr) {
+        Record *next = record->next;
+        delete[] reinterpret_cast<char *>(record);
+        record = next;
+    }
+}
+
+// See MutationLog.h
+std::size_t MutationLog::Replay(const std::function<void(const std::string &, const std::string &, int64_t)> &put,
+                                const std::function<void(const std::string &)> &del,
+                                const std::function<void(const std::string &, int64_t)> &touch) {
+    std::size_t replayed = 0;
+    std::string key, value;
+    for (uint64_t segment : Segments()) {
+        std::string path = SegmentPath(segment);
+        int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd == -1) {
+            throw std::runtime_error("Failed to open " + path + ": " + std::string(strerror(errno)));
+        }
+        struct stat st;
+        if (fstat(fd, &st) != 0) {
+            close(fd);
+            throw std::runtime_error("Failed to stat " + path + ": " + std::string(strerror(errno)));
+        }
+        std::size_t size = st.st_size;
+        if (size == 0) {
+            close(fd);
+            continue;
+        }
+        void *base = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (base == MAP_FAILED) {
+            throw std::runtime_error("Failed to map " + path + ": " + std::string(strerror(errno)));
+        }
+        madvise(base, size, MADV_SEQUENTIAL);
+
+        const char *begin = static_cast<const char *>(base);
+        const char *pos = begin, *end = begin + size;
+        while (end - pos >= static_cast<std::ptrdiff_t>(kRecordHeader)) {
+            uint32_t sum, key_size, value_size;
+            std::memcpy(&sum, pos, 4);
+            std::memcpy(&key_size, pos + 5, 4);
+            std::memcpy(&value_size, pos + 9, 4);
+            std::size_t record_size = kRecordHeader + std::size_t(key_size) + value_size;
+            bool with_deadline = pos[4] == kExpiring || pos[4] == kTouch;
+            if (static_cast<std::size_t>(end - pos) < record_size || checksum(pos + 4, record_size - 4) != sum ||
+                (pos[4] != kPut && pos[4] != kDelete && !with_deadline) || (with_deadline && value_size < 8)) {
+                break;
+            }
+
+            key.assign(pos + kRecordHeader, key_size);
+            const char *data = pos + kRecordHeader + key_size;
+            int64_t deadline = 0;
+            if (with_deadline) {
+                std::memcpy(&deadline, data, 8);
+                data += 8;
+                value_size -= 8;
+            }
+            if (pos[4] == kDelete) {
+                del(key);
+            } else if (pos[4] == kTouch) {
+                touch(key, deadline);
+            } else {
+                value.assign(data, value_size);
+                put(key, value, deadline);
+            }
+            replayed++;
+            pos += record_size;
+        }
+
+        if (pos != end) {
+            _logger->error("Mutation log {} is damaged at offset {}, {} bytes ignored", path, pos - begin, end - pos);
+        }
+        munmap(base, size);
+    }
+    return replayed;
+}
+
+// See MutationLog.h
+void MutationLog::Start() {
+    std::vector<uint64_t> segments = Segments();
+
+    // Never append after possibly damaged tail of the previous run
+    std::unique_lock<std::mutex> lock(_file_mutex);
+    Open(segments.empty() ? 1 : segments.back() + 1);
+    _stopping = false;
+    _writer = std::thread(&MutationLog::OnRun, this);
+}
+
+// See MutationLog.h
+void MutationLog::Stop() {
+    if (!_writer.joinable()) {
+        return;
+    }
+
+    {
+        std::unique_lock<std::mutex> lock(_file_mutex);
+        _stopping = true;
+    }
+    _cv.notify_one();
+    _writer.join();
+
+    std::unique_lock<std::mutex> lock(_file_mutex);
+    Flush();
+    if (fdatasync(_fd) != 0) {
+        _logger->error("Failed to sync mutation log: {}", strerror(errno));
+    }
+    close(_fd);
+    _fd = -1;
+}
+
+// See MutationLog.h
+void MutationLog::Put(const std::string &key, const std::string &value, int64_t deadline) {
+    Append(deadline != 0 ? kExpiring : kPut, key, value, deadline);
+}
+
+// See MutationLog.h
+void MutationLog::Delete(std::string_view key) { Append(kDelete, key, std::string_view()); }
+
+// See MutationLog.h
+void MutationLog::Touch(std::string_view key, int64_t deadline) {
+    Append(kTouch, key, std::string_view(), deadline);
+}
+
+// See MutationLog.h
+void MutationLog::Append(char op, std::string_view key, std::string_view value, int64_t deadline) {
+    std::size_t prefix = op == kExpiring || op == kTouch ? 8 : 0;
+    std::size_t size = kRecordHeader + key.size() + prefix + value.size();
+    Record *record = reinterpret_cast<Record *>(new char[sizeof(Record) + size]);
+    record->size = size;
+
+    // Checksum is left to the writer thread
+    char *data = record->Data();
+    uint32_t key_size = key.size(), value_size = prefix + value.size();
+    data[4] = op;
+    std::memcpy(data + 5, &key_size, 4);
+    std::memcpy(data + 9, &value_size, 4);
+    std::memcpy(data + kRecordHeader, key.data(), key.size());
+    std::memcpy(data + kRecordHeader + key.size(), &deadline, prefix);
+    std::memcpy(data + kRecordHeader + key.size() + prefix, value.data(), value.size());
+
+    record->next = _head.load(std::memory_order_relaxed);
+    while (!_head.compare_exchange_weak(record->next, record, std::memory_order_release, std::memory_order_relaxed)) {
+    }
+}
+
+// See MutationLog.h
+uint64_t MutationLog::Rotate() {
+    std::unique_lock<std::mutex> lock(_file_mutex);
+    Flush();
+    Open(_segment + 1);
+    return _segment;
+}
+
+// See MutationLog.h
+void MutationLog::Drop(uint64_t segment) {
+    for (uint64_t s : Segments()) {
+        if (s >= segment) {
+            break;
+        }
+        if (unlink(SegmentPath(s).c_str()) != 0) {
+            _logger->error("Failed to remove {}: {}", SegmentPath(s), strerror(errno));
+        }
+    }
+}
+
+// See MutationLog.h
+void MutationLog::OnRun() {
+    std::chrono::milliseconds interval = _sync_interval.count() > 0 ? _sync_interval : kAsyncInterval;
+    std::unique_lock<std::mutex> lock(_file_mutex);
+    while (!_stopping) {
+        _cv.wait_for(lock, interval);
+        Flush();
+    }
+}
+
+// See MutationLog.h
+void MutationLog::Flush() {
+    Record *record = _head.exchange(nullptr, std::memory_order_acquire);
+    if (record == nullptr) {
+        return;
+    }
+
+    // List keeps the latest record first
+    Record *ordered = nullptr;
+    while (record != nullptr) {
+        Record *next = record->next;
+        record->next = ordered;
+        ordered = record;
+        record = next;
+    }
+
+    _buffer.clear();
+    for (record = ordered; record != nullptr;) {
+        char *data = record->Data();
+        uint32_t sum = checksum(data + 4, record->size - 4);
+        std::memcpy(data, &sum, 4);
+        _buffer.append(data, record->size);
+
+        Record *next = record->next;
+        delete[] reinterpret_cast<char *>(record);
+        record = next;
+    }
+
+    const char *pos = _buffer.data();
+    std::size_t size = _buffer.size();
+    while (size > 0) {
+        ssize_t n = write(_fd, pos, size);
+        if (n == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            _logger->error("Failed to write mutation log, {} bytes lost: {}", size, strerror(errno));
+            return;
+        }
+        pos += n;
+        size -= n;
+    }
+
+    if (_sync_interval.count() > 0 && fdatasync(_fd) != 0) {
+        _logger->error("Failed to sync mutation log: {}", strerror(errno));
+    }
+}
+
+// See MutationLog.h
+void MutationLog::Open(uint64_t segment) {
+    std::string path = SegmentPath(segment);
+    int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_APPEND | O_CLOEXEC, 0600);
+    if (fd == -1) {
+        throw std::runtime_error("Failed to create " + path + ": " + std::string(strerror(errno)));
+    }
+
+    if (_fd != -1) {
+        close(_fd);
+    }
+    _fd = fd;
+    _segment = segment;
+}
+
+// See MutationLog.h
+std::vector<uint64_t> MutationLog::Segments() const {
+    std::string dir = ".", prefix = _path + ".";
+    std::size_t slash = _path.rfind('/');
+    if (slash != std::string::npos) {
+        dir = slash == 0 ? "/" : _path.substr(0, slash);
+        prefix = _path.substr(slash + 1) + ".";
+    }
+
+    DIR *d = opendir(dir.c_str());
+    if (d == nullptr) {
+        throw std::runtime_error("Failed to open " + dir + ": " + std::string(strerror(errno)));
+    }
+    std::vector<uint64_t> segments;
+    for (struct dirent *entry = readdir(d); entry != nullptr; entry = readdir(d)) {
+        std::string name = entry->d_name;
+        if (name.size() <= prefix.size() || name.compare(0, prefix.size(), prefix) != 0 ||
+            name.find_first_not_of("0123456789", prefix.size()) != std::string::npos) {
+            continue;
+        }
+        segments.push_back(std::strtoull(name.c_str() + prefix.size(), nullptr, 10));
+    }
+    closedir(d);
+
+    std::sort(segments.begin(), segments.end());
+    return segments;
+}
+
+// See MutationLog.h
+std::string MutationLog::SegmentPath(uint64_t segment) const {
+    char suffix[32];
+    std::snprintf(suffix, sizeof(suffix), ".%06llu", static_cast<unsigned long long>(segment));
+    return _path + suffix;
+}
+
+} // namespace Backend
+} // namespace Afina
@@ -0,0 +1,131 @@
+#ifndef AFINA_STORAGE_MUTATION_LOG_H
+#define AFINA_STORAGE_MUTATION_LOG_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace spdlog {
+class logger;
+}
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # Append-only log of storage mutations
+ * Storage appends every successful change to the log, so changes made after the last snapshot survive
+ * restart. Storage threads never touch the file: they push records into the lock-free list, while the
+ * dedicated writer thread takes the whole list once per group commit interval and writes it with a single
+ * write(). In sync mode each group is followed by fdatasync(), so at most one interval of changes could
+ * be lost on power failure. In async mode file is never synced explicitly, that survives process crash
+ * but not OS one.
+ *
+ * Log is a sequence of segment files <path>.<number>. Rotate starts new segment, so ones written before
+ * could be dropped once snapshot covering them is saved.
+ *
+ * Record layout, numbers are in host byte order:
+ *   checksum(4) op(1) key_size(4) value_size(4) key value
+ * Checksum covers everything after itself. Op is P for put, D for delete, E for put of the value which
+ * expires and T for change of expiration time. Value of E record starts with deadline(8), Unix time value
+ * expires at, value of T record is just deadline. Replay stops at the first incomplete or damaged record, which
+ * is what crash in the middle of write leaves behind.
+ */
+class MutationLog {
+public:
+    /**
+     * Log writes segments next to path, sync_interval is time between group commits, async mode
+     * if zero
+     */
+    MutationLog(const std::string &path, std::chrono::milliseconds sync_interval,
+                std::shared_ptr<spdlog::logger> logger);
+    ~MutationLog();
+
+    /**
+     * Feeds every record of every segment on the disk to the given callbacks in order, returns number
+     * of records. Put and touch get deadline of the value, 0 if it never expires. Must be called before Start
+     */
+    std::size_t Replay(const std::function<void(const std::string &, const std::string &, int64_t)> &put,
+                       const std::function<void(const std::string &)> &del,
+                       const std::function<void(const std::string &, int64_t)> &touch);
+
+    /**
+     * Opens new segment and starts writer thread. Throws std::runtime_error if segment can't be created
+     */
+    void Start();
+
+    /**
+     * Writes and syncs everything appended so far, stops writer thread
+     */
+    void Stop();
+
+    // Append records, safe to call from any thread. Record is written on the next group commit. Deadline
+    // is Unix time value expires at, 0 if it never does
+    void Put(const std::string &key, const std::string &value, int64_t deadline = 0);
+    void Delete(std::string_view key);
+    void Touch(std::string_view key, int64_t deadline);
+
+    /**
+     * Writes everything appended so far to the current segment and starts new one, returns its
+     * number. Throws std::runtime_error if segment can't be created
+     */
+    uint64_t Rotate();
+
+    /**
+     * Removes segments older than the given one
+     */
+    void Drop(uint64_t segment);
+
+private:
+    MutationLog(const MutationLog &) = delete;
+    MutationLog &operator=(const MutationLog &) = delete;
+
+    struct Record;
+
+    // Writer thread
+    void OnRun();
+
+    // Push record to the list
+    void Append(char op, std::string_view key, std::string_view value, int64_t deadline = 0);
+
+    // Write and maybe sync records appended so far, _file_mutex must be held
+    void Flush();
+
+    // Opens segment with the given number, _file_mutex must be held
+    void Open(uint64_t segment);
+
+    // Numbers of segments on the disk, ascending
+    std::vector<uint64_t> Segments() const;
+    std::string SegmentPath(uint64_t segment) const;
+
+    std::string _path;
+    std::chrono::milliseconds _sync_interval;
+    std::shared_ptr<spdlog::logger> _logger;
+
+    // Records appended since last flush, the latest first
+    std::atomic<Record *> _head;
+
+    // Current segment, guarded by _file_mutex
+    std::mutex _file_mutex;
+    int _fd;
+    uint64_t _segment;
+    std::string _buffer;
+
+    // Writer thread state, guarded by _file_mutex
+    std::condition_variable _cv;
+    bool _stopping;
+    std::thread _writer;
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_MUTATION_LOG_H
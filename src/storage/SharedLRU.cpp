@@ -0,0 +1,679 @@
+#include "SharedLRU.h"
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <unordered_set>
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "Expiration.h"
+
+namespace Afina {
+namespace Backend {
+
+namespace {
+
+// Segment identification, version must be bumped on any layout change
+constexpr uint64_t kMagic = 0x4d48535f414e4946; // "FINA_SHM"
+constexpr uint32_t kVersion = 2;
+
+// Space reserved for the header at the segment start
+constexpr std::size_t kHeaderSpace = 4096;
+
+// Buddy allocator block sizes: from 64 bytes up to 2MB
+constexpr unsigned kMinOrder = 6;
+constexpr unsigned kMaxOrder = 21;
+constexpr unsigned kOrders = kMaxOrder - kMinOrder + 1;
+
+// Expected average entry size, defines number of hash buckets
+constexpr std::size_t kBytesPerBucket = 256;
+constexpr std::size_t kMinBuckets = 1024;
+
+// Hash must be the same in every process attaching the segment, so std::hash can't be used
+uint64_t fnv1a(const char *data, std::size_t size) {
+    uint64_t hash = 0xcbf29ce484222325ull;
+    for (std::size_t i = 0; i < size; i++) {
+        hash ^= static_cast<unsigned char>(data[i]);
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
+
+uint64_t fnv1a(std::string_view s) { return fnv1a(s.data(), s.size()); }
+
+// Header of every arena block, free block also keeps free list links
+struct Block {
+    uint32_t order;
+    uint32_t free;
+    uint64_t prev;
+    uint64_t next;
+};
+
+} // namespace
+
+struct SharedLRU::Header {
+    uint64_t magic;
+    uint32_t version;
+    uint32_t header_size;
+
+    // Whole segment size
+    uint64_t size;
+
+    // Hash index: array of entry offsets, chained by Entry::hash_next
+    uint64_t buckets;
+    uint64_t bucket_count;
+
+    // Memory entries are allocated from, multiple of the max block size
+    uint64_t arena;
+    uint64_t arena_size;
+    uint64_t free_lists[kOrders];
+
+    // LRU list, head is the most recently used entry
+    uint64_t lru_head;
+    uint64_t lru_tail;
+
+    // Number of entries and size of their keys and values
+    uint64_t count;
+    uint64_t bytes;
+
+    pthread_mutex_t lock;
+};
+
+struct SharedLRU::Entry {
+    // Block header, see Block
+    uint32_t order;
+    uint32_t free;
+
+    uint64_t hash;
+    uint64_t hash_next;
+    uint64_t lru_prev;
+    uint64_t lru_next;
+
+    uint32_t key_size;
+    uint32_t value_size;
+
+    // Unix time entry expires at, 0 if never
+    int64_t deadline;
+
+    char *Key() { return reinterpret_cast<char *>(this + 1); }
+    char *Value() { return Key() + key_size; }
+    std::size_t Capacity() const { return (std::size_t(1) << order) - sizeof(Entry); }
+};
+
+/**
+ * Holds segment lock. If previous owner died holding it then cache could be in the middle of an
+ * update, so it is dropped
+ */
+class SharedLRU::Lock {
+public:
+    explicit Lock(SharedLRU &lru) : _lru(lru) {
+        int err = pthread_mutex_lock(&_lru._header->lock);
+        if (err == EOWNERDEAD) {
+            pthread_mutex_consistent(&_lru._header->lock);
+            _lru.Format();
+        } else if (err != 0) {
+            throw std::runtime_error("Failed to lock shared storage: " + std::string(strerror(err)));
+        }
+    }
+    ~Lock() { pthread_mutex_unlock(&_lru._header->lock); }
+
+private:
+    SharedLRU &_lru;
+};
+
+// See SharedLRU.h
+SharedLRU::SharedLRU(const std::string &name, std::size_t size)
+    : _name(name), _fd(-1), _base(nullptr), _size(0), _header(nullptr), _recovered(0) {
+    static_assert(sizeof(Header) <= kHeaderSpace, "Header doesn't fit reserved space");
+    static_assert(sizeof(Block) <= (1u << kMinOrder), "Block header doesn't fit min block");
+    static_assert(sizeof(Entry) <= (1u << kMinOrder), "Entry header doesn't fit min block");
+
+    _fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+    if (_fd == -1) {
+        throw std::runtime_error("Failed to open shared memory " + name + ": " + std::string(strerror(errno)));
+    }
+
+    // Serialize concurrent attaches, so segment is formatted once
+    if (flock(_fd, LOCK_EX) == -1) {
+        close(_fd);
+        throw std::runtime_error("Failed to lock shared memory " + name + ": " + std::string(strerror(errno)));
+    }
+
+    try {
+        // Existing segment keeps its size, new one must be removed first to be resized
+        struct stat st;
+        if (fstat(_fd, &st) == -1) {
+            throw std::runtime_error("Failed to stat shared memory: " + std::string(strerror(errno)));
+        }
+        bool created = (st.st_size == 0);
+        if (created && ftruncate(_fd, size) == -1) {
+            throw std::runtime_error("Failed to resize shared memory: " + std::string(strerror(errno)));
+        }
+        _size = created ? size : st.st_size;
+        if (_size < kHeaderSpace + (1u << kMaxOrder)) {
+            throw std::runtime_error("Shared memory is too small: " + std::to_string(_size));
+        }
+
+        void *base = mmap(nullptr, _size, PROT_READ | PROT_WRITE, MAP_SHARED, _fd, 0);
+        if (base == MAP_FAILED) {
+            throw std::runtime_error("Failed to map shared memory: " + std::string(strerror(errno)));
+        }
+        _base = static_cast<char *>(base);
+        _header = reinterpret_cast<Header *>(_base);
+
+        std::string error;
+        if (!created && Validate(error)) {
+            _recovered = _header->count;
+        } else {
+            if (!created) {
+                _dropped = error;
+            }
+
+            // Either nobody uses segment or it is broken anyway
+            std::memset(_header, 0, sizeof(Header));
+            _header->size = _size;
+            _header->buckets = kHeaderSpace;
+            _header->bucket_count = kMinBuckets;
+            while (_header->bucket_count * kBytesPerBucket < _size) {
+                _header->bucket_count *= 2;
+            }
+            _header->arena = _header->buckets + _header->bucket_count * sizeof(uint64_t);
+            _header->arena = (_header->arena + (1u << kMinOrder) - 1) & ~uint64_t((1u << kMinOrder) - 1);
+            if (_header->arena + (1u << kMaxOrder) > _size) {
+                throw std::runtime_error("Shared memory is too small: " + std::to_string(_size));
+            }
+            _header->arena_size = (_size - _header->arena) & ~uint64_t((1u << kMaxOrder) - 1);
+
+            pthread_mutexattr_t attr;
+            pthread_mutexattr_init(&attr);
+            pthread_mutexattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+            pthread_mutexattr_setrobust(&attr, PTHREAD_MUTEX_ROBUST);
+            pthread_mutex_init(&_header->lock, &attr);
+            pthread_mutexattr_destroy(&attr);
+
+            Format();
+
+            // Header is complete, segment could be attached by others
+            _header->version = kVersion;
+            _header->header_size = sizeof(Header);
+            __atomic_store_n(&_header->magic, kMagic, __ATOMIC_RELEASE);
+        }
+    } catch (...) {
+        if (_base != nullptr) {
+            munmap(_base, _size);
+        }
+        close(_fd);
+        throw;
+    }
+
+    flock(_fd, LOCK_UN);
+}
+
+// See SharedLRU.h
+SharedLRU::~SharedLRU() {
+    munmap(_base, _size);
+    close(_fd);
+}
+
+// See SharedLRU.h
+std::size_t SharedLRU::Size() {
+    Lock lock(*this);
+    return _header->count;
+}
+
+// See SharedLRU.h
+std::size_t SharedLRU::MaxEntry() const {
+    std::size_t block = std::size_t(1) << kMaxOrder;
+    if (_header->arena_size < block) {
+        block = _header->arena_size;
+    }
+    return block - sizeof(Entry);
+}
+
+// See SharedLRU.h
+bool SharedLRU::Put(const std::string &key, const std::string &value, int32_t expire) {
+    if (key.size() + value.size() > MaxEntry()) {
+        return false;
+    }
+
+    uint64_t hash = fnv1a(key);
+    int64_t when = deadline(expire);
+    Lock lock(*this);
+    uint64_t offset = Find(key, hash);
+    if (expired(when, time(nullptr))) {
+        // Value expired already is as good as deleted
+        if (offset != 0) {
+            Remove(offset);
+        }
+        return true;
+    }
+    if (offset != 0 && At<Entry>(offset)->Capacity() >= key.size() + value.size()) {
+        Replace(offset, value);
+        At<Entry>(offset)->deadline = when;
+        return true;
+    }
+    if (offset != 0) {
+        Remove(offset);
+    }
+    return Insert(key, value, hash, when) != 0;
+}
+
+// See SharedLRU.h
+bool SharedLRU::PutIfAbsent(const std::string &key, const std::string &value, int32_t expire) {
+    if (key.size() + value.size() > MaxEntry()) {
+        return false;
+    }
+
+    uint64_t hash = fnv1a(key);
+    int64_t when = deadline(expire);
+    Lock lock(*this);
+    if (Find(key, hash) != 0) {
+        return false;
+    }
+    if (expired(when, time(nullptr))) {
+        return true;
+    }
+    return Insert(key, value, hash, when) != 0;
+}
+
+// See SharedLRU.h
+bool SharedLRU::Set(const std::string &key, const std::string &value, int32_t expire) {
+    if (key.size() + value.size() > MaxEntry()) {
+        return false;
+    }
+
+    uint64_t hash = fnv1a(key);
+    int64_t when = deadline(expire);
+    Lock lock(*this);
+    uint64_t offset = Find(key, hash);
+    if (offset == 0) {
+        return false;
+    }
+    if (expired(when, time(nullptr))) {
+        Remove(offset);
+        return true;
+    }
+    if (At<Entry>(offset)->Capacity() >= key.size() + value.size()) {
+        Replace(offset, value);
+        At<Entry>(offset)->deadline = when;
+        return true;
+    }
+    Remove(offset);
+    return Insert(key, value, hash, when) != 0;
+}
+
+// See SharedLRU.h
+bool SharedLRU::Delete(std::string_view key) {
+    uint64_t hash = fnv1a(key);
+    Lock lock(*this);
+    uint64_t offset = Find(key, hash);
+    if (offset == 0) {
+        return false;
+    }
+    Remove(offset);
+    return true;
+}
+
+// See SharedLRU.h
+bool SharedLRU::Update(std::string_view key, const std::function<bool(std::string &)> &update) {
+    uint64_t hash = fnv1a(key);
+    Lock lock(*this);
+    uint64_t offset = Find(key, hash);
+    if (offset == 0) {
+        return false;
+    }
+
+    Entry *entry = At<Entry>(offset);
+    std::string value(entry->Value(), entry->value_size);
+    if (!update(value) || key.size() + value.size() > MaxEntry()) {
+        return false;
+    }
+    if (entry->Capacity() >= key.size() + value.size()) {
+        Replace(offset, value);
+        return true;
+    }
+
+    // Entry keeps its deadline, only the value changes
+    int64_t when = entry->deadline;
+    Remove(offset);
+    return Insert(std::string(key), value, hash, when) != 0;
+}
+
+// See SharedLRU.h
+bool SharedLRU::Get(std::string_view key, std::string &value) {
+    uint64_t hash = fnv1a(key);
+    Lock lock(*this);
+    uint64_t offset = Find(key, hash);
+    if (offset == 0) {
+        return false;
+    }
+
+    Entry *entry = At<Entry>(offset);
+    value.assign(entry->Value(), entry->value_size);
+    Unlink(offset);
+    LinkHead(offset);
+    return true;
+}
+
+// See SharedLRU.h
+bool SharedLRU::Touch(std::string_view key, int32_t expire) {
+    uint64_t hash = fnv1a(key);
+    int64_t when = deadline(expire);
+    Lock lock(*this);
+    uint64_t offset = Find(key, hash);
+    if (offset == 0) {
+        return false;
+    }
+
+    if (expired(when, time(nullptr))) {
+        Remove(offset);
+    } else {
+        At<Entry>(offset)->deadline = when;
+    }
+    return true;
+}
+
+uint64_t *SharedLRU::Buckets() const { return At<uint64_t>(_header->buckets); }
+
+// Drops all entries, segment header must be valid
+void SharedLRU::Format() {
+    std::memset(Buckets(), 0, _header->bucket_count * sizeof(uint64_t));
+    std::memset(_header->free_lists, 0, sizeof(_header->free_lists));
+    _header->lru_head = _header->lru_tail = 0;
+    _header->count = _header->bytes = 0;
+
+    for (uint64_t offset = 0; offset < _header->arena_size; offset += (1u << kMaxOrder)) {
+        PushFree(_header->arena + offset, kMaxOrder);
+    }
+}
+
+// Checks that segment is created by compatible version and its structures are consistent
+bool SharedLRU::Validate(std::string &error) const {
+    const Header *h = _header;
+    if (_size < kHeaderSpace || __atomic_load_n(&h->magic, __ATOMIC_ACQUIRE) != kMagic) {
+        error = "not a storage segment";
+        return false;
+    }
+    if (h->version != kVersion || h->header_size != sizeof(Header)) {
+        error = "segment created by incompatible version";
+        return false;
+    }
+    if (h->size != _size || h->buckets != kHeaderSpace || h->bucket_count == 0 ||
+        (h->bucket_count & (h->bucket_count - 1)) != 0 || h->arena < h->buckets + h->bucket_count * sizeof(uint64_t) ||
+        h->arena > _size || h->arena_size > _size - h->arena || h->arena_size % (1u << kMaxOrder) != 0) {
+        error = "broken segment layout";
+        return false;
+    }
+
+    // Segment is consistent unless its last user died in the middle of update
+    int err = pthread_mutex_trylock(const_cast<pthread_mutex_t *>(&h->lock));
+    if (err == EOWNERDEAD) {
+        pthread_mutex_consistent(const_cast<pthread_mutex_t *>(&h->lock));
+        pthread_mutex_unlock(const_cast<pthread_mutex_t *>(&h->lock));
+        error = "previous process died while updating cache";
+        return false;
+    } else if (err != 0) {
+        // Held by alive process, which is sharing cache during restart. Everything is fine then
+        return true;
+    }
+
+    // Walk all blocks of the arena
+    std::unordered_set<uint64_t> entries;
+    uint64_t free_blocks = 0, bytes = 0;
+    uint64_t end = h->arena + h->arena_size;
+    bool ok = true;
+    for (uint64_t offset = h->arena; ok && offset < end;) {
+        const Block *block = At<Block>(offset);
+        if (block->order < kMinOrder || block->order > kMaxOrder || ((offset - h->arena) & ((1u << block->order) - 1)) ||
+            offset + (1u << block->order) > end) {
+            ok = false;
+            break;
+        }
+        if (block->free) {
+            free_blocks++;
+        } else {
+            Entry *entry = At<Entry>(offset);
+            if (sizeof(Entry) + uint64_t(entry->key_size) + entry->value_size > (uint64_t(1) << entry->order) ||
+                entry->hash != fnv1a(entry->Key(), entry->key_size)) {
+                ok = false;
+                break;
+            }
+            entries.insert(offset);
+            bytes += entry->key_size + entry->value_size;
+        }
+        offset += (1u << block->order);
+    }
+    ok = ok && entries.size() == h->count && bytes == h->bytes;
+
+    // Free lists must refer free blocks only
+    uint64_t listed = 0;
+    for (unsigned order = kMinOrder; ok && order <= kMaxOrder; order++) {
+        uint64_t prev = 0;
+        for (uint64_t offset = h->free_lists[order - kMinOrder]; ok && offset != 0;) {
+            ok = offset >= h->arena && offset < end && ++listed <= free_blocks;
+            if (ok) {
+                const Block *block = At<Block>(offset);
+                ok = block->free && block->order == order && block->prev == prev;
+                prev = offset;
+                offset = block->next;
+            }
+        }
+    }
+    ok = ok && listed == free_blocks;
+
+    // Both index and LRU list must refer every entry exactly once
+    uint64_t linked = 0, prev = 0;
+    for (uint64_t offset = h->lru_head; ok && offset != 0; offset = At<Entry>(prev)->lru_next) {
+        ok = entries.count(offset) > 0 && ++linked <= h->count && At<Entry>(offset)->lru_prev == prev;
+        prev = offset;
+    }
+    ok = ok && linked == h->count && h->lru_tail == prev;
+
+    uint64_t indexed = 0;
+    const uint64_t *buckets = Buckets();
+    for (uint64_t i = 0; ok && i < h->bucket_count; i++) {
+        for (uint64_t offset = buckets[i]; ok && offset != 0; offset = At<Entry>(offset)->hash_next) {
+            ok = entries.count(offset) > 0 && ++indexed <= h->count &&
+                 (At<Entry>(offset)->hash & (h->bucket_count - 1)) == i;
+            if (!ok) {
+                break;
+            }
+        }
+    }
+    ok = ok && indexed == h->count;
+
+    pthread_mutex_unlock(const_cast<pthread_mutex_t *>(&h->lock));
+    if (!ok) {
+        error = "inconsistent cache structures";
+    }
+    return ok;
+}
+
+// Returns offset of the block big enough to keep size bytes, 0 if there is no such block
+uint64_t SharedLRU::Allocate(std::size_t size) {
+    unsigned order = kMinOrder;
+    while ((std::size_t(1) << order) < size) {
+        order++;
+    }
+    if (order > kMaxOrder) {
+        return 0;
+    }
+
+    unsigned found = order;
+    while (found <= kMaxOrder && _header->free_lists[found - kMinOrder] == 0) {
+        found++;
+    }
+    if (found > kMaxOrder) {
+        return 0;
+    }
+
+    // Split bigger block, upper halves go to free lists
+    uint64_t offset = _header->free_lists[found - kMinOrder];
+    RemoveFree(offset, found);
+    while (found > order) {
+        found--;
+        PushFree(offset + (uint64_t(1) << found), found);
+    }
+
+    Block *block = At<Block>(offset);
+    block->order = order;
+    block->free = 0;
+    return offset;
+}
+
+// Returns block to allocator, merging it with free buddies
+void SharedLRU::Free(uint64_t offset) {
+    unsigned order = At<Block>(offset)->order;
+    while (order < kMaxOrder) {
+        uint64_t buddy = _header->arena + ((offset - _header->arena) ^ (uint64_t(1) << order));
+        Block *block = At<Block>(buddy);
+        if (!block->free || block->order != order) {
+            break;
+        }
+        RemoveFree(buddy, order);
+        if (buddy < offset) {
+            offset = buddy;
+        }
+        order++;
+    }
+    PushFree(offset, order);
+}
+
+void SharedLRU::PushFree(uint64_t offset, unsigned order) {
+    uint64_t &head = _header->free_lists[order - kMinOrder];
+    Block *block = At<Block>(offset);
+    block->order = order;
+    block->free = 1;
+    block->prev = 0;
+    block->next = head;
+    if (head != 0) {
+        At<Block>(head)->prev = offset;
+    }
+    head = offset;
+}
+
+void SharedLRU::RemoveFree(uint64_t offset, unsigned order) {
+    Block *block = At<Block>(offset);
+    if (block->prev != 0) {
+        At<Block>(block->prev)->next = block->next;
+    } else {
+        _header->free_lists[order - kMinOrder] = block->next;
+    }
+    if (block->next != 0) {
+        At<Block>(block->next)->prev = block->prev;
+    }
+    block->free = 0;
+}
+
+// Returns offset of the entry for the key, 0 if there is none. Expired entry is removed once found
+uint64_t SharedLRU::Find(std::string_view key, uint64_t hash) {
+    uint64_t offset = Buckets()[hash & (_header->bucket_count - 1)];
+    while (offset != 0) {
+        Entry *entry = At<Entry>(offset);
+        if (entry->hash == hash && entry->key_size == key.size() && !std::memcmp(entry->Key(), key.data(), key.size())) {
+            if (expired(entry->deadline, time(nullptr))) {
+                Remove(offset);
+                return 0;
+            }
+            return offset;
+        }
+        offset = entry->hash_next;
+    }
+    return 0;
+}
+
+// Creates new entry, evicting least recently used ones if arena is full
+uint64_t SharedLRU::Insert(const std::string &key, const std::string &value, uint64_t hash, int64_t deadline) {
+    uint64_t offset;
+    while ((offset = Allocate(sizeof(Entry) + key.size() + value.size())) == 0) {
+        if (!EvictTail()) {
+            return 0;
+        }
+    }
+
+    Entry *entry = At<Entry>(offset);
+    entry->hash = hash;
+    entry->key_size = key.size();
+    entry->value_size = value.size();
+    entry->deadline = deadline;
+    std::memcpy(entry->Key(), key.data(), key.size());
+    std::memcpy(entry->Value(), value.data(), value.size());
+
+    uint64_t &bucket = Buckets()[hash & (_header->bucket_count - 1)];
+    entry->hash_next = bucket;
+    bucket = offset;
+    LinkHead(offset);
+
+    _header->count++;
+    _header->bytes += key.size() + value.size();
+    return offset;
+}
+
+void SharedLRU::Remove(uint64_t offset) {
+    Entry *entry = At<Entry>(offset);
+    uint64_t *link = &Buckets()[entry->hash & (_header->bucket_count - 1)];
+    while (*link != offset) {
+        link = &At<Entry>(*link)->hash_next;
+    }
+    *link = entry->hash_next;
+    Unlink(offset);
+
+    _header->count--;
+    _header->bytes -= entry->key_size + entry->value_size;
+    Free(offset);
+}
+
+// Updates value of the entry in place, block must be big enough
+void SharedLRU::Replace(uint64_t offset, const std::string &value) {
+    Entry *entry = At<Entry>(offset);
+    _header->bytes += value.size();
+    _header->bytes -= entry->value_size;
+    entry->value_size = value.size();
+    std::memcpy(entry->Value(), value.data(), value.size());
+    Unlink(offset);
+    LinkHead(offset);
+}
+
+void SharedLRU::Unlink(uint64_t offset) {
+    Entry *entry = At<Entry>(offset);
+    if (entry->lru_prev != 0) {
+        At<Entry>(entry->lru_prev)->lru_next = entry->lru_next;
+    } else {
+        _header->lru_head = entry->lru_next;
+    }
+    if (entry->lru_next != 0) {
+        At<Entry>(entry->lru_next)->lru_prev = entry->lru_prev;
+    } else {
+        _header->lru_tail = entry->lru_prev;
+    }
+    entry->lru_prev = entry->lru_next = 0;
+}
+
+void SharedLRU::LinkHead(uint64_t offset) {
+    Entry *entry = At<Entry>(offset);
+    entry->lru_prev = 0;
+    entry->lru_next = _header->lru_head;
+    if (_header->lru_head != 0) {
+        At<Entry>(_header->lru_head)->lru_prev = offset;
+    } else {
+        _header->lru_tail = offset;
+    }
+    _header->lru_head = offset;
+}
+
+bool SharedLRU::EvictTail() {
+    if (_header->lru_tail == 0) {
+        return false;
+    }
+    Remove(_header->lru_tail);
+    return true;
+}
+
+} // namespace Backend
+} // namespace Afina
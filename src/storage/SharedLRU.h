@@ -0,0 +1,129 @@
+#ifndef AFINA_STORAGE_SHARED_LRU_H
+#define AFINA_STORAGE_SHARED_LRU_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include <afina/Storage.h>
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # LRU living in a named shared memory segment
+ * Whole cache state - entries, hash index, LRU list and allocator - is kept in the POSIX shared
+ * memory segment, so it survives process restart: new process attaches the segment left by the
+ * previous one and serves warm cache right away. Segment is never removed by afina itself, it
+ * lives till reboot or till `rm /dev/shm/<name>`.
+ *
+ * Segment could be mapped at different address by each process, so there are no pointers inside:
+ * entries refer each other by offsets from the segment start. Entries are allocated by buddy
+ * allocator from the arena, once arena is full the least recently used entries are evicted.
+ *
+ * Expired entries are removed lazily, once they are looked up, or evicted as any other entry.
+ *
+ * Access is serialized by the robust process shared mutex stored in the segment, so two processes
+ * could share cache during graceful restart. If process dies in the middle of update then cache
+ * is dropped by the next one taking the lock. On attach segment layout is validated and cache is
+ * dropped if segment turns out to be broken or created by incompatible version
+ */
+class SharedLRU : public Afina::Storage {
+public:
+    /**
+     * Attaches segment with the given name or creates new one of the given size. Throws
+     * std::runtime_error if segment can't be created or mapped
+     */
+    SharedLRU(const std::string &name, std::size_t size = 64 * 1024 * 1024);
+    ~SharedLRU();
+
+    // Implements Afina::Storage interface, see MaxEntry
+    std::size_t MaxValueSize() const override { return MaxEntry(); }
+
+    // Implements Afina::Storage interface. Value which expires right away only removes the old one
+    bool Put(const std::string &key, const std::string &value, int32_t expire = 0) override;
+
+    // Implements Afina::Storage interface
+    bool PutIfAbsent(const std::string &key, const std::string &value, int32_t expire = 0) override;
+
+    // Implements Afina::Storage interface
+    bool Set(const std::string &key, const std::string &value, int32_t expire = 0) override;
+
+    // Implements Afina::Storage interface
+    bool Delete(std::string_view key) override;
+
+    // Implements Afina::Storage interface, update is called under the segment lock
+    bool Update(std::string_view key, const std::function<bool(std::string &)> &update) override;
+
+    // Implements Afina::Storage interface
+    bool Get(std::string_view key, std::string &value) override;
+
+    // Implements Afina::Storage interface, deadline is kept in the segment together with the entry
+    bool Touch(std::string_view key, int32_t expire) override;
+
+    /**
+     * Number of entries found in the segment on attach, 0 if cache started cold
+     */
+    std::size_t Recovered() const { return _recovered; }
+
+    /**
+     * Why existing segment has been dropped on attach, empty if it hasn't
+     */
+    const std::string &Dropped() const { return _dropped; }
+
+    /**
+     * Number of entries in cache
+     */
+    std::size_t Size();
+
+    /**
+     * Largest key + value size cache is able to keep
+     */
+    std::size_t MaxEntry() const;
+
+private:
+    SharedLRU(const SharedLRU &) = delete;
+    SharedLRU &operator=(const SharedLRU &) = delete;
+
+    struct Header;
+    struct Entry;
+    class Lock;
+
+    // Offset based access
+    template <typename T> T *At(uint64_t offset) const { return reinterpret_cast<T *>(_base + offset); }
+    uint64_t *Buckets() const;
+
+    // Segment layout
+    void Format();
+    bool Validate(std::string &error) const;
+
+    // Buddy allocator
+    uint64_t Allocate(std::size_t size);
+    void Free(uint64_t offset);
+    void PushFree(uint64_t offset, unsigned order);
+    void RemoveFree(uint64_t offset, unsigned order);
+
+    // Index and LRU list
+    uint64_t Find(std::string_view key, uint64_t hash);
+    uint64_t Insert(const std::string &key, const std::string &value, uint64_t hash, int64_t deadline);
+    void Remove(uint64_t offset);
+    void Replace(uint64_t offset, const std::string &value);
+    void Unlink(uint64_t offset);
+    void LinkHead(uint64_t offset);
+    bool EvictTail();
+
+    std::string _name;
+    int _fd;
+    char *_base;
+    std::size_t _size;
+    Header *_header;
+
+    std::size_t _recovered;
+    std::string _dropped;
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_SHARED_LRU_H
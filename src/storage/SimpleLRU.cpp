@@ -1,77 +1,206 @@
 #include "SimpleLRU.h"
+#include <ctime>
 #include <iostream>
 
+#include "Expiration.h"
+
 
 namespace Afina {
 namespace Backend {
 
-// See MapBasedGlobalLockImpl.h
-bool SimpleLRU::Put( const std::string &key, const std::string &value ){ 
+namespace {
+
+// Smaller values cost more to keep in the file tier than they save
+const size_t kMinDemote = 64;
+
+// Smaller values are cheaper to copy than to send by a separate syscall
+const size_t kMinFileValue = 16 * 1024;
+
+} // namespace
+
+template <typename Value> bool SimpleLRU::SetVal( lru_node* node, Value&& value ){
+
+	DropValue( node );
+
+	// Large values go to the file tier right away, memory keeps only the location
+	if( _tier && value.size() >= _tier_threshold && _tier->Write( node->key, value, node->location ) ){
+		std::string().swap( node->value );
+		node->in_file = true;
+	}
+	else{
+		_cur_size += value.size();
+		node->value = std::forward<Value>(value);
+	}
+
+	return true;
+}
+
+
+template <typename Value> bool SimpleLRU::CreateNode( const std::string& key, Value&& value, int64_t deadline ){
+
+	lru_node* node = new lru_node{key, {}, {}, {}, {}, false, deadline};
+	_cur_size += key.size();
+	SetVal( node, std::forward<Value>(value) );
+	_lru_index.emplace( std::cref(node->key), std::ref(*node) );
+
+        if( _lru_head ){
 
-	if( key.size() + value.size() > _max_size )
+                std::unique_ptr<lru_node> un_node;
+                un_node.reset(node);
+
+                _lru_head->prev = node;
+                un_node->next = std::move(_lru_head);
+                _lru_head = std::move(un_node);
+        }
+        else{
+                _lru_head.reset(node);
+                _lru_tail = _lru_head.get();
+        }
+
+	if( !_scan )
+		_scan = node;
+
+        return true;
+}
+
+
+// See SimpleLRU.h
+template <typename Value>
+bool SimpleLRU::Store( const std::string &key, Value &&value, bool create, bool update, int32_t expire ){
+
+	if( !Fits( key, value ) )
 		return false;
 
-	auto it = _lru_index.find(key);
+	auto it = Find(key);
+	int64_t when = deadline( expire );
+	bool gone = when != 0 && expired( when, time( nullptr ) );
 
 	if( it != _lru_index.end() ){
-	
-		lru_node* current_node = &it->second.get();		
+
+		if( !update )
+			return false;
+
+		if( gone ){
+			Unlink( it );
+			return true;
+		}
+
+		lru_node* current_node = &it->second.get();
 		MoveToHead( current_node );
-		SetVal( current_node, value );
+		SetVal( current_node, std::forward<Value>(value) );
+		current_node->deadline = when;
+	}
+	else
+	if( create ){
+		if( gone )
+			return true;
+		CreateNode( key, std::forward<Value>(value), when );
 	}
 	else
-		CreateNode( key, value );		
+		return false;
 	ClearSpace();
 
-	return true; 
+	return true;
 }
 
 // See MapBasedGlobalLockImpl.h
-bool SimpleLRU::PutIfAbsent( const std::string &key, const std::string &value ){
+bool SimpleLRU::Put( const std::string &key, const std::string &value, int32_t expire ){
 
-	if( key.size() + value.size() > _max_size )
-		return false;
+	return Store( key, value, true, true, expire );
+}
 
-	if( _lru_index.find(key) == _lru_index.end() ){			
+// See SimpleLRU.h
+bool SimpleLRU::Put( const std::string &key, std::string &&value, int32_t expire ){
 
-		CreateNode( key, value );
-		ClearSpace();
-		return true;
-	}
-       
-	return false; 
+	return Store( key, std::move(value), true, true, expire );
 }
 
 // See MapBasedGlobalLockImpl.h
-bool SimpleLRU::Set( const std::string &key, const std::string &value ){
+bool SimpleLRU::PutIfAbsent( const std::string &key, const std::string &value, int32_t expire ){
 
-	if( key.size() + value.size() > _max_size )
-		return false;
-	
-	auto it = _lru_index.find(key);
+	return Store( key, value, true, false, expire );
+}
 
-	if( it != _lru_index.end() ){
-	
-		lru_node* current_node = &it->second.get();
-		MoveToHead( current_node );
-		SetVal( current_node, value );
-		ClearSpace();
-		return true;
-	}	
+// See SimpleLRU.h
+bool SimpleLRU::PutIfAbsent( const std::string &key, std::string &&value, int32_t expire ){
 
-	return false;
+	return Store( key, std::move(value), true, false, expire );
 }
 
 // See MapBasedGlobalLockImpl.h
-bool SimpleLRU::Delete( const std::string &key ){
+bool SimpleLRU::Set( const std::string &key, const std::string &value, int32_t expire ){
+
+	return Store( key, value, false, true, expire );
+}
+
+// See SimpleLRU.h
+bool SimpleLRU::Set( const std::string &key, std::string &&value, int32_t expire ){
 
-	auto it = _lru_index.find(key);	
+	return Store( key, std::move(value), false, true, expire );
+}
+
+// See MapBasedGlobalLockImpl.h
+bool SimpleLRU::Delete( std::string_view key ){
+
+	auto it = Find(key);	
 	if( it == _lru_index.end() )
 		return false;
 
+	Unlink( it );
+	return true;
+}
+
+// See SimpleLRU.h
+bool SimpleLRU::Update( std::string_view key, const std::function<bool(std::string &)> &update ){
+
+	auto it = Find(key);
+	if( it == _lru_index.end() )
+		return false;
+
+	lru_node* current_node = &it->second.get();
+	std::string value;
+	if( current_node->in_file ){
+		if( !_tier->Read( current_node->location, value ) )
+			return false;
+	}
+	else
+		value = current_node->value;
+
+	// Node keeps its deadline, only the value changes
+	if( !update( value ) || !Fits( current_node->key, value ) )
+		return false;
+	MoveToHead( current_node );
+	SetVal( current_node, std::move(value) );
+	ClearSpace();
+
+	return true;
+}
+
+// See SimpleLRU.h
+SimpleLRU::lru_index::iterator SimpleLRU::Find( std::string_view key ){
+
+	auto it = _lru_index.find(key);
+	if( it != _lru_index.end() && it->second.get().deadline != 0 &&
+	    expired( it->second.get().deadline, time( nullptr ) ) ){
+
+		Unlink( it );
+		return _lru_index.end();
+	}
+	return it;
+}
+
+// See SimpleLRU.h
+void SimpleLRU::Unlink( lru_index::iterator it ){
+
 	lru_node* node = &it->second.get();
 	_lru_index.erase(it);
 
+	// Node is freed once unlinked
+	DropValue( node );
+	_cur_size -= node->key.size();
+	if( node == _scan )
+		_scan = node->prev;
+
 	if( node->next )
 		node->next->prev = node->prev;	
 	else
@@ -82,38 +211,41 @@ bool SimpleLRU::Delete( const std::string &key ){
 		node->prev->next = std::move(node->next);		
 	else
 		_lru_head = std::move(_lru_head->next);
-
-
-	_cur_size -= (node->key.size() + node->value.size());
-	return true;
 }
 
 // See MapBasedGlobalLockImpl.h
-bool SimpleLRU::Get( const std::string &key, std::string &value ){
+bool SimpleLRU::Get( std::string_view key, std::string &value ){
 
-	auto it = _lru_index.find(key);
+	auto it = Find(key);
 	
 	if( it != _lru_index.end() ){
 
 		lru_node* current_node = &it->second.get();
+		if( current_node->in_file ){
+
+			// Value stays in the file, only key becomes fresh
+			std::string stored;
+			if( !_tier->Read( current_node->location, stored ) ){
+				_misses++;
+				return false;
+			}
+			value.swap( stored );
+			_file_hits++;
+		}
+		else{
+			value = current_node->value;
+			_ram_hits++;
+		}
 		MoveToHead( current_node );
-		value = current_node->value;
 
 		return true;
 	}
 
+	_misses++;
 	return false; 
 }
 
 
-bool SimpleLRU::SetVal( lru_node* node, const std::string& value ){
-
-	_cur_size += value.size() - node->value.size();
-	node->value = value;
-
-	return true;
-}
-
 
 bool SimpleLRU::MoveToHead( lru_node* node ){
 
@@ -123,6 +255,9 @@ bool SimpleLRU::MoveToHead( lru_node* node ){
 	if( node == _lru_head.get() )
 		return true;
 
+	if( node == _scan )
+		_scan = node->prev;
+
 	if( _lru_head ){
 
 		std::unique_ptr<lru_node> un_node;
@@ -154,40 +289,27 @@ bool SimpleLRU::MoveToHead( lru_node* node ){
 		_lru_tail = _lru_head.get();
 	}
 
+	if( !_scan )
+		_scan = node;
+
 	return true;
 }
 
 
-bool SimpleLRU::CreateNode( const std::string& key, const std::string& value ){
-
-	lru_node* node = new lru_node{key, value, {}, {}};
-	_cur_size += key.size() + value.size();
-	_lru_index.emplace( std::cref(node->key), std::ref(*node) );
-
-        if( _lru_head ){
-
-                std::unique_ptr<lru_node> un_node;
-                un_node.reset(node);
-
-                _lru_head->prev = node;
-                un_node->next = std::move(_lru_head);
-                _lru_head = std::move(un_node);
-        }
-        else{
-                _lru_head.reset(node);
-                _lru_tail = _lru_head.get();
-        }
-
-        return true;
-}
-
 
 bool SimpleLRU::ClearSpace(){
 
 	while( _cur_size > _max_size && _lru_head ){
+
+		// Cold value goes to the file tier first, entry is dropped only if there is nothing to move
+		if( Demote() )
+			continue;
 	     		
         	_lru_index.erase(_lru_tail->key);
-        	_cur_size -= (_lru_tail->key.size() + _lru_tail->value.size());
+        	DropValue( _lru_tail );
+        	_cur_size -= _lru_tail->key.size();
+        	if( _lru_tail == _scan )
+        		_scan = _lru_tail->prev;
         
         	if( _lru_head ){
         
@@ -209,6 +331,146 @@ bool SimpleLRU::ClearSpace(){
 	else		return false;
 }
 
+// See SimpleLRU.h
+bool SimpleLRU::GetFile(std::string_view key, std::string &value, FileValue &file) {
+    file.fd = -1;
+    auto it = Find(key);
+    if (it == _lru_index.end() || !it->second.get().in_file || it->second.get().location.size < kMinFileValue) {
+        // Not virtual call, thread safe version already holds the lock
+        return SimpleLRU::Get(key, value);
+    }
+
+    lru_node *node = &it->second.get();
+    file.fd = _tier->Fd(node->location);
+    file.offset = FileTier::ValueOffset(node->location);
+    file.size = node->location.size;
+    file.pin = _tier->Pin(node->location);
+    _file_hits++;
+    MoveToHead(node);
+    return true;
+}
+
+// See SimpleLRU.h
+bool SimpleLRU::Touch(std::string_view key, int32_t expire) {
+    auto it = Find(key);
+    if (it == _lru_index.end()) {
+        return false;
+    }
+
+    int64_t when = deadline(expire);
+    if (expired(when, time(nullptr))) {
+        Unlink(it);
+    } else {
+        it->second.get().deadline = when;
+    }
+    return true;
+}
+
+// See SimpleLRU.h
+void SimpleLRU::ForEach(const Visitor &f) const {
+    const std::string empty;
+    FileValue file{-1, 0, 0, nullptr};
+    int64_t now = time(nullptr);
+    for (const lru_node *node = _lru_tail; node != nullptr; node = node->prev) {
+        if (expired(node->deadline, now)) {
+            continue;
+        } else if (!node->in_file) {
+            f(node->key, node->value, node->deadline, file);
+            continue;
+        }
+
+        FileValue stored{_tier->Fd(node->location), FileTier::ValueOffset(node->location), node->location.size,
+                         _tier->Pin(node->location)};
+        f(node->key, empty, node->deadline, stored);
+    }
+}
+
+// See SimpleLRU.h
+bool SimpleLRU::Deadline(std::string_view key, int64_t &deadline) const {
+    auto it = _lru_index.find(key);
+    if (it == _lru_index.end() || expired(it->second.get().deadline, time(nullptr))) {
+        return false;
+    }
+    deadline = it->second.get().deadline;
+    return true;
+}
+
+// See SimpleLRU.h
+void SimpleLRU::SetTier(FileTier *tier, size_t threshold) {
+    _tier = tier;
+    _tier_threshold = threshold;
+}
+
+// See SimpleLRU.h
+bool SimpleLRU::Refers(const std::string &key, const FileTier::Location &location) const {
+    auto it = _lru_index.find(key);
+    if (it == _lru_index.end()) {
+        return false;
+    }
+
+    const lru_node &node = it->second.get();
+    return node.in_file && node.location == location;
+}
+
+// See SimpleLRU.h
+bool SimpleLRU::Relocate(const std::string &key, const FileTier::Location &from, const FileTier::Location &to) {
+    if (!Refers(key, from)) {
+        return false;
+    }
+    _lru_index.find(key)->second.get().location = to;
+    return true;
+}
+
+// See SimpleLRU.h
+SimpleLRU::Hits SimpleLRU::GetHits() const { return Hits{_ram_hits, _file_hits, _misses}; }
+
+// See SimpleLRU.h
+std::size_t SimpleLRU::MaxValueSize() const {
+    if (_tier && _tier->SegmentSize() > _max_size) {
+        return _tier->SegmentSize();
+    }
+    return _max_size;
+}
+
+// See SimpleLRU.h
+bool SimpleLRU::Fits(const std::string &key, const std::string &value) const {
+    // Value written to the tier right away takes no memory
+    size_t in_memory = _tier && value.size() >= _tier_threshold ? 0 : value.size();
+    return key.size() + in_memory <= _max_size;
+}
+
+// See SimpleLRU.h
+void SimpleLRU::DropValue(lru_node *node) {
+    if (node->in_file) {
+        _tier->Release(node->location);
+        node->in_file = false;
+    } else {
+        _cur_size -= node->value.size();
+        node->value.clear();
+    }
+}
+
+// See SimpleLRU.h
+bool SimpleLRU::Demote() {
+    if (!_tier) {
+        return false;
+    }
+
+    // Nodes below _scan have nothing to demote
+    while (_scan && (_scan->in_file || _scan->value.size() < kMinDemote)) {
+        _scan = _scan->prev;
+    }
+    if (!_scan || !_tier->Write(_scan->key, _scan->value, _scan->location)) {
+        return false;
+    }
+
+    _cur_size -= _scan->value.size();
+    std::string().swap(_scan->value);
+    _scan->in_file = true;
+    _scan = _scan->prev;
+    return true;
+}
+
 
 void SimpleLRU::print_list(){
 
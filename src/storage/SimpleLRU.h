@@ -1,14 +1,18 @@
 #ifndef AFINA_STORAGE_SIMPLE_LRU_H
 #define AFINA_STORAGE_SIMPLE_LRU_H
 
+#include <functional>
 #include <unordered_map>
 #include <map>
 #include <memory>
 #include <mutex>
 #include <string>
+#include <string_view>
 
 #include <afina/Storage.h>
 
+#include "FileTier.h"
+
 namespace Afina {
 namespace Backend {
 
@@ -18,7 +22,8 @@ namespace Backend {
  */
 class SimpleLRU : public Afina::Storage {
 public:
-    SimpleLRU(size_t max_size = 1024) : _max_size(max_size), _cur_size(0), _node_count(0), _lru_head(nullptr), _lru_tail(nullptr) {}
+    SimpleLRU(size_t max_size = 1024) : _max_size(max_size), _cur_size(0), _node_count(0), _lru_head(nullptr), _lru_tail(nullptr),
+        _tier(nullptr), _tier_threshold(0), _scan(nullptr), _ram_hits(0), _file_hits(0), _misses(0) {}
 
     ~SimpleLRU(){
 
@@ -31,42 +36,142 @@ public:
 	_lru_head.reset();
     }
 
+    // Implements Afina::Storage interface. Value could take the whole memory or a tier segment
+    std::size_t MaxValueSize() const override;
+
+    // Implements Afina::Storage interface. Value which expires right away only removes the old one
+    bool Put(const std::string &key, const std::string &value, int32_t expire = 0) override;
+
+    // Implements Afina::Storage interface. Value memory becomes node value, unless it goes to the file tier
+    bool Put(const std::string &key, std::string &&value, int32_t expire = 0) override;
+
     // Implements Afina::Storage interface
-    bool Put(const std::string &key, const std::string &value) override;
+    bool PutIfAbsent(const std::string &key, const std::string &value, int32_t expire = 0) override;
+
+    // Implements Afina::Storage interface, see Put
+    bool PutIfAbsent(const std::string &key, std::string &&value, int32_t expire = 0) override;
 
     // Implements Afina::Storage interface
-    bool PutIfAbsent(const std::string &key, const std::string &value) override;
+    bool Set(const std::string &key, const std::string &value, int32_t expire = 0) override;
+
+    // Implements Afina::Storage interface, see Put
+    bool Set(const std::string &key, std::string &&value, int32_t expire = 0) override;
 
     // Implements Afina::Storage interface
-    bool Set(const std::string &key, const std::string &value) override;
+    bool Delete(std::string_view key) override;
+
+    // Implements Afina::Storage interface. Updated value that doesn't fit isn't stored
+    bool Update(std::string_view key, const std::function<bool(std::string &)> &update) override;
 
     // Implements Afina::Storage interface
-    bool Delete(const std::string &key) override;
+    bool Get(std::string_view key, std::string &value) override;
 
     // Implements Afina::Storage interface
-    bool Get(const std::string &key, std::string &value) override;
+    bool GetFile(std::string_view key, std::string &value, FileValue &file) override;
+
+    // Implements Afina::Storage interface. Only node deadline changes, expired nodes are dropped once
+    // they are looked up or get to the LRU tail
+    bool Touch(std::string_view key, int32_t expire) override;
+
+    // Callback of ForEach: key, value, deadline and file
+    using Visitor = std::function<void(const std::string &, const std::string &, int64_t, const FileValue &)>;
+
+    /**
+     * Calls f(key, value, deadline, file) for every live entry, from the least recently used to the most
+     * recently used one. Deadline is Unix time entry expires at, 0 if it never does. Doesn't change
+     * LRU order
+     *
+     * Value kept in the file tier isn't read here: value is empty and file refers the data, file.fd is -1
+     * for the rest. File data stays in place while file.pin is held, so caller reads it once storage lock
+     * is released
+     */
+    virtual void ForEach(const Visitor &f) const;
+
+    /**
+     * Moves values to the file tier: ones at least threshold bytes long are written there right away,
+     * others once they get to the LRU tail, instead of dropping the entry. Memory keeps key and location
+     * of such values, they count against max size by key only. Must be set before any Put
+     */
+    void SetTier(FileTier *tier, size_t threshold);
+
+    /**
+     * Returns true if key value is kept in the tier at the given location, see FileTier
+     */
+    virtual bool Refers(const std::string &key, const FileTier::Location &location) const;
+
+    /**
+     * Switches key to the new location in the tier if it still refers the old one, see FileTier
+     */
+    virtual bool Relocate(const std::string &key, const FileTier::Location &from, const FileTier::Location &to);
+
+    // Outcomes of Get calls
+    struct Hits {
+        size_t ram;
+        size_t file;
+        size_t miss;
+    };
+    virtual Hits GetHits() const;
 
     // For debag
     void print_list();
 
+protected:
+    // Unix time the live entry expires at, 0 if it never does. Returns false if there is no entry
+    bool Deadline( std::string_view key, int64_t &deadline ) const;
+
 private:
 
-    // LRU cache node
+    // LRU cache node, value is empty if it is kept in the file tier. Node expires once Unix time gets
+    // to deadline, 0 if it never expires
     using lru_node = struct lru_node {
         const std::string key;
         std::string value;
         std::unique_ptr<lru_node> next;
         lru_node* prev;
+        FileTier::Location location;
+        bool in_file;
+        int64_t deadline;
+    };
+
+    // Orders index by key, looks keys up by string_view with no temporary string
+    struct KeyLess {
+        using is_transparent = void;
+        bool operator()(const std::string &a, const std::string &b) const { return a < b; }
+        bool operator()(const std::string &a, std::string_view b) const { return a < b; }
+        bool operator()(std::string_view a, const std::string &b) const { return a < b; }
     };
 
+    using lru_index = std::map<std::reference_wrapper<const std::string>, std::reference_wrapper<lru_node>, KeyLess>;
+
+    // Looks node up, expired one is removed on the way. Returns end of index if there is no live node
+    lru_index::iterator Find( std::string_view key );
+
+    // Removes node from the index and the list
+    void Unlink( lru_index::iterator it );
+
+    // Whether entry could be stored at all
+    bool Fits( const std::string& key, const std::string& value ) const;
+
+    // Releases value wherever it is kept
+    void DropValue( lru_node* node );
+
+    // Moves the least recently used value still kept in memory to the file tier
+    bool Demote();
+
     // Put node to top of the list
     bool MoveToHead( lru_node* current_node );
 
-    // Change value in node
-    bool SetVal( lru_node* current_node, const std::string& value );
+    // Put, PutIfAbsent and Set for both copied and moved value: node is created if there is no one for
+    // the key and create is set, existing node is updated if update is set. Node gets value and deadline
+    // at once
+    template <typename Value>
+    bool Store( const std::string& key, Value&& value, bool create, bool update, int32_t expire );
+
+    // Change value in node, rvalue is moved there
+    template <typename Value> bool SetVal( lru_node* current_node, Value&& value );
 
     // Create new node on top of the list
-    bool CreateNode( const std::string& key, const std::string& value );
+    template <typename Value> bool CreateNode( const std::string& key, Value&& value, int64_t deadline );
 
     // Pop off last some nodes
     bool ClearSpace();
@@ -84,8 +189,19 @@ private:
     lru_node* _lru_tail;
     size_t _node_count;
 
+    // File tier, values are moved to
+    FileTier *_tier;
+    size_t _tier_threshold;
+
+    // Demotion candidate, nodes below it have nothing to move to the file tier
+    lru_node* _scan;
+
+    size_t _ram_hits;
+    size_t _file_hits;
+    size_t _misses;
+
     // Index of nodes from list above, allows fast random access to elements by lru_node#key
-    std::map<std::reference_wrapper<const std::string>, std::reference_wrapper<lru_node>, std::less<std::string>> _lru_index;
+    lru_index _lru_index;
 };
 
 } // namespace Backend
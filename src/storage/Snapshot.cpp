@@ -0,0 +1,210 @@
+#include "Snapshot.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace Afina {
+namespace Backend {
+
+namespace {
+
+const char kMagic[8] = {'A', 'F', 'S', 'N', 'A', 'P', '\r', '\n'};
+const uint32_t kVersion = 2;
+
+// The oldest version reader still supports
+const uint32_t kMinVersion = 1;
+
+const std::size_t kHeaderSize = sizeof(kMagic) + 2 * sizeof(uint32_t);
+const std::size_t kTrailerSize = 2 * sizeof(uint64_t) + sizeof(kMagic);
+
+// Directory record: offset, size, count
+const std::size_t kRecord = 3;
+
+} // namespace
+
+// See Snapshot.h
+SnapshotWriter::SnapshotWriter(const std::string &path)
+    : _path(path), _tmp_path(path + ".tmp"), _fd(-1), _offset(0), _entries(0) {
+    _fd = open(_tmp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    if (_fd == -1) {
+        throw std::runtime_error("Failed to create " + _tmp_path + ": " + std::string(strerror(errno)));
+    }
+
+    char header[kHeaderSize] = {};
+    std::memcpy(header, kMagic, sizeof(kMagic));
+    std::memcpy(header + sizeof(kMagic), &kVersion, sizeof(kVersion));
+    Write(header, sizeof(header));
+}
+
+// See Snapshot.h
+SnapshotWriter::~SnapshotWriter() {
+    // Not commited, so leave the previous snapshot in place
+    if (_fd != -1) {
+        close(_fd);
+        unlink(_tmp_path.c_str());
+    }
+}
+
+// See Snapshot.h
+void SnapshotWriter::Encode(std::string &section, const std::string &key, const std::string &value,
+                            int64_t deadline) {
+    std::size_t offset = Reserve(section, key, value.size(), deadline);
+    std::memcpy(&section[offset], value.data(), value.size());
+}
+
+// See Snapshot.h
+std::size_t SnapshotWriter::Reserve(std::string &section, const std::string &key, std::size_t value_size,
+                                    int64_t deadline) {
+    uint32_t sizes[2] = {static_cast<uint32_t>(key.size()), static_cast<uint32_t>(value_size)};
+    section.append(reinterpret_cast<const char *>(sizes), sizeof(sizes));
+    section.append(reinterpret_cast<const char *>(&deadline), sizeof(deadline));
+    section.append(key);
+    section.resize(section.size() + value_size);
+    return section.size() - value_size;
+}
+
+// See Snapshot.h
+void SnapshotWriter::Add(const std::string &section, std::size_t count) {
+    _directory.push_back(_offset);
+    _directory.push_back(section.size());
+    _directory.push_back(count);
+    _entries += count;
+    Write(section.data(), section.size());
+}
+
+// See Snapshot.h
+void SnapshotWriter::Commit() {
+    // Directory is aligned, so reader could access it right in the mapping
+    const char padding[sizeof(uint64_t)] = {};
+    Write(padding, (sizeof(uint64_t) - _offset % sizeof(uint64_t)) % sizeof(uint64_t));
+
+    uint64_t trailer[2] = {_offset, _directory.size() / kRecord};
+    Write(_directory.data(), _directory.size() * sizeof(uint64_t));
+    Write(trailer, sizeof(trailer));
+    Write(kMagic, sizeof(kMagic));
+
+    if (fdatasync(_fd) != 0) {
+        throw std::runtime_error("Failed to sync " + _tmp_path + ": " + std::string(strerror(errno)));
+    }
+    if (rename(_tmp_path.c_str(), _path.c_str()) != 0) {
+        throw std::runtime_error("Failed to rename " + _tmp_path + ": " + std::string(strerror(errno)));
+    }
+    close(_fd);
+    _fd = -1;
+
+    // Make rename itself durable
+    std::string dir = ".";
+    std::size_t slash = _path.rfind('/');
+    if (slash != std::string::npos) {
+        dir = slash == 0 ? "/" : _path.substr(0, slash);
+    }
+    int dir_fd = open(dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dir_fd != -1) {
+        fsync(dir_fd);
+        close(dir_fd);
+    }
+}
+
+// See Snapshot.h
+void SnapshotWriter::Write(const void *data, std::size_t size) {
+    const char *pos = static_cast<const char *>(data);
+    while (size > 0) {
+        ssize_t n = write(_fd, pos, size);
+        if (n == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw std::runtime_error("Failed to write " + _tmp_path + ": " + std::string(strerror(errno)));
+        }
+        pos += n;
+        size -= n;
+        _offset += n;
+    }
+}
+
+// See Snapshot.h
+SnapshotReader::SnapshotReader(const std::string &path)
+    : _path(path), _base(nullptr), _size(0), _sections(0), _directory(0), _deadline_size(0) {
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd == -1) {
+        throw std::runtime_error("Failed to open " + path + ": " + std::string(strerror(errno)));
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        throw std::runtime_error("Failed to stat " + path + ": " + std::string(strerror(errno)));
+    }
+    _size = st.st_size;
+    if (_size < kHeaderSize + kTrailerSize) {
+        close(fd);
+        throw std::runtime_error("Snapshot " + path + " is truncated");
+    }
+
+    void *base = mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) {
+        throw std::runtime_error("Failed to map " + path + ": " + std::string(strerror(errno)));
+    }
+    _base = static_cast<char *>(base);
+
+    // Start read ahead of the whole file, loaders will fault pages in their sections in parallel
+    madvise(_base, _size, MADV_WILLNEED);
+
+    uint32_t version;
+    uint64_t trailer[2];
+    std::memcpy(&version, _base + sizeof(kMagic), sizeof(version));
+    std::memcpy(trailer, _base + _size - kTrailerSize, sizeof(trailer));
+    if (std::memcmp(_base, kMagic, sizeof(kMagic)) != 0 ||
+        std::memcmp(_base + _size - sizeof(kMagic), kMagic, sizeof(kMagic)) != 0) {
+        munmap(_base, _size);
+        throw std::runtime_error("Snapshot " + path + " is truncated or isn't a snapshot");
+    }
+    if (version < kMinVersion || version > kVersion) {
+        munmap(_base, _size);
+        throw std::runtime_error("Snapshot " + path + " has unsupported version " + std::to_string(version));
+    }
+    _deadline_size = version >= 2 ? sizeof(int64_t) : 0;
+
+    // Directory must fit between sections and trailer exactly, each section must lay before directory
+    _directory = trailer[0];
+    _sections = trailer[1];
+    if (_directory < kHeaderSize || _directory > _size - kTrailerSize || _directory % sizeof(uint64_t) != 0 ||
+        (_size - kTrailerSize - _directory) / sizeof(uint64_t) / kRecord != _sections ||
+        (_size - kTrailerSize - _directory) % (sizeof(uint64_t) * kRecord) != 0) {
+        munmap(_base, _size);
+        throw std::runtime_error("Snapshot " + path + " has malformed directory");
+    }
+    for (std::size_t i = 0; i < _sections; i++) {
+        const uint64_t *record = Directory(i);
+        if (record[0] < kHeaderSize || record[0] > _directory || record[1] > _directory - record[0]) {
+            munmap(_base, _size);
+            throw std::runtime_error("Snapshot " + path + " has malformed directory");
+        }
+    }
+}
+
+// See Snapshot.h
+SnapshotReader::~SnapshotReader() { munmap(_base, _size); }
+
+// See Snapshot.h
+std::size_t SnapshotReader::Count(std::size_t section) const { return Directory(section)[2]; }
+
+// See Snapshot.h
+const uint64_t *SnapshotReader::Directory(std::size_t section) const {
+    return reinterpret_cast<const uint64_t *>(_base + _directory) + section * kRecord;
+}
+
+// See Snapshot.h
+void SnapshotReader::Malformed(std::size_t section) const {
+    throw std::runtime_error("Snapshot " + _path + " has malformed section " + std::to_string(section));
+}
+
+} // namespace Backend
+} // namespace Afina
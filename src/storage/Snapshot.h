@@ -0,0 +1,143 @@
+#ifndef AFINA_STORAGE_SNAPSHOT_H
+#define AFINA_STORAGE_SNAPSHOT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # Snapshot file
+ * Storage content is written as a sequence of independent sections, usually one per storage shard, so
+ * that sections could be produced one by one and loaded back in parallel. File layout, all numbers are
+ * in host byte order:
+ *
+ *   header:    magic(8) version(4) reserved(4)
+ *   sections:  [key_size(4) value_size(4) deadline(8) key value]...
+ *   padding:   up to 8 bytes alignment
+ *   directory: [offset(8) size(8) count(8)] per section
+ *   trailer:   directory offset(8) sections(8) magic(8)
+ *
+ * Deadline is Unix time entry expires at, 0 if it never does. Version 1 files have no deadline, their
+ * entries never expire.
+ *
+ * Entries of each section go from the least to the most recently used one, so loading them in order
+ * restores LRU order as well.
+ *
+ * Snapshot is written into the temporary file next to the target one, which replaces target only once
+ * all data is on the disk. So the target file is always either the previous snapshot or the new one.
+ */
+class SnapshotWriter {
+public:
+    /**
+     * Creates temporary file, throws std::runtime_error on failure
+     */
+    SnapshotWriter(const std::string &path);
+    ~SnapshotWriter();
+
+    /**
+     * Appends entry into the section buffer, deadline is 0 if entry never expires
+     */
+    static void Encode(std::string &section, const std::string &key, const std::string &value, int64_t deadline);
+
+    /**
+     * Appends entry with value_size bytes of value to be filled in later, returns offset of the value in
+     * the section
+     */
+    static std::size_t Reserve(std::string &section, const std::string &key, std::size_t value_size,
+                               int64_t deadline);
+
+    /**
+     * Writes section made of count entries built by Encode
+     */
+    void Add(const std::string &section, std::size_t count);
+
+    /**
+     * Writes directory, syncs file and replaces the target one
+     */
+    void Commit();
+
+    // Total number of entries and bytes written
+    std::size_t Entries() const { return _entries; }
+    std::size_t Bytes() const { return _offset; }
+
+private:
+    SnapshotWriter(const SnapshotWriter &) = delete;
+    SnapshotWriter &operator=(const SnapshotWriter &) = delete;
+
+    void Write(const void *data, std::size_t size);
+
+    std::string _path;
+    std::string _tmp_path;
+    int _fd;
+
+    std::vector<uint64_t> _directory;
+    std::size_t _offset;
+    std::size_t _entries;
+};
+
+/**
+ * Maps snapshot file into memory, see SnapshotWriter for the format
+ */
+class SnapshotReader {
+public:
+    /**
+     * Maps and validates file, throws std::runtime_error if file can't be read or is malformed
+     */
+    SnapshotReader(const std::string &path);
+    ~SnapshotReader();
+
+    std::size_t Sections() const { return _sections; }
+
+    // Number of entries in the given section
+    std::size_t Count(std::size_t section) const;
+
+    /**
+     * Calls f(key, key_size, value, value_size, deadline) for every entry of the section, pointers
+     * refer mapped file. Throws std::runtime_error if section is malformed
+     */
+    template <typename F> void ForEach(std::size_t section, F f) const {
+        const char *pos = _base + Directory(section)[0];
+        const char *end = pos + Directory(section)[1];
+        for (std::size_t i = 0, count = Directory(section)[2]; i < count; i++) {
+            uint32_t sizes[2];
+            int64_t deadline = 0;
+            if (end - pos < static_cast<std::ptrdiff_t>(sizeof(sizes) + _deadline_size)) {
+                Malformed(section);
+            }
+            std::memcpy(sizes, pos, sizeof(sizes));
+            std::memcpy(&deadline, pos + sizeof(sizes), _deadline_size);
+            pos += sizeof(sizes) + _deadline_size;
+            if (static_cast<std::size_t>(end - pos) < std::size_t(sizes[0]) + sizes[1]) {
+                Malformed(section);
+            }
+            f(pos, sizes[0], pos + sizes[0], sizes[1], deadline);
+            pos += sizes[0] + sizes[1];
+        }
+    }
+
+private:
+    SnapshotReader(const SnapshotReader &) = delete;
+    SnapshotReader &operator=(const SnapshotReader &) = delete;
+
+    const uint64_t *Directory(std::size_t section) const;
+    [[noreturn]] void Malformed(std::size_t section) const;
+
+    std::string _path;
+    char *_base;
+    std::size_t _size;
+    std::size_t _sections;
+    std::size_t _directory;
+
+    // Entries of version 1 files have no deadline
+    std::size_t _deadline_size;
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_SNAPSHOT_H
@@ -1,36 +1,82 @@
 #include "StripedLRU.h"
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+#include <exception>
 #include <iostream>
 
+#include <afina/logging/Service.h>
+#include <spdlog/logger.h>
+
+#include "Snapshot.h"
+
 namespace Afina {
 namespace Backend {
 
+namespace {
+
+// Expiration time of the restored entry, see Storage::Touch. Deadline is Unix time, so it is passed as is
+// unless it has already come
+int32_t expiration(int64_t deadline) {
+    if (deadline == 0) {
+        return 0;
+    }
+    return deadline <= time(nullptr) ? -1 : static_cast<int32_t>(deadline);
+}
+
+} // namespace
+
+// See StripedLRU.h
+std::size_t StripedLRU::MaxValueSize() const {
+    // Shards are all of the same size
+    return shard.front()->MaxValueSize();
+}
 
 // See MapBasedGlobalLockImpl.h
-bool StripedLRU::Put( const std::string &key, const std::string &value ){ 
+bool StripedLRU::Put( const std::string &key, const std::string &value, int32_t expire ){ 
 
 	size_t shard_num = hash_func(key) % _stripe_count;		
-	return shard[shard_num]->Put( key, value );		
+	return shard[shard_num]->Put( key, value, expire );		
+}
+
+
+// See StripedLRU.h
+bool StripedLRU::Put(const std::string &key, std::string &&value, int32_t expire) {
+    return shard[hash_func(key) % _stripe_count]->Put(key, std::move(value), expire);
 }
 
 
 // See MapBasedGlobalLockImpl.h
-bool StripedLRU::PutIfAbsent( const std::string &key, const std::string &value ){
+bool StripedLRU::PutIfAbsent( const std::string &key, const std::string &value, int32_t expire ){
 
 	size_t shard_num = hash_func(key) % _stripe_count;
-	return shard[shard_num]->PutIfAbsent( key, value );       
+	return shard[shard_num]->PutIfAbsent( key, value, expire );       
+}
+
+
+// See StripedLRU.h
+bool StripedLRU::PutIfAbsent(const std::string &key, std::string &&value, int32_t expire) {
+    return shard[hash_func(key) % _stripe_count]->PutIfAbsent(key, std::move(value), expire);
 }
 
 
 // See MapBasedGlobalLockImpl.h
-bool StripedLRU::Set( const std::string &key, const std::string &value ){
+bool StripedLRU::Set( const std::string &key, const std::string &value, int32_t expire ){
 
 	size_t shard_num = hash_func(key) % _stripe_count;
-	return shard[shard_num]->Set( key, value );       
+	return shard[shard_num]->Set( key, value, expire );       
+}
+
+
+// See StripedLRU.h
+bool StripedLRU::Set(const std::string &key, std::string &&value, int32_t expire) {
+    return shard[hash_func(key) % _stripe_count]->Set(key, std::move(value), expire);
 }
 
 
 // See MapBasedGlobalLockImpl.h
-bool StripedLRU::Delete( const std::string &key ){
+bool StripedLRU::Delete( std::string_view key ){
 
 	size_t shard_num = hash_func(key) % _stripe_count;
 	return shard[shard_num]->Delete( key );	
@@ -38,12 +84,324 @@ bool StripedLRU::Delete( const std::string &key ){
 
 
 // See MapBasedGlobalLockImpl.h
-bool StripedLRU::Get( const std::string &key, std::string &value ){
+bool StripedLRU::Get( std::string_view key, std::string &value ){
 
 	size_t shard_num = hash_func(key) % _stripe_count;
 	return shard[shard_num]->Get( key, value );
 }
 
 
+// See StripedLRU.h
+bool StripedLRU::Update(std::string_view key, const std::function<bool(std::string &)> &update) {
+    return shard[hash_func(key) % _stripe_count]->Update(key, update);
+}
+
+// See StripedLRU.h
+bool StripedLRU::Touch(std::string_view key, int32_t expire) {
+    size_t shard_num = hash_func(key) % _stripe_count;
+    return shard[shard_num]->Touch(key, expire);
+}
+
+// See StripedLRU.h
+bool StripedLRU::GetFile(std::string_view key, std::string &value, FileValue &file) {
+    return shard[hash_func(key) % _stripe_count]->GetFile(key, value, file);
+}
+
+
+// See StripedLRU.h
+void StripedLRU::ConfigureSnapshot(const std::string &path, std::chrono::seconds period,
+                                   std::shared_ptr<Logging::Service> logging) {
+    _snapshot_path = path;
+    _snapshot_period = period;
+    _logging = logging;
+}
+
+// See StripedLRU.h
+void StripedLRU::ConfigureLog(const std::string &path, std::chrono::milliseconds sync_interval,
+                              std::shared_ptr<Logging::Service> logging) {
+    _log_path = path;
+    _log_sync = sync_interval;
+    _logging = logging;
+}
+
+// See StripedLRU.h
+void StripedLRU::ConfigureTier(const std::string &path, size_t size, size_t threshold,
+                               std::shared_ptr<Logging::Service> logging) {
+    _tier_path = path;
+    _tier_size = size;
+    _tier_threshold = threshold;
+    _logging = logging;
+}
+
+// See StripedLRU.h
+void StripedLRU::Start() {
+    if (_snapshot_path.empty() && _log_path.empty() && _tier_path.empty()) {
+        return;
+    }
+    _logger = _logging->select("storage");
+
+    // Tier goes first, so loaded values could already be moved there
+    if (!_tier_path.empty()) {
+        _tier.reset(new FileTier(_tier_path, _tier_size, _logger));
+        for (auto &s : shard) {
+            s->SetTier(_tier.get(), _tier_threshold);
+        }
+        _tier->Start(
+            [this](const std::string &key, const FileTier::Location &location) {
+                return shard[hash_func(key) % _stripe_count]->Refers(key, location);
+            },
+            [this](const std::string &key, const FileTier::Location &from, const FileTier::Location &to) {
+                return shard[hash_func(key) % _stripe_count]->Relocate(key, from, to);
+            });
+    }
+
+    if (!_snapshot_path.empty()) {
+        LoadSnapshot();
+    }
+
+    // Unlike snapshot, log is asked for explicitly: failure to replay or write it must stop the server
+    if (!_log_path.empty()) {
+        if (_snapshot_path.empty()) {
+            _logger->warn("Mutation log {} is never compacted without snapshots", _log_path);
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        _log.reset(new MutationLog(_log_path, _log_sync, _logger));
+        size_t replayed = _log->Replay(
+            [this](const std::string &key, const std::string &value, int64_t deadline) {
+                Put(key, value, expiration(deadline));
+            },
+            [this](const std::string &key) { Delete(key); },
+            [this](const std::string &key, int64_t deadline) { Touch(key, expiration(deadline)); });
+        auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+        _logger->warn("Replayed {} records of mutation log {} in {} ms", replayed, _log_path, elapsed.count());
+
+        _log->Start();
+        for (auto &s : shard) {
+            s->SetLog(_log.get());
+        }
+    }
+
+    if (!_snapshot_path.empty()) {
+        _stopping = false;
+        _snapshot_thread = std::thread(&StripedLRU::OnRun, this);
+    }
+}
+
+// See StripedLRU.h
+void StripedLRU::LoadSnapshot() {
+    // No file is normal for the very first start, broken one means cold cache but not the failure to serve
+    if (access(_snapshot_path.c_str(), F_OK) == 0) {
+        auto start = std::chrono::steady_clock::now();
+        try {
+            size_t loaded = Load(_snapshot_path);
+            auto elapsed =
+                std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+            _logger->warn("Loaded {} entries from snapshot {} in {} ms", loaded, _snapshot_path, elapsed.count());
+        } catch (std::exception &ex) {
+            _logger->error("Failed to load snapshot: {}", ex.what());
+        }
+    } else {
+        _logger->warn("No snapshot {} found, start empty", _snapshot_path);
+    }
+}
+
+// See StripedLRU.h
+void StripedLRU::Stop() {
+    if (_snapshot_thread.joinable()) {
+        {
+            std::unique_lock<std::mutex> lock(_snapshot_mutex);
+            _stopping = true;
+        }
+        _snapshot_cv.notify_one();
+        _snapshot_thread.join();
+    }
+
+    if (_log) {
+        for (auto &s : shard) {
+            s->SetLog(nullptr);
+        }
+        _log->Stop();
+        _log.reset();
+    }
+
+    // Shards keep referring the tier, so it lives as long as the storage does
+    if (_tier) {
+        _tier->Stop();
+    }
+}
+
+// See StripedLRU.h
+void StripedLRU::Snapshot() {
+    if (_snapshot_path.empty()) {
+        throw std::runtime_error("Snapshot path isn't configured");
+    }
+
+    {
+        std::unique_lock<std::mutex> lock(_snapshot_mutex);
+        _snapshot_requested = true;
+    }
+    _snapshot_cv.notify_one();
+}
+
+// See StripedLRU.h
+void StripedLRU::Stats(std::vector<std::pair<std::string, std::string>> &stats) {
+    SimpleLRU::Hits total{0, 0, 0};
+    for (auto &s : shard) {
+        SimpleLRU::Hits hits = s->GetHits();
+        total.ram += hits.ram;
+        total.file += hits.file;
+        total.miss += hits.miss;
+    }
+    stats.emplace_back("ram_hits", std::to_string(total.ram));
+    stats.emplace_back("file_hits", std::to_string(total.file));
+    stats.emplace_back("get_misses", std::to_string(total.miss));
+
+    if (_tier) {
+        stats.emplace_back("tier_bytes", std::to_string(_tier->LiveBytes()));
+        stats.emplace_back("tier_capacity", std::to_string(_tier->Capacity()));
+        stats.emplace_back("tier_compactions", std::to_string(_tier->Compactions()));
+    }
+}
+
+// See StripedLRU.h
+size_t StripedLRU::Save(const std::string &path) {
+    SnapshotWriter writer(path);
+
+    // Value in the file tier whose place in the section is filled in once the shard is unlocked
+    struct Pending {
+        size_t entry;
+        size_t value;
+        FileValue file;
+    };
+
+    // Shard is locked only while its entries are copied, so writers to that shard are delayed by
+    // memcpy of one shard at most. Values kept in the file tier are pinned rather than read under
+    // the lock, pinned data stays as it was even if value is changed or moved meanwhile
+    std::string section;
+    std::vector<Pending> pending;
+    for (auto &s : shard) {
+        size_t count = 0;
+        section.clear();
+        pending.clear();
+        s->ForEach([&section, &count, &pending](const std::string &key, const std::string &value, int64_t deadline,
+                                                const FileValue &file) {
+            if (file.fd == -1) {
+                SnapshotWriter::Encode(section, key, value, deadline);
+            } else {
+                size_t entry = section.size();
+                pending.push_back(Pending{entry, SnapshotWriter::Reserve(section, key, file.size, deadline), file});
+            }
+            count++;
+        });
+
+        // Entry which value can't be read is cut out, the ones after it shift
+        size_t removed = 0;
+        for (Pending &p : pending) {
+            if (FileTier::ReadAt(p.file.fd, &section[p.value - removed], p.file.size, p.file.offset)) {
+                continue;
+            }
+            _logger->error("Failed to read tier value for snapshot, entry is skipped: {}", strerror(errno));
+            size_t end = p.value + p.file.size;
+            section.erase(p.entry - removed, end - p.entry);
+            removed += end - p.entry;
+            count--;
+        }
+        pending.clear();
+        writer.Add(section, count);
+    }
+
+    writer.Commit();
+    return writer.Entries();
+}
+
+// See StripedLRU.h
+size_t StripedLRU::Load(const std::string &path) {
+    SnapshotReader reader(path);
+
+    // Sections are taken by threads one by one. Snapshot of the storage with the same number of stripes
+    // has one section per shard, so threads don't compete for shard locks
+    std::atomic<size_t> next(0);
+    std::atomic<size_t> loaded(0);
+    std::mutex error_mutex;
+    std::exception_ptr error;
+    auto loader = [&]() {
+        try {
+            for (size_t i = next++; i < reader.Sections(); i = next++) {
+                reader.ForEach(i, [this](const char *key, size_t key_size, const char *value, size_t value_size,
+                                         int64_t deadline) {
+                    Put(std::string(key, key_size), std::string(value, value_size), expiration(deadline));
+                });
+                loaded += reader.Count(i);
+            }
+        } catch (...) {
+            std::unique_lock<std::mutex> lock(error_mutex);
+            error = std::current_exception();
+        }
+    };
+
+    size_t n_threads = std::max<size_t>(1, std::min<size_t>(std::thread::hardware_concurrency(), reader.Sections()));
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < n_threads; i++) {
+        threads.emplace_back(loader);
+    }
+    loader();
+    for (auto &t : threads) {
+        t.join();
+    }
+
+    if (error) {
+        std::rethrow_exception(error);
+    }
+    return loaded;
+}
+
+// See StripedLRU.h
+void StripedLRU::OnRun() {
+    std::unique_lock<std::mutex> lock(_snapshot_mutex);
+    auto next = std::chrono::steady_clock::now() + _snapshot_period;
+    for (;;) {
+        while (!_stopping && !_snapshot_requested &&
+               (_snapshot_period.count() == 0 || std::chrono::steady_clock::now() < next)) {
+            if (_snapshot_period.count() == 0) {
+                _snapshot_cv.wait(lock);
+            } else {
+                _snapshot_cv.wait_until(lock, next);
+            }
+        }
+        if (_stopping) {
+            break;
+        }
+
+        _snapshot_requested = false;
+        lock.unlock();
+        SaveSnapshot();
+        lock.lock();
+        next = std::chrono::steady_clock::now() + _snapshot_period;
+    }
+
+    // Network is already stopped, so the final snapshot has everything
+    lock.unlock();
+    SaveSnapshot();
+}
+
+// See StripedLRU.h
+void StripedLRU::SaveSnapshot() {
+    auto start = std::chrono::steady_clock::now();
+    try {
+        // Every change written to older segments is already applied, so snapshot taken after rotation
+        // covers them
+        uint64_t segment = _log ? _log->Rotate() : 0;
+        size_t saved = Save(_snapshot_path);
+        if (_log) {
+            _log->Drop(segment);
+        }
+        auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+        _logger->warn("Saved {} entries to snapshot {} in {} ms", saved, _snapshot_path, elapsed.count());
+    } catch (std::exception &ex) {
+        _logger->error("Failed to save snapshot: {}", ex.what());
+    }
+}
+
 } // namespace Backend
 } // namespace Afina
@@ -4,24 +4,57 @@
 #include <map>
 #include <vector>
 #include <string>
+#include <string_view>
+#include "FileTier.h"
+#include "MutationLog.h"
 #include "ThreadSafeSimpleLRU.h"
 
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
 #include <functional>
 #include <mutex>
+#include <thread>
 #include <unistd.h>
 #include <afina/Storage.h>
 
+namespace spdlog {
+class logger;
+}
+
+namespace Afina {
+namespace Logging {
+class Service;
+}
+}
+
 namespace Afina {
 namespace Backend {
 
 /**
  * # SimpleLRU thread striped lock version
  *
+ * Storage could be saved to the snapshot file and loaded back on start, see ConfigureSnapshot. Snapshot
+ * is taken one shard at a time: shard is locked only while its entries are copied to the memory, file is
+ * written with no locks held. So writers wait for one shard copy at most, while the whole snapshot isn't
+ * point-in-time across shards: each shard is saved as it was at its own moment.
+ *
+ * Changes made after the last snapshot are kept by the mutation log, see ConfigureLog. Each snapshot
+ * starts new log segment and drops ones it covers. Changes that got to both snapshot and the log are
+ * just applied twice on start, that gives the same result.
  *
+ * Values could be kept in the file tier rather than in memory, see ConfigureTier. Each shard moves large
+ * values there right away and cold ones instead of evicting them, so memory limit bounds keys and hot values
+ * while the tier holds the rest.
  */
 class StripedLRU : public Afina::Storage {
 public:
-    StripedLRU( size_t max_size = 1024, size_t st_cnt = 4 * 2 * 1024 * 1024 * sizeof(char) ) : max_size(max_size), _stripe_count(st_cnt) {
+    // Shard size BuildLRU aims at when number of stripes isn't given
+    static const size_t kShardSize = 4 * 1024 * 1024;
+
+    StripedLRU( size_t max_size = 64 * 1024 * 1024, size_t st_cnt = 16 ) : max_size(max_size), _stripe_count(st_cnt),
+        _snapshot_period(0), _log_sync(0), _tier_size(0), _tier_threshold(0), _snapshot_requested(false),
+        _stopping(false) {
     
 	size_t shard_size = max_size / _stripe_count;
 
@@ -31,12 +64,15 @@ public:
 	}
     }
 
-    static std::shared_ptr<StripedLRU> BuildLRU( size_t max_size = 1024, size_t st_cnt = 4 * 2 * 1024 * 1024 * sizeof(char) ){
+    // Builds storage of max_size bytes split in st_cnt stripes, one stripe per kShardSize if st_cnt is 0
+    static std::shared_ptr<StripedLRU> BuildLRU( size_t max_size = 64 * 1024 * 1024, size_t st_cnt = 0 ){
 
+	if( st_cnt == 0 )
+		st_cnt = std::max<size_t>( 1, max_size / kShardSize );
 	size_t shard_size = max_size / st_cnt;
     	
 	// Max 1MB for one key, 1MB for value
-	if( shard_size > 2 * 1024 * 1024 * sizeof(char) ){
+	if( shard_size < 2 * 1024 * 1024 * sizeof(char) ){
 
 		throw std::runtime_error( "Too small shard size: " + std::to_string(shard_size) );
 	}
@@ -45,25 +81,100 @@ public:
 
     }
 
-    ~StripedLRU() {}
+    ~StripedLRU() { Stop(); }
+
+    /**
+     * Enables snapshots: Start loads the file if it exists, then snapshot is written every period (never
+     * if period is zero), on Snapshot call and on Stop
+     */
+    void ConfigureSnapshot(const std::string &path, std::chrono::seconds period,
+                           std::shared_ptr<Logging::Service> logging);
+
+    /**
+     * Enables mutation log: Start replays it after snapshot and then appends every change there, see
+     * MutationLog for sync_interval
+     */
+    void ConfigureLog(const std::string &path, std::chrono::milliseconds sync_interval,
+                      std::shared_ptr<Logging::Service> logging);
+
+    /**
+     * Enables file tier of size bytes at path prefix, values at least threshold bytes long are written
+     * there right away, see SimpleLRU::SetTier. Tier content is dropped on restart, snapshot keeps it
+     */
+    void ConfigureTier(const std::string &path, size_t size, size_t threshold,
+                       std::shared_ptr<Logging::Service> logging);
+
+    // Creates file tier, loads snapshot, replays mutation log and starts periodic snapshots if configured
+    void Start() override;
+
+    // Writes final snapshot and syncs mutation log if configured
+    void Stop() override;
+
+    // Wakes up snapshot thread, see Storage.h
+    void Snapshot() override;
+
+    // Hits by tier and tier usage, see Storage.h
+    void Stats(std::vector<std::pair<std::string, std::string>> &stats) override;
+
+    /**
+     * Writes snapshot to the given path, returns number of entries saved. Throws std::runtime_error on
+     * failure, previous snapshot file is kept intact in this case
+     */
+    size_t Save(const std::string &path);
+
+    /**
+     * Puts every entry of the snapshot to the storage using all cores, returns number of entries loaded.
+     * Throws std::runtime_error if file can't be read or is malformed
+     */
+    size_t Load(const std::string &path);
+
+    // Implements Afina::Storage interface, value must fit into a single shard
+    std::size_t MaxValueSize() const override;
 
     // see SimpleLRU.h
-    bool Put(const std::string &key, const std::string &value) override;
+    bool Put(const std::string &key, const std::string &value, int32_t expire = 0) override;
 
     // see SimpleLRU.h
-    bool PutIfAbsent(const std::string &key, const std::string &value) override;
+    bool Put(const std::string &key, std::string &&value, int32_t expire = 0) override;
 
     // see SimpleLRU.h
-    bool Set(const std::string &key, const std::string &value) override;
+    bool PutIfAbsent(const std::string &key, const std::string &value, int32_t expire = 0) override;
 
     // see SimpleLRU.h
-    bool Delete(const std::string &key) override;
+    bool PutIfAbsent(const std::string &key, std::string &&value, int32_t expire = 0) override;
 
     // see SimpleLRU.h
-    bool Get(const std::string &key, std::string &value) override;
+    bool Set(const std::string &key, const std::string &value, int32_t expire = 0) override;
+
+    // see SimpleLRU.h
+    bool Set(const std::string &key, std::string &&value, int32_t expire = 0) override;
+
+    // see SimpleLRU.h
+    bool Delete(std::string_view key) override;
+
+    // see SimpleLRU.h
+    bool Update(std::string_view key, const std::function<bool(std::string &)> &update) override;
+
+    // see SimpleLRU.h
+    bool Get(std::string_view key, std::string &value) override;
+
+    // see SimpleLRU.h
+    bool GetFile(std::string_view key, std::string &value, FileValue &file) override;
+
+    // see SimpleLRU.h
+    bool Touch(std::string_view key, int32_t expire) override;
 
 private:
 
+    // Snapshot thread
+    void OnRun();
+
+    // Load from the configured path and report result
+    void LoadSnapshot();
+
+    // Save to the configured path, compact mutation log and report result
+    void SaveSnapshot();
+
     // Max size for StripedLRU
     size_t max_size;
     
@@ -74,7 +185,31 @@ private:
     std::vector<std::unique_ptr<ThreadSafeSimplLRU>> shard;
 
     // Hash functor
-    std::hash<std::string> hash_func;
+    std::hash<std::string_view> hash_func;
+
+    // Snapshot config
+    std::string _snapshot_path;
+    std::chrono::seconds _snapshot_period;
+    std::shared_ptr<Logging::Service> _logging;
+    std::shared_ptr<spdlog::logger> _logger;
+
+    // Mutation log config, log itself exists once storage is started
+    std::string _log_path;
+    std::chrono::milliseconds _log_sync;
+    std::unique_ptr<MutationLog> _log;
+
+    // File tier config, tier itself exists once storage is started
+    std::string _tier_path;
+    size_t _tier_size;
+    size_t _tier_threshold;
+    std::unique_ptr<FileTier> _tier;
+
+    // Snapshot thread state, guarded by _snapshot_mutex
+    std::mutex _snapshot_mutex;
+    std::condition_variable _snapshot_cv;
+    bool _snapshot_requested;
+    bool _stopping;
+    std::thread _snapshot_thread;
 };
 
 } // namespace Backend
@@ -5,6 +5,7 @@
 #include <mutex>
 #include <string>
 
+#include "MutationLog.h"
 #include "SimpleLRU.h"
 
 namespace Afina {
@@ -17,52 +18,182 @@ namespace Backend {
  */
 class ThreadSafeSimplLRU : public SimpleLRU {
 public:
-    ThreadSafeSimplLRU(size_t max_size = 1024) : SimpleLRU(max_size) {}
+    ThreadSafeSimplLRU(size_t max_size = 1024) : SimpleLRU(max_size), _log(nullptr) {}
     ~ThreadSafeSimplLRU() {}
 
     // see SimpleLRU.h
-    bool Put(const std::string &key, const std::string &value) override {
+    bool Put(const std::string &key, const std::string &value, int32_t expire = 0) override {
         
 	// TODO: sinchronization
 	std::unique_lock<std::mutex> lock( lru_mutex );
-        return SimpleLRU::Put(key, value);
+        bool result = SimpleLRU::Put(key, value, expire);
+        return _log ? Logged(key, value, result) : result;
     }
 
     // see SimpleLRU.h
-    bool PutIfAbsent(const std::string &key, const std::string &value) override {
+    bool Put(const std::string &key, std::string &&value, int32_t expire = 0) override {
+        std::unique_lock<std::mutex> lock(lru_mutex);
+        if (_log) {
+            return Logged(key, value, SimpleLRU::Put(key, value, expire));
+        }
+        return SimpleLRU::Put(key, std::move(value), expire);
+    }
+
+    // see SimpleLRU.h
+    bool PutIfAbsent(const std::string &key, const std::string &value, int32_t expire = 0) override {
         
 	// TODO: sinchronization
 	std::unique_lock<std::mutex> lock( lru_mutex );
-        return SimpleLRU::PutIfAbsent(key, value);
+        bool result = SimpleLRU::PutIfAbsent(key, value, expire);
+        return _log ? Logged(key, value, result) : result;
+    }
+
+    // see SimpleLRU.h
+    bool PutIfAbsent(const std::string &key, std::string &&value, int32_t expire = 0) override {
+        std::unique_lock<std::mutex> lock(lru_mutex);
+        if (_log) {
+            return Logged(key, value, SimpleLRU::PutIfAbsent(key, value, expire));
+        }
+        return SimpleLRU::PutIfAbsent(key, std::move(value), expire);
     }
 
     // see SimpleLRU.h
-    bool Set(const std::string &key, const std::string &value) override {
+    bool Set(const std::string &key, const std::string &value, int32_t expire = 0) override {
         
 	// TODO: sinchronization
 	std::unique_lock<std::mutex> lock( lru_mutex );
-        return SimpleLRU::Set(key, value);
+        bool result = SimpleLRU::Set(key, value, expire);
+        return _log ? Logged(key, value, result) : result;
     }
 
     // see SimpleLRU.h
-    bool Delete(const std::string &key) override {
+    bool Set(const std::string &key, std::string &&value, int32_t expire = 0) override {
+        std::unique_lock<std::mutex> lock(lru_mutex);
+        if (_log) {
+            return Logged(key, value, SimpleLRU::Set(key, value, expire));
+        }
+        return SimpleLRU::Set(key, std::move(value), expire);
+    }
+
+    // see SimpleLRU.h
+    bool Delete(std::string_view key) override {
         
 	// TODO: sinchronization
 	std::unique_lock<std::mutex> lock( lru_mutex );
-        return SimpleLRU::Delete(key);
+        bool result = SimpleLRU::Delete(key);
+        if (result && _log) {
+            _log->Delete(key);
+        }
+        return result;
+    }
+
+    // see SimpleLRU.h
+    bool Update(std::string_view key, const std::function<bool(std::string &)> &update) override {
+        std::unique_lock<std::mutex> lock(lru_mutex);
+        if (!_log) {
+            return SimpleLRU::Update(key, update);
+        }
+
+        // Updated value is moved to the node, so the logged one is copied on the way
+        std::string updated;
+        bool result = SimpleLRU::Update(key, [&update, &updated](std::string &value) {
+            if (!update(value)) {
+                return false;
+            }
+            updated = value;
+            return true;
+        });
+        return Logged(std::string(key), updated, result);
     }
 
     // see SimpleLRU.h
-    bool Get(const std::string &key, std::string &value) override {
+    bool Get(std::string_view key, std::string &value) override {
         
 	// TODO: sinchronization
 	std::unique_lock<std::mutex> lock( lru_mutex );
         return SimpleLRU::Get(key, value);
     }
 
+    // see SimpleLRU.h
+    bool GetFile(std::string_view key, std::string &value, FileValue &file) override {
+        std::unique_lock<std::mutex> lock(lru_mutex);
+        return SimpleLRU::GetFile(key, value, file);
+    }
+
+    // see SimpleLRU.h
+    bool Touch(std::string_view key, int32_t expire) override {
+        std::unique_lock<std::mutex> lock(lru_mutex);
+        int64_t deadline;
+        bool result = SimpleLRU::Touch(key, expire);
+        if (!result || !_log) {
+            return result;
+        } else if (Deadline(key, deadline)) {
+            _log->Touch(key, deadline);
+        } else {
+            _log->Delete(key);
+        }
+        return true;
+    }
+
+    // see SimpleLRU.h
+    void ForEach(const Visitor &f) const override {
+        std::unique_lock<std::mutex> lock(lru_mutex);
+        SimpleLRU::ForEach(f);
+    }
+
+    // see SimpleLRU.h
+    void SetTier(FileTier *tier, size_t threshold) {
+        std::unique_lock<std::mutex> lock(lru_mutex);
+        SimpleLRU::SetTier(tier, threshold);
+    }
+
+    // see SimpleLRU.h
+    bool Refers(const std::string &key, const FileTier::Location &location) const override {
+        std::unique_lock<std::mutex> lock(lru_mutex);
+        return SimpleLRU::Refers(key, location);
+    }
+
+    // see SimpleLRU.h
+    bool Relocate(const std::string &key, const FileTier::Location &from, const FileTier::Location &to) override {
+        std::unique_lock<std::mutex> lock(lru_mutex);
+        return SimpleLRU::Relocate(key, from, to);
+    }
+
+    // see SimpleLRU.h
+    Hits GetHits() const override {
+        std::unique_lock<std::mutex> lock(lru_mutex);
+        return SimpleLRU::GetHits();
+    }
+
+    /**
+     * Appends every successful change to the given log, nullptr stops that. Records are appended
+     * under the same lock changes are made, so the log keeps changes of each key in order
+     */
+    void SetLog(MutationLog *log) {
+        std::unique_lock<std::mutex> lock(lru_mutex);
+        _log = log;
+    }
+
 private:
+    // Logs stored value together with its deadline, returns result of the store. Value which has expired
+    // right away is logged as delete. Logged value has to stay in place, so with the log on value is copied
+    // to the storage even if it could be moved
+    bool Logged(const std::string &key, const std::string &value, bool result) {
+        int64_t deadline;
+        if (!result) {
+            return false;
+        } else if (Deadline(key, deadline)) {
+            _log->Put(key, value, deadline);
+        } else {
+            _log->Delete(key);
+        }
+        return true;
+    }
+
     // TODO: sinchronization primitives
-    std::mutex lru_mutex;
+    mutable std::mutex lru_mutex;
+
+    MutationLog *_log;
 };
 
 } // namespace Backend
@@ -0,0 +1,95 @@
+#include "gtest/gtest.h"
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <afina/execute/Incr.h>
+#include <afina/execute/MetaArithmetic.h>
+#include <afina/execute/MetaDelete.h>
+#include <afina/execute/MetaGet.h>
+#include <afina/execute/MetaNoop.h>
+#include <afina/execute/MetaSet.h>
+
+#include "storage/SimpleLRU.h"
+#include "storage/StripedLRU.h"
+
+using namespace Afina;
+using namespace Afina::Execute;
+using namespace std;
+
+namespace {
+
+MetaCommand::Flags flags(const string &returns, bool quiet = false, const string &opaque = "") {
+    MetaCommand::Flags out;
+    for (char c : returns) {
+        out.Add(c);
+    }
+    out.quiet = quiet;
+    out.opaque = opaque;
+    return out;
+}
+
+template <typename T> string execute(Storage &storage, T &&command, const string &args = "") {
+    string out;
+    command.Execute(storage, args, out);
+    return out;
+}
+
+} // namespace
+
+TEST(MetaCommandTest, GetSet) {
+    Backend::SimpleLRU storage;
+
+    EXPECT_EQ(execute(storage, MetaGet("KEY1", flags("v"))), "EN");
+    EXPECT_EQ(execute(storage, MetaGet("KEY1", flags("v", true))), "");
+
+    EXPECT_EQ(execute(storage, MetaSet("KEY1", MetaSet::Mode::Set, 0, 0, flags("", false, "1")), "val1"), "HD O1");
+    EXPECT_EQ(execute(storage, MetaSet("KEY1", MetaSet::Mode::Add, 0, 0, flags("", true)), "val2"), "NS");
+    EXPECT_EQ(execute(storage, MetaSet("KEY2", MetaSet::Mode::Replace, 0, 0, flags("k")), "val2"), "NS kKEY2");
+    EXPECT_EQ(execute(storage, MetaSet("KEY1", MetaSet::Mode::Append, 0, 0, flags("", true)), "+"), "");
+    EXPECT_EQ(execute(storage, MetaSet("KEY1", MetaSet::Mode::Prepend, 0, 0, flags("")), "-"), "HD");
+
+    EXPECT_EQ(execute(storage, MetaGet("KEY1", flags("vk", false, "opaque"))), "VA 6 kKEY1 Oopaque\r\n-val1+");
+    EXPECT_EQ(execute(storage, MetaGet("KEY1", flags("sftc"))), "HD s6 f0 t-1 c0");
+    EXPECT_EQ(execute(storage, MetaNoop()), "MN");
+}
+
+TEST(MetaCommandTest, DeleteArithmetic) {
+    Backend::SimpleLRU storage;
+
+    EXPECT_EQ(execute(storage, MetaArithmetic("CNT", 1, false, false, 0, flags("k"))), "NF kCNT");
+    EXPECT_EQ(execute(storage, MetaArithmetic("CNT", 1, false, true, 10, flags("v"))), "VA 2\r\n10");
+    EXPECT_EQ(execute(storage, MetaArithmetic("CNT", 5, false, true, 10, flags("", true))), "");
+    EXPECT_EQ(execute(storage, MetaArithmetic("CNT", 20, true, false, 0, flags("v"))), "VA 1\r\n0");
+
+    storage.Put("STR", "abc");
+    EXPECT_EQ(execute(storage, MetaArithmetic("STR", 1, false, false, 0, flags(""))).substr(0, 12), "CLIENT_ERROR");
+
+    EXPECT_EQ(execute(storage, MetaDelete("CNT", flags("", false, "x"))), "HD Ox");
+    EXPECT_EQ(execute(storage, MetaDelete("CNT", flags(""))), "NF");
+    EXPECT_EQ(execute(storage, MetaDelete("STR", flags("", true))), "");
+    EXPECT_EQ(execute(storage, MetaGet("STR", flags(""))), "EN");
+}
+
+TEST(MetaCommandTest, ConcurrentArithmetic) {
+    auto storage = Backend::StripedLRU::BuildLRU(16 * 1024 * 1024, 4);
+
+    // Every change is applied once, except the one which creates the counter
+    const int threads_count = 4, changes = 10000;
+    vector<thread> threads;
+    for (int t = 0; t < threads_count; t++) {
+        threads.emplace_back([&storage, t]() {
+            uint64_t value;
+            for (int i = 0; i < changes; i++) {
+                Incr::Apply(*storage, "CNT", 1, false, true, 0, value);
+            }
+        });
+    }
+    for (auto &t : threads) {
+        t.join();
+    }
+
+    string value;
+    EXPECT_TRUE(storage->Get("CNT", value));
+    EXPECT_EQ(value, to_string(threads_count * changes - 1));
+}
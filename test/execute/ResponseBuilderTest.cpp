@@ -0,0 +1,42 @@
+#include "gtest/gtest.h"
+#include <cstdint>
+#include <limits>
+#include <string>
+
+#include <afina/execute/ResponseBuilder.h>
+
+using namespace Afina::Execute;
+using namespace std;
+
+TEST(ResponseBuilderTest, AppendsTextAndNumbers) {
+    string out = "VALUE";
+    ResponseBuilder response(out);
+    response.Append(' ').Append("key").Append(' ').Number(0).Append(' ').Number(size_t(12345));
+    EXPECT_EQ(out, "VALUE key 0 12345");
+
+    out.clear();
+    response.Number(-42).Append(' ').Number(numeric_limits<uint64_t>::max());
+    EXPECT_EQ(out, "-42 18446744073709551615");
+    EXPECT_EQ(response.Size(), out.size());
+}
+
+TEST(ResponseBuilderTest, ReserveKeepsMemory) {
+    string out;
+    ResponseBuilder response(out);
+    response.Reserve(100);
+    ASSERT_GE(out.capacity(), 100);
+    EXPECT_TRUE(out.empty());
+
+    // Reserved part is filled with no reallocation
+    const char *data = out.data();
+    for (int i = 0; i < 10; i++) {
+        response.Append("0123456789");
+    }
+    EXPECT_EQ(out.data(), data);
+
+    // Growing reserve at least doubles capacity
+    size_t capacity = out.capacity();
+    response.Reserve(capacity - out.size() + 1);
+    EXPECT_GE(out.capacity(), 2 * capacity);
+    EXPECT_EQ(out.size(), 100);
+}
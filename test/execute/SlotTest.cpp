@@ -0,0 +1,112 @@
+#include "gtest/gtest.h"
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <afina/execute/Slot.h>
+
+#include "storage/SimpleLRU.h"
+
+using namespace Afina;
+using namespace Afina::Execute;
+using namespace std;
+
+namespace {
+
+// Command which isn't built into the slot
+class Echo : public Command {
+public:
+    void Execute(Storage &storage, const string &args, string &out) override { out = "ECHO " + args; }
+};
+
+// Storage which tells whether the last value was copied or moved to it
+class Recorder : public Backend::SimpleLRU {
+public:
+    bool Put(const string &key, const string &value, int32_t expire = 0) override {
+        moved = false;
+        return SimpleLRU::Put(key, value, expire);
+    }
+    bool Put(const string &key, string &&value, int32_t expire = 0) override {
+        moved = true;
+        return SimpleLRU::Put(key, std::move(value), expire);
+    }
+
+    bool moved = false;
+};
+
+} // namespace
+
+TEST(SlotTest, ExecutesBuiltinCommands) {
+    Backend::SimpleLRU storage;
+    Slot slot;
+    EXPECT_TRUE(slot.Empty());
+
+    Response response;
+    slot.Emplace<Set>("KEY1", 0, 0);
+    slot.ExecuteResponse(storage, "val1", response);
+    EXPECT_EQ(response.text, "STORED");
+    slot.Clear();
+    EXPECT_TRUE(slot.Empty());
+
+    string keys = "KEY1 KEY2";
+    response.text.clear();
+    slot.Emplace<Get>(vector<string_view>{string_view(keys).substr(0, 4), string_view(keys).substr(5)});
+    slot.ExecuteResponse(storage, "", response);
+    EXPECT_EQ(response.text, "VALUE KEY1 0 4\r\nval1\r\nEND");
+}
+
+TEST(SlotTest, ReusesCommandOfTheSameType) {
+    Slot slot;
+    EXPECT_EQ(slot.Reuse<Get>(), nullptr);
+
+    Get &first = slot.Emplace<Get>(vector<string_view>{"KEY1", "KEY2", "KEY3"});
+    slot.Clear();
+    EXPECT_EQ(slot.Reuse<Set>(), nullptr);
+    EXPECT_TRUE(slot.Empty());
+
+    Get *second = slot.Reuse<Get>();
+    ASSERT_EQ(second, &first);
+    EXPECT_FALSE(slot.Empty());
+    second->keys(vector<string_view>{"KEY4"});
+    EXPECT_EQ(second->keys().size(), 1);
+}
+
+TEST(SlotTest, PluggedCommand) {
+    Backend::SimpleLRU storage;
+    Slot slot;
+    slot.Emplace(unique_ptr<Command>(new Echo()));
+
+    Response response;
+    slot.ExecuteResponse(storage, "hello", response);
+    EXPECT_EQ(response.text, "ECHO hello");
+
+    unique_ptr<Command> released = slot.Release();
+    EXPECT_NE(dynamic_cast<Echo *>(released.get()), nullptr);
+    EXPECT_TRUE(slot.Empty());
+    EXPECT_THROW(slot.ExecuteResponse(storage, "", response), runtime_error);
+}
+
+TEST(SlotTest, MovesArgumentToStorage) {
+    Recorder storage;
+    Slot slot;
+    Response response;
+
+    string value = "val1";
+    slot.Emplace<Set>("KEY1", 0, 0);
+    slot.ExecuteResponse(storage, value, response);
+    EXPECT_FALSE(storage.moved);
+    slot.ExecuteResponse(storage, std::move(value), response);
+    EXPECT_TRUE(storage.moved);
+    EXPECT_EQ(response.text, "STORED");
+
+    // Appended value is a new one anyway
+    slot.Emplace<Append>("KEY1", 0, 0);
+    slot.ExecuteResponse(storage, string("+"), response);
+    EXPECT_TRUE(storage.moved);
+
+    response.text.clear();
+    slot.Emplace<Get>(vector<string_view>{"KEY1"});
+    slot.ExecuteResponse(storage, string(), response);
+    EXPECT_EQ(response.text, "VALUE KEY1 0 5\r\nval1+\r\nEND");
+}
@@ -0,0 +1,159 @@
+#include "gtest/gtest.h"
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <spdlog/logger.h>
+#include <spdlog/sinks/null_sink.h>
+
+#include <afina/network/Config.h>
+#include <afina/network/Server.h>
+
+#include "network/common/Handoff.h"
+#include "network/common/Utils.h"
+
+using namespace Afina::Network;
+using namespace std;
+
+namespace {
+
+// Server which does nothing but owns a listening socket
+class ListenOnly : public Server {
+public:
+    explicit ListenOnly(int s) : Server(nullptr, nullptr, nullptr), _socket(s) {}
+    void Start(uint16_t port, uint32_t acceptors, uint32_t workers) override {}
+    void Stop() override {}
+    void Join() override {}
+    vector<int> ListenSockets() const override { return _socket == -1 ? vector<int>() : vector<int>(1, _socket); }
+
+private:
+    int _socket;
+};
+
+shared_ptr<spdlog::logger> null_logger() {
+    return make_shared<spdlog::logger>("handoff", make_shared<spdlog::sinks::null_sink_st>());
+}
+
+string test_path() { return "/tmp/afina-handoff-test." + to_string(getpid()); }
+
+// Listening socket on random port
+int make_listener(uint16_t &port) {
+    int s = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    bind(s, (struct sockaddr *)&addr, sizeof(addr));
+    listen(s, 5);
+
+    socklen_t len = sizeof(addr);
+    getsockname(s, (struct sockaddr *)&addr, &len);
+    port = ntohs(addr.sin_port);
+    return s;
+}
+
+bool wait_for(const atomic<bool> &flag) {
+    for (int i = 0; i < 200 && !flag; i++) {
+        this_thread::sleep_for(chrono::milliseconds(10));
+    }
+    return flag;
+}
+
+} // namespace
+
+TEST(HandoffTest, NothingToTakeOver) {
+    unlink(test_path().c_str());
+    Handoff handoff(null_logger(), test_path());
+    EXPECT_TRUE(handoff.Receive().empty());
+}
+
+TEST(HandoffTest, PassesListeningSocket) {
+    uint16_t port;
+    int listener = make_listener(port);
+
+    atomic<bool> done(false);
+    Handoff running(null_logger(), test_path());
+    running.Start(make_shared<ListenOnly>(listener), [&done]() { done = true; });
+
+    Handoff next(null_logger(), test_path());
+    Config config;
+    config.inherited_sockets = next.Receive();
+    ASSERT_EQ(config.inherited_sockets.size(), 1);
+    EXPECT_FALSE(done);
+
+    // Received descriptor refers the same socket
+    EXPECT_EQ(take_server_socket(config, port + 1, false), -1);
+    EXPECT_EQ(take_server_socket(config, port, true), -1);
+    int inherited = take_server_socket(config, port, false);
+    ASSERT_NE(inherited, -1);
+    EXPECT_NE(inherited, listener);
+    EXPECT_TRUE(config.inherited_sockets.empty());
+
+    next.Confirm(config.inherited_sockets);
+    EXPECT_TRUE(wait_for(done));
+
+    // Connection queued in the old socket is accepted by the new one
+    close(listener);
+    int client = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons(port);
+    ASSERT_EQ(connect(client, (struct sockaddr *)&addr, sizeof(addr)), 0);
+    int accepted = accept(inherited, nullptr, nullptr);
+    EXPECT_NE(accepted, -1);
+
+    close(accepted);
+    close(client);
+    close(inherited);
+    running.Stop();
+}
+
+TEST(HandoffTest, KeepsServingIfNextProcessFails) {
+    uint16_t port;
+    int listener = make_listener(port);
+
+    atomic<bool> done(false);
+    Handoff running(null_logger(), test_path());
+    running.Start(make_shared<ListenOnly>(listener), [&done]() { done = true; });
+
+    {
+        // Next process dies before confirmation
+        Handoff next(null_logger(), test_path());
+        vector<int> sockets = next.Receive();
+        ASSERT_EQ(sockets.size(), 1);
+        close(sockets[0]);
+    }
+    this_thread::sleep_for(chrono::milliseconds(50));
+    EXPECT_FALSE(done);
+
+    // Running process still waits for the next attempt
+    Handoff next(null_logger(), test_path());
+    vector<int> sockets = next.Receive();
+    ASSERT_EQ(sockets.size(), 1);
+    next.Confirm(sockets);
+    EXPECT_TRUE(wait_for(done));
+
+    running.Stop();
+    close(listener);
+}
+
+TEST(HandoffTest, RefusedByServerWithoutSockets) {
+    atomic<bool> done(false);
+    Handoff running(null_logger(), test_path());
+    running.Start(make_shared<ListenOnly>(-1), [&done]() { done = true; });
+
+    Handoff next(null_logger(), test_path());
+    EXPECT_THROW(next.Receive(), std::runtime_error);
+    EXPECT_FALSE(done);
+    running.Stop();
+}
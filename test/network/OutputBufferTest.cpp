@@ -0,0 +1,216 @@
+#include "gtest/gtest.h"
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <string_view>
+
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include "network/common/OutputBuffer.h"
+#include "network/common/OutputQuota.h"
+
+using namespace Afina;
+using namespace Afina::Network;
+using namespace std;
+
+namespace {
+
+// Socket pair and the file with value, both removed once test is done
+class OutputBufferTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, sockets), 0);
+        ASSERT_EQ(fcntl(sockets[0], F_SETFL, O_NONBLOCK), 0);
+        char path[] = "/tmp/afina-output-XXXXXX";
+        fd = mkstemp(path);
+        ASSERT_NE(fd, -1);
+        unlink(path);
+
+        value.assign(100000, 'v');
+        for (size_t i = 0; i < value.size(); i += 1000) {
+            value[i] = 'a' + (i / 1000) % 26;
+        }
+        string content = "header" + value + "trailer";
+        ASSERT_EQ(write(fd, content.data(), content.size()), content.size());
+    }
+    void TearDown() override {
+        close(sockets[0]);
+        close(sockets[1]);
+        close(fd);
+    }
+
+    // Value in the file, pins counts the ones not dropped yet
+    FileValue File() {
+        pins++;
+        return FileValue{fd, 6, value.size(), shared_ptr<void>(nullptr, [this](void *) { pins--; })};
+    }
+
+    string Receive(size_t size) {
+        string result(size, '\0');
+        for (size_t done = 0; done < size;) {
+            ssize_t n = read(sockets[1], &result[done], size - done);
+            if (n <= 0) {
+                break;
+            }
+            done += n;
+        }
+        return result;
+    }
+
+    int sockets[2];
+    int fd;
+    int pins = 0;
+    string value;
+};
+
+// Connected pair of TCP sockets on loopback, zerocopy needs TCP
+void tcp_pair(int sockets[2]) {
+    int listener = socket(AF_INET, SOCK_STREAM, 0);
+    ASSERT_NE(listener, -1);
+    struct sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t len = sizeof(addr);
+    ASSERT_EQ(bind(listener, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)), 0);
+    ASSERT_EQ(listen(listener, 1), 0);
+    ASSERT_EQ(getsockname(listener, reinterpret_cast<struct sockaddr *>(&addr), &len), 0);
+
+    sockets[1] = socket(AF_INET, SOCK_STREAM, 0);
+    ASSERT_EQ(connect(sockets[1], reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)), 0);
+    sockets[0] = accept4(listener, nullptr, nullptr, SOCK_NONBLOCK);
+    ASSERT_NE(sockets[0], -1);
+    close(listener);
+}
+
+} // namespace
+
+TEST_F(OutputBufferTest, SendsFileChunks) {
+    OutputBuffer out;
+    out.Append("VALUE k 0 100000\r\n");
+    out.AppendFile(File());
+    out.Append("\r\nEND\r\n");
+    EXPECT_EQ(out.Size(), 18 + value.size() + 7);
+
+    // Socket buffer is smaller than the value, so data goes in portions
+    string received;
+    while (!out.Empty()) {
+        ASSERT_TRUE(out.Flush(sockets[0]));
+        received += Receive(out.Sent() - received.size());
+    }
+    EXPECT_EQ(received, "VALUE k 0 100000\r\n" + value + "\r\nEND\r\n");
+    EXPECT_EQ(pins, 0);
+}
+
+TEST_F(OutputBufferTest, ReadsFileWithoutSendfile) {
+    OutputBuffer out(nullptr, false);
+    out.Append("VALUE k 0 100000\r\n");
+    out.AppendFile(File());
+    out.Append("\r\nEND\r\n");
+
+    // Value is copied right away, file isn't needed anymore
+    EXPECT_EQ(pins, 0);
+    struct iovec iov[8];
+    EXPECT_EQ(out.Prepare(iov, 8), 3);
+    EXPECT_EQ(string(static_cast<char *>(iov[1].iov_base), iov[1].iov_len), value);
+}
+
+TEST_F(OutputBufferTest, ClearDropsPins) {
+    OutputBuffer out;
+    out.AppendFile(File());
+    out.AppendFile(File());
+    EXPECT_EQ(pins, 2);
+    out.Consume(value.size() + 10);
+    EXPECT_EQ(pins, 1);
+    out.Clear();
+    EXPECT_EQ(pins, 0);
+}
+
+TEST(OutputBufferZerocopyTest, KeepsChunksUntilCompletion) {
+    int sockets[2];
+    tcp_pair(sockets);
+    OutputQuota quota(SIZE_MAX, 0, 64 * 1024);
+    OutputBuffer out(&quota);
+
+    string value(1000000, 'z');
+    for (size_t i = 0; i < value.size(); i += 1000) {
+        value[i] = 'a' + (i / 1000) % 26;
+    }
+    out.Append("VALUE k 0 1000000\r\n");
+    out.Append(string(value));
+    out.Append("\r\nEND\r\n");
+
+    string received;
+    char data[65536];
+    while (received.size() < value.size() + 26) {
+        ASSERT_TRUE(out.Flush(sockets[0]));
+        ssize_t n = recv(sockets[1], data, sizeof(data), 0);
+        ASSERT_GT(n, 0);
+        received.append(data, n);
+    }
+    EXPECT_TRUE(out.Empty());
+    EXPECT_EQ(received, "VALUE k 0 1000000\r\n" + value + "\r\nEND\r\n");
+
+    // Everything is acked, so completions arrive shortly
+    for (int i = 0; i < 100 && out.Pending(); i++) {
+        struct pollfd pfd = {sockets[0], 0, 0};
+        ASSERT_GE(poll(&pfd, 1, 100), 0);
+        if (pfd.revents & POLLERR) {
+            ASSERT_TRUE(out.ErrorQueue(sockets[0]));
+        }
+    }
+    EXPECT_FALSE(out.Pending());
+
+    // Loopback delivers pages to the receiver's queue, so kernel copies them anyway
+    EXPECT_EQ(quota.Zerocopied() + quota.ZerocopyCopied(), value.size());
+    close(sockets[0]);
+    close(sockets[1]);
+}
+
+TEST(OutputBufferZerocopyTest, SmallChunksAreCopied) {
+    int sockets[2];
+    tcp_pair(sockets);
+    OutputQuota quota(SIZE_MAX, 0, 64 * 1024);
+    OutputBuffer out(&quota);
+
+    out.Append(string(1000, 'a'));
+    out.Append(string(1000, 'b'));
+    ASSERT_TRUE(out.Flush(sockets[0]));
+    EXPECT_TRUE(out.Empty());
+    EXPECT_FALSE(out.Pending());
+
+    // No zerocopy sends, so error event would be a real error
+    EXPECT_FALSE(out.ErrorQueue(sockets[0]));
+    close(sockets[0]);
+    close(sockets[1]);
+}
+
+TEST_F(OutputBufferTest, CopiesSmallResponses) {
+    OutputBuffer out;
+    out.Append(string_view("STORED\r\n"));
+    out.Append("END\r\n");
+    struct iovec iov[8];
+    ASSERT_EQ(out.Prepare(iov, 8), 1);
+    const void *prepared = iov[0].iov_base;
+
+    // Large response goes as is, prepared memory stays in place while more is appended
+    out.Append(string(5000, 'x'));
+    out.Append("tail");
+    ASSERT_EQ(out.Prepare(iov, 8), 3);
+    EXPECT_EQ(iov[0].iov_base, prepared);
+    EXPECT_EQ(iov[0].iov_len, 13);
+
+    ASSERT_TRUE(out.Flush(sockets[0]));
+    EXPECT_TRUE(out.Empty());
+    EXPECT_EQ(Receive(5017), "STORED\r\nEND\r\n" + string(5000, 'x') + "tail");
+
+    // Sent chunks are reused
+    out.Append("again");
+    ASSERT_EQ(out.Prepare(iov, 8), 1);
+    ASSERT_TRUE(out.Flush(sockets[0]));
+    EXPECT_EQ(Receive(5), "again");
+}
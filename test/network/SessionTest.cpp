@@ -0,0 +1,119 @@
+#include "gtest/gtest.h"
+#include <memory>
+#include <string>
+
+#include <sys/uio.h>
+
+#include <spdlog/logger.h>
+#include <spdlog/sinks/null_sink.h>
+
+#include "network/common/OutputBuffer.h"
+#include "network/common/Session.h"
+#include "storage/SimpleLRU.h"
+
+using namespace Afina;
+using namespace Afina::Backend;
+using namespace Afina::Network;
+using namespace std;
+
+namespace {
+
+// Everything queued in the buffer, in order
+string Output(OutputBuffer &out) {
+    struct iovec iov[64];
+    int n = out.Prepare(iov, 64);
+    string result;
+    for (int i = 0; i < n; i++) {
+        result.append(static_cast<const char *>(iov[i].iov_base), iov[i].iov_len);
+    }
+    out.Consume(result.size());
+    return result;
+}
+
+shared_ptr<spdlog::logger> Logger() {
+    return make_shared<spdlog::logger>("session", make_shared<spdlog::sinks::null_sink_st>());
+}
+
+} // namespace
+
+const string kEmptyValues = "set k 0 0 0\r\n\r\n"
+                            "add k2 0 0 0\r\n\r\n"
+                            "append k 0 0 0\r\n\r\n"
+                            "get k k2\r\n";
+const string kEmptyResponse = "STORED\r\nSTORED\r\nSTORED\r\n"
+                              "VALUE k 0 0\r\n\r\nVALUE k2 0 0\r\n\r\nEND\r\n";
+
+TEST(SessionTest, EmptyValue) {
+    Session session(make_shared<SimpleLRU>(), Logger());
+    OutputBuffer out;
+
+    EXPECT_EQ(session.Process(kEmptyValues.data(), kEmptyValues.size(), out), 4);
+    EXPECT_EQ(Output(out), kEmptyResponse);
+}
+
+TEST(SessionTest, EmptyValueByteByByte) {
+    Session session(make_shared<SimpleLRU>(), Logger());
+    OutputBuffer out;
+
+    size_t executed = 0;
+    for (char c : kEmptyValues) {
+        executed += session.Process(&c, 1, out);
+    }
+    EXPECT_EQ(executed, 4);
+    EXPECT_EQ(Output(out), kEmptyResponse);
+}
+
+TEST(SessionTest, EmptyValueUnterminated) {
+    Session session(make_shared<SimpleLRU>(), Logger());
+    OutputBuffer out;
+
+    string request = "set k 0 0 0\r\nXX";
+    EXPECT_THROW(session.Process(request.data(), request.size(), out), runtime_error);
+}
+
+TEST(SessionTest, TooLargeValue) {
+    Session session(make_shared<SimpleLRU>(), Logger());
+    OutputBuffer out;
+
+    // Value is skipped as it arrives, command after it is served as usual
+    string request = "set big 0 0 2000\r\n" + string(2000, 'x') + "\r\nset k 0 0 1\r\nv\r\nget big k\r\n";
+    size_t executed = 0;
+    for (size_t pos = 0; pos < request.size(); pos += 100) {
+        executed += session.Process(request.data() + pos, min<size_t>(100, request.size() - pos), out);
+    }
+    EXPECT_EQ(executed, 3);
+    EXPECT_EQ(Output(out), "SERVER_ERROR object too large for cache\r\nSTORED\r\nVALUE k 0 1\r\nv\r\nEND\r\n");
+}
+
+TEST(SessionTest, HugeDeclaredValue) {
+    Session session(make_shared<SimpleLRU>(), Logger());
+    OutputBuffer out;
+
+    // Declared size allocates nothing, session just waits for the rest to skip it
+    string request = "set big 0 0 3000000000\r\nab";
+    EXPECT_EQ(session.Process(request.data(), request.size(), out), 0);
+    size_t len = 0;
+    EXPECT_EQ(session.ArgumentSpace(len), nullptr);
+    EXPECT_TRUE(session.Pending());
+}
+
+TEST(SessionTest, TooLargeBinaryValue) {
+    Session session(make_shared<SimpleLRU>(), Logger());
+    OutputBuffer out;
+
+    // Binary set with 8 bytes of extras, key and value of 2000 bytes
+    string key = "big";
+    uint32_t body = 8 + key.size() + 2000;
+    string request = {char(0x80), char(0x01), 0, char(key.size()), 8, 0, 0, 0};
+    for (int shift = 24; shift >= 0; shift -= 8) {
+        request += char((body >> shift) & 0xff);
+    }
+    request += string(12, '\0') + string(8, '\0') + key + string(2000, 'x');
+
+    EXPECT_EQ(session.Process(request.data(), request.size(), out), 1);
+    string response = Output(out);
+    ASSERT_GE(response.size(), 24);
+    EXPECT_EQ(response[0], char(0x81));
+    EXPECT_EQ(response[6], 0);
+    EXPECT_EQ(response[7], 0x03);
+}
@@ -0,0 +1,122 @@
+#include "gtest/gtest.h"
+#include <chrono>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <string>
+
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <spdlog/logger.h>
+#include <spdlog/sinks/null_sink.h>
+
+#include <afina/logging/Service.h>
+#include <afina/network/Config.h>
+
+#include "network/mt_nonblocking/ServerImpl.h"
+#include "storage/SimpleLRU.h"
+
+using namespace Afina;
+using namespace Afina::Network;
+using namespace std;
+
+namespace {
+
+// Every logger drops messages
+class NullLogging : public Logging::Service {
+public:
+    NullLogging() : _logger(make_shared<spdlog::logger>("timeout", make_shared<spdlog::sinks::null_sink_mt>())) {}
+    void Start() override {}
+    void Stop() override {}
+    shared_ptr<spdlog::logger> select(const string &name) noexcept override { return _logger; }
+    unique_ptr<spdlog::logger> create(const string &name, const map<string, string> &mdc) noexcept override {
+        return unique_ptr<spdlog::logger>(new spdlog::logger(name, make_shared<spdlog::sinks::null_sink_mt>()));
+    }
+    void reopen_all() override {}
+
+private:
+    shared_ptr<spdlog::logger> _logger;
+};
+
+// Listening socket on random port, server takes it over instead of binding its own
+int make_listener(uint16_t &port, bool reuse_port) {
+    int s = socket(AF_INET, SOCK_STREAM, 0);
+    int opts = 1;
+    if (reuse_port) {
+        setsockopt(s, SOL_SOCKET, SO_REUSEPORT, &opts, sizeof(opts));
+    }
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    bind(s, (struct sockaddr *)&addr, sizeof(addr));
+    listen(s, 5);
+
+    socklen_t len = sizeof(addr);
+    getsockname(s, (struct sockaddr *)&addr, &len);
+    port = ntohs(addr.sin_port);
+    return s;
+}
+
+int connect_to(uint16_t port) {
+    int s = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons(port);
+    if (connect(s, (struct sockaddr *)&addr, sizeof(addr)) == -1) {
+        close(s);
+        return -1;
+    }
+
+    struct timeval tv = {5, 0};
+    setsockopt(s, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    return s;
+}
+
+// Client which has nothing more to say gets disconnected by mt_nonblock server in the given mode
+void ExpectIdleClosed(bool reuse_port) {
+    auto config = make_shared<Config>();
+    config->reuse_port = reuse_port;
+    config->idle_timeout = 200;
+
+    uint16_t port;
+    config->inherited_sockets.push_back(make_listener(port, reuse_port));
+    MTnonblock::ServerImpl server(make_shared<Backend::SimpleLRU>(), make_shared<NullLogging>(), config);
+    server.Start(port, 1, 2 - reuse_port);
+
+    // Connection which sent nothing at all
+    int silent = connect_to(port);
+    ASSERT_NE(silent, -1);
+
+    // Connection which got response and then went silent
+    int served = connect_to(port);
+    ASSERT_NE(served, -1);
+    string request = "set k 0 0 1\r\nv\r\n";
+    ASSERT_EQ(write(served, request.data(), request.size()), request.size());
+    char buffer[64];
+    ASSERT_EQ(read(served, buffer, sizeof(buffer)), 8);
+    EXPECT_EQ(string(buffer, 8), "STORED\r\n");
+
+    auto start = chrono::steady_clock::now();
+    EXPECT_EQ(read(served, buffer, sizeof(buffer)), 0);
+    EXPECT_EQ(read(silent, buffer, sizeof(buffer)), 0);
+    auto elapsed = chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - start);
+    EXPECT_GE(elapsed.count(), 100);
+    EXPECT_LT(elapsed.count(), 2000);
+
+    close(served);
+    close(silent);
+    server.Stop();
+    server.Join();
+}
+
+} // namespace
+
+TEST(TimeoutTest, SharedEpollClosesIdle) { ExpectIdleClosed(false); }
+
+TEST(TimeoutTest, ReusePortClosesIdle) { ExpectIdleClosed(true); }
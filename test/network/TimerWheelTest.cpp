@@ -0,0 +1,129 @@
+#include "gtest/gtest.h"
+#include <algorithm>
+#include <map>
+#include <random>
+#include <vector>
+
+#include "network/common/TimerWheel.h"
+
+using namespace Afina::Network;
+using namespace std;
+
+TEST(TimerWheelTest, FiresOnDeadline) {
+    TimerWheel wheel(1000, 10);
+    TimerWheel::Timer timer;
+
+    wheel.Arm(&timer, 1100);
+    EXPECT_TRUE(timer.Armed());
+
+    vector<TimerWheel::Timer *> expired;
+    wheel.Expire(1099, expired);
+    EXPECT_TRUE(expired.empty());
+
+    wheel.Expire(1100, expired);
+    ASSERT_EQ(expired.size(), 1);
+    EXPECT_EQ(expired[0], &timer);
+    EXPECT_FALSE(timer.Armed());
+}
+
+TEST(TimerWheelTest, RearmAndCancel) {
+    TimerWheel wheel(0, 10);
+    TimerWheel::Timer t1, t2;
+
+    wheel.Arm(&t1, 100);
+    wheel.Arm(&t2, 100);
+    wheel.Arm(&t1, 5000);
+    wheel.Cancel(&t2);
+    EXPECT_FALSE(t2.Armed());
+
+    vector<TimerWheel::Timer *> expired;
+    wheel.Expire(4990, expired);
+    EXPECT_TRUE(expired.empty());
+
+    wheel.Expire(5000, expired);
+    ASSERT_EQ(expired.size(), 1);
+    EXPECT_EQ(expired[0], &t1);
+}
+
+TEST(TimerWheelTest, NextTimeout) {
+    TimerWheel wheel(0, 10);
+    EXPECT_EQ(wheel.NextTimeout(0), -1);
+
+    TimerWheel::Timer t1, t2;
+    wheel.Arm(&t1, 300);
+    EXPECT_EQ(wheel.NextTimeout(0), 300);
+
+    // Far timer is on upper level, wheel must wake up no later than deadline
+    wheel.Cancel(&t1);
+    wheel.Arm(&t2, 100000);
+    int timeout = wheel.NextTimeout(5);
+    EXPECT_GT(timeout, 0);
+    EXPECT_LE(timeout, 100000 - 5);
+}
+
+TEST(TimerWheelTest, ManyTimers) {
+    const uint64_t start = 123456;
+    TimerWheel wheel(start, 10);
+
+    std::mt19937 gen(42);
+    std::uniform_int_distribution<uint64_t> deadline(0, 3600 * 1000);
+
+    vector<TimerWheel::Timer> timers(1000);
+    map<TimerWheel::Timer *, uint64_t> deadlines;
+    for (auto &timer : timers) {
+        uint64_t at = start + deadline(gen);
+        wheel.Arm(&timer, at);
+        deadlines[&timer] = at;
+    }
+
+    // Drive wheel the way worker does: sleep for suggested timeout or less
+    uint64_t now = start;
+    std::uniform_int_distribution<int> jitter(0, 3);
+    size_t fired = 0;
+    vector<TimerWheel::Timer *> expired;
+    while (fired < timers.size()) {
+        int timeout = wheel.NextTimeout(now);
+        ASSERT_GE(timeout, 0);
+        for (auto &p : deadlines) {
+            if (p.first->Armed()) {
+                ASSERT_LE(now + timeout, p.second + 10);
+            }
+        }
+
+        now += (jitter(gen) == 0) ? timeout / 2 : timeout;
+        expired.clear();
+        wheel.Expire(now, expired);
+        for (auto *timer : expired) {
+            ASSERT_LE(deadlines[timer], now);
+            ASSERT_FALSE(timer->Armed());
+        }
+        fired += expired.size();
+
+        // Nothing overdue stays in the wheel
+        for (auto &p : deadlines) {
+            if (p.first->Armed()) {
+                ASSERT_GT(p.second, now - now % 10);
+            }
+        }
+    }
+    EXPECT_EQ(wheel.NextTimeout(now), -1);
+}
+
+TEST(TimerWheelTest, MoveKeepsDeadline) {
+    TimerWheel from(1000, 10), to(1020, 10);
+    TimerWheel::Timer timer;
+
+    from.Arm(&timer, 1105);
+    uint64_t deadline = from.Deadline(&timer);
+    EXPECT_EQ(deadline, 1110);
+    from.Cancel(&timer);
+    to.Arm(&timer, deadline);
+
+    vector<TimerWheel::Timer *> expired;
+    to.Expire(1109, expired);
+    EXPECT_TRUE(expired.empty());
+
+    to.Expire(1110, expired);
+    ASSERT_EQ(expired.size(), 1);
+    EXPECT_EQ(expired[0], &timer);
+}
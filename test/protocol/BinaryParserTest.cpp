@@ -0,0 +1,162 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <string>
+
+#include <afina/execute/Command.h>
+#include <afina/execute/Slot.h>
+
+#include <protocol/BinaryParser.h>
+
+#include "storage/SimpleLRU.h"
+
+using namespace Afina;
+using Opcode = Protocol::BinaryParser::Opcode;
+using Status = Protocol::BinaryParser::Status;
+
+namespace {
+
+std::string number(uint64_t value, int size) {
+    std::string out(size, '\0');
+    for (int i = size - 1; i >= 0; i--, value >>= 8) {
+        out[i] = char(value & 0xff);
+    }
+    return out;
+}
+
+uint64_t number(const std::string &data, size_t pos, int size) {
+    uint64_t value = 0;
+    for (int i = 0; i < size; i++) {
+        value = value << 8 | static_cast<uint8_t>(data[pos + i]);
+    }
+    return value;
+}
+
+std::string request(Opcode opcode, const std::string &key, const std::string &extras = "",
+                    const std::string &value = "", uint32_t opaque = 0) {
+    std::string out;
+    out += char(0x80);
+    out += char(opcode);
+    out += number(key.size(), 2);
+    out += char(extras.size());
+    out += std::string(3, '\0');
+    out += number(extras.size() + key.size() + value.size(), 4);
+    out += number(opaque, 4);
+    out += std::string(8, '\0');
+    return out + extras + key + value;
+}
+
+// Parses request fed by the given portions, executes it and returns response. Returns empty string
+// if there is nothing to respond
+std::string execute(Storage &storage, const std::string &input, size_t portion = 1024) {
+    Protocol::BinaryParser parser;
+    Execute::Slot slot;
+    size_t pos = 0, parsed = 0;
+    bool complete = false;
+    while (!complete && pos < input.size()) {
+        complete = parser.Parse(input.data() + pos, std::min(portion, input.size() - pos), parsed);
+        pos += parsed;
+    }
+    EXPECT_TRUE(complete);
+
+    size_t body_size = 0;
+    EXPECT_TRUE(parser.Build(slot, body_size));
+    EXPECT_EQ(body_size, input.size() - pos);
+
+    Execute::Response response;
+    slot.ExecuteResponse(storage, input.substr(pos), response);
+    if (!parser.Respond(response)) {
+        return "";
+    }
+    return response.text;
+}
+
+Status status(const std::string &response) { return static_cast<Status>(number(response, 6, 2)); }
+
+} // namespace
+
+TEST(BinaryParserTest, SetGet) {
+    Backend::SimpleLRU storage;
+
+    // Request split at every byte gives the same result
+    std::string response = execute(storage, request(Opcode::Set, "KEY1", number(7, 4) + number(0, 4), "val1", 42), 1);
+    ASSERT_EQ(response.size(), 24);
+    EXPECT_EQ(static_cast<uint8_t>(response[0]), 0x81);
+    EXPECT_EQ(response[1], char(Opcode::Set));
+    EXPECT_EQ(status(response), Status::NoError);
+    EXPECT_EQ(number(response, 12, 4), 42);
+
+    response = execute(storage, request(Opcode::Get, "KEY1", "", "", 7), 1);
+    ASSERT_EQ(response.size(), 24 + 4 + 4);
+    EXPECT_EQ(status(response), Status::NoError);
+    EXPECT_EQ(number(response, 2, 2), 0);
+    EXPECT_EQ(response[4], 4);
+    EXPECT_EQ(number(response, 8, 4), 8);
+    EXPECT_EQ(number(response, 12, 4), 7);
+    EXPECT_EQ(response.substr(28), "val1");
+
+    response = execute(storage, request(Opcode::GetK, "KEY1"));
+    ASSERT_EQ(response.size(), 24 + 4 + 4 + 4);
+    EXPECT_EQ(number(response, 2, 2), 4);
+    EXPECT_EQ(number(response, 8, 4), 12);
+    EXPECT_EQ(response.substr(28), "KEY1val1");
+
+    response = execute(storage, request(Opcode::Get, "KEY2"));
+    EXPECT_EQ(status(response), Status::KeyNotFound);
+}
+
+TEST(BinaryParserTest, QuietCommands) {
+    Backend::SimpleLRU storage;
+
+    // Quiet get is silent on miss, the rest on success
+    EXPECT_EQ(execute(storage, request(Opcode::GetQ, "KEY1")), "");
+    EXPECT_EQ(execute(storage, request(Opcode::SetQ, "KEY1", std::string(8, '\0'), "val1")), "");
+    EXPECT_EQ(execute(storage, request(Opcode::GetKQ, "KEY1")).substr(28), "KEY1val1");
+    EXPECT_EQ(execute(storage, request(Opcode::AppendQ, "KEY1", "", "+")), "");
+    EXPECT_EQ(execute(storage, request(Opcode::PrependQ, "KEY1", "", "-")), "");
+    EXPECT_EQ(execute(storage, request(Opcode::GetQ, "KEY1")).substr(28), "-val1+");
+    EXPECT_EQ(status(execute(storage, request(Opcode::AddQ, "KEY1", std::string(8, '\0'), "val2"))),
+              Status::KeyExists);
+    EXPECT_EQ(execute(storage, request(Opcode::DeleteQ, "KEY1")), "");
+    EXPECT_EQ(status(execute(storage, request(Opcode::DeleteQ, "KEY1"))), Status::KeyNotFound);
+    EXPECT_EQ(status(execute(storage, request(Opcode::Noop, ""))), Status::NoError);
+}
+
+TEST(BinaryParserTest, Counters) {
+    Backend::SimpleLRU storage;
+
+    // No initial value: expiration is 0xffffffff
+    std::string response = execute(storage, request(Opcode::Increment, "CNT", number(1, 8) + number(0, 8) +
+                                                                                     number(UINT32_MAX, 4)));
+    EXPECT_EQ(status(response), Status::KeyNotFound);
+
+    response = execute(storage, request(Opcode::Increment, "CNT", number(1, 8) + number(10, 8) + number(0, 4)));
+    EXPECT_EQ(status(response), Status::NoError);
+    EXPECT_EQ(number(response, 24, 8), 10);
+    response = execute(storage, request(Opcode::Increment, "CNT", number(5, 8) + number(10, 8) + number(0, 4)));
+    EXPECT_EQ(number(response, 24, 8), 15);
+    response = execute(storage, request(Opcode::Decrement, "CNT", number(20, 8) + number(10, 8) + number(0, 4)));
+    EXPECT_EQ(number(response, 24, 8), 0);
+
+    execute(storage, request(Opcode::Set, "STR", std::string(8, '\0'), "abc"));
+    response = execute(storage, request(Opcode::Increment, "STR", number(1, 8) + number(0, 8) + number(0, 4)));
+    EXPECT_EQ(status(response), Status::NonNumeric);
+}
+
+TEST(BinaryParserTest, Errors) {
+    Backend::SimpleLRU storage;
+
+    // Unknown request and wrong extras get error response, stream goes on
+    EXPECT_EQ(status(execute(storage, request(Opcode(0x50), "KEY1", "", "value"))), Status::UnknownCommand);
+    EXPECT_EQ(status(execute(storage, request(Opcode::Set, "KEY1", "", "value"))), Status::InvalidArguments);
+    EXPECT_EQ(status(execute(storage, request(Opcode::Get, ""))), Status::InvalidArguments);
+
+    // Stream is broken otherwise
+    Protocol::BinaryParser parser;
+    size_t parsed;
+    std::string input = "get KEY1\r\n";
+    EXPECT_THROW(parser.Parse(input.data(), input.size(), parsed), std::runtime_error);
+    input = request(Opcode::Get, "KEY1");
+    input[11] = 1;
+    EXPECT_THROW(parser.Parse(input.data(), input.size(), parsed), std::runtime_error);
+}
@@ -4,9 +4,16 @@
 #include <string>
 
 #include <afina/execute/Add.h>
+#include <afina/execute/Delete.h>
 #include <afina/execute/Get.h>
+#include <afina/execute/GetAndTouch.h>
+#include <afina/execute/Incr.h>
+#include <afina/execute/MetaGet.h>
+#include <afina/execute/MetaSet.h>
 #include <afina/execute/Set.h>
+#include <afina/execute/Snapshot.h>
 #include <afina/execute/Stats.h>
+#include <afina/execute/Touch.h>
 
 #include <protocol/Parser.h>
 
@@ -21,7 +28,8 @@ TEST(MemcachedParserTest, SimpleSet) {
     Protocol::Parser parser;
 
     size_t consumed = 0;
-    bool cmd_avail = parser.Parse("set foo 0 0 6\r\nfooval\r\n", consumed);
+    std::string input = "set foo 0 0 6\r\nfooval\r\n";
+    bool cmd_avail = parser.Parse(input, consumed);
     ASSERT_TRUE(cmd_avail);
     ASSERT_EQ(15, consumed);
     ASSERT_EQ("set", parser.Name());
@@ -42,7 +50,8 @@ TEST(MemcachedParserTest, SimpleAdd) {
     Protocol::Parser parser;
 
     size_t consumed = 0;
-    bool cmd_avail = parser.Parse("add bar 10 -1 60\r\nbarval\r\n", consumed);
+    std::string input = "add bar 10 -1 60\r\nbarval\r\n";
+    bool cmd_avail = parser.Parse(input, consumed);
     ASSERT_TRUE(cmd_avail);
     ASSERT_EQ(18, consumed);
     ASSERT_EQ("add", parser.Name());
@@ -63,7 +72,8 @@ TEST(MemcachedParserTest, SimpleGet) {
     Protocol::Parser parser;
 
     size_t consumed = 0;
-    bool cmd_avail = parser.Parse("get ke key2 super_long_key\r\n", consumed);
+    std::string input = "get ke key2 super_long_key\r\n";
+    bool cmd_avail = parser.Parse(input, consumed);
     ASSERT_TRUE(cmd_avail);
     ASSERT_EQ(28, consumed);
     ASSERT_EQ("get", parser.Name());
@@ -74,7 +84,7 @@ TEST(MemcachedParserTest, SimpleGet) {
     ASSERT_EQ(0, value_size);
 
     Execute::Get *tmp = reinterpret_cast<Execute::Get *>(cmd.get());
-    std::vector<std::string> keys = tmp->keys();
+    std::vector<std::string_view> keys = tmp->keys();
     ASSERT_EQ(3, keys.size());
     ASSERT_EQ("ke", keys[0]);
     ASSERT_EQ("key2", keys[1]);
@@ -85,7 +95,8 @@ TEST(MemcachedParserTest, Stats) {
     Protocol::Parser parser;
 
     size_t consumed = 0;
-    bool cmd_avail = parser.Parse("stats\r\n", consumed);
+    std::string input = "stats\r\n";
+    bool cmd_avail = parser.Parse(input, consumed);
     ASSERT_TRUE(cmd_avail);
     ASSERT_EQ(7, consumed);
     ASSERT_EQ("stats", parser.Name());
@@ -98,3 +109,223 @@ TEST(MemcachedParserTest, Stats) {
     Execute::Stats *tmp = reinterpret_cast<Execute::Stats *>(cmd.get());
     ASSERT_FALSE(tmp == nullptr);
 }
+
+TEST(MemcachedParserTest, Snapshot) {
+    Protocol::Parser parser;
+
+    size_t consumed = 0;
+    std::string input = "snapshot\r\n";
+    bool cmd_avail = parser.Parse(input, consumed);
+    ASSERT_TRUE(cmd_avail);
+    ASSERT_EQ(10, consumed);
+    ASSERT_EQ("snapshot", parser.Name());
+
+    size_t value_size;
+    std::unique_ptr<Execute::Command> cmd = parser.Build(value_size);
+    ASSERT_FALSE(cmd == nullptr);
+    ASSERT_EQ(0, value_size);
+    ASSERT_FALSE(dynamic_cast<Execute::Snapshot *>(cmd.get()) == nullptr);
+}
+
+// Verify command split into single bytes is parsed the same way as whole one
+TEST(MemcachedParserTest, ByteByByte) {
+    Protocol::Parser parser;
+    std::string input = "get ke key2 super_long_key_longer_than_any_vector_register\r\nnext";
+
+    size_t total = 0;
+    bool cmd_avail = false;
+    while (!cmd_avail) {
+        size_t consumed = 0;
+        cmd_avail = parser.Parse(&input[total], 1, consumed);
+        ASSERT_EQ(1, consumed);
+        total += consumed;
+    }
+    ASSERT_EQ(input.size() - 4, total);
+    ASSERT_EQ("get", parser.Name());
+
+    size_t value_size;
+    std::unique_ptr<Execute::Command> cmd = parser.Build(value_size);
+    Execute::Get *tmp = reinterpret_cast<Execute::Get *>(cmd.get());
+    std::vector<std::string_view> keys = tmp->keys();
+    ASSERT_EQ(3, keys.size());
+    ASSERT_EQ("ke", keys[0]);
+    ASSERT_EQ("super_long_key_longer_than_any_vector_register", keys[2]);
+}
+
+// Verify line split between \r and \n
+TEST(MemcachedParserTest, SplitLineEnd) {
+    Protocol::Parser parser;
+
+    size_t consumed = 0;
+    std::string first = "set foo 1 2 3\r";
+    ASSERT_FALSE(parser.Parse(first, consumed));
+    ASSERT_EQ(14, consumed);
+    std::string second = "\nbar\r\n";
+    ASSERT_TRUE(parser.Parse(second, consumed));
+    ASSERT_EQ(1, consumed);
+
+    size_t value_size;
+    std::unique_ptr<Execute::Command> cmd = parser.Build(value_size);
+    ASSERT_EQ(3, value_size);
+    Execute::Set *tmp = reinterpret_cast<Execute::Set *>(cmd.get());
+    ASSERT_EQ("foo", tmp->key());
+    ASSERT_EQ(1, tmp->flags());
+    ASSERT_EQ(2, tmp->expire());
+}
+
+// Verify malformed commands are rejected
+TEST(MemcachedParserTest, Errors) {
+    size_t consumed = 0;
+    Protocol::Parser parser;
+    // Unknown name fails before the whole line arrives
+    std::string input = "unknown ";
+    ASSERT_THROW(parser.Parse(input, consumed), std::runtime_error);
+
+    parser.Reset();
+    input = "set foo 0 0 6\rX";
+    ASSERT_THROW(parser.Parse(input, consumed), std::runtime_error);
+    parser.Reset();
+    input = "set foo 4294967296 0 6\r\n";
+    ASSERT_THROW(parser.Parse(input, consumed), std::runtime_error);
+    parser.Reset();
+    input = "set foo 0 0 1x\r\n";
+    ASSERT_THROW(parser.Parse(input, consumed), std::runtime_error);
+    parser.Reset();
+    input = "set foo 0 0\r\n";
+    ASSERT_THROW(parser.Parse(input, consumed), std::runtime_error);
+    parser.Reset();
+    input = "get\r\n";
+    ASSERT_THROW(parser.Parse(input, consumed), std::runtime_error);
+
+    parser.Reset();
+    input = "set foo 4294967295 -2147483648 0\r\n";
+    ASSERT_TRUE(parser.Parse(input, consumed));
+    size_t value_size;
+    std::unique_ptr<Execute::Command> cmd = parser.Build(value_size);
+    Execute::Set *tmp = reinterpret_cast<Execute::Set *>(cmd.get());
+    ASSERT_EQ(4294967295u, tmp->flags());
+    ASSERT_EQ(INT32_MIN, tmp->expire());
+}
+
+// Commands without value: delete, incr and decr
+TEST(MemcachedParserTest, DeleteIncr) {
+    Protocol::Parser parser;
+    size_t consumed = 0;
+    size_t value_size;
+
+    std::string input = "delete foo\r\n";
+    ASSERT_TRUE(parser.Parse(input, consumed));
+    ASSERT_EQ("delete", parser.Name());
+    std::unique_ptr<Execute::Command> cmd = parser.Build(value_size);
+    ASSERT_EQ(0, value_size);
+    ASSERT_EQ("foo", reinterpret_cast<Execute::Delete *>(cmd.get())->key());
+
+    parser.Reset();
+    input = "decr bar 18446744073709551615\r\n";
+    ASSERT_TRUE(parser.Parse(input, consumed));
+    cmd = parser.Build(value_size);
+    Execute::Incr *incr = reinterpret_cast<Execute::Incr *>(cmd.get());
+    ASSERT_EQ("bar", incr->key());
+    ASSERT_EQ(UINT64_MAX, incr->delta());
+    ASSERT_TRUE(incr->decrement());
+
+    parser.Reset();
+    input = "incr bar 18446744073709551616\r\n";
+    ASSERT_THROW(parser.Parse(input, consumed), std::runtime_error);
+}
+
+// Meta commands keep flags they don't know nothing about
+TEST(MemcachedParserTest, MetaCommands) {
+    Protocol::Parser parser;
+    size_t consumed = 0;
+    size_t value_size;
+
+    std::string input = "mg foo v k Oabc q t\r\n";
+    ASSERT_TRUE(parser.Parse(input, consumed));
+    ASSERT_EQ("mg", parser.Name());
+    std::unique_ptr<Execute::Command> cmd = parser.Build(value_size);
+    Execute::MetaGet *get = reinterpret_cast<Execute::MetaGet *>(cmd.get());
+    ASSERT_EQ("foo", get->key());
+    ASSERT_TRUE(get->flags().Has('v'));
+    ASSERT_TRUE(get->flags().Has('k'));
+    ASSERT_FALSE(get->flags().Has('s'));
+    ASSERT_TRUE(get->flags().quiet);
+    ASSERT_EQ("abc", get->flags().opaque);
+
+    parser.Reset();
+    input = "ms bar 5 MA F7 T-1 I\r\nhello\r\n";
+    ASSERT_TRUE(parser.Parse(input, consumed));
+    ASSERT_EQ(22, consumed);
+    cmd = parser.Build(value_size);
+    ASSERT_EQ(5, value_size);
+    Execute::MetaSet *set = reinterpret_cast<Execute::MetaSet *>(cmd.get());
+    ASSERT_EQ("bar", set->key());
+    ASSERT_EQ(Execute::MetaSet::Mode::Append, set->mode());
+    ASSERT_EQ(7, set->client_flags());
+    ASSERT_EQ(-1, set->expire());
+    ASSERT_FALSE(set->flags().quiet);
+
+    parser.Reset();
+    input = "mn\r\n";
+    ASSERT_TRUE(parser.Parse(input, consumed));
+    ASSERT_EQ("mn", parser.Name());
+
+    parser.Reset();
+    input = "ms bar 5 MX\r\n";
+    ASSERT_THROW(parser.Parse(input, consumed), std::runtime_error);
+}
+
+// noreply is the last token of the line
+TEST(MemcachedParserTest, NoReply) {
+    Protocol::Parser parser;
+    size_t consumed = 0;
+
+    std::string input = "set foo 0 0 6 noreply\r\nfooval\r\n";
+    ASSERT_TRUE(parser.Parse(input, consumed));
+    ASSERT_EQ(23, consumed);
+    ASSERT_TRUE(parser.NoReply());
+
+    const char *lines[] = {"delete foo noreply\r\n", "delete foo 0 noreply\r\n", "incr foo 1 noreply\r\n",
+                           "append foo 0 0 1 noreply\r\n"};
+    for (const char *line : lines) {
+        parser.Reset();
+        input = line;
+        ASSERT_TRUE(parser.Parse(input, consumed));
+        ASSERT_TRUE(parser.NoReply()) << line;
+    }
+
+    parser.Reset();
+    input = "set foo 0 0 6\r\n";
+    ASSERT_TRUE(parser.Parse(input, consumed));
+    ASSERT_FALSE(parser.NoReply());
+}
+
+// touch, gat and gats
+TEST(MemcachedParserTest, Touch) {
+    Protocol::Parser parser;
+    size_t consumed = 0;
+    size_t value_size;
+
+    std::string input = "touch foo 100 noreply\r\n";
+    ASSERT_TRUE(parser.Parse(input, consumed));
+    ASSERT_TRUE(parser.NoReply());
+    std::unique_ptr<Execute::Command> cmd = parser.Build(value_size);
+    Execute::Touch *touch = reinterpret_cast<Execute::Touch *>(cmd.get());
+    ASSERT_EQ("foo", touch->key());
+    ASSERT_EQ(100, touch->expire());
+
+    parser.Reset();
+    input = "gats -1 foo bar\r\n";
+    ASSERT_TRUE(parser.Parse(input, consumed));
+    ASSERT_EQ("gats", parser.Name());
+    cmd = parser.Build(value_size);
+    Execute::GetAndTouch *gat = reinterpret_cast<Execute::GetAndTouch *>(cmd.get());
+    ASSERT_EQ(-1, gat->expire());
+    ASSERT_EQ(2, gat->keys().size());
+    ASSERT_EQ("bar", gat->keys()[1]);
+    ASSERT_TRUE(gat->cas());
+
+    parser.Reset();
+    input = "gat 10\r\n";
+    ASSERT_THROW(parser.Parse(input, consumed), std::runtime_error);
+}
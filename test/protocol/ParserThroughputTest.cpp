@@ -0,0 +1,87 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <string>
+
+#include <afina/execute/Slot.h>
+
+#include <protocol/Parser.h>
+
+using namespace Afina;
+
+namespace {
+
+// Pipelined stream of small commands the way memcached clients send them
+std::string make_stream(std::size_t commands, std::size_t &values) {
+    std::string stream;
+    values = 0;
+    for (std::size_t i = 0; i < commands; i++) {
+        std::string key = "user:session:" + std::to_string(i * 7919 % 100000);
+        if (i % 10 == 0) {
+            stream += "set " + key + " 0 0 10\r\n0123456789\r\n";
+            values++;
+        } else if (i % 10 == 1) {
+            stream += "get " + key + " " + key + "a " + key + "b\r\n";
+        } else {
+            stream += "get " + key + "\r\n";
+        }
+    }
+    return stream;
+}
+
+// Parses the whole stream fed in portions of the given size, returns number of commands
+std::size_t parse_stream(Protocol::Parser &parser, const std::string &stream, std::size_t portion) {
+    Execute::Slot slot;
+    std::size_t commands = 0;
+    std::size_t body = 0;
+    for (std::size_t pos = 0; pos < stream.size();) {
+        std::size_t size = std::min(portion, stream.size() - pos);
+        if (body > 0) {
+            std::size_t skip = std::min(body, size);
+            body -= skip;
+            pos += skip;
+            continue;
+        }
+
+        std::size_t parsed = 0;
+        if (parser.Parse(stream.data() + pos, size, parsed)) {
+            parser.Build(slot, body);
+            if (body > 0) {
+                body += 2;
+            }
+            slot.Clear();
+            parser.Reset();
+            commands++;
+        }
+        pos += parsed;
+    }
+    return commands;
+}
+
+} // namespace
+
+// Not a strict benchmark, but shows parser speed on small requests and verifies nothing is lost
+// on any split of the stream
+TEST(ParserThroughputTest, PipelinedSmallCommands) {
+    std::size_t values;
+    std::string stream = make_stream(10000, values);
+
+    const std::size_t portions[] = {7, 1500, 16 * 1024};
+    for (std::size_t portion : portions) {
+        Protocol::Parser parser;
+        std::size_t rounds = 0, commands = 0;
+        auto start = std::chrono::steady_clock::now();
+        std::chrono::duration<double> elapsed(0);
+        while (elapsed.count() < 0.3) {
+            commands += parse_stream(parser, stream, portion);
+            rounds++;
+            elapsed = std::chrono::steady_clock::now() - start;
+        }
+        ASSERT_EQ(commands, rounds * 10000);
+
+        std::cout << "portion " << portion << ": " << int(rounds * stream.size() / elapsed.count() / 1e6) << " MB/s, "
+                  << int(commands / elapsed.count() / 1e3) << "K commands/s" << std::endl;
+    }
+}
@@ -0,0 +1,304 @@
+#include "gtest/gtest.h"
+#include <chrono>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <glob.h>
+#include <unistd.h>
+
+#include <afina/logging/Service.h>
+#include <spdlog/sinks/null_sink.h>
+
+#include "storage/FileTier.h"
+#include "storage/SimpleLRU.h"
+#include "storage/StripedLRU.h"
+
+using namespace Afina::Backend;
+using namespace std;
+
+namespace {
+
+shared_ptr<spdlog::logger> null_logger() {
+    return make_shared<spdlog::logger>("tier", make_shared<spdlog::sinks::null_sink_st>());
+}
+
+// Storage only needs some logger
+class NullLogging : public Afina::Logging::Service {
+public:
+    void Start() override {}
+    void Stop() override {}
+    shared_ptr<spdlog::logger> select(const string &name) noexcept override { return null_logger(); }
+    unique_ptr<spdlog::logger> create(const string &name, const map<string, string> &mdc) noexcept override {
+        return nullptr;
+    }
+    void reopen_all() override {}
+};
+
+// Each test works with its own files, removed once test is done
+class FileTierTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        path = "/tmp/afina-tier-" + to_string(getpid()) + "-" +
+               ::testing::UnitTest::GetInstance()->current_test_info()->name();
+    }
+    void TearDown() override {
+        glob_t g;
+        if (glob((path + ".*").c_str(), 0, nullptr, &g) == 0) {
+            for (size_t i = 0; i < g.gl_pathc; i++) {
+                unlink(g.gl_pathv[i]);
+            }
+        }
+        globfree(&g);
+    }
+
+    string path;
+};
+
+} // namespace
+
+TEST_F(FileTierTest, WriteReadRelease) {
+    FileTier tier(path, 0, null_logger(), 4096);
+    EXPECT_EQ(tier.Capacity(), 2 * 4096);
+
+    FileTier::Location first, second;
+    ASSERT_TRUE(tier.Write("KEY1", string(1000, 'a'), first));
+    ASSERT_TRUE(tier.Write("KEY2", string(1000, 'b'), second));
+    EXPECT_EQ(tier.LiveBytes(), 2 * (8 + 4 + 1000));
+
+    string value;
+    ASSERT_TRUE(tier.Read(first, value));
+    EXPECT_EQ(value, string(1000, 'a'));
+    ASSERT_TRUE(tier.Read(second, value));
+    EXPECT_EQ(value, string(1000, 'b'));
+
+    tier.Release(first);
+    EXPECT_EQ(tier.LiveBytes(), 8 + 4 + 1000);
+
+    // Doesn't fit into segment at all
+    FileTier::Location big;
+    EXPECT_FALSE(tier.Write("KEY3", string(4096, 'c'), big));
+}
+
+TEST_F(FileTierTest, CompactionRelocates) {
+    FileTier tier(path, 4 * 4096, null_logger(), 4096);
+
+    // Tier doesn't index values, so test keeps index the storage would keep
+    mutex index_mutex;
+    map<string, FileTier::Location> index;
+    tier.Start(
+        [&](const string &key, const FileTier::Location &location) {
+            unique_lock<mutex> lock(index_mutex);
+            auto it = index.find(key);
+            return it != index.end() && it->second == location;
+        },
+        [&](const string &key, const FileTier::Location &from, const FileTier::Location &to) {
+            unique_lock<mutex> lock(index_mutex);
+            auto it = index.find(key);
+            if (it == index.end() || !(it->second == from)) {
+                return false;
+            }
+            it->second = to;
+            return true;
+        });
+
+    // Fill the first segment, then kill most of its values
+    for (int i = 0; i < 6; i++) {
+        FileTier::Location location;
+        ASSERT_TRUE(tier.Write("KEY" + to_string(i), string(600, 'a' + i), location));
+        unique_lock<mutex> lock(index_mutex);
+        index["KEY" + to_string(i)] = location;
+    }
+    for (int i = 0; i < 4; i++) {
+        unique_lock<mutex> lock(index_mutex);
+        tier.Release(index["KEY" + to_string(i)]);
+        index.erase("KEY" + to_string(i));
+    }
+    // Switch to the next segment wakes compaction up
+    FileTier::Location location;
+    ASSERT_TRUE(tier.Write("KEY6", string(600, 'g'), location));
+    {
+        unique_lock<mutex> lock(index_mutex);
+        index["KEY6"] = location;
+    }
+
+    for (int i = 0; i < 50 && tier.Compactions() == 0; i++) {
+        this_thread::sleep_for(chrono::milliseconds(100));
+    }
+    tier.Stop();
+    EXPECT_EQ(tier.Compactions(), 1);
+    EXPECT_EQ(tier.LiveBytes(), 3 * (8 + 4 + 600));
+
+    string value;
+    for (auto &entry : index) {
+        EXPECT_NE(entry.second.segment, 0);
+        ASSERT_TRUE(tier.Read(entry.second, value));
+        EXPECT_EQ(value, string(600, 'a' + (entry.first[3] - '0')));
+    }
+}
+
+TEST_F(FileTierTest, LRUDemotesInsteadOfEviction) {
+    FileTier tier(path, 0, null_logger(), 1024 * 1024);
+    SimpleLRU storage(1000);
+    storage.SetTier(&tier, 2000);
+
+    // Large value never takes memory
+    EXPECT_TRUE(storage.Put("BIG", string(3000, 'b')));
+    for (int i = 0; i < 10; i++) {
+        EXPECT_TRUE(storage.Put("KEY" + to_string(i), string(100, '0' + i)));
+    }
+
+    // Cold values have moved to the file rather than been evicted
+    string value;
+    for (int i = 0; i < 10; i++) {
+        ASSERT_TRUE(storage.Get("KEY" + to_string(i), value));
+        EXPECT_EQ(value, string(100, '0' + i));
+    }
+    ASSERT_TRUE(storage.Get("BIG", value));
+    EXPECT_EQ(value, string(3000, 'b'));
+    EXPECT_FALSE(storage.Get("NONE", value));
+
+    SimpleLRU::Hits hits = storage.GetHits();
+    EXPECT_EQ(hits.ram + hits.file, 11);
+    EXPECT_GE(hits.file, 2);
+    EXPECT_EQ(hits.miss, 1);
+
+    // Overwrite and delete release space in the tier
+    size_t live = tier.LiveBytes();
+    EXPECT_TRUE(storage.Put("BIG", "small"));
+    EXPECT_EQ(tier.LiveBytes(), live - (8 + 3 + 3000));
+    EXPECT_TRUE(storage.Delete("KEY0"));
+    EXPECT_FALSE(storage.Get("KEY0", value));
+    ASSERT_TRUE(storage.Get("BIG", value));
+    EXPECT_EQ(value, "small");
+}
+
+TEST_F(FileTierTest, StripedStats) {
+    StripedLRU storage(8 * 1024 * 1024, 4);
+    storage.ConfigureTier(path, 128 * 1024 * 1024, 8192, make_shared<NullLogging>());
+    storage.Start();
+
+    EXPECT_TRUE(storage.Put("KEY1", string(10000, 'a')));
+    EXPECT_TRUE(storage.Put("KEY2", "val2"));
+    string value;
+    EXPECT_TRUE(storage.Get("KEY1", value));
+    EXPECT_EQ(value, string(10000, 'a'));
+    EXPECT_TRUE(storage.Get("KEY2", value));
+    EXPECT_FALSE(storage.Get("KEY3", value));
+
+    vector<pair<string, string>> stats;
+    storage.Stats(stats);
+    map<string, string> named(stats.begin(), stats.end());
+    EXPECT_EQ(named["ram_hits"], "1");
+    EXPECT_EQ(named["file_hits"], "1");
+    EXPECT_EQ(named["get_misses"], "1");
+    EXPECT_EQ(named["tier_bytes"], to_string(8 + 4 + 10000));
+    EXPECT_EQ(named["tier_capacity"], to_string(128 * 1024 * 1024));
+    storage.Stop();
+}
+
+TEST_F(FileTierTest, PinKeepsSegment) {
+    FileTier tier(path, 3 * 4096, null_logger(), 4096);
+
+    FileTier::Location first, second;
+    ASSERT_TRUE(tier.Write("KEY1", string(3000, 'a'), first));
+    shared_ptr<void> pin = tier.Pin(first);
+    tier.Release(first);
+
+    // The only free segment is left for compaction, first one is dead but pinned
+    ASSERT_TRUE(tier.Write("KEY2", string(3000, 'b'), second));
+    EXPECT_NE(second.segment, first.segment);
+    FileTier::Location third;
+    tier.Release(second);
+    EXPECT_FALSE(tier.Write("KEY3", string(3000, 'c'), third));
+
+    string value;
+    ASSERT_TRUE(tier.Read(first, value));
+    EXPECT_EQ(value, string(3000, 'a'));
+
+    // Segment is reused once pin is dropped
+    pin.reset();
+    ASSERT_TRUE(tier.Write("KEY3", string(3000, 'c'), third));
+    EXPECT_EQ(third.segment, first.segment);
+}
+
+TEST_F(FileTierTest, StripedGetFile) {
+    StripedLRU storage(8 * 1024 * 1024, 4);
+    storage.ConfigureTier(path, 128 * 1024 * 1024, 8192, make_shared<NullLogging>());
+    storage.Start();
+
+    string large(100000, 'a');
+    EXPECT_TRUE(storage.Put("KEY1", large));
+    EXPECT_TRUE(storage.Put("KEY2", string(10000, 'b')));
+    EXPECT_TRUE(storage.Put("KEY3", "val3"));
+
+    // Only large file values are worth sending from the file
+    string value;
+    Afina::FileValue file;
+    ASSERT_TRUE(storage.GetFile("KEY1", value, file));
+    ASSERT_NE(file.fd, -1);
+    EXPECT_EQ(file.size, large.size());
+    string stored(file.size, '\0');
+    ASSERT_EQ(pread(file.fd, &stored[0], file.size, file.offset), file.size);
+    EXPECT_EQ(stored, large);
+
+    ASSERT_TRUE(storage.GetFile("KEY2", value, file));
+    EXPECT_EQ(file.fd, -1);
+    EXPECT_EQ(value, string(10000, 'b'));
+    ASSERT_TRUE(storage.GetFile("KEY3", value, file));
+    EXPECT_EQ(file.fd, -1);
+    EXPECT_EQ(value, "val3");
+    EXPECT_FALSE(storage.GetFile("KEY4", value, file));
+    storage.Stop();
+}
+
+TEST_F(FileTierTest, SnapshotReadsPinnedValues) {
+    FileTier tier(path, 128 * 1024 * 1024, null_logger());
+    SimpleLRU storage(1024 * 1024);
+    storage.SetTier(&tier, 8192);
+    EXPECT_TRUE(storage.Put("KEY1", string(10000, 'a')));
+    EXPECT_TRUE(storage.Put("KEY2", "val2"));
+
+    // Tier values are left to be read after the walk, their data stays even if value is replaced
+    vector<pair<string, Afina::FileValue>> files;
+    vector<string> keys;
+    storage.ForEach([&files, &keys](const string &key, const string &value, int64_t, const Afina::FileValue &file) {
+        keys.push_back(key);
+        if (file.fd != -1) {
+            EXPECT_TRUE(value.empty());
+            files.emplace_back(key, file);
+        }
+    });
+    EXPECT_EQ(keys, vector<string>({"KEY1", "KEY2"}));
+    ASSERT_EQ(files.size(), 1);
+    EXPECT_TRUE(storage.Put("KEY1", string(10000, 'b')));
+    EXPECT_TRUE(storage.Delete("KEY1"));
+
+    string stored(files[0].second.size, '\0');
+    ASSERT_TRUE(FileTier::ReadAt(files[0].second.fd, &stored[0], stored.size(), files[0].second.offset));
+    EXPECT_EQ(stored, string(10000, 'a'));
+}
+
+TEST_F(FileTierTest, StripedSnapshot) {
+    StripedLRU storage(8 * 1024 * 1024, 1);
+    storage.ConfigureTier(path, 128 * 1024 * 1024, 8192, make_shared<NullLogging>());
+    storage.Start();
+    EXPECT_TRUE(storage.Put("KEY1", string(10000, 'a')));
+    EXPECT_TRUE(storage.Put("KEY2", "val2"));
+    EXPECT_TRUE(storage.Put("KEY3", string(20000, 'c')));
+    EXPECT_EQ(storage.Save(path + ".snapshot"), 3);
+    storage.Stop();
+
+    StripedLRU loaded(8 * 1024 * 1024, 1);
+    EXPECT_EQ(loaded.Load(path + ".snapshot"), 3);
+    string value;
+    EXPECT_TRUE(loaded.Get("KEY1", value));
+    EXPECT_EQ(value, string(10000, 'a'));
+    EXPECT_TRUE(loaded.Get("KEY2", value));
+    EXPECT_EQ(value, "val2");
+    EXPECT_TRUE(loaded.Get("KEY3", value));
+    EXPECT_EQ(value, string(20000, 'c'));
+}
@@ -0,0 +1,198 @@
+#include "gtest/gtest.h"
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <glob.h>
+#include <unistd.h>
+
+#include <afina/logging/Service.h>
+#include <spdlog/sinks/null_sink.h>
+
+#include "storage/MutationLog.h"
+#include "storage/StripedLRU.h"
+
+using namespace Afina::Backend;
+using namespace std;
+
+namespace {
+
+const size_t kStorageSize = 8 * 1024 * 1024;
+
+shared_ptr<spdlog::logger> null_logger() {
+    return make_shared<spdlog::logger>("log", make_shared<spdlog::sinks::null_sink_st>());
+}
+
+// Storage only needs some logger
+class NullLogging : public Afina::Logging::Service {
+public:
+    void Start() override {}
+    void Stop() override {}
+    shared_ptr<spdlog::logger> select(const string &name) noexcept override { return null_logger(); }
+    unique_ptr<spdlog::logger> create(const string &name, const map<string, string> &mdc) noexcept override {
+        return nullptr;
+    }
+    void reopen_all() override {}
+};
+
+// Each test works with its own files, removed once test is done
+class MutationLogTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        path = "/tmp/afina-log-" + to_string(getpid()) + "-" +
+               ::testing::UnitTest::GetInstance()->current_test_info()->name();
+    }
+    void TearDown() override {
+        for (auto &file : Files()) {
+            unlink(file.c_str());
+        }
+        unlink((path + ".snapshot").c_str());
+    }
+
+    vector<string> Files() {
+        vector<string> result;
+        glob_t g;
+        if (glob((path + ".0*").c_str(), 0, nullptr, &g) == 0) {
+            result.assign(g.gl_pathv, g.gl_pathv + g.gl_pathc);
+        }
+        globfree(&g);
+        return result;
+    }
+
+    // Replays log into map
+    size_t Replay(map<string, string> &content) {
+        MutationLog log(path, chrono::milliseconds(0), null_logger());
+        return log.Replay([&content](const string &key, const string &value, int64_t) { content[key] = value; },
+                          [&content](const string &key) { content.erase(key); }, [](const string &, int64_t) {});
+    }
+
+    string path;
+};
+
+} // namespace
+
+TEST_F(MutationLogTest, WriteReplay) {
+    {
+        MutationLog log(path, chrono::milliseconds(1), null_logger());
+        log.Start();
+
+        vector<thread> threads;
+        for (int t = 0; t < 4; t++) {
+            threads.emplace_back([&log, t]() {
+                for (int i = 0; i < 1000; i++) {
+                    log.Put("key" + to_string(t) + "_" + to_string(i), to_string(i));
+                }
+                log.Delete("key" + to_string(t) + "_0");
+            });
+        }
+        for (auto &t : threads) {
+            t.join();
+        }
+        log.Put("KEY1", "val1");
+        log.Put("KEY1", "val2");
+        log.Stop();
+    }
+
+    map<string, string> content;
+    EXPECT_EQ(Replay(content), 4006);
+    EXPECT_EQ(content.size(), 4 * 999 + 1);
+    EXPECT_EQ(content["KEY1"], "val2");
+    EXPECT_EQ(content["key3_999"], "999");
+    EXPECT_EQ(content.count("key2_0"), 0);
+}
+
+TEST_F(MutationLogTest, StopsAtDamagedTail) {
+    {
+        MutationLog log(path, chrono::milliseconds(0), null_logger());
+        log.Start();
+        log.Put("KEY1", "val1");
+        log.Put("KEY2", "val2");
+        log.Stop();
+    }
+    ASSERT_EQ(Files().size(), 1);
+    // Cut the last byte of the second record off
+    ASSERT_EQ(truncate(Files()[0].c_str(), 2 * (13 + 8) - 1), 0);
+
+    // Next run appends to the new segment
+    {
+        MutationLog log(path, chrono::milliseconds(0), null_logger());
+        log.Start();
+        log.Put("KEY3", "val3");
+        log.Stop();
+    }
+    EXPECT_EQ(Files().size(), 2);
+
+    map<string, string> content;
+    EXPECT_EQ(Replay(content), 2);
+    EXPECT_EQ(content["KEY1"], "val1");
+    EXPECT_EQ(content.count("KEY2"), 0);
+    EXPECT_EQ(content["KEY3"], "val3");
+}
+
+TEST_F(MutationLogTest, RotateDrop) {
+    MutationLog log(path, chrono::milliseconds(0), null_logger());
+    log.Start();
+    log.Put("KEY1", "val1");
+    uint64_t segment = log.Rotate();
+    log.Put("KEY2", "val2");
+    log.Drop(segment);
+    log.Stop();
+
+    map<string, string> content;
+    EXPECT_EQ(Replay(content), 1);
+    EXPECT_EQ(content["KEY2"], "val2");
+}
+
+TEST_F(MutationLogTest, StorageRecovers) {
+    auto logging = make_shared<NullLogging>();
+
+    // No snapshot, everything is in the log
+    {
+        StripedLRU storage(kStorageSize, 4);
+        storage.ConfigureLog(path, chrono::milliseconds(0), logging);
+        storage.Start();
+        EXPECT_TRUE(storage.Put("KEY1", "val1"));
+        EXPECT_TRUE(storage.PutIfAbsent("KEY2", "val2"));
+        EXPECT_TRUE(storage.Put("KEY3", "val3"));
+        EXPECT_TRUE(storage.Set("KEY3", "val4"));
+        EXPECT_TRUE(storage.Delete("KEY1"));
+
+        // Expiration time is kept, the past one is as good as delete
+        EXPECT_TRUE(storage.Put("KEY6", "val6", 1000));
+        EXPECT_TRUE(storage.Put("KEY8", "val8", 1));
+        EXPECT_TRUE(storage.Put("KEY7", "val7"));
+        EXPECT_TRUE(storage.Set("KEY7", "val7", -1));
+        storage.Stop();
+    }
+
+    // Snapshot written on stop takes the whole log over
+    {
+        StripedLRU storage(kStorageSize, 4);
+        storage.ConfigureLog(path, chrono::milliseconds(0), logging);
+        storage.ConfigureSnapshot(path + ".snapshot", chrono::seconds(0), logging);
+        storage.Start();
+
+        string value;
+        this_thread::sleep_for(chrono::milliseconds(1100));
+        EXPECT_FALSE(storage.Get("KEY8", value));
+        EXPECT_FALSE(storage.Get("KEY1", value));
+        EXPECT_TRUE(storage.Get("KEY2", value));
+        EXPECT_EQ(value, "val2");
+        EXPECT_TRUE(storage.Get("KEY3", value));
+        EXPECT_EQ(value, "val4");
+        EXPECT_FALSE(storage.Get("KEY7", value));
+        EXPECT_TRUE(storage.Touch("KEY6", 0));
+        EXPECT_TRUE(storage.Touch("KEY2", 1000));
+        EXPECT_TRUE(storage.Put("KEY5", "val5"));
+        storage.Stop();
+    }
+    EXPECT_EQ(Files().size(), 1);
+
+    StripedLRU storage(kStorageSize, 4);
+    EXPECT_EQ(storage.Load(path + ".snapshot"), 4);
+    string value;
+    EXPECT_TRUE(storage.Get("KEY5", value));
+    EXPECT_EQ(value, "val5");
+}
@@ -0,0 +1,194 @@
+#include "gtest/gtest.h"
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "storage/SharedLRU.h"
+
+using namespace Afina::Backend;
+using namespace std;
+
+namespace {
+
+const size_t kSegmentSize = 8 * 1024 * 1024;
+
+// Header fields offsets: 7 fixed fields, then 16 free lists, lru_head, lru_tail, count, bytes and lock
+const size_t kLruHeadOffset = 56 + 16 * sizeof(uint64_t);
+const size_t kLockOffset = kLruHeadOffset + 4 * sizeof(uint64_t);
+
+// Each test works with its own segment, removed once test is done
+class SharedLRUTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        name = "/afina-test-" + to_string(getpid()) + "-" +
+               ::testing::UnitTest::GetInstance()->current_test_info()->name();
+        shm_unlink(name.c_str());
+    }
+    void TearDown() override { shm_unlink(name.c_str()); }
+
+    string name;
+};
+
+} // namespace
+
+TEST_F(SharedLRUTest, PutGetDelete) {
+    SharedLRU storage(name, kSegmentSize);
+    EXPECT_EQ(storage.Recovered(), 0);
+
+    EXPECT_TRUE(storage.Put("KEY1", "val1"));
+    EXPECT_TRUE(storage.Put("KEY1", "longer value which doesn't fit the old block"));
+    EXPECT_FALSE(storage.PutIfAbsent("KEY1", "val2"));
+    EXPECT_FALSE(storage.Set("KEY2", "val2"));
+    EXPECT_TRUE(storage.PutIfAbsent("KEY2", "val2"));
+    EXPECT_TRUE(storage.Set("KEY2", "val3"));
+
+    string value;
+    EXPECT_TRUE(storage.Get("KEY1", value));
+    EXPECT_EQ(value, "longer value which doesn't fit the old block");
+    EXPECT_TRUE(storage.Get("KEY2", value));
+    EXPECT_EQ(value, "val3");
+
+    EXPECT_TRUE(storage.Delete("KEY1"));
+    EXPECT_FALSE(storage.Delete("KEY1"));
+    EXPECT_FALSE(storage.Get("KEY1", value));
+    EXPECT_EQ(storage.Size(), 1);
+}
+
+TEST_F(SharedLRUTest, EvictsLeastRecentlyUsed) {
+    SharedLRU storage(name, kSegmentSize);
+    string big(100 * 1024, 'x');
+
+    EXPECT_TRUE(storage.Put("first", big));
+    for (int i = 0; i < 1000; i++) {
+        // Keep "first" fresh
+        string value;
+        EXPECT_TRUE(storage.Get("first", value));
+        EXPECT_TRUE(storage.Put("key" + to_string(i), big));
+    }
+
+    string value;
+    EXPECT_TRUE(storage.Get("first", value));
+    EXPECT_TRUE(storage.Get("key999", value));
+    EXPECT_FALSE(storage.Get("key0", value));
+    EXPECT_LT(storage.Size(), 1000);
+
+    EXPECT_FALSE(storage.Put("huge", string(storage.MaxEntry() + 1, 'x')));
+    EXPECT_TRUE(storage.Put("huge", string(storage.MaxEntry() - 4, 'x')));
+}
+
+TEST_F(SharedLRUTest, SurvivesRestart) {
+    {
+        SharedLRU storage(name, kSegmentSize);
+        for (int i = 0; i < 1000; i++) {
+            EXPECT_TRUE(storage.Put("key" + to_string(i), "value" + to_string(i)));
+        }
+        EXPECT_TRUE(storage.Delete("key500"));
+    }
+
+    // Next process attaches the same segment, maybe at another address
+    void *hole = mmap(nullptr, kSegmentSize, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    SharedLRU storage(name, 2 * kSegmentSize);
+    munmap(hole, kSegmentSize);
+
+    EXPECT_EQ(storage.Recovered(), 999);
+    EXPECT_TRUE(storage.Dropped().empty());
+
+    string value;
+    EXPECT_TRUE(storage.Get("key0", value));
+    EXPECT_EQ(value, "value0");
+    EXPECT_TRUE(storage.Get("key999", value));
+    EXPECT_EQ(value, "value999");
+    EXPECT_FALSE(storage.Get("key500", value));
+    EXPECT_TRUE(storage.Put("key500", "again"));
+}
+
+TEST_F(SharedLRUTest, Expires) {
+    {
+        SharedLRU storage(name, kSegmentSize);
+        EXPECT_TRUE(storage.Put("KEY1", "short", 1));
+        EXPECT_TRUE(storage.Put("KEY2", "long", 1000));
+        EXPECT_TRUE(storage.Put("KEY3", "forever"));
+        EXPECT_TRUE(storage.Put("KEY4", "touched"));
+        EXPECT_TRUE(storage.Touch("KEY4", 1));
+        EXPECT_FALSE(storage.Touch("KEY5", 1));
+
+        // Expired right away, old value is removed
+        EXPECT_TRUE(storage.Put("KEY3", "gone", -1));
+        EXPECT_TRUE(storage.PutIfAbsent("KEY6", "gone", -1));
+        EXPECT_EQ(storage.Size(), 3);
+
+        // Changed value keeps deadline
+        EXPECT_TRUE(storage.Update("KEY1", [](string &value) {
+            value += string(100, 'x');
+            return true;
+        }));
+    }
+
+    // Deadlines survive restart
+    std::this_thread::sleep_for(std::chrono::milliseconds(1100));
+    SharedLRU storage(name, kSegmentSize);
+    string value;
+    EXPECT_FALSE(storage.Get("KEY1", value));
+    EXPECT_TRUE(storage.Get("KEY2", value));
+    EXPECT_FALSE(storage.Get("KEY3", value));
+    EXPECT_FALSE(storage.Get("KEY4", value));
+    EXPECT_FALSE(storage.Get("KEY6", value));
+    EXPECT_EQ(storage.Size(), 1);
+}
+
+TEST_F(SharedLRUTest, DropsBrokenSegment) {
+    {
+        SharedLRU storage(name, kSegmentSize);
+        EXPECT_TRUE(storage.Put("KEY1", "val1"));
+    }
+
+    // Break LRU list head
+    int fd = shm_open(name.c_str(), O_RDWR, 0600);
+    ASSERT_NE(fd, -1);
+    char *base = static_cast<char *>(mmap(nullptr, kSegmentSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0));
+    uint64_t *lru_head = reinterpret_cast<uint64_t *>(base + kLruHeadOffset);
+    *lru_head += 8;
+    munmap(base, kSegmentSize);
+    close(fd);
+
+    SharedLRU storage(name, kSegmentSize);
+    EXPECT_EQ(storage.Recovered(), 0);
+    EXPECT_FALSE(storage.Dropped().empty());
+
+    string value;
+    EXPECT_FALSE(storage.Get("KEY1", value));
+    EXPECT_TRUE(storage.Put("KEY1", "val1"));
+}
+
+TEST_F(SharedLRUTest, DropsCacheIfOwnerDied) {
+    {
+        SharedLRU storage(name, kSegmentSize);
+        EXPECT_TRUE(storage.Put("KEY1", "val1"));
+    }
+
+    // Child takes segment lock and dies without releasing it
+    pid_t child = fork();
+    if (child == 0) {
+        int fd = shm_open(name.c_str(), O_RDWR, 0600);
+        char *base = static_cast<char *>(mmap(nullptr, kSegmentSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0));
+        pthread_mutex_lock(reinterpret_cast<pthread_mutex_t *>(base + kLockOffset));
+        _exit(0);
+    }
+    int status;
+    waitpid(child, &status, 0);
+
+    SharedLRU storage(name, kSegmentSize);
+    EXPECT_EQ(storage.Recovered(), 0);
+    EXPECT_FALSE(storage.Dropped().empty());
+
+    string value;
+    EXPECT_FALSE(storage.Get("KEY1", value));
+    EXPECT_TRUE(storage.Put("KEY1", "val1"));
+    EXPECT_TRUE(storage.Get("KEY1", value));
+}
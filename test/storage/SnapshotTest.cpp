@@ -0,0 +1,117 @@
+#include "gtest/gtest.h"
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <thread>
+
+#include <unistd.h>
+
+#include "storage/StripedLRU.h"
+
+using namespace Afina::Backend;
+using namespace std;
+
+namespace {
+
+const size_t kStorageSize = 8 * 1024 * 1024;
+
+// Each test works with its own file, removed once test is done
+class SnapshotTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        path = "/tmp/afina-snapshot-" + to_string(getpid()) + "-" +
+               ::testing::UnitTest::GetInstance()->current_test_info()->name();
+    }
+    void TearDown() override { unlink(path.c_str()); }
+
+    string path;
+};
+
+} // namespace
+
+TEST_F(SnapshotTest, SaveLoad) {
+    StripedLRU storage(kStorageSize, 4);
+    for (int i = 0; i < 1000; i++) {
+        EXPECT_TRUE(storage.Put("key" + to_string(i), string(i, 'x')));
+    }
+    EXPECT_EQ(storage.Save(path), 1000);
+
+    // Storage with other number of stripes still gets every entry into the right shard
+    StripedLRU loaded(kStorageSize, 3);
+    EXPECT_EQ(loaded.Load(path), 1000);
+
+    string value;
+    for (int i = 0; i < 1000; i++) {
+        EXPECT_TRUE(loaded.Get("key" + to_string(i), value));
+        EXPECT_EQ(value, string(i, 'x'));
+    }
+}
+
+TEST_F(SnapshotTest, KeepsLRUOrder) {
+    StripedLRU storage(1024, 1);
+    EXPECT_TRUE(storage.Put("KEY1", string(300, '1')));
+    EXPECT_TRUE(storage.Put("KEY2", string(300, '2')));
+    EXPECT_TRUE(storage.Put("KEY3", string(300, '3')));
+
+    string value;
+    EXPECT_TRUE(storage.Get("KEY1", value));
+    EXPECT_EQ(storage.Save(path), 3);
+
+    // Restored storage evicts the same entry as the original one would
+    StripedLRU loaded(1024, 1);
+    EXPECT_EQ(loaded.Load(path), 3);
+    EXPECT_TRUE(loaded.Put("KEY4", string(300, '4')));
+    EXPECT_TRUE(loaded.Get("KEY1", value));
+    EXPECT_FALSE(loaded.Get("KEY2", value));
+    EXPECT_TRUE(loaded.Get("KEY3", value));
+}
+
+TEST_F(SnapshotTest, KeepsExpiration) {
+    StripedLRU storage(kStorageSize, 4);
+    EXPECT_TRUE(storage.Put("KEY1", "val1", 1));
+    EXPECT_TRUE(storage.Put("KEY2", "val2", 1000));
+    EXPECT_TRUE(storage.Put("KEY3", "val3"));
+    EXPECT_EQ(storage.Save(path), 3);
+
+    // Loaded entry expires when the saved one was going to
+    StripedLRU loaded(kStorageSize, 4);
+    EXPECT_EQ(loaded.Load(path), 3);
+    this_thread::sleep_for(chrono::milliseconds(1100));
+    string value;
+    EXPECT_FALSE(loaded.Get("KEY1", value));
+    EXPECT_TRUE(loaded.Get("KEY2", value));
+    EXPECT_TRUE(loaded.Get("KEY3", value));
+}
+
+TEST_F(SnapshotTest, KeepsPreviousOnFailure) {
+    StripedLRU storage(kStorageSize, 4);
+    EXPECT_TRUE(storage.Put("KEY1", "val1"));
+    EXPECT_EQ(storage.Save(path), 1);
+
+    EXPECT_THROW(storage.Save("/nonexistent/snapshot"), std::runtime_error);
+    EXPECT_EQ(StripedLRU(kStorageSize, 4).Load(path), 1);
+}
+
+TEST_F(SnapshotTest, RejectsBrokenFile) {
+    StripedLRU storage(kStorageSize, 4);
+    EXPECT_THROW(storage.Load(path), std::runtime_error);
+
+    for (int i = 0; i < 100; i++) {
+        EXPECT_TRUE(storage.Put("key" + to_string(i), "value" + to_string(i)));
+    }
+    EXPECT_EQ(storage.Save(path), 100);
+
+    // Cut the trailer off
+    ifstream in(path, ios::binary);
+    string data((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+    in.close();
+    ofstream(path, ios::binary | ios::trunc) << data.substr(0, data.size() - 10);
+    EXPECT_THROW(StripedLRU(kStorageSize, 4).Load(path), std::runtime_error);
+
+    // Damage entry size in the first section
+    data[16] = '\xff';
+    data[17] = '\xff';
+    ofstream(path, ios::binary | ios::trunc) << data;
+    EXPECT_THROW(StripedLRU(kStorageSize, 4).Load(path), std::runtime_error);
+}
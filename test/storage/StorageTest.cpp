@@ -1,7 +1,10 @@
 #include "gtest/gtest.h"
+#include <chrono>
+#include <ctime>
 #include <iomanip>
 #include <iostream>
 #include <set>
+#include <thread>
 #include <vector>
 
 #include <afina/execute/Add.h>
@@ -11,6 +14,7 @@
 #include <afina/execute/Set.h>
 
 #include "storage/SimpleLRU.h"
+#include "storage/StripedLRU.h"
 
 using namespace Afina::Backend;
 using namespace Afina::Execute;
@@ -93,6 +97,11 @@ TEST(StorageTest, PutDeleteGet) {
     EXPECT_FALSE(storage.Get("KEY1", value));
     EXPECT_TRUE(storage.Get("KEY2", value));
     EXPECT_TRUE(value == "val2");
+
+    // Key could refer any memory, e.g. the request line
+    std::string request = "delete KEY2\r\n";
+    EXPECT_TRUE(storage.Delete(std::string_view(request).substr(7, 4)));
+    EXPECT_FALSE(storage.Get("KEY2", value));
 }
 
 
@@ -200,3 +209,122 @@ TEST(StorageTest, MaxTest) {
     }
 }
 
+TEST(StorageTest, TouchExpires) {
+    SimpleLRU storage;
+    int32_t past = int32_t(time(nullptr) - 10);
+
+    EXPECT_FALSE(storage.Touch("KEY1", 100));
+    EXPECT_TRUE(storage.Put("KEY1", "val1"));
+    EXPECT_TRUE(storage.Put("KEY2", "val2"));
+    EXPECT_TRUE(storage.Put("KEY3", "val3"));
+
+    // Relative time keeps item for now, Unix time in the past expires it
+    std::string value;
+    EXPECT_TRUE(storage.Touch("KEY1", 100));
+    EXPECT_TRUE(storage.Get("KEY1", value));
+    EXPECT_TRUE(storage.Touch("KEY1", past));
+    EXPECT_FALSE(storage.Get("KEY1", value));
+    EXPECT_FALSE(storage.Touch("KEY1", 0));
+
+    // Expired item is absent for every call
+    EXPECT_TRUE(storage.Touch("KEY2", -1));
+    EXPECT_FALSE(storage.Delete("KEY2"));
+    EXPECT_FALSE(storage.Set("KEY2", "new"));
+    EXPECT_TRUE(storage.PutIfAbsent("KEY2", "new"));
+    EXPECT_TRUE(storage.Get("KEY2", value));
+    EXPECT_EQ(value, "new");
+
+    // Put makes item never expire again
+    EXPECT_TRUE(storage.Touch("KEY3", 100));
+    EXPECT_TRUE(storage.Put("KEY3", "new"));
+    EXPECT_TRUE(storage.Touch("KEY3", 0));
+    EXPECT_TRUE(storage.Get("KEY3", value));
+}
+
+TEST(StorageTest, PutExpires) {
+    SimpleLRU storage;
+    int32_t past = int32_t(time(nullptr) - 10);
+
+    // Item gets value and expiration time at once
+    std::string value;
+    EXPECT_TRUE(storage.Put("KEY1", "val1", 100));
+    EXPECT_TRUE(storage.Get("KEY1", value));
+    EXPECT_TRUE(storage.Put("KEY1", "val2", past));
+    EXPECT_FALSE(storage.Get("KEY1", value));
+
+    // Expired item is absent for PutIfAbsent, the one expiring right away isn't stored
+    EXPECT_TRUE(storage.PutIfAbsent("KEY1", "val3", -1));
+    EXPECT_FALSE(storage.Get("KEY1", value));
+    EXPECT_TRUE(storage.PutIfAbsent("KEY1", "val3", 1));
+    EXPECT_FALSE(storage.PutIfAbsent("KEY1", "val4"));
+    EXPECT_TRUE(storage.Set("KEY1", "val4", 100));
+    std::this_thread::sleep_for(std::chrono::milliseconds(1100));
+    EXPECT_TRUE(storage.Get("KEY1", value));
+    EXPECT_EQ(value, "val4");
+}
+
+TEST(StorageTest, UpdateKeepsDeadline) {
+    SimpleLRU storage;
+    auto append = [](std::string &value) {
+        value += "+";
+        return true;
+    };
+
+    EXPECT_FALSE(storage.Update("KEY1", append));
+    EXPECT_TRUE(storage.Put("KEY1", "val1"));
+    EXPECT_TRUE(storage.Update("KEY1", append));
+    EXPECT_FALSE(storage.Update("KEY1", [](std::string &value) { return false; }));
+
+    std::string value;
+    EXPECT_TRUE(storage.Get("KEY1", value));
+    EXPECT_EQ(value, "val1+");
+
+    // Updated item expires when it was going to
+    EXPECT_TRUE(storage.Touch("KEY1", 1));
+    EXPECT_TRUE(storage.Update("KEY1", append));
+    std::this_thread::sleep_for(std::chrono::milliseconds(1100));
+    EXPECT_FALSE(storage.Get("KEY1", value));
+}
+
+TEST(StorageTest, ReservePut) {
+    SimpleLRU storage(1024);
+
+    // Value moved to the storage is there as if it was copied
+    std::string value;
+    ASSERT_TRUE(storage.Reserve(100, value));
+    ASSERT_GE(value.size(), 100);
+    value.assign(100, 'x');
+    EXPECT_TRUE(storage.Put("KEY1", std::move(value)));
+
+    std::string stored;
+    EXPECT_TRUE(storage.Get("KEY1", stored));
+    EXPECT_EQ(stored, std::string(100, 'x'));
+
+    // Dropped reservation changes nothing, value too large isn't stored
+    {
+        std::string aborted;
+        EXPECT_TRUE(storage.Reserve(10, aborted));
+    }
+    EXPECT_FALSE(storage.Get("KEY2", stored));
+    EXPECT_FALSE(storage.Put("KEY2", std::string(2048, 'y')));
+    EXPECT_FALSE(storage.Set("KEY1", std::string(2048, 'y')));
+    EXPECT_FALSE(storage.Get("KEY2", stored));
+    EXPECT_TRUE(storage.Get("KEY1", stored));
+
+    // Value which could never be stored gets no place at all
+    std::string huge;
+    EXPECT_EQ(storage.MaxValueSize(), 1024);
+    EXPECT_FALSE(storage.Reserve(3000000000, huge));
+    EXPECT_TRUE(huge.empty());
+}
+
+TEST(StorageTest, StripedMaxValue) {
+    StripedLRU storage(16 * 1024 * 1024, 4);
+
+    // Value must fit into the shard it goes to
+    EXPECT_EQ(storage.MaxValueSize(), 4 * 1024 * 1024);
+    std::string value;
+    EXPECT_FALSE(storage.Reserve(8 * 1024 * 1024, value));
+    EXPECT_TRUE(storage.Reserve(1024 * 1024, value));
+    EXPECT_EQ(value.size(), 1024 * 1024);
+}